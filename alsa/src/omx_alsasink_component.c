@@ -28,6 +28,12 @@
 #include <bellagio/omx_base_clock_port.h>
 #include <omx_alsasink_component.h>
 #include <config.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
 
 /** Maximum Number of AlsaSink Instance*/
 #define MAX_COMPONENT_ALSASINK 1
@@ -125,7 +131,7 @@ OMX_ERRORTYPE omx_alsasink_component_Constructor(OMX_COMPONENTTYPE *openmaxStand
   }
 
   /* Allocate the playback handle and the hardware parameter structure */
-  if ((err = snd_pcm_open (&omx_alsasink_component_Private->playback_handle, "default", SND_PCM_STREAM_PLAYBACK, 0)) < 0) {
+  if ((err = snd_pcm_open (&omx_alsasink_component_Private->playback_handle, "default", SND_PCM_STREAM_PLAYBACK, SND_PCM_NONBLOCK)) < 0) {
     DEBUG(DEB_LEV_ERR, "cannot open audio device %s (%s)\n", "default", snd_strerror (err));
     return OMX_ErrorHardware;
   }
@@ -144,14 +150,36 @@ OMX_ERRORTYPE omx_alsasink_component_Constructor(OMX_COMPONENTTYPE *openmaxStand
     return OMX_ErrorHardware;
   }
 
+  if (snd_pcm_status_malloc(&omx_alsasink_component_Private->pcm_status) < 0) {
+    DEBUG(DEB_LEV_ERR, "%s: failed allocating the pcm status\n", __func__);
+    return OMX_ErrorHardware;
+  }
+
   openmaxStandComp->SetParameter  = omx_alsasink_component_SetParameter;
   openmaxStandComp->GetParameter  = omx_alsasink_component_GetParameter;
+  openmaxStandComp->GetExtensionIndex = omx_alsasink_component_GetExtensionIndex;
+  omx_alsasink_component_Private->messageHandler = omx_alsasink_component_MessageHandler;
+
+  /* the buffer thread polls this pipe with the PCM, so that flushes and state changes interrupt a wait for the device */
+  if (pipe(omx_alsasink_component_Private->wakeup_fd) < 0) {
+    DEBUG(DEB_LEV_ERR, "cannot create the wakeup pipe (%s)\n", strerror(errno));
+    omx_alsasink_component_Private->wakeup_fd[0] = omx_alsasink_component_Private->wakeup_fd[1] = -1;
+    return OMX_ErrorInsufficientResources;
+  }
+  fcntl(omx_alsasink_component_Private->wakeup_fd[0], F_SETFL, O_NONBLOCK);
+  fcntl(omx_alsasink_component_Private->wakeup_fd[1], F_SETFL, O_NONBLOCK);
+  pthread_mutex_init(&omx_alsasink_component_Private->sync_mutex, NULL);
 
   /* Write in the default parameters */
   omx_alsasink_component_Private->AudioPCMConfigured  = 0;
   omx_alsasink_component_Private->eState  = OMX_TIME_ClockStateStopped;
   omx_alsasink_component_Private->xScale  = 1<<16;
 
+  /* driver defaults for the period and buffer sizes */
+  setHeader(&omx_alsasink_component_Private->sPCMTiming, sizeof(OMX_ALSASINK_PARAM_PCMTIMINGTYPE));
+  omx_alsasink_component_Private->sPCMTiming.nPortIndex = 0;
+  omx_alsasink_component_Private->bLowLatency = OMX_FALSE;
+
   if (!omx_alsasink_component_Private->AudioPCMConfigured) {
     DEBUG(DEB_LEV_SIMPLE_SEQ, "Configuring the PCM interface in the Init function\n");
     omxErr = omx_alsasink_component_SetParameter(openmaxStandComp, OMX_IndexParamAudioPcm, &omx_alsasink_component_Private->sPCMModeParam);
@@ -172,9 +200,17 @@ OMX_ERRORTYPE omx_alsasink_component_Destructor(OMX_COMPONENTTYPE *openmaxStandC
   if(omx_alsasink_component_Private->hw_params) {
     snd_pcm_hw_params_free (omx_alsasink_component_Private->hw_params);
   }
+  if(omx_alsasink_component_Private->pcm_status) {
+    snd_pcm_status_free (omx_alsasink_component_Private->pcm_status);
+  }
   if(omx_alsasink_component_Private->playback_handle) {
     snd_pcm_close(omx_alsasink_component_Private->playback_handle);
   }
+  if(omx_alsasink_component_Private->wakeup_fd[0] > 0) {
+    close(omx_alsasink_component_Private->wakeup_fd[0]);
+    close(omx_alsasink_component_Private->wakeup_fd[1]);
+    pthread_mutex_destroy(&omx_alsasink_component_Private->sync_mutex);
+  }
 
   /* frees port/s */
   if (omx_alsasink_component_Private->ports) {
@@ -303,6 +339,71 @@ OMX_ERRORTYPE omx_alsasink_component_port_SendBufferFunction(omx_base_PortType *
   return OMX_ErrorNone;
 }
 
+/** Asks the buffer thread to align the next buffer it plays to the media time.
+ * Called from the thread calling EmptyThisBuffer: bSyncPending and nDriftFrames are only
+ * touched by the buffer thread, which takes the request in omx_alsasink_component_TakeSyncRequest.
+ */
+static void omx_alsasink_component_RequestSync(omx_alsasink_component_PrivateType* omx_alsasink_component_Private) {
+  pthread_mutex_lock(&omx_alsasink_component_Private->sync_mutex);
+  omx_alsasink_component_Private->bSyncRequested = OMX_TRUE;
+  pthread_mutex_unlock(&omx_alsasink_component_Private->sync_mutex);
+}
+
+/** Turns a sync request of the clock port into bSyncPending, in the buffer thread */
+static void omx_alsasink_component_TakeSyncRequest(omx_alsasink_component_PrivateType* omx_alsasink_component_Private) {
+  pthread_mutex_lock(&omx_alsasink_component_Private->sync_mutex);
+  if(omx_alsasink_component_Private->bSyncRequested) {
+    omx_alsasink_component_Private->bSyncRequested = OMX_FALSE;
+    omx_alsasink_component_Private->bSyncPending   = OMX_TRUE;
+    omx_alsasink_component_Private->nDriftFrames   = 0;
+  }
+  pthread_mutex_unlock(&omx_alsasink_component_Private->sync_mutex);
+}
+
+/** Waits at most nTimeout milliseconds for a buffer from the clock component, so that a clock that
+ * stops sending cannot block the caller for ever. The wait ends early when either port is flushed or
+ * the component goes to idle. Returns OMX_TRUE when a clock buffer is ready to be dequeued.
+ */
+static OMX_BOOL omx_alsasink_component_ClockWait(omx_alsasink_component_PrivateType* omx_alsasink_component_Private, OMX_U32 nTimeout) {
+  omx_base_clock_PortType* pClockPort = (omx_base_clock_PortType*)omx_alsasink_component_Private->ports[OMX_BASE_SINK_CLOCKPORT_INDEX];
+  omx_base_PortType*       pAudioPort = omx_alsasink_component_Private->ports[OMX_BASE_SINK_INPUTPORT_INDEX];
+  tsem_t*                  pSem = pClockPort->pBufferSem;
+  struct timeval           now;
+  struct timespec          slice;
+  OMX_S64                  nNow;
+  OMX_S64                  nEnd;
+  OMX_BOOL                 bReady;
+
+  gettimeofday(&now, NULL);
+  nNow = (OMX_S64)now.tv_sec * 1000000 + now.tv_usec;
+  nEnd = nNow + (OMX_S64)nTimeout * 1000;
+
+  pthread_mutex_lock(&pSem->mutex);
+  while(pSem->semval == 0 && nNow < nEnd &&
+        !PORT_IS_BEING_FLUSHED(pAudioPort) && !PORT_IS_BEING_FLUSHED(pClockPort) &&
+        omx_alsasink_component_Private->transientState != OMX_TransStateExecutingToIdle) {
+    nNow += ALSASINK_CLOCK_WAIT_SLICE * 1000;
+    if(nNow > nEnd) {
+      nNow = nEnd;
+    }
+    slice.tv_sec  = nNow / 1000000;
+    slice.tv_nsec = (nNow % 1000000) * 1000;
+    pthread_cond_timedwait(&pSem->condition, &pSem->mutex, &slice);
+    gettimeofday(&now, NULL);
+    nNow = (OMX_S64)now.tv_sec * 1000000 + now.tv_usec;
+  }
+  bReady = (pSem->semval > 0) ? OMX_TRUE : OMX_FALSE;
+  if(bReady) {
+    pSem->semval--;
+  }
+  pthread_mutex_unlock(&pSem->mutex);
+
+  if(!bReady && nNow >= nEnd) {
+    DEBUG(DEB_LEV_ERR, "In %s no answer from the clock after %d ms\n", __func__, (int)nTimeout);
+  }
+  return bReady;
+}
+
 OMX_BOOL omx_alsasink_component_ClockPortHandleFunction(omx_alsasink_component_PrivateType* omx_alsasink_component_Private, OMX_BUFFERHEADERTYPE* inputbuffer){
   omx_base_clock_PortType*            pClockPort;
   OMX_BUFFERHEADERTYPE*               clockBuffer;
@@ -332,10 +433,11 @@ OMX_BOOL omx_alsasink_component_ClockPortHandleFunction(omx_alsasink_component_P
     if(err!=OMX_ErrorNone) {
       DEBUG(DEB_LEV_ERR,"Error %08x In OMX_SetConfig in func=%s \n",err,__func__);
     }
+    /* the clock may start at an earlier start time of another client, or after a seek: align the first buffer played */
+    omx_alsasink_component_RequestSync(omx_alsasink_component_Private);
 
-    if(!PORT_IS_BEING_FLUSHED(pAudioPort) && !PORT_IS_BEING_FLUSHED(pClockPort)) {
-      tsem_down(pClockPort->pBufferSem); /* wait for state change notification from clock src*/
-
+    /* wait for state change notification from clock src; if it comes later it is handled below */
+    if(omx_alsasink_component_ClockWait(omx_alsasink_component_Private, ALSASINK_CLOCK_START_TIMEOUT)) {
       /* update the clock state and clock scale info into the alsa sink private data */
       if(pClockPort->pBufferQueue->nelem > 0) {
         clockBuffer = dequeue(pClockPort->pBufferQueue);
@@ -347,6 +449,33 @@ OMX_BOOL omx_alsasink_component_ClockPortHandleFunction(omx_alsasink_component_P
     }
   }
 
+  /* check for any state or scale change information from the clock component */
+  while(pClockPort->pBufferSem->semval>0){
+    tsem_down(pClockPort->pBufferSem);
+    if(pClockPort->pBufferQueue->nelem == 0) {
+      break;
+    }
+    clockBuffer = dequeue(pClockPort->pBufferQueue);
+    pMediaTime  = (OMX_TIME_MEDIATIMETYPE*)clockBuffer->pBuffer;
+    if(pMediaTime->eUpdateType==OMX_TIME_UpdateScaleChanged) {
+     if(/*(omx_alsasink_component_Private->xScale>>16)==2 &&*/ (pMediaTime->xScale>>16)==1){ /* check with Q16 format only */
+           /* rebase the clock time base when turning to normal play mode*/
+        hclkComponent = pClockPort->hTunneledComponent;
+        setHeader(&sClientTimeStamp, sizeof(OMX_TIME_CONFIG_TIMESTAMPTYPE));
+        sClientTimeStamp.nPortIndex = pClockPort->nTunneledPort;
+        sClientTimeStamp.nTimestamp = inputbuffer->nTimeStamp;
+        err = OMX_SetConfig(hclkComponent, OMX_IndexConfigTimeCurrentAudioReference, &sClientTimeStamp);
+        if(err!=OMX_ErrorNone) {
+          DEBUG(DEB_LEV_ERR,"Error %08x In OMX_SetConfig in func=%s \n",err,__func__);
+        }
+     }
+     omx_alsasink_component_Private->xScale = pMediaTime->xScale;
+    } else if(pMediaTime->eUpdateType==OMX_TIME_UpdateClockStateChanged) {
+      omx_alsasink_component_Private->eState = pMediaTime->eState;
+    }
+    pClockPort->ReturnBufferFunction((omx_base_PortType*)pClockPort,clockBuffer);
+  }
+
   /* do not send the data to alsa and return back, if the clock is not running or the scale is anything but 1*/
   if(!(omx_alsasink_component_Private->eState==OMX_TIME_ClockStateRunning  && (omx_alsasink_component_Private->xScale>>16)==1)){
     inputbuffer->nFilledLen=0;
@@ -355,30 +484,6 @@ OMX_BOOL omx_alsasink_component_ClockPortHandleFunction(omx_alsasink_component_P
     return SendFrame;
   }
 
-  /* check for any scale change information from the clock component */
-  if(pClockPort->pBufferSem->semval>0){
-    tsem_down(pClockPort->pBufferSem);
-    if(pClockPort->pBufferQueue->nelem > 0) {
-      clockBuffer = dequeue(pClockPort->pBufferQueue);
-      pMediaTime  = (OMX_TIME_MEDIATIMETYPE*)clockBuffer->pBuffer;
-      if(pMediaTime->eUpdateType==OMX_TIME_UpdateScaleChanged) {
-       if(/*(omx_alsasink_component_Private->xScale>>16)==2 &&*/ (pMediaTime->xScale>>16)==1){ /* check with Q16 format only */
-             /* rebase the clock time base when turning to normal play mode*/
-          hclkComponent = pClockPort->hTunneledComponent;
-          setHeader(&sClientTimeStamp, sizeof(OMX_TIME_CONFIG_TIMESTAMPTYPE));
-          sClientTimeStamp.nPortIndex = pClockPort->nTunneledPort;
-          sClientTimeStamp.nTimestamp = inputbuffer->nTimeStamp;
-          err = OMX_SetConfig(hclkComponent, OMX_IndexConfigTimeCurrentAudioReference, &sClientTimeStamp);
-          if(err!=OMX_ErrorNone) {
-            DEBUG(DEB_LEV_ERR,"Error %08x In OMX_SetConfig in func=%s \n",err,__func__);
-          }
-       }
-       omx_alsasink_component_Private->xScale = pMediaTime->xScale;
-      }
-      pClockPort->ReturnBufferFunction((omx_base_PortType*)pClockPort,clockBuffer);
-    }
-  }
-
   count++;
   if(count==15) { //send request for every 15th frame
     count=0;
@@ -393,22 +498,23 @@ OMX_BOOL omx_alsasink_component_ClockPortHandleFunction(omx_alsasink_component_P
       if(err!=OMX_ErrorNone) {
        DEBUG(DEB_LEV_ERR,"Error %08x In OMX_SetConfig in func=%s \n",err,__func__);
       }
-      if(!PORT_IS_BEING_FLUSHED(pAudioPort) && !PORT_IS_BEING_FLUSHED(pClockPort) &&
-        omx_alsasink_component_Private->transientState != OMX_TransStateExecutingToIdle) {
-        tsem_down(pClockPort->pBufferSem); /* wait for the request fullfillment */
+      /* wait for the request fullfillment; one that comes later is returned with the notifications above */
+      if(omx_alsasink_component_ClockWait(omx_alsasink_component_Private, ALSASINK_CLOCK_REQUEST_TIMEOUT)) {
         if(pClockPort->pBufferQueue->nelem > 0) {
           clockBuffer = dequeue(pClockPort->pBufferQueue);
           pMediaTime  = (OMX_TIME_MEDIATIMETYPE*)clockBuffer->pBuffer;
           if(pMediaTime->eUpdateType==OMX_TIME_UpdateScaleChanged) {
             omx_alsasink_component_Private->xScale = pMediaTime->xScale;
           }
-          if(pMediaTime->eUpdateType==OMX_TIME_UpdateRequestFulfillment) {
-            if((pMediaTime->nOffset)>0) {
-              SendFrame = OMX_TRUE; /* as offset is >0 send the data to the device */
-            }
-            else {
-              SendFrame = OMX_FALSE; /* as offset is <0 do not send the data to the device */
-            }
+          if(pMediaTime->eUpdateType==OMX_TIME_UpdateClockStateChanged) {
+            omx_alsasink_component_Private->eState = pMediaTime->eState;
+          }
+          if(pMediaTime->eUpdateType==OMX_TIME_UpdateRequestFulfillment &&
+             pMediaTime->nOffset < -ALSASINK_RESYNC_THRESHOLD) {
+            /* the data is late: rather than drop the whole buffer, the late samples are trimmed when it is played */
+            DEBUG(DEB_LEV_SIMPLE_SEQ,"In %s buffer %lld late by %lld us\n", __func__,
+                  (long long)inputbuffer->nTimeStamp, (long long)-pMediaTime->nOffset);
+            omx_alsasink_component_RequestSync(omx_alsasink_component_Private);
           }
           pClockPort->ReturnBufferFunction((omx_base_PortType*)pClockPort,clockBuffer);
         }
@@ -419,6 +525,15 @@ OMX_BOOL omx_alsasink_component_ClockPortHandleFunction(omx_alsasink_component_P
   return(SendFrame);
 }
 
+/** Wakes the buffer management thread up if it is polling the PCM */
+static void omx_alsasink_component_Wakeup(omx_alsasink_component_PrivateType* omx_alsasink_component_Private) {
+  char c = 0;
+
+  if(write(omx_alsasink_component_Private->wakeup_fd[1], &c, 1) < 0 && errno != EAGAIN) {
+    DEBUG(DEB_LEV_ERR, "In %s cannot wake the buffer thread (%s)\n", __func__, strerror(errno));
+  }
+}
+
 /** @brief Releases buffers under processing.
  * This function must be implemented in the derived classes, for the
  * specific processing
@@ -452,12 +567,28 @@ OMX_ERRORTYPE omx_alsasink_component_port_FlushProcessingBuffers(omx_base_PortTy
     /* Wait until flush is completed */
     pthread_mutex_unlock(&omx_base_component_Private->flush_mutex);
 
+    /* the buffer thread may be polling the device */
+    omx_alsasink_component_Wakeup(omx_alsasink_component_Private);
+
     /*Dummy signal to clock port*/
     if(pClockPort->pBufferSem->semval == 0) {
       tsem_up(pClockPort->pBufferSem);
       tsem_reset(pClockPort->pBufferSem);
     }
     tsem_down(omx_base_component_Private->flush_all_condition);
+
+    /* the buffer thread is parked: discard what is queued in the device on a flush or a port disable.
+     * On the way to idle the device plays out what it holds, typically the end of the stream */
+    if(omx_alsasink_component_Private->transientState != OMX_TransStateExecutingToIdle) {
+      snd_pcm_drop(omx_alsasink_component_Private->playback_handle);
+      snd_pcm_prepare(omx_alsasink_component_Private->playback_handle);
+    }
+    omx_alsasink_component_Private->pPlayingBuffer = NULL;
+    omx_alsasink_component_Private->nPlayedBytes   = 0;
+    omx_alsasink_component_Private->nPadFrames     = 0;
+    omx_alsasink_component_Private->nDriftFrames   = 0;
+    /* playback restarts from an empty device: align the next buffer to the media time */
+    omx_alsasink_component_Private->bSyncPending   = OMX_TRUE;
   }
 
   tsem_reset(omx_base_component_Private->bMgmtSem);
@@ -524,16 +655,382 @@ OMX_ERRORTYPE omx_alsasink_component_port_FlushProcessingBuffers(omx_base_PortTy
   return OMX_ErrorNone;
 }
 
+/** Widens nSamples packed 24 bit samples to the 32 bit containers ALSA uses for S24/U24 */
+static void omx_alsasink_component_Widen24(omx_alsasink_component_PrivateType* omx_alsasink_component_Private,
+  OMX_U8* dest, const OMX_U8* src, OMX_U32 nSamples) {
+  OMX_U8 fill;
+
+  if(omx_alsasink_component_Private->sPCMModeParam.eEndian == OMX_EndianLittle) {
+    while(nSamples--) {
+      fill = (omx_alsasink_component_Private->sPCMModeParam.eNumData == OMX_NumericalDataSigned && (src[2] & 0x80)) ? 0xff : 0;
+      dest[0] = src[0];
+      dest[1] = src[1];
+      dest[2] = src[2];
+      dest[3] = fill;
+      dest += 4;
+      src  += 3;
+    }
+  } else {
+    while(nSamples--) {
+      fill = (omx_alsasink_component_Private->sPCMModeParam.eNumData == OMX_NumericalDataSigned && (src[0] & 0x80)) ? 0xff : 0;
+      dest[0] = fill;
+      dest[1] = src[0];
+      dest[2] = src[1];
+      dest[3] = src[2];
+      dest += 4;
+      src  += 3;
+    }
+  }
+}
+
+/** Copies nFrames frames of the input buffer into the mmap area at the given offset.
+ * Packed 24 bit samples are widened to the 32 bit containers ALSA uses for S24/U24.
+ */
+static void omx_alsasink_component_CopyToArea(omx_alsasink_component_PrivateType* omx_alsasink_component_Private,
+  const snd_pcm_channel_area_t* area, snd_pcm_uframes_t offset, const OMX_U8* src, snd_pcm_uframes_t nFrames, OMX_U32 frameSize) {
+  OMX_U8* dest = (OMX_U8*)area->addr + ((area->first + offset * area->step) >> 3);
+
+  if(area->step == frameSize * 8) {
+    memcpy(dest, src, nFrames * frameSize);
+    return;
+  }
+  if(omx_alsasink_component_Private->sPCMModeParam.nBitPerSample != 24 ||
+     area->step != omx_alsasink_component_Private->sPCMModeParam.nChannels * 32) {
+    DEBUG(DEB_LEV_ERR, "In %s unsupported mmap frame layout step=%d frame size=%d\n", __func__, (int)area->step, (int)frameSize);
+    memset(dest, 0, (nFrames * area->step) >> 3);
+    return;
+  }
+  omx_alsasink_component_Widen24(omx_alsasink_component_Private, dest, src, nFrames * omx_alsasink_component_Private->sPCMModeParam.nChannels);
+}
+
+/** Writes at most nFrames frames straight into the ring buffer of an mmap interleaved PCM, without waiting.
+ * Returns the frames written, 0 when the ring buffer is full, or a negative ALSA error code
+ * when the stream could not be recovered.
+ */
+static snd_pcm_sframes_t omx_alsasink_component_MmapWrite(omx_alsasink_component_PrivateType* omx_alsasink_component_Private,
+  const OMX_U8* src, snd_pcm_uframes_t nFrames, OMX_U32 frameSize) {
+  snd_pcm_t*                   playback_handle = omx_alsasink_component_Private->playback_handle;
+  const snd_pcm_channel_area_t *areas;
+  snd_pcm_uframes_t            offset;
+  snd_pcm_uframes_t            size;
+  snd_pcm_uframes_t            written = 0;
+  snd_pcm_sframes_t            avail;
+  snd_pcm_sframes_t            committed;
+  int                          err;
+
+  while(written < nFrames) {
+    avail = snd_pcm_avail_update(playback_handle);
+    if(avail < 0) {
+      if(avail == -EPIPE) {
+        DEBUG(DEB_LEV_ERR, "ALSA Underrun..\n");
+      }
+      if((err = snd_pcm_recover(playback_handle, avail, 1)) < 0) {
+        return err;
+      }
+      continue;
+    }
+    if(avail == 0) {
+      /* the ring buffer is full: it must play even if the start threshold is not reached */
+      if(snd_pcm_state(playback_handle) == SND_PCM_STATE_PREPARED && (err = snd_pcm_start(playback_handle)) < 0) {
+        return err;
+      }
+      break;
+    }
+
+    size = nFrames - written;
+    if((err = snd_pcm_mmap_begin(playback_handle, &areas, &offset, &size)) < 0) {
+      if((err = snd_pcm_recover(playback_handle, err, 1)) < 0) {
+        return err;
+      }
+      continue;
+    }
+    omx_alsasink_component_CopyToArea(omx_alsasink_component_Private, &areas[0], offset, src, size, frameSize);
+    committed = snd_pcm_mmap_commit(playback_handle, offset, size);
+    if(committed < 0 || (snd_pcm_uframes_t)committed != size) {
+      if((err = snd_pcm_recover(playback_handle, committed >= 0 ? -EPIPE : committed, 1)) < 0) {
+        return err;
+      }
+      continue;
+    }
+    src     += size * frameSize;
+    written += size;
+  }
+
+  /* like snd_pcm_writei, play once the start threshold is queued */
+  if(snd_pcm_state(playback_handle) == SND_PCM_STATE_PREPARED &&
+     (avail = snd_pcm_avail_update(playback_handle)) >= 0 &&
+     omx_alsasink_component_Private->buffer_size - avail >= omx_alsasink_component_Private->start_threshold) {
+    if((err = snd_pcm_start(playback_handle)) < 0) {
+      return err;
+    }
+  }
+  return written;
+}
+
+/** Polls the PCM descriptors together with the wakeup pipe until the device has room for avail_min frames,
+ * or omx_alsasink_component_Wakeup is called.
+ */
+static void omx_alsasink_component_WaitPcm(omx_alsasink_component_PrivateType* omx_alsasink_component_Private) {
+  struct pollfd  fds[ALSASINK_MAX_POLL_FDS + 1];
+  unsigned short revents;
+  char           drain[16];
+  int            count;
+
+  count = snd_pcm_poll_descriptors_count(omx_alsasink_component_Private->playback_handle);
+  if(count < 0 || count > ALSASINK_MAX_POLL_FDS) {
+    count = ALSASINK_MAX_POLL_FDS;
+  }
+  fds[0].fd      = omx_alsasink_component_Private->wakeup_fd[0];
+  fds[0].events  = POLLIN;
+  fds[0].revents = 0;
+  count = snd_pcm_poll_descriptors(omx_alsasink_component_Private->playback_handle, &fds[1], count);
+
+  while(poll(fds, count + 1, -1) < 0) {
+    if(errno != EINTR) {
+      DEBUG(DEB_LEV_ERR, "In %s poll failed (%s)\n", __func__, strerror(errno));
+      return;
+    }
+  }
+  if(fds[0].revents & POLLIN) {
+    while(read(fds[0].fd, drain, sizeof(drain)) > 0);
+  }
+  /* errors show up as an xrun on the next write, where they are recovered */
+  snd_pcm_poll_descriptors_revents(omx_alsasink_component_Private->playback_handle, &fds[1], count, &revents);
+}
+
+/** Reads the media time of the clock component */
+static OMX_ERRORTYPE omx_alsasink_component_GetMediaTime(omx_alsasink_component_PrivateType* omx_alsasink_component_Private, OMX_TICKS* pMediaTime) {
+  omx_base_clock_PortType*      pClockPort = (omx_base_clock_PortType*)omx_alsasink_component_Private->ports[OMX_BASE_SINK_CLOCKPORT_INDEX];
+  OMX_TIME_CONFIG_TIMESTAMPTYPE sMediaTime;
+  OMX_ERRORTYPE                 err;
+
+  setHeader(&sMediaTime, sizeof(OMX_TIME_CONFIG_TIMESTAMPTYPE));
+  sMediaTime.nPortIndex = pClockPort->nTunneledPort;
+  err = OMX_GetConfig(pClockPort->hTunneledComponent, OMX_IndexConfigTimeCurrentMediaTime, &sMediaTime);
+  if(err != OMX_ErrorNone) {
+    DEBUG(DEB_LEV_ERR,"Error %08x In OMX_GetConfig in func=%s \n",err,__func__);
+    return err;
+  }
+  *pMediaTime = sMediaTime.nTimestamp;
+  return OMX_ErrorNone;
+}
+
+/** Tells whether playback follows the clock component: the clock port is tunneled and the clock runs at normal speed */
+static OMX_BOOL omx_alsasink_component_IsClockRunning(omx_alsasink_component_PrivateType* omx_alsasink_component_Private) {
+  omx_base_clock_PortType* pClockPort = (omx_base_clock_PortType*)omx_alsasink_component_Private->ports[OMX_BASE_SINK_CLOCKPORT_INDEX];
+
+  return (PORT_IS_TUNNELED(pClockPort) && PORT_IS_ENABLED(pClockPort) && omx_alsasink_component_Private->sPCMModeParam.nSamplingRate &&
+          omx_alsasink_component_Private->eState == OMX_TIME_ClockStateRunning && (omx_alsasink_component_Private->xScale>>16) == 1) ? OMX_TRUE : OMX_FALSE;
+}
+
+/** Sends the media time being played out to the clock component, as the audio reference.
+ * That is the time of the last frame written, minus the delay of the device, plus the
+ * time elapsed since the delay was measured. The same time is then compared with the media
+ * time: a small drift is corrected frame by frame while the next frames are written, a large
+ * one by aligning the next buffer. Done at most every ALSASINK_AUDIO_REFERENCE_INTERVAL.
+ */
+static void omx_alsasink_component_SyncToClock(omx_alsasink_component_PrivateType* omx_alsasink_component_Private, OMX_U32 frameSize) {
+  omx_base_clock_PortType*      pClockPort = (omx_base_clock_PortType*)omx_alsasink_component_Private->ports[OMX_BASE_SINK_CLOCKPORT_INDEX];
+  OMX_U32                       rate = omx_alsasink_component_Private->sPCMModeParam.nSamplingRate;
+  OMX_TIME_CONFIG_TIMESTAMPTYPE sRefTimeStamp;
+  snd_htimestamp_t              htstamp;
+  struct timeval                now;
+  OMX_S64                       nNow;
+  OMX_S64                       nWritten;
+  OMX_S64                       nDelay;
+  OMX_S64                       nAge = 0;
+  OMX_S64                       nDrift;
+  OMX_TICKS                     nMediaTime;
+  OMX_ERRORTYPE                 err;
+
+  if(!omx_alsasink_component_IsClockRunning(omx_alsasink_component_Private)) {
+    return;
+  }
+
+  gettimeofday(&now, NULL);
+  nNow = (OMX_S64)now.tv_sec * 1000000 + now.tv_usec;
+  if(nNow - omx_alsasink_component_Private->nLastReferenceTime < ALSASINK_AUDIO_REFERENCE_INTERVAL) {
+    return;
+  }
+
+  if(snd_pcm_status(omx_alsasink_component_Private->playback_handle, omx_alsasink_component_Private->pcm_status) < 0 ||
+     snd_pcm_status_get_state(omx_alsasink_component_Private->pcm_status) != SND_PCM_STATE_RUNNING) {
+    return;
+  }
+  nDelay = snd_pcm_status_get_delay(omx_alsasink_component_Private->pcm_status);
+  /* the status timestamp is set to the clock of gettimeofday by SetSwTiming. An age outside
+   * the ring buffer duration means another clock (older alsa-lib) and is not used */
+  snd_pcm_status_get_htstamp(omx_alsasink_component_Private->pcm_status, &htstamp);
+  if(htstamp.tv_sec) {
+    nAge = nNow - ((OMX_S64)htstamp.tv_sec * 1000000 + htstamp.tv_nsec / 1000);
+    if(nAge < 0 || nAge > (OMX_S64)omx_alsasink_component_Private->buffer_size * 1000000 / rate) {
+      nAge = 0;
+    }
+  }
+
+  nWritten = omx_alsasink_component_Private->nPlayingTimeStamp +
+             (OMX_S64)(omx_alsasink_component_Private->nPlayedBytes / frameSize) * 1000000 / rate;
+
+  setHeader(&sRefTimeStamp, sizeof(OMX_TIME_CONFIG_TIMESTAMPTYPE));
+  sRefTimeStamp.nPortIndex = pClockPort->nTunneledPort;
+  sRefTimeStamp.nTimestamp = nWritten - nDelay * 1000000 / rate + nAge;
+  err = OMX_SetConfig(pClockPort->hTunneledComponent, OMX_IndexConfigTimeCurrentAudioReference, &sRefTimeStamp);
+  if(err != OMX_ErrorNone) {
+    DEBUG(DEB_LEV_ERR,"Error %08x In OMX_SetConfig in func=%s \n",err,__func__);
+  }
+  DEBUG(DEB_LEV_FULL_SEQ, "In %s audio reference %lld delay %d frames\n", __func__, (long long)sRefTimeStamp.nTimestamp, (int)nDelay);
+  omx_alsasink_component_Private->nLastReferenceTime = nNow;
+
+  /* when audio is not the reference clock, follow the media time */
+  if(omx_alsasink_component_GetMediaTime(omx_alsasink_component_Private, &nMediaTime) != OMX_ErrorNone) {
+    return;
+  }
+  nDrift = sRefTimeStamp.nTimestamp - nMediaTime;
+  if(nDrift > ALSASINK_RESYNC_THRESHOLD || nDrift < -ALSASINK_RESYNC_THRESHOLD) {
+    DEBUG(DEB_LEV_SIMPLE_SEQ, "In %s audio off the media time by %lld us, realigning\n", __func__, (long long)nDrift);
+    omx_alsasink_component_Private->bSyncPending = OMX_TRUE;
+    omx_alsasink_component_Private->nDriftFrames = 0;
+  } else if(nDrift > ALSASINK_DRIFT_THRESHOLD || nDrift < -ALSASINK_DRIFT_THRESHOLD) {
+    /* audio ahead of the media time gets frames inserted, audio behind gets frames dropped */
+    omx_alsasink_component_Private->nDriftFrames = (OMX_S32)(nDrift * rate / 1000000);
+  } else {
+    omx_alsasink_component_Private->nDriftFrames = 0;
+  }
+}
+
+/** Aligns a buffer played after a start, a seek or a large drift with the media time: the media time
+ * the buffer will be heard at is the current media time plus the delay of the device. A buffer that is
+ * early gets silence played before it, one that is late has its late frames skipped.
+ * Returns OMX_FALSE when the whole buffer is late.
+ */
+static OMX_BOOL omx_alsasink_component_AlignToClock(omx_alsasink_component_PrivateType* omx_alsasink_component_Private,
+  OMX_BUFFERHEADERTYPE* inputbuffer, OMX_U32 frameSize) {
+  OMX_U32           rate = omx_alsasink_component_Private->sPCMModeParam.nSamplingRate;
+  OMX_TICKS         nMediaTime;
+  OMX_S64           nOffset;
+  OMX_U64           nTrimFrames;
+  snd_pcm_sframes_t delay;
+
+  omx_alsasink_component_Private->bSyncPending = OMX_FALSE;
+  omx_alsasink_component_Private->nDriftFrames = 0;
+  if(omx_alsasink_component_GetMediaTime(omx_alsasink_component_Private, &nMediaTime) != OMX_ErrorNone) {
+    return OMX_TRUE;
+  }
+  if(snd_pcm_delay(omx_alsasink_component_Private->playback_handle, &delay) < 0 || delay < 0) {
+    delay = 0;
+  }
+
+  nOffset = inputbuffer->nTimeStamp - (nMediaTime + (OMX_S64)delay * 1000000 / rate);
+  if(nOffset > 0) {
+    if(nOffset > ALSASINK_MAX_SYNC_PAD) {
+      DEBUG(DEB_LEV_ERR, "In %s buffer %lld early by %lld us, played as is\n", __func__, (long long)inputbuffer->nTimeStamp, (long long)nOffset);
+      return OMX_TRUE;
+    }
+    omx_alsasink_component_Private->nPadFrames = (OMX_U32)(nOffset * rate / 1000000);
+  } else {
+    nTrimFrames = (OMX_U64)(-nOffset) * rate / 1000000;
+    if(nTrimFrames >= inputbuffer->nFilledLen / frameSize) {
+      /* try again with the next buffer */
+      omx_alsasink_component_Private->bSyncPending = OMX_TRUE;
+      return OMX_FALSE;
+    }
+    omx_alsasink_component_Private->nPlayedBytes = nTrimFrames * frameSize;
+  }
+  DEBUG(DEB_LEV_SIMPLE_SEQ, "In %s buffer %lld offset %lld us: %d frames of silence, %d frames skipped\n", __func__,
+    (long long)inputbuffer->nTimeStamp, (long long)nOffset,
+    (int)omx_alsasink_component_Private->nPadFrames, (int)(omx_alsasink_component_Private->nPlayedBytes / frameSize));
+  return OMX_TRUE;
+}
+
+/** Fills nFrames frames with silence in the format of the input port */
+static void omx_alsasink_component_FillSilence(omx_alsasink_component_PrivateType* omx_alsasink_component_Private,
+  OMX_U8* dest, OMX_U32 nFrames, OMX_U32 frameSize) {
+  OMX_U32 nBytes = omx_alsasink_component_Private->sPCMModeParam.nBitPerSample >> 3;
+  OMX_U32 i;
+
+  memset(dest, 0, nFrames * frameSize);
+  if(omx_alsasink_component_Private->sPCMModeParam.eNumData == OMX_NumericalDataUnsigned && nBytes) {
+    /* the silence of unsigned samples is the middle value: set the most significant bit */
+    i = (omx_alsasink_component_Private->sPCMModeParam.eEndian == OMX_EndianLittle) ? nBytes - 1 : 0;
+    for(; i < nFrames * frameSize; i += nBytes) {
+      dest[i] = 0x80;
+    }
+  }
+}
+
+/** Writes nFrames packed 24 bit frames with snd_pcm_writei, widened a bounce buffer at a time
+ * to the 32 bit containers of the PCM format. Returns the frames written, or the error of the
+ * first write when no frame could be written.
+ */
+static snd_pcm_sframes_t omx_alsasink_component_WriteWidened(omx_alsasink_component_PrivateType* omx_alsasink_component_Private,
+  const OMX_U8* src, snd_pcm_uframes_t nFrames, OMX_U32 frameSize) {
+  OMX_U32           nChannels = omx_alsasink_component_Private->sPCMModeParam.nChannels;
+  snd_pcm_uframes_t nChunkFrames = ALSASINK_BOUNCE_SIZE / (nChannels * 4);
+  snd_pcm_uframes_t written = 0;
+  snd_pcm_sframes_t chunk;
+  OMX_U8            bounce[ALSASINK_BOUNCE_SIZE];
+
+  while(written < nFrames) {
+    if(nChunkFrames > nFrames - written) {
+      nChunkFrames = nFrames - written;
+    }
+    omx_alsasink_component_Widen24(omx_alsasink_component_Private, bounce, src + written * frameSize, nChunkFrames * nChannels);
+    chunk = snd_pcm_writei(omx_alsasink_component_Private->playback_handle, bounce, nChunkFrames);
+    if(chunk < 0) {
+      return written ? (snd_pcm_sframes_t)written : chunk;
+    }
+    written += chunk;
+    if((snd_pcm_uframes_t)chunk < nChunkFrames) {
+      break;
+    }
+  }
+  return written;
+}
+
+/** Writes at most nFrames frames to the device, without waiting.
+ * Returns the frames written, 0 when the device is full, or a negative ALSA error code.
+ */
+static snd_pcm_sframes_t omx_alsasink_component_WriteFrames(omx_alsasink_component_PrivateType* omx_alsasink_component_Private,
+  const OMX_U8* src, snd_pcm_uframes_t nFrames, OMX_U32 frameSize) {
+  snd_pcm_t*        playback_handle = omx_alsasink_component_Private->playback_handle;
+  snd_pcm_sframes_t written;
+
+  if(omx_alsasink_component_Private->bMmapAccess) {
+    return omx_alsasink_component_MmapWrite(omx_alsasink_component_Private, src, nFrames, frameSize);
+  }
+  if(omx_alsasink_component_Private->bWiden24) {
+    written = omx_alsasink_component_WriteWidened(omx_alsasink_component_Private, src, nFrames, frameSize);
+  } else {
+    written = snd_pcm_writei(playback_handle, src, nFrames);
+  }
+  if(written == -EAGAIN) {
+    written = 0;
+  } else if(written < 0) {
+    if(written == -EPIPE){
+      DEBUG(DEB_LEV_ERR, "ALSA Underrun..\n");
+    }
+    written = snd_pcm_recover(playback_handle, written, 1);
+  }
+  return written;
+}
+
 /**
- * This function plays the input buffer. When fully consumed it returns.
+ * This function plays the input buffer. The PCM is non blocking: the function polls the device
+ * until the buffer is fully consumed, or returns early with the buffer partly played when the port
+ * is flushed or the component leaves the executing state. The base sink then calls it again
+ * with the same buffer, and playback resumes where it stopped.
+ * With a running clock, the buffer is aligned with the media time when needed, and the drift
+ * from the media time is corrected by writing a frame twice or skipping it.
  */
 void omx_alsasink_component_BufferMgmtCallback(OMX_COMPONENTTYPE *openmaxStandComp, OMX_BUFFERHEADERTYPE* inputbuffer) {
   OMX_U32                             frameSize;
-  OMX_S32                             written;
-  OMX_S32                             totalBuffer;
-  OMX_S32                             offsetBuffer;
-  OMX_BOOL                            allDataSent;
+  OMX_U32                             totalBuffer;
+  snd_pcm_uframes_t                   nFrames;
+  snd_pcm_sframes_t                   written;
+  OMX_U8                              silence[ALSASINK_SILENCE_SIZE];
   omx_alsasink_component_PrivateType* omx_alsasink_component_Private = openmaxStandComp->pComponentPrivate;
+  omx_base_PortType*                  pPort = omx_alsasink_component_Private->ports[OMX_BASE_SINK_INPUTPORT_INDEX];
+  snd_pcm_t*                          playback_handle = omx_alsasink_component_Private->playback_handle;
 
   /* Feed it to ALSA */
   frameSize = (omx_alsasink_component_Private->sPCMModeParam.nChannels * omx_alsasink_component_Private->sPCMModeParam.nBitPerSample) >> 3;
@@ -546,38 +1043,212 @@ void omx_alsasink_component_BufferMgmtCallback(OMX_COMPONENTTYPE *openmaxStandCo
     return;
   }
 
-  allDataSent = OMX_FALSE;
+  /* a buffer seen for the first time is played from its start */
+  if(omx_alsasink_component_Private->pPlayingBuffer != inputbuffer) {
+    omx_alsasink_component_Private->pPlayingBuffer    = inputbuffer;
+    omx_alsasink_component_Private->nPlayedBytes      = 0;
+    omx_alsasink_component_Private->nPlayingTimeStamp = inputbuffer->nTimeStamp;
+    omx_alsasink_component_TakeSyncRequest(omx_alsasink_component_Private);
+    if(omx_alsasink_component_Private->bSyncPending && omx_alsasink_component_IsClockRunning(omx_alsasink_component_Private) &&
+       !omx_alsasink_component_AlignToClock(omx_alsasink_component_Private, inputbuffer, frameSize)) {
+      DEBUG(DEB_LEV_SIMPLE_SEQ, "In %s dropping late buffer %lld\n", __func__, (long long)inputbuffer->nTimeStamp);
+      omx_alsasink_component_Private->pPlayingBuffer = NULL;
+      inputbuffer->nFilledLen = 0;
+      return;
+    }
+  }
+
+  if(snd_pcm_state(playback_handle) == SND_PCM_STATE_PAUSED) {
+    snd_pcm_pause(playback_handle, 0);
+  }
 
-  totalBuffer = inputbuffer->nFilledLen/frameSize;
-  offsetBuffer = 0;
-  while (!allDataSent) {
-//  DEBUG(DEB_LEV_ERR, "Writing to the device ..\n");
-    written = snd_pcm_writei(omx_alsasink_component_Private->playback_handle, inputbuffer->pBuffer + (offsetBuffer * frameSize), totalBuffer);
-    if (written < 0) {
-      if(written == -EPIPE){
-        DEBUG(DEB_LEV_ERR, "ALSA Underrun..\n");
-        snd_pcm_prepare(omx_alsasink_component_Private->playback_handle);
-        written = 0;
-      } else {
-        DEBUG(DEB_LEV_ERR, "Cannot send any data to the audio device %s (%s)\n", "default", snd_strerror (written));
-        DEBUG(DEB_LEV_ERR, "IB FilledLen=%d,totalBuffer=%d,frame size=%d,offset=%d\n",
-        (int)inputbuffer->nFilledLen, (int)totalBuffer, (int)frameSize, (int)offsetBuffer);
-        break;
-        return;
+  while((totalBuffer = (inputbuffer->nFilledLen - omx_alsasink_component_Private->nPlayedBytes) / frameSize) > 0) {
+    if(PORT_IS_BEING_FLUSHED(pPort) || omx_alsasink_component_Private->state != OMX_StateExecuting) {
+      /* keep the rest of the buffer, and stop the device while paused rather than let it underrun */
+      if(omx_alsasink_component_Private->state == OMX_StatePause && snd_pcm_state(playback_handle) == SND_PCM_STATE_RUNNING) {
+        snd_pcm_pause(playback_handle, 1);
       }
+      return;
     }
 
-    if(written != totalBuffer){
-      totalBuffer = totalBuffer - written;
-      offsetBuffer = written;
+    if(omx_alsasink_component_Private->nPadFrames > 0) {
+      /* silence that aligns the buffer with the media time goes first */
+      nFrames = ALSASINK_SILENCE_SIZE / frameSize;
+      if(nFrames > omx_alsasink_component_Private->nPadFrames) {
+        nFrames = omx_alsasink_component_Private->nPadFrames;
+      }
+      omx_alsasink_component_FillSilence(omx_alsasink_component_Private, silence, nFrames, frameSize);
+      written = omx_alsasink_component_WriteFrames(omx_alsasink_component_Private, silence, nFrames, frameSize);
+      if(written > 0) {
+        omx_alsasink_component_Private->nPadFrames -= written;
+      }
     } else {
-      DEBUG(DEB_LEV_FULL_SEQ, "Buffer successfully sent to ALSA. Length was %i\n", (int)inputbuffer->nFilledLen);
-      allDataSent = OMX_TRUE;
+      nFrames = totalBuffer;
+      if(omx_alsasink_component_Private->nDriftFrames != 0 && nFrames > ALSASINK_DRIFT_CORRECTION_SPACING) {
+        nFrames = ALSASINK_DRIFT_CORRECTION_SPACING;
+      }
+      written = omx_alsasink_component_WriteFrames(omx_alsasink_component_Private,
+        inputbuffer->pBuffer + inputbuffer->nOffset + omx_alsasink_component_Private->nPlayedBytes, nFrames, frameSize);
+      if(written > 0) {
+        omx_alsasink_component_Private->nPlayedBytes += written * frameSize;
+        if((snd_pcm_uframes_t)written == nFrames && nFrames < totalBuffer) {
+          if(omx_alsasink_component_Private->nDriftFrames > 0) {
+            /* write the last frame again */
+            omx_alsasink_component_Private->nPlayedBytes -= frameSize;
+            omx_alsasink_component_Private->nDriftFrames--;
+          } else if(omx_alsasink_component_Private->nDriftFrames < 0) {
+            /* skip the next frame */
+            omx_alsasink_component_Private->nPlayedBytes += frameSize;
+            omx_alsasink_component_Private->nDriftFrames++;
+          }
+        }
+        omx_alsasink_component_SyncToClock(omx_alsasink_component_Private, frameSize);
+      }
+    }
+    if(written < 0) {
+      DEBUG(DEB_LEV_ERR, "Cannot send any data to the audio device %s (%s)\n", "default", snd_strerror (written));
+      DEBUG(DEB_LEV_ERR, "IB FilledLen=%d,totalBuffer=%d,frame size=%d,offset=%d\n",
+        (int)inputbuffer->nFilledLen, (int)totalBuffer, (int)frameSize, (int)omx_alsasink_component_Private->nPlayedBytes);
+      break;
+    }
+    if((snd_pcm_uframes_t)written < nFrames) {
+      /* the device is full, wait for room or for a flush or state change */
+      omx_alsasink_component_WaitPcm(omx_alsasink_component_Private);
     }
   }
+
+  DEBUG(DEB_LEV_FULL_SEQ, "Buffer successfully sent to ALSA. Length was %i\n", (int)inputbuffer->nFilledLen);
+  omx_alsasink_component_Private->pPlayingBuffer = NULL;
   inputbuffer->nFilledLen=0;
 }
 
+/** Sets the requested period and buffer time into hw_params, before they are installed.
+ * The low latency profile takes precedence over the OMX_IndexVendorAlsaSinkPcmTiming values.
+ */
+static int omx_alsasink_component_SetHwTiming(omx_alsasink_component_PrivateType* omx_alsasink_component_Private) {
+  unsigned int period_time = omx_alsasink_component_Private->sPCMTiming.nPeriodTime;
+  unsigned int buffer_time = omx_alsasink_component_Private->sPCMTiming.nBufferTime;
+  int          err;
+
+  if(omx_alsasink_component_Private->bLowLatency) {
+    period_time = ALSASINK_LOW_LATENCY_PERIOD_TIME;
+    buffer_time = ALSASINK_LOW_LATENCY_BUFFER_TIME;
+  }
+  if(buffer_time) {
+    if ((err = snd_pcm_hw_params_set_buffer_time_near(omx_alsasink_component_Private->playback_handle, omx_alsasink_component_Private->hw_params, &buffer_time, 0)) < 0) {
+      DEBUG(DEB_LEV_ERR, "cannot set buffer time %u (%s)\n", buffer_time, snd_strerror (err));
+      return err;
+    }
+  }
+  if(period_time) {
+    if ((err = snd_pcm_hw_params_set_period_time_near(omx_alsasink_component_Private->playback_handle, omx_alsasink_component_Private->hw_params, &period_time, 0)) < 0) {
+      DEBUG(DEB_LEV_ERR, "cannot set period time %u (%s)\n", period_time, snd_strerror (err));
+      return err;
+    }
+  }
+  return 0;
+}
+
+/** Installs avail_min and start_threshold once the hw_params are set, zero keeps the ALSA default.
+ * Both are clamped to the buffer size. The low latency profile wakes up and starts playback after one period.
+ */
+static int omx_alsasink_component_SetSwTiming(omx_alsasink_component_PrivateType* omx_alsasink_component_Private) {
+  snd_pcm_t*           playback_handle = omx_alsasink_component_Private->playback_handle;
+  snd_pcm_sw_params_t* sw_params;
+  snd_pcm_uframes_t    avail_min = omx_alsasink_component_Private->sPCMTiming.nAvailMin;
+  snd_pcm_uframes_t    start_threshold = omx_alsasink_component_Private->sPCMTiming.nStartThreshold;
+  snd_pcm_uframes_t    period_size;
+  int                  err;
+
+  if ((err = snd_pcm_hw_params_get_buffer_size(omx_alsasink_component_Private->hw_params, &omx_alsasink_component_Private->buffer_size)) < 0) {
+    return err;
+  }
+  if(omx_alsasink_component_Private->bLowLatency) {
+    if ((err = snd_pcm_hw_params_get_period_size(omx_alsasink_component_Private->hw_params, &period_size, 0)) < 0) {
+      return err;
+    }
+    avail_min = period_size;
+    start_threshold = period_size;
+  }
+  /* a threshold above the buffer size is never reached: the PCM would not start and writes would wait for ever */
+  if(start_threshold > omx_alsasink_component_Private->buffer_size) {
+    start_threshold = omx_alsasink_component_Private->buffer_size;
+  }
+  if(avail_min > omx_alsasink_component_Private->buffer_size) {
+    avail_min = omx_alsasink_component_Private->buffer_size;
+  }
+
+  if ((err = snd_pcm_sw_params_malloc(&sw_params)) < 0) {
+    return err;
+  }
+  err = snd_pcm_sw_params_current(playback_handle, sw_params);
+  if (err >= 0 && avail_min) {
+    err = snd_pcm_sw_params_set_avail_min(playback_handle, sw_params, avail_min);
+  }
+  if (err >= 0 && start_threshold) {
+    err = snd_pcm_sw_params_set_start_threshold(playback_handle, sw_params, start_threshold);
+  }
+  if (err >= 0) {
+    /* the audio reference sent to the clock needs the time the delay was measured at */
+    err = snd_pcm_sw_params_set_tstamp_mode(playback_handle, sw_params, SND_PCM_TSTAMP_ENABLE);
+  }
+#if SND_LIB_VERSION >= 0x01001d
+  if (err >= 0) {
+    /* on the clock of gettimeofday, which SyncToClock compares it with */
+    err = snd_pcm_sw_params_set_tstamp_type(playback_handle, sw_params, SND_PCM_TSTAMP_TYPE_GETTIMEOFDAY);
+  }
+#endif
+  if (err >= 0) {
+    err = snd_pcm_sw_params(playback_handle, sw_params);
+  }
+  if (err >= 0) {
+    err = snd_pcm_sw_params_get_start_threshold(sw_params, &omx_alsasink_component_Private->start_threshold);
+  }
+  if (err < 0) {
+    DEBUG(DEB_LEV_ERR, "cannot set software parameters (%s)\n", snd_strerror (err));
+  }
+  snd_pcm_sw_params_free(sw_params);
+  return err;
+}
+
+/** Reads back the period, buffer, avail_min and start threshold the PCM is configured with */
+static int omx_alsasink_component_GetPcmTiming(omx_alsasink_component_PrivateType* omx_alsasink_component_Private, OMX_ALSASINK_PARAM_PCMTIMINGTYPE* pPCMTiming) {
+  snd_pcm_t*           playback_handle = omx_alsasink_component_Private->playback_handle;
+  snd_pcm_hw_params_t* hw_params;
+  snd_pcm_sw_params_t* sw_params;
+  snd_pcm_uframes_t    frames;
+  unsigned int         time;
+  int                  err;
+
+  if ((err = snd_pcm_hw_params_malloc(&hw_params)) < 0) {
+    return err;
+  }
+  if ((err = snd_pcm_sw_params_malloc(&sw_params)) < 0) {
+    snd_pcm_hw_params_free(hw_params);
+    return err;
+  }
+  /* the private hw_params are reset by every SetParameter, ask the PCM instead */
+  err = snd_pcm_hw_params_current(playback_handle, hw_params);
+  if (err >= 0 && (err = snd_pcm_hw_params_get_period_time(hw_params, &time, 0)) >= 0) {
+    pPCMTiming->nPeriodTime = time;
+  }
+  if (err >= 0 && (err = snd_pcm_hw_params_get_buffer_time(hw_params, &time, 0)) >= 0) {
+    pPCMTiming->nBufferTime = time;
+  }
+  if (err >= 0) {
+    err = snd_pcm_sw_params_current(playback_handle, sw_params);
+  }
+  if (err >= 0 && (err = snd_pcm_sw_params_get_avail_min(sw_params, &frames)) >= 0) {
+    pPCMTiming->nAvailMin = frames;
+  }
+  if (err >= 0 && (err = snd_pcm_sw_params_get_start_threshold(sw_params, &frames)) >= 0) {
+    pPCMTiming->nStartThreshold = frames;
+  }
+  snd_pcm_sw_params_free(sw_params);
+  snd_pcm_hw_params_free(hw_params);
+  return err;
+}
+
 OMX_ERRORTYPE omx_alsasink_component_SetParameter(
   OMX_HANDLETYPE hComponent,
   OMX_INDEXTYPE nParamIndex,
@@ -667,8 +1338,13 @@ OMX_ERRORTYPE omx_alsasink_component_SetParameter(
         return OMX_ErrorBadParameter;
       }
 
+      omx_alsasink_component_Private->bMmapAccess = OMX_FALSE;
       if(sPCMModeParam->bInterleaved == OMX_TRUE){
-        if ((err = snd_pcm_hw_params_set_access(playback_handle, hw_params, SND_PCM_ACCESS_RW_INTERLEAVED)) < 0) {
+        /* prefer writing straight into the ring buffer, fall back to snd_pcm_writei */
+        if ((err = snd_pcm_hw_params_set_access(playback_handle, hw_params, SND_PCM_ACCESS_MMAP_INTERLEAVED)) == 0) {
+          DEBUG(DEB_LEV_SIMPLE_SEQ, "Using mmap interleaved access\n");
+          omx_alsasink_component_Private->bMmapAccess = OMX_TRUE;
+        } else if ((err = snd_pcm_hw_params_set_access(playback_handle, hw_params, SND_PCM_ACCESS_RW_INTERLEAVED)) < 0) {
           DEBUG(DEB_LEV_ERR, "cannot set access type intrleaved (%s)\n", snd_strerror (err));
           return OMX_ErrorHardware;
         }
@@ -723,16 +1399,16 @@ OMX_ERRORTYPE omx_alsasink_component_SetParameter(
         case 24:
           if(sPCMModeParam->eNumData == OMX_NumericalDataSigned){
             if(sPCMModeParam->eEndian ==  OMX_EndianLittle) {
-              snd_pcm_format = SND_PCM_FORMAT_S24_LE;
+              snd_pcm_format = SND_PCM_FORMAT_S24_3LE;
             } else {
-              snd_pcm_format = SND_PCM_FORMAT_S24_BE;
+              snd_pcm_format = SND_PCM_FORMAT_S24_3BE;
             }
           }
           if(sPCMModeParam->eNumData == OMX_NumericalDataUnsigned){
             if(sPCMModeParam->eEndian ==  OMX_EndianLittle) {
-              snd_pcm_format = SND_PCM_FORMAT_U24_LE;
+              snd_pcm_format = SND_PCM_FORMAT_U24_3LE;
             } else {
-              snd_pcm_format = SND_PCM_FORMAT_U24_BE;
+              snd_pcm_format = SND_PCM_FORMAT_U24_3BE;
             }
           }
           break;
@@ -758,8 +1434,23 @@ OMX_ERRORTYPE omx_alsasink_component_SetParameter(
           break;
         }
 
+        omx_alsasink_component_Private->bWiden24 = OMX_FALSE;
         if(snd_pcm_format != SND_PCM_FORMAT_UNKNOWN){
-          if ((err = snd_pcm_hw_params_set_format(playback_handle, hw_params, snd_pcm_format)) < 0) {
+          err = snd_pcm_hw_params_set_format(playback_handle, hw_params, snd_pcm_format);
+          if (err < 0 && sPCMModeParam->nBitPerSample == 24) {
+            /* no packed 3 byte format: the samples are widened to the 32 bit containers */
+            switch(snd_pcm_format) {
+            case SND_PCM_FORMAT_S24_3LE: snd_pcm_format = SND_PCM_FORMAT_S24_LE; break;
+            case SND_PCM_FORMAT_S24_3BE: snd_pcm_format = SND_PCM_FORMAT_S24_BE; break;
+            case SND_PCM_FORMAT_U24_3LE: snd_pcm_format = SND_PCM_FORMAT_U24_LE; break;
+            default:                     snd_pcm_format = SND_PCM_FORMAT_U24_BE; break;
+            }
+            if ((err = snd_pcm_hw_params_set_format(playback_handle, hw_params, snd_pcm_format)) == 0) {
+              DEBUG(DEB_LEV_SIMPLE_SEQ, "Widening 24 bit samples to 32 bit containers\n");
+              omx_alsasink_component_Private->bWiden24 = OMX_TRUE;
+            }
+          }
+          if (err < 0) {
             DEBUG(DEB_LEV_ERR, "cannot set sample format (%s)\n",  snd_strerror (err));
             return OMX_ErrorHardware;
           }
@@ -785,6 +1476,10 @@ OMX_ERRORTYPE omx_alsasink_component_SetParameter(
         }
         memcpy(&omx_alsasink_component_Private->sPCMModeParam, ComponentParameterStructure, sizeof(OMX_AUDIO_PARAM_PCMMODETYPE));
       }
+      if (omx_alsasink_component_SetHwTiming(omx_alsasink_component_Private) < 0) {
+        return OMX_ErrorHardware;
+      }
+
       /** Configure and prepare the ALSA handle */
       DEBUG(DEB_LEV_SIMPLE_SEQ, "Configuring the PCM interface\n");
       if ((err = snd_pcm_hw_params (playback_handle, hw_params)) < 0) {
@@ -792,6 +1487,10 @@ OMX_ERRORTYPE omx_alsasink_component_SetParameter(
         return OMX_ErrorHardware;
       }
 
+      if (omx_alsasink_component_SetSwTiming(omx_alsasink_component_Private) < 0) {
+        return OMX_ErrorHardware;
+      }
+
       if ((err = snd_pcm_prepare (playback_handle)) < 0) {
         DEBUG(DEB_LEV_ERR, "cannot prepare audio interface for use (%s)\n", snd_strerror (err));
         return OMX_ErrorHardware;
@@ -807,6 +1506,34 @@ OMX_ERRORTYPE omx_alsasink_component_SetParameter(
       break;
     }
     break;
+  case OMX_IndexVendorAlsaSinkPcmTiming:
+  case OMX_IndexVendorAlsaSinkLowLatency:
+    {
+      OMX_AUDIO_PARAM_PCMMODETYPE sPCMModeParam;
+
+      if (nParamIndex == (OMX_INDEXTYPE)OMX_IndexVendorAlsaSinkPcmTiming) {
+        OMX_ALSASINK_PARAM_PCMTIMINGTYPE* pPCMTiming = (OMX_ALSASINK_PARAM_PCMTIMINGTYPE*)ComponentParameterStructure;
+        omxErr = omx_base_component_ParameterSanityCheck(hComponent, pPCMTiming->nPortIndex, pPCMTiming, sizeof(OMX_ALSASINK_PARAM_PCMTIMINGTYPE));
+        if(omxErr != OMX_ErrorNone) {
+          DEBUG(DEB_LEV_ERR, "In %s Parameter Check Error=%x\n", __func__, omxErr);
+          break;
+        }
+        memcpy(&omx_alsasink_component_Private->sPCMTiming, pPCMTiming, sizeof(OMX_ALSASINK_PARAM_PCMTIMINGTYPE));
+      } else {
+        OMX_CONFIG_BOOLEANTYPE* pLowLatency = (OMX_CONFIG_BOOLEANTYPE*)ComponentParameterStructure;
+        omxErr = omx_base_component_ParameterSanityCheck(hComponent, OMX_BASE_SINK_INPUTPORT_INDEX, pLowLatency, sizeof(OMX_CONFIG_BOOLEANTYPE));
+        if(omxErr != OMX_ErrorNone) {
+          DEBUG(DEB_LEV_ERR, "In %s Parameter Check Error=%x\n", __func__, omxErr);
+          break;
+        }
+        omx_alsasink_component_Private->bLowLatency = pLowLatency->bEnabled;
+      }
+
+      /* the timing is part of the hw_params, so the whole PCM is configured again */
+      memcpy(&sPCMModeParam, &omx_alsasink_component_Private->sPCMModeParam, sizeof(OMX_AUDIO_PARAM_PCMMODETYPE));
+      omxErr = omx_alsasink_component_SetParameter(hComponent, OMX_IndexParamAudioPcm, &sPCMModeParam);
+    }
+    break;
   default: /*Call the base component function*/
     return omx_base_component_SetParameter(hComponent, nParamIndex, ComponentParameterStructure);
   }
@@ -877,8 +1604,58 @@ OMX_ERRORTYPE omx_alsasink_component_GetParameter(
         return OMX_ErrorBadPortIndex;
       }
       break;
+  case OMX_IndexVendorAlsaSinkPcmTiming:
+    if ((err = checkHeader(ComponentParameterStructure, sizeof(OMX_ALSASINK_PARAM_PCMTIMINGTYPE))) != OMX_ErrorNone) {
+      break;
+    }
+    if (((OMX_ALSASINK_PARAM_PCMTIMINGTYPE*)ComponentParameterStructure)->nPortIndex != OMX_BASE_SINK_INPUTPORT_INDEX) {
+      return OMX_ErrorBadPortIndex;
+    }
+    if (omx_alsasink_component_GetPcmTiming(omx_alsasink_component_Private, (OMX_ALSASINK_PARAM_PCMTIMINGTYPE*)ComponentParameterStructure) < 0) {
+      return OMX_ErrorHardware;
+    }
+    break;
+  case OMX_IndexVendorAlsaSinkLowLatency:
+    if ((err = checkHeader(ComponentParameterStructure, sizeof(OMX_CONFIG_BOOLEANTYPE))) != OMX_ErrorNone) {
+      break;
+    }
+    ((OMX_CONFIG_BOOLEANTYPE*)ComponentParameterStructure)->bEnabled = omx_alsasink_component_Private->bLowLatency;
+    break;
   default: /*Call the base component function*/
   return omx_base_component_GetParameter(hComponent, nParamIndex, ComponentParameterStructure);
   }
   return err;
 }
+
+OMX_ERRORTYPE omx_alsasink_component_GetExtensionIndex(
+  OMX_HANDLETYPE hComponent,
+  OMX_STRING cParameterName,
+  OMX_INDEXTYPE* pIndexType) {
+
+  DEBUG(DEB_LEV_FUNCTION_NAME,"In  %s \n",__func__);
+
+  if(strcmp(cParameterName,ALSASINK_PCM_TIMING_EXTENSION) == 0) {
+    *pIndexType = OMX_IndexVendorAlsaSinkPcmTiming;
+  } else if(strcmp(cParameterName,ALSASINK_LOW_LATENCY_EXTENSION) == 0) {
+    *pIndexType = OMX_IndexVendorAlsaSinkLowLatency;
+  } else {
+    return omx_base_component_GetExtensionIndex(hComponent, cParameterName, pIndexType);
+  }
+  return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE omx_alsasink_component_MessageHandler(OMX_COMPONENTTYPE* openmaxStandComp,internalRequestMessageType *message) {
+  omx_alsasink_component_PrivateType* omx_alsasink_component_Private = (omx_alsasink_component_PrivateType*)openmaxStandComp->pComponentPrivate;
+  OMX_ERRORTYPE err;
+
+  DEBUG(DEB_LEV_FUNCTION_NAME, "In %s\n", __func__);
+
+  // Execute the base message handling
+  err = omx_base_component_MessageHandler(openmaxStandComp,message);
+
+  /* a buffer thread polling the device sees the new state at once, e.g. to pause it */
+  if (message->messageType == OMX_CommandStateSet) {
+    omx_alsasink_component_Wakeup(omx_alsasink_component_Private);
+  }
+  return err;
+}
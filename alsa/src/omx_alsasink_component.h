@@ -33,6 +33,68 @@
 #include <bellagio/omx_base_sink.h>
 #include <alsa/asoundlib.h>
 
+/**  Extension names of the PCM timing parameter and of the low latency profile */
+#define ALSASINK_PCM_TIMING_EXTENSION "OMX.ST.index.param.alsasink.pcmtiming"
+#define ALSASINK_LOW_LATENCY_EXTENSION "OMX.ST.index.param.alsasink.lowlatency"
+
+/**  Period and buffer time in microseconds of the low latency profile */
+#define ALSASINK_LOW_LATENCY_PERIOD_TIME 5000
+#define ALSASINK_LOW_LATENCY_BUFFER_TIME 15000
+
+/** Maximum number of PCM descriptors polled by the buffer thread */
+#define ALSASINK_MAX_POLL_FDS 8
+
+/** Interval in microseconds at which the played position is sent to the clock component as audio reference */
+#define ALSASINK_AUDIO_REFERENCE_INTERVAL 100000
+
+/** Longest waits in milliseconds for the clock component: for the clock to start after the start time
+  * is set, and for a media time request to be fulfilled. The waits check for flushes every ALSASINK_CLOCK_WAIT_SLICE
+  */
+#define ALSASINK_CLOCK_START_TIMEOUT 2000
+#define ALSASINK_CLOCK_REQUEST_TIMEOUT 1000
+#define ALSASINK_CLOCK_WAIT_SLICE 20
+
+/** Drift in microseconds of the played audio from the media time that is corrected by inserting or
+  * dropping single frames, and the drift beyond which the next buffer is realigned instead
+  */
+#define ALSASINK_DRIFT_THRESHOLD 2000
+#define ALSASINK_RESYNC_THRESHOLD 100000
+
+/** While the drift is corrected, one frame in ALSASINK_DRIFT_CORRECTION_SPACING is inserted or dropped */
+#define ALSASINK_DRIFT_CORRECTION_SPACING 500
+
+/** Longest silence in microseconds played to align a buffer with the media time */
+#define ALSASINK_MAX_SYNC_PAD 2000000
+
+/** Size in bytes of the silence played in one write */
+#define ALSASINK_SILENCE_SIZE 4096
+
+/** Size in bytes of the buffer packed 24 bit samples are widened into for snd_pcm_writei */
+#define ALSASINK_BOUNCE_SIZE 4096
+
+/** Vendor specific indexes of the alsa sink */
+typedef enum OMX_ALSASINK_INDEXVENDORTYPE {
+  OMX_IndexVendorAlsaSinkPcmTiming = OMX_IndexVendorStartUnused + 0x00d00400, /**< reference: OMX_ALSASINK_PARAM_PCMTIMINGTYPE */
+  OMX_IndexVendorAlsaSinkLowLatency                                           /**< reference: OMX_CONFIG_BOOLEANTYPE */
+} OMX_ALSASINK_INDEXVENDORTYPE;
+
+/** Device timing of the PCM, applied each time the PCM is configured.
+  * A zero field keeps the driver or ALSA default. GetParameter returns the values in use.
+  * @param nPeriodTime period time in microseconds
+  * @param nBufferTime ring buffer time in microseconds
+  * @param nAvailMin frames that must be free in the ring buffer before a blocked write wakes up
+  * @param nStartThreshold frames queued in the ring buffer before playback starts
+  */
+typedef struct OMX_ALSASINK_PARAM_PCMTIMINGTYPE {
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U32 nPortIndex;
+  OMX_U32 nPeriodTime;
+  OMX_U32 nBufferTime;
+  OMX_U32 nAvailMin;
+  OMX_U32 nStartThreshold;
+} OMX_ALSASINK_PARAM_PCMTIMINGTYPE;
+
 /** Alsasinkport component private structure.
  * see the define above
  * @param sPCMModeParam Audio PCM specific OpenMAX parameter
@@ -41,6 +103,23 @@
  * @param xScale the scale of the media clock
  * @param eState the state of the media clock
  * @param hw_params ALSA specif hardware parameters
+ * @param bMmapAccess the PCM uses mmap interleaved access and buffers are copied straight into the ring buffer
+ * @param bWiden24 the PCM has no packed 3 byte format: 24 bit samples are widened to the 32 bit containers of S24/U24
+ * @param sPCMTiming the requested PCM timing
+ * @param bLowLatency the low latency profile is used instead of sPCMTiming
+ * @param buffer_size ring buffer size in frames of the configured PCM
+ * @param start_threshold start threshold in frames of the configured PCM
+ * @param wakeup_fd pipe polled with the PCM, written to interrupt the buffer thread waiting for the device
+ * @param pPlayingBuffer the buffer being played, kept across calls of the buffer management callback
+ * @param nPlayedBytes bytes of pPlayingBuffer already written to the device
+ * @param nPlayingTimeStamp media time of the first frame of pPlayingBuffer
+ * @param nLastReferenceTime wall time in microseconds the audio reference was last sent to the clock
+ * @param pcm_status ALSA status, read for the delay of the device
+ * @param bSyncPending the next buffer played is aligned to the media time, by trimming its start or playing silence first
+ * @param nPadFrames frames of silence still to play before pPlayingBuffer
+ * @param nDriftFrames frames still to insert (positive) or drop (negative) to follow the media time
+ * @param bSyncRequested the clock port asks for bSyncPending; bSyncPending and nDriftFrames belong to the buffer thread
+ * @param sync_mutex protects bSyncRequested, set from the thread calling EmptyThisBuffer
  */
 DERIVEDCLASS(omx_alsasink_component_PrivateType, omx_base_sink_PrivateType)
 #define omx_alsasink_component_PrivateType_FIELDS omx_base_sink_PrivateType_FIELDS \
@@ -49,7 +128,24 @@ DERIVEDCLASS(omx_alsasink_component_PrivateType, omx_base_sink_PrivateType)
   snd_pcm_t*                   playback_handle;  \
   OMX_S32                      xScale; \
   OMX_TIME_CLOCKSTATE          eState; \
-  snd_pcm_hw_params_t*         hw_params;
+  snd_pcm_hw_params_t*         hw_params; \
+  OMX_BOOL                     bMmapAccess; \
+  OMX_BOOL                     bWiden24; \
+  OMX_ALSASINK_PARAM_PCMTIMINGTYPE sPCMTiming; \
+  OMX_BOOL                     bLowLatency; \
+  snd_pcm_uframes_t            buffer_size; \
+  snd_pcm_uframes_t            start_threshold; \
+  int                          wakeup_fd[2]; \
+  OMX_BUFFERHEADERTYPE*        pPlayingBuffer; \
+  OMX_U32                      nPlayedBytes; \
+  OMX_TICKS                    nPlayingTimeStamp; \
+  OMX_S64                      nLastReferenceTime; \
+  snd_pcm_status_t*            pcm_status; \
+  OMX_BOOL                     bSyncPending; \
+  OMX_U32                      nPadFrames; \
+  OMX_S32                      nDriftFrames; \
+  OMX_BOOL                     bSyncRequested; \
+  pthread_mutex_t              sync_mutex;
 ENDCLASS(omx_alsasink_component_PrivateType)
 
 /* Component private entry points declaration */
@@ -81,4 +177,11 @@ OMX_ERRORTYPE omx_alsasink_component_SetParameter(
 
 OMX_ERRORTYPE omx_alsasink_component_port_FlushProcessingBuffers(omx_base_PortType *openmaxStandPort);
 
+OMX_ERRORTYPE omx_alsasink_component_GetExtensionIndex(
+  OMX_HANDLETYPE hComponent,
+  OMX_STRING cParameterName,
+  OMX_INDEXTYPE* pIndexType);
+
+OMX_ERRORTYPE omx_alsasink_component_MessageHandler(OMX_COMPONENTTYPE*, internalRequestMessageType*);
+
 #endif
@@ -132,10 +132,16 @@ OMX_ERRORTYPE omx_alsasrc_component_Constructor(OMX_COMPONENTTYPE *openmaxStandC
 
   openmaxStandComp->SetParameter  = omx_alsasrc_component_SetParameter;
   openmaxStandComp->GetParameter  = omx_alsasrc_component_GetParameter;
+  openmaxStandComp->GetExtensionIndex = omx_alsasrc_component_GetExtensionIndex;
 
   /* Write in the default paramenters */
   omx_alsasrc_component_Private->AudioPCMConfigured  = 0;
 
+  /* driver defaults for the period and buffer sizes */
+  setHeader(&omx_alsasrc_component_Private->sPCMTiming, sizeof(OMX_ALSASRC_PARAM_PCMTIMINGTYPE));
+  omx_alsasrc_component_Private->sPCMTiming.nPortIndex = 0;
+  omx_alsasrc_component_Private->bLowLatency = OMX_FALSE;
+
   if (!omx_alsasrc_component_Private->AudioPCMConfigured) {
     DEBUG(DEB_LEV_SIMPLE_SEQ, "Configuring the PCM interface in the Init function\n");
     omxErr = omx_alsasrc_component_SetParameter(openmaxStandComp, OMX_IndexParamAudioPcm, &omx_alsasrc_component_Private->sPCMModeParam);
@@ -181,6 +187,7 @@ OMX_ERRORTYPE omx_alsasrc_component_Destructor(OMX_COMPONENTTYPE *openmaxStandCo
  */
 void omx_alsasrc_component_BufferMgmtCallback(OMX_COMPONENTTYPE *openmaxStandComp, OMX_BUFFERHEADERTYPE* outputbuffer) {
   OMX_U32  frameSize;
+  OMX_U32  nFrames;
   OMX_S32 data_read;
   omx_alsasrc_component_PrivateType* omx_alsasrc_component_Private = openmaxStandComp->pComponentPrivate;
 
@@ -194,13 +201,19 @@ void omx_alsasrc_component_BufferMgmtCallback(OMX_COMPONENTTYPE *openmaxStandCom
     return;
   }
 
-  data_read = snd_pcm_readi(omx_alsasrc_component_Private->playback_handle,outputbuffer->pBuffer,outputbuffer->nAllocLen/frameSize);
+  /* a full buffer can hold seconds of audio, the low latency profile hands out every period */
+  nFrames = outputbuffer->nAllocLen/frameSize;
+  if(omx_alsasrc_component_Private->bLowLatency && omx_alsasrc_component_Private->period_size && nFrames > omx_alsasrc_component_Private->period_size) {
+    nFrames = omx_alsasrc_component_Private->period_size;
+  }
+
+  data_read = snd_pcm_readi(omx_alsasrc_component_Private->playback_handle,outputbuffer->pBuffer,nFrames);
   if (data_read<0) {
     if (data_read !=-EPIPE){
       DEBUG(DEB_LEV_ERR,"alsa_card_read 1: snd_pcm_readi() failed:%s.\n",snd_strerror(data_read));
     }
     snd_pcm_prepare(omx_alsasrc_component_Private->playback_handle);
-    data_read=snd_pcm_readi(omx_alsasrc_component_Private->playback_handle,outputbuffer->pBuffer,outputbuffer->nAllocLen/frameSize);
+    data_read=snd_pcm_readi(omx_alsasrc_component_Private->playback_handle,outputbuffer->pBuffer,nFrames);
     if (data_read<0) {
       DEBUG(DEB_LEV_ERR,"alsa_card_read 2: snd_pcm_readi() failed:%s.\n",snd_strerror(data_read));
       return;
@@ -213,6 +226,109 @@ void omx_alsasrc_component_BufferMgmtCallback(OMX_COMPONENTTYPE *openmaxStandCom
 
 }
 
+/** Sets the requested period and buffer time into hw_params, before they are installed.
+ * The low latency profile takes precedence over the OMX_IndexVendorAlsaSrcPcmTiming values.
+ */
+static int omx_alsasrc_component_SetHwTiming(omx_alsasrc_component_PrivateType* omx_alsasrc_component_Private) {
+  unsigned int period_time = omx_alsasrc_component_Private->sPCMTiming.nPeriodTime;
+  unsigned int buffer_time = omx_alsasrc_component_Private->sPCMTiming.nBufferTime;
+  int          err;
+
+  if(omx_alsasrc_component_Private->bLowLatency) {
+    period_time = ALSASRC_LOW_LATENCY_PERIOD_TIME;
+    buffer_time = ALSASRC_LOW_LATENCY_BUFFER_TIME;
+  }
+  if(buffer_time) {
+    if ((err = snd_pcm_hw_params_set_buffer_time_near(omx_alsasrc_component_Private->playback_handle, omx_alsasrc_component_Private->hw_params, &buffer_time, 0)) < 0) {
+      DEBUG(DEB_LEV_ERR, "cannot set buffer time %u (%s)\n", buffer_time, snd_strerror (err));
+      return err;
+    }
+  }
+  if(period_time) {
+    if ((err = snd_pcm_hw_params_set_period_time_near(omx_alsasrc_component_Private->playback_handle, omx_alsasrc_component_Private->hw_params, &period_time, 0)) < 0) {
+      DEBUG(DEB_LEV_ERR, "cannot set period time %u (%s)\n", period_time, snd_strerror (err));
+      return err;
+    }
+  }
+  return 0;
+}
+
+/** Installs avail_min and start_threshold once the hw_params are set, zero keeps the ALSA default.
+ * The low latency profile wakes up a blocked read after one period.
+ */
+static int omx_alsasrc_component_SetSwTiming(omx_alsasrc_component_PrivateType* omx_alsasrc_component_Private) {
+  snd_pcm_t*           playback_handle = omx_alsasrc_component_Private->playback_handle;
+  snd_pcm_sw_params_t* sw_params;
+  snd_pcm_uframes_t    avail_min = omx_alsasrc_component_Private->sPCMTiming.nAvailMin;
+  snd_pcm_uframes_t    start_threshold = omx_alsasrc_component_Private->sPCMTiming.nStartThreshold;
+  int                  err;
+
+  if ((err = snd_pcm_hw_params_get_period_size(omx_alsasrc_component_Private->hw_params, &omx_alsasrc_component_Private->period_size, 0)) < 0) {
+    return err;
+  }
+  if(omx_alsasrc_component_Private->bLowLatency) {
+    avail_min = omx_alsasrc_component_Private->period_size;
+    start_threshold = 0;
+  }
+
+  if ((err = snd_pcm_sw_params_malloc(&sw_params)) < 0) {
+    return err;
+  }
+  err = snd_pcm_sw_params_current(playback_handle, sw_params);
+  if (err >= 0 && avail_min) {
+    err = snd_pcm_sw_params_set_avail_min(playback_handle, sw_params, avail_min);
+  }
+  if (err >= 0 && start_threshold) {
+    err = snd_pcm_sw_params_set_start_threshold(playback_handle, sw_params, start_threshold);
+  }
+  if (err >= 0) {
+    err = snd_pcm_sw_params(playback_handle, sw_params);
+  }
+  if (err < 0) {
+    DEBUG(DEB_LEV_ERR, "cannot set software parameters (%s)\n", snd_strerror (err));
+  }
+  snd_pcm_sw_params_free(sw_params);
+  return err;
+}
+
+/** Reads back the period, buffer, avail_min and start threshold the PCM is configured with */
+static int omx_alsasrc_component_GetPcmTiming(omx_alsasrc_component_PrivateType* omx_alsasrc_component_Private, OMX_ALSASRC_PARAM_PCMTIMINGTYPE* pPCMTiming) {
+  snd_pcm_t*           playback_handle = omx_alsasrc_component_Private->playback_handle;
+  snd_pcm_hw_params_t* hw_params;
+  snd_pcm_sw_params_t* sw_params;
+  snd_pcm_uframes_t    frames;
+  unsigned int         time;
+  int                  err;
+
+  if ((err = snd_pcm_hw_params_malloc(&hw_params)) < 0) {
+    return err;
+  }
+  if ((err = snd_pcm_sw_params_malloc(&sw_params)) < 0) {
+    snd_pcm_hw_params_free(hw_params);
+    return err;
+  }
+  /* the private hw_params are reset by every SetParameter, ask the PCM instead */
+  err = snd_pcm_hw_params_current(playback_handle, hw_params);
+  if (err >= 0 && (err = snd_pcm_hw_params_get_period_time(hw_params, &time, 0)) >= 0) {
+    pPCMTiming->nPeriodTime = time;
+  }
+  if (err >= 0 && (err = snd_pcm_hw_params_get_buffer_time(hw_params, &time, 0)) >= 0) {
+    pPCMTiming->nBufferTime = time;
+  }
+  if (err >= 0) {
+    err = snd_pcm_sw_params_current(playback_handle, sw_params);
+  }
+  if (err >= 0 && (err = snd_pcm_sw_params_get_avail_min(sw_params, &frames)) >= 0) {
+    pPCMTiming->nAvailMin = frames;
+  }
+  if (err >= 0 && (err = snd_pcm_sw_params_get_start_threshold(sw_params, &frames)) >= 0) {
+    pPCMTiming->nStartThreshold = frames;
+  }
+  snd_pcm_sw_params_free(sw_params);
+  snd_pcm_hw_params_free(hw_params);
+  return err;
+}
+
 OMX_ERRORTYPE omx_alsasrc_component_SetParameter(
   OMX_HANDLETYPE hComponent,
   OMX_INDEXTYPE nParamIndex,
@@ -409,6 +525,10 @@ OMX_ERRORTYPE omx_alsasrc_component_SetParameter(
         memcpy(&omx_alsasrc_component_Private->sPCMModeParam, ComponentParameterStructure, sizeof(OMX_AUDIO_PARAM_PCMMODETYPE));
       }
 
+      if (omx_alsasrc_component_SetHwTiming(omx_alsasrc_component_Private) < 0) {
+        return OMX_ErrorHardware;
+      }
+
       /** Configure and prepare the ALSA handle */
       DEBUG(DEB_LEV_SIMPLE_SEQ, "Configuring the PCM interface\n");
       if ((err = snd_pcm_hw_params (omx_alsasrc_component_Private->playback_handle, omx_alsasrc_component_Private->hw_params)) < 0) {
@@ -416,12 +536,44 @@ OMX_ERRORTYPE omx_alsasrc_component_SetParameter(
         return OMX_ErrorHardware;
       }
 
+      if (omx_alsasrc_component_SetSwTiming(omx_alsasrc_component_Private) < 0) {
+        return OMX_ErrorHardware;
+      }
+
       if ((err = snd_pcm_prepare (omx_alsasrc_component_Private->playback_handle)) < 0) {
         DEBUG(DEB_LEV_ERR, "cannot prepare audio interface for use (%s)\n", snd_strerror (err));
         return OMX_ErrorHardware;
       }
     }
     break;
+  case OMX_IndexVendorAlsaSrcPcmTiming:
+  case OMX_IndexVendorAlsaSrcLowLatency:
+    {
+      OMX_AUDIO_PARAM_PCMMODETYPE sPCMModeParam;
+
+      if (nParamIndex == (OMX_INDEXTYPE)OMX_IndexVendorAlsaSrcPcmTiming) {
+        OMX_ALSASRC_PARAM_PCMTIMINGTYPE* pPCMTiming = (OMX_ALSASRC_PARAM_PCMTIMINGTYPE*)ComponentParameterStructure;
+        omxErr = omx_base_component_ParameterSanityCheck(hComponent, pPCMTiming->nPortIndex, pPCMTiming, sizeof(OMX_ALSASRC_PARAM_PCMTIMINGTYPE));
+        if(omxErr != OMX_ErrorNone) {
+          DEBUG(DEB_LEV_ERR, "In %s Parameter Check Error=%x\n", __func__, omxErr);
+          break;
+        }
+        memcpy(&omx_alsasrc_component_Private->sPCMTiming, pPCMTiming, sizeof(OMX_ALSASRC_PARAM_PCMTIMINGTYPE));
+      } else {
+        OMX_CONFIG_BOOLEANTYPE* pLowLatency = (OMX_CONFIG_BOOLEANTYPE*)ComponentParameterStructure;
+        omxErr = omx_base_component_ParameterSanityCheck(hComponent, OMX_BASE_SOURCE_OUTPUTPORT_INDEX, pLowLatency, sizeof(OMX_CONFIG_BOOLEANTYPE));
+        if(omxErr != OMX_ErrorNone) {
+          DEBUG(DEB_LEV_ERR, "In %s Parameter Check Error=%x\n", __func__, omxErr);
+          break;
+        }
+        omx_alsasrc_component_Private->bLowLatency = pLowLatency->bEnabled;
+      }
+
+      /* the timing is part of the hw_params, so the whole PCM is configured again */
+      memcpy(&sPCMModeParam, &omx_alsasrc_component_Private->sPCMModeParam, sizeof(OMX_AUDIO_PARAM_PCMMODETYPE));
+      omxErr = omx_alsasrc_component_SetParameter(hComponent, OMX_IndexParamAudioPcm, &sPCMModeParam);
+    }
+    break;
   default: /*Call the base component function*/
     return omx_base_component_SetParameter(hComponent, nParamIndex, ComponentParameterStructure);
   }
@@ -471,8 +623,42 @@ OMX_ERRORTYPE omx_alsasrc_component_GetParameter(
     }
     memcpy(ComponentParameterStructure, &omx_alsasrc_component_Private->sPCMModeParam, sizeof(OMX_AUDIO_PARAM_PCMMODETYPE));
     break;
+  case OMX_IndexVendorAlsaSrcPcmTiming:
+    if ((err = checkHeader(ComponentParameterStructure, sizeof(OMX_ALSASRC_PARAM_PCMTIMINGTYPE))) != OMX_ErrorNone) {
+      break;
+    }
+    if (((OMX_ALSASRC_PARAM_PCMTIMINGTYPE*)ComponentParameterStructure)->nPortIndex != OMX_BASE_SOURCE_OUTPUTPORT_INDEX) {
+      return OMX_ErrorBadPortIndex;
+    }
+    if (omx_alsasrc_component_GetPcmTiming(omx_alsasrc_component_Private, (OMX_ALSASRC_PARAM_PCMTIMINGTYPE*)ComponentParameterStructure) < 0) {
+      return OMX_ErrorHardware;
+    }
+    break;
+  case OMX_IndexVendorAlsaSrcLowLatency:
+    if ((err = checkHeader(ComponentParameterStructure, sizeof(OMX_CONFIG_BOOLEANTYPE))) != OMX_ErrorNone) {
+      break;
+    }
+    ((OMX_CONFIG_BOOLEANTYPE*)ComponentParameterStructure)->bEnabled = omx_alsasrc_component_Private->bLowLatency;
+    break;
   default: /*Call the base component function*/
   return omx_base_component_GetParameter(hComponent, nParamIndex, ComponentParameterStructure);
   }
   return err;
 }
+
+OMX_ERRORTYPE omx_alsasrc_component_GetExtensionIndex(
+  OMX_HANDLETYPE hComponent,
+  OMX_STRING cParameterName,
+  OMX_INDEXTYPE* pIndexType) {
+
+  DEBUG(DEB_LEV_FUNCTION_NAME,"In  %s \n",__func__);
+
+  if(strcmp(cParameterName,ALSASRC_PCM_TIMING_EXTENSION) == 0) {
+    *pIndexType = OMX_IndexVendorAlsaSrcPcmTiming;
+  } else if(strcmp(cParameterName,ALSASRC_LOW_LATENCY_EXTENSION) == 0) {
+    *pIndexType = OMX_IndexVendorAlsaSrcLowLatency;
+  } else {
+    return omx_base_component_GetExtensionIndex(hComponent, cParameterName, pIndexType);
+  }
+  return OMX_ErrorNone;
+}
@@ -33,6 +33,37 @@
 #include <bellagio/omx_base_source.h>
 #include <alsa/asoundlib.h>
 
+/**  Extension names of the PCM timing parameter and of the low latency profile */
+#define ALSASRC_PCM_TIMING_EXTENSION "OMX.ST.index.param.alsasrc.pcmtiming"
+#define ALSASRC_LOW_LATENCY_EXTENSION "OMX.ST.index.param.alsasrc.lowlatency"
+
+/**  Period and buffer time in microseconds of the low latency profile */
+#define ALSASRC_LOW_LATENCY_PERIOD_TIME 5000
+#define ALSASRC_LOW_LATENCY_BUFFER_TIME 15000
+
+/** Vendor specific indexes of the alsa source */
+typedef enum OMX_ALSASRC_INDEXVENDORTYPE {
+  OMX_IndexVendorAlsaSrcPcmTiming = OMX_IndexVendorStartUnused + 0x00d00500, /**< reference: OMX_ALSASRC_PARAM_PCMTIMINGTYPE */
+  OMX_IndexVendorAlsaSrcLowLatency                                           /**< reference: OMX_CONFIG_BOOLEANTYPE */
+} OMX_ALSASRC_INDEXVENDORTYPE;
+
+/** Device timing of the PCM, applied each time the PCM is configured.
+  * A zero field keeps the driver or ALSA default. GetParameter returns the values in use.
+  * @param nPeriodTime period time in microseconds
+  * @param nBufferTime ring buffer time in microseconds
+  * @param nAvailMin frames that must be captured before a blocked read wakes up
+  * @param nStartThreshold frames requested by a read before capture starts
+  */
+typedef struct OMX_ALSASRC_PARAM_PCMTIMINGTYPE {
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U32 nPortIndex;
+  OMX_U32 nPeriodTime;
+  OMX_U32 nBufferTime;
+  OMX_U32 nAvailMin;
+  OMX_U32 nStartThreshold;
+} OMX_ALSASRC_PARAM_PCMTIMINGTYPE;
+
 /** Alsasrcport component private structure.
  * see the define above
  */
@@ -45,7 +76,13 @@ DERIVEDCLASS(omx_alsasrc_component_PrivateType, omx_base_source_PrivateType)
   /** @param playback_handle ALSA specific handle for audio player */  \
   snd_pcm_t* playback_handle;  \
   /** @param hw_params ALSA specific hardware parameters */  \
-  snd_pcm_hw_params_t* hw_params;
+  snd_pcm_hw_params_t* hw_params; \
+  /** @param sPCMTiming the requested PCM timing */  \
+  OMX_ALSASRC_PARAM_PCMTIMINGTYPE sPCMTiming; \
+  /** @param bLowLatency the low latency profile is used instead of sPCMTiming, and a buffer is filled with one period */  \
+  OMX_BOOL bLowLatency; \
+  /** @param period_size period size in frames of the configured PCM */  \
+  snd_pcm_uframes_t period_size;
 ENDCLASS(omx_alsasrc_component_PrivateType)
 
 /* Component private entry points declaration */
@@ -66,4 +103,9 @@ OMX_ERRORTYPE omx_alsasrc_component_SetParameter(
   OMX_INDEXTYPE nParamIndex,
   OMX_PTR ComponentParameterStructure);
 
+OMX_ERRORTYPE omx_alsasrc_component_GetExtensionIndex(
+  OMX_HANDLETYPE hComponent,
+  OMX_STRING cParameterName,
+  OMX_INDEXTYPE* pIndexType);
+
 #endif
@@ -0,0 +1,335 @@
+/**
+  test/omxalsasinksynctest.c
+
+  Clock synchronization test program of the OpenMAX ALSA sink component
+
+  This test program builds the ALSA sink with the PCM functions it uses
+  replaced by a fake device, and a fake clock component tunneled to its
+  clock port, so it runs on machines without a sound card. It checks the
+  alignment of a buffer with the media time, the audio reference and the
+  drift sent by SyncToClock, the frames inserted and dropped to correct
+  the drift, and the timed waits for the clock.
+
+  Copyright (C) 2007-2009  STMicroelectronics and Agere Systems
+
+  This library is free software; you can redistribute it and/or modify it under
+  the terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation; either version 2.1 of the License, or (at your option)
+  any later version.
+
+  This library is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+  FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin St, Fifth Floor, Boston, MA
+  02110-1301  USA
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "omxalsasinksynctest.h"
+
+/* The functions under test are static: the component is built into the test program */
+#include "omx_alsasink_component.c"
+
+static fakeDeviceType device;
+static omx_alsasink_component_PrivateType sinkPrivate;
+static OMX_COMPONENTTYPE sink;
+static omx_base_audio_PortType audioPort;
+static omx_base_clock_PortType clockPort;
+static omx_base_PortType* ports[2];
+static OMX_COMPONENTTYPE clockComponent;
+static tsem_t clockSem;
+static OMX_U8 data[SYNC_TEST_FRAMES * SYNC_TEST_FRAME_SIZE];
+static int failures;
+
+#define CHECK(condition) \
+  do { \
+    if (!(condition)) { \
+      printf("%s:%d check failed: %s\n", __FILE__, __LINE__, #condition); \
+      failures++; \
+    } \
+  } while (0)
+
+/* The fake device: always running, it takes every frame written and has a fixed delay */
+int snd_pcm_status(snd_pcm_t* pcm, snd_pcm_status_t* status) {
+  return 0;
+}
+
+snd_pcm_state_t snd_pcm_status_get_state(const snd_pcm_status_t* status) {
+  return SND_PCM_STATE_RUNNING;
+}
+
+snd_pcm_sframes_t snd_pcm_status_get_delay(const snd_pcm_status_t* status) {
+  return device.delay;
+}
+
+void snd_pcm_status_get_htstamp(const snd_pcm_status_t* status, snd_htimestamp_t* tstamp) {
+  /* no timestamp: the delay is taken as measured now */
+  tstamp->tv_sec = 0;
+  tstamp->tv_nsec = 0;
+}
+
+int snd_pcm_delay(snd_pcm_t* pcm, snd_pcm_sframes_t* delay) {
+  *delay = device.delay;
+  return 0;
+}
+
+snd_pcm_state_t snd_pcm_state(snd_pcm_t* pcm) {
+  return SND_PCM_STATE_RUNNING;
+}
+
+/* The left sample of a frame tells which frame of the test buffer it is, silence is 0 */
+snd_pcm_sframes_t snd_pcm_writei(snd_pcm_t* pcm, const void* buffer, snd_pcm_uframes_t size) {
+  const short* sample = buffer;
+  snd_pcm_uframes_t i;
+
+  for (i = 0; i < size; i++, sample += SYNC_TEST_CHANNELS) {
+    if (*sample) {
+      if (device.nFirstSound < 0) {
+        device.nFirstSound = device.nWritten;
+      }
+      device.nLastSample = *sample;
+    }
+    device.nWritten++;
+  }
+  return size;
+}
+
+/* The fake clock component */
+static OMX_ERRORTYPE clockSetConfig(OMX_HANDLETYPE hComponent, OMX_INDEXTYPE nIndex, OMX_PTR pConfig) {
+  if (nIndex == OMX_IndexConfigTimeCurrentAudioReference) {
+    device.nAudioReference = ((OMX_TIME_CONFIG_TIMESTAMPTYPE*) pConfig)->nTimestamp;
+    device.nReferences++;
+  }
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE clockGetConfig(OMX_HANDLETYPE hComponent, OMX_INDEXTYPE nIndex, OMX_PTR pConfig) {
+  if (nIndex != OMX_IndexConfigTimeCurrentMediaTime) {
+    return OMX_ErrorUnsupportedIndex;
+  }
+  ((OMX_TIME_CONFIG_TIMESTAMPTYPE*) pConfig)->nTimestamp = device.nMediaTime;
+  return OMX_ErrorNone;
+}
+
+static void setupSink() {
+  clockComponent.SetConfig = clockSetConfig;
+  clockComponent.GetConfig = clockGetConfig;
+  tsem_init(&clockSem, 0);
+  clockPort.hTunneledComponent = &clockComponent;
+  clockPort.nTunnelFlags = TUNNEL_ESTABLISHED;
+  clockPort.sPortParam.bEnabled = OMX_TRUE;
+  clockPort.pBufferSem = &clockSem;
+  ports[OMX_BASE_SINK_INPUTPORT_INDEX] = (omx_base_PortType*) &audioPort;
+  ports[OMX_BASE_SINK_CLOCKPORT_INDEX] = (omx_base_PortType*) &clockPort;
+
+  sinkPrivate.ports = ports;
+  sinkPrivate.state = OMX_StateExecuting;
+  sinkPrivate.eState = OMX_TIME_ClockStateRunning;
+  sinkPrivate.xScale = 1 << 16;
+  sinkPrivate.sPCMModeParam.nSamplingRate = SYNC_TEST_RATE;
+  sinkPrivate.sPCMModeParam.nChannels = SYNC_TEST_CHANNELS;
+  sinkPrivate.sPCMModeParam.nBitPerSample = 16;
+  sinkPrivate.sPCMModeParam.eNumData = OMX_NumericalDataSigned;
+  sinkPrivate.sPCMModeParam.eEndian = OMX_EndianLittle;
+  pthread_mutex_init(&sinkPrivate.sync_mutex, NULL);
+  sink.pComponentPrivate = &sinkPrivate;
+}
+
+/* Sets the frames queued in the device and the media time, and lets SyncToClock run at once */
+static void setClock(snd_pcm_sframes_t delay, OMX_TICKS nMediaTime) {
+  device.delay = delay;
+  device.nMediaTime = nMediaTime;
+  sinkPrivate.nLastReferenceTime = 0;
+}
+
+static OMX_S64 elapsedSince(struct timeval* start) {
+  struct timeval now;
+
+  gettimeofday(&now, NULL);
+  return (OMX_S64) (now.tv_sec - start->tv_sec) * 1000000 + now.tv_usec - start->tv_usec;
+}
+
+/* 100 ms of a buffer at 10 s are written, 50 ms of them still queued: 10.050 s are being played */
+static void testSyncToClock() {
+  sinkPrivate.nPlayingTimeStamp = SYNC_TEST_TIMESTAMP;
+  sinkPrivate.nPlayedBytes = SYNC_TEST_RATE / 10 * SYNC_TEST_FRAME_SIZE;
+
+  /* 5 ms ahead of the media time: 240 frames to insert */
+  setClock(SYNC_TEST_RATE / 20, SYNC_TEST_TIMESTAMP + 45000);
+  omx_alsasink_component_SyncToClock(&sinkPrivate, SYNC_TEST_FRAME_SIZE);
+  CHECK(device.nReferences == 1 && device.nAudioReference == SYNC_TEST_TIMESTAMP + 50000);
+  CHECK(sinkPrivate.nDriftFrames == 240 && !sinkPrivate.bSyncPending);
+
+  /* the audio reference is sent at most every ALSASINK_AUDIO_REFERENCE_INTERVAL */
+  omx_alsasink_component_SyncToClock(&sinkPrivate, SYNC_TEST_FRAME_SIZE);
+  CHECK(device.nReferences == 1);
+
+  /* 5 ms behind: 240 frames to drop */
+  setClock(SYNC_TEST_RATE / 20, SYNC_TEST_TIMESTAMP + 55000);
+  omx_alsasink_component_SyncToClock(&sinkPrivate, SYNC_TEST_FRAME_SIZE);
+  CHECK(sinkPrivate.nDriftFrames == -240);
+
+  /* within ALSASINK_DRIFT_THRESHOLD: nothing to correct */
+  setClock(SYNC_TEST_RATE / 20, SYNC_TEST_TIMESTAMP + 51000);
+  omx_alsasink_component_SyncToClock(&sinkPrivate, SYNC_TEST_FRAME_SIZE);
+  CHECK(sinkPrivate.nDriftFrames == 0 && !sinkPrivate.bSyncPending);
+
+  /* beyond ALSASINK_RESYNC_THRESHOLD: the next buffer is aligned */
+  setClock(SYNC_TEST_RATE / 20, SYNC_TEST_TIMESTAMP + 300000);
+  omx_alsasink_component_SyncToClock(&sinkPrivate, SYNC_TEST_FRAME_SIZE);
+  CHECK(sinkPrivate.nDriftFrames == 0 && sinkPrivate.bSyncPending);
+
+  /* the clock does not follow audio when paused or at another speed */
+  sinkPrivate.xScale = 2 << 16;
+  setClock(SYNC_TEST_RATE / 20, SYNC_TEST_TIMESTAMP);
+  omx_alsasink_component_SyncToClock(&sinkPrivate, SYNC_TEST_FRAME_SIZE);
+  CHECK(device.nReferences == 4);
+  sinkPrivate.xScale = 1 << 16;
+  printf("SyncToClock: audio reference %lld us, %d references sent\n", (long long) device.nAudioReference, device.nReferences);
+}
+
+static void testAlignToClock() {
+  OMX_BUFFERHEADERTYPE buffer;
+
+  memset(&buffer, 0, sizeof(buffer));
+  buffer.pBuffer = data;
+  buffer.nFilledLen = sizeof(data);
+  buffer.nTimeStamp = SYNC_TEST_TIMESTAMP;
+
+  /* 100 ms early: 4800 frames of silence first */
+  sinkPrivate.nPlayedBytes = 0;
+  sinkPrivate.nPadFrames = 0;
+  setClock(0, SYNC_TEST_TIMESTAMP - 100000);
+  CHECK(omx_alsasink_component_AlignToClock(&sinkPrivate, &buffer, SYNC_TEST_FRAME_SIZE));
+  CHECK(sinkPrivate.nPadFrames == 4800 && sinkPrivate.nPlayedBytes == 0 && !sinkPrivate.bSyncPending);
+
+  /* exactly on time once the 10 ms queued in the device are played */
+  sinkPrivate.nPadFrames = 0;
+  setClock(SYNC_TEST_RATE / 100, SYNC_TEST_TIMESTAMP - 10000);
+  CHECK(omx_alsasink_component_AlignToClock(&sinkPrivate, &buffer, SYNC_TEST_FRAME_SIZE));
+  CHECK(sinkPrivate.nPadFrames == 0 && sinkPrivate.nPlayedBytes == 0);
+
+  /* 10 ms late: the first 480 frames are skipped */
+  setClock(0, SYNC_TEST_TIMESTAMP + 10000);
+  CHECK(omx_alsasink_component_AlignToClock(&sinkPrivate, &buffer, SYNC_TEST_FRAME_SIZE));
+  CHECK(sinkPrivate.nPadFrames == 0 && sinkPrivate.nPlayedBytes == 480 * SYNC_TEST_FRAME_SIZE);
+
+  /* later than the whole buffer: dropped, and the next buffer is aligned */
+  sinkPrivate.nPlayedBytes = 0;
+  setClock(0, SYNC_TEST_TIMESTAMP + 200000);
+  CHECK(!omx_alsasink_component_AlignToClock(&sinkPrivate, &buffer, SYNC_TEST_FRAME_SIZE));
+  CHECK(sinkPrivate.bSyncPending);
+
+  /* too early to pad: played as is */
+  sinkPrivate.bSyncPending = OMX_FALSE;
+  setClock(0, SYNC_TEST_TIMESTAMP - ALSASINK_MAX_SYNC_PAD - 1000);
+  CHECK(omx_alsasink_component_AlignToClock(&sinkPrivate, &buffer, SYNC_TEST_FRAME_SIZE));
+  CHECK(sinkPrivate.nPadFrames == 0 && sinkPrivate.nPlayedBytes == 0);
+  printf("AlignToClock: padded, skipped and dropped buffers as expected\n");
+}
+
+/* Plays the test buffer, with SyncToClock kept from changing the drift to correct */
+static void playBuffer(OMX_BUFFERHEADERTYPE* buffer, OMX_S32 nDriftFrames) {
+  device.nWritten = 0;
+  device.nFirstSound = -1;
+  device.nLastSample = 0;
+  sinkPrivate.nDriftFrames = nDriftFrames;
+  sinkPrivate.nLastReferenceTime = (OMX_S64) 1 << 62;
+  sinkPrivate.pPlayingBuffer = NULL;
+  buffer->nFilledLen = sizeof(data);
+  omx_alsasink_component_BufferMgmtCallback(&sink, buffer);
+}
+
+static void testPlayback() {
+  OMX_BUFFERHEADERTYPE buffer;
+  int i;
+
+  memset(&buffer, 0, sizeof(buffer));
+  buffer.pBuffer = data;
+  buffer.nTimeStamp = SYNC_TEST_TIMESTAMP;
+  for (i = 0; i < SYNC_TEST_FRAMES; i++) {
+    ((short*) data)[SYNC_TEST_CHANNELS * i] = i + 1;
+    ((short*) data)[SYNC_TEST_CHANNELS * i + 1] = i + 1;
+  }
+
+  /* 1000 frames early after a seek: the buffer is heard after 1000 frames of silence */
+  sinkPrivate.bSyncPending = OMX_TRUE;
+  device.delay = 0;
+  device.nMediaTime = SYNC_TEST_TIMESTAMP - 1000 * 1000000LL / SYNC_TEST_RATE - 1;
+  playBuffer(&buffer, 0);
+  CHECK(buffer.nFilledLen == 0 && device.nFirstSound == 1000 && device.nWritten == 1000 + SYNC_TEST_FRAMES);
+  printf("Aligned playback: %ld frames written, sound from frame %ld\n", device.nWritten, device.nFirstSound);
+
+  /* audio ahead: 2 frames written twice */
+  playBuffer(&buffer, 2);
+  CHECK(device.nWritten == SYNC_TEST_FRAMES + 2 && device.nLastSample == SYNC_TEST_FRAMES && sinkPrivate.nDriftFrames == 0);
+  printf("Drift insert: %ld frames written\n", device.nWritten);
+
+  /* audio behind: 3 frames skipped */
+  playBuffer(&buffer, -3);
+  CHECK(device.nWritten == SYNC_TEST_FRAMES - 3 && device.nLastSample == SYNC_TEST_FRAMES && sinkPrivate.nDriftFrames == 0);
+  printf("Drift drop: %ld frames written\n", device.nWritten);
+}
+
+static void* answerClock(void* arg) {
+  usleep(SYNC_TEST_ANSWER_DELAY * 1000);
+  tsem_up(&clockSem);
+  return NULL;
+}
+
+static void testClockWait() {
+  struct timeval start;
+  pthread_t answer;
+  OMX_S64 elapsed;
+
+  /* no answer: gives up after the timeout */
+  gettimeofday(&start, NULL);
+  CHECK(!omx_alsasink_component_ClockWait(&sinkPrivate, 100));
+  elapsed = elapsedSince(&start);
+  CHECK(elapsed >= 100000 && elapsed < 100000 + 5 * ALSASINK_CLOCK_WAIT_SLICE * 1000);
+  printf("ClockWait: timed out after %lld us\n", (long long) elapsed);
+
+  /* an answer ends the wait and is taken */
+  pthread_create(&answer, NULL, answerClock, NULL);
+  gettimeofday(&start, NULL);
+  CHECK(omx_alsasink_component_ClockWait(&sinkPrivate, 1000));
+  elapsed = elapsedSince(&start);
+  pthread_join(answer, NULL);
+  CHECK(elapsed < 1000 * (SYNC_TEST_ANSWER_DELAY + 5 * ALSASINK_CLOCK_WAIT_SLICE) && clockSem.semval == 0);
+  printf("ClockWait: answered after %lld us\n", (long long) elapsed);
+
+  /* a flush ends the wait at once */
+  audioPort.bIsPortFlushed = OMX_TRUE;
+  gettimeofday(&start, NULL);
+  CHECK(!omx_alsasink_component_ClockWait(&sinkPrivate, 1000));
+  elapsed = elapsedSince(&start);
+  audioPort.bIsPortFlushed = OMX_FALSE;
+  CHECK(elapsed < ALSASINK_CLOCK_WAIT_SLICE * 1000);
+  printf("ClockWait: flushed after %lld us\n", (long long) elapsed);
+}
+
+int main(int argc, char** argv) {
+  setupSink();
+  testSyncToClock();
+  testAlignToClock();
+  testPlayback();
+  testClockWait();
+  tsem_deinit(&clockSem);
+
+  if (failures) {
+    printf("%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("All synchronization checks passed\n");
+  return 0;
+}
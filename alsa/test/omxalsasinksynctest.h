@@ -0,0 +1,70 @@
+/**
+  test/omxalsasinksynctest.h
+
+  Clock synchronization test program of the OpenMAX ALSA sink component
+
+  This test program builds the ALSA sink with the PCM functions it uses
+  replaced by a fake device, and a fake clock component tunneled to its
+  clock port, so it runs on machines without a sound card. It checks the
+  alignment of a buffer with the media time, the audio reference and the
+  drift sent by SyncToClock, the frames inserted and dropped to correct
+  the drift, and the timed waits for the clock.
+
+  Copyright (C) 2007-2009  STMicroelectronics and Agere Systems
+
+  This library is free software; you can redistribute it and/or modify it under
+  the terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation; either version 2.1 of the License, or (at your option)
+  any later version.
+
+  This library is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+  FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin St, Fifth Floor, Boston, MA
+  02110-1301  USA
+
+*/
+
+#include <OMX_Types.h>
+#include <OMX_Core.h>
+#include <OMX_Component.h>
+#include <OMX_Audio.h>
+
+#include <pthread.h>
+#include <alsa/asoundlib.h>
+
+#include <bellagio/tsemaphore.h>
+
+#include <omx_alsasink_component.h>
+
+/* Stereo 16 bit frames at 48 kHz */
+#define SYNC_TEST_RATE       48000
+#define SYNC_TEST_CHANNELS   2
+#define SYNC_TEST_FRAME_SIZE 4
+
+/* Frames of the test buffer */
+#define SYNC_TEST_FRAMES 8000
+
+/* Timestamp of the test buffer, in microseconds */
+#define SYNC_TEST_TIMESTAMP 10000000
+
+/* Delay in milliseconds before the clock answers a timed wait */
+#define SYNC_TEST_ANSWER_DELAY 30
+
+/* The fake device and the fake clock component */
+typedef struct fakeDeviceType {
+  /* frames queued in the device, as told by snd_pcm_delay and the status */
+  snd_pcm_sframes_t delay;
+  /* media time of the clock, the last audio reference it received and how many */
+  OMX_TICKS nMediaTime;
+  OMX_TICKS nAudioReference;
+  int nReferences;
+  /* frames written, the first one that is not silence and the last sample written */
+  long nWritten;
+  long nFirstSound;
+  short nLastSample;
+} fakeDeviceType;
@@ -33,6 +33,7 @@
 #define COMPONENT_NAME_BASE "OMX.st.video_decoder"
 #define BASE_ROLE "video_decoder.avc"
 #define COMPONENT_NAME_BASE_LEN 20
+#define LOWDELAY_EXTENSION "OMX.ST.index.config.videodec.lowdelay"
 
 /** global variables */
 OMX_COLOR_FORMATTYPE COLOR_CONV_OUT_RGB_FORMAT = OMX_COLOR_Format24bitRGB888;
@@ -88,6 +89,23 @@ int flagIsSinkRequested;
 int flagIsFormatRequested;
 int flagSetupTunnel;
 int flagIsXrequired;
+int flagIsLowDelayRequested;
+int flagIsLatencyRequested;
+
+/** input to output latency statistics, in microseconds */
+OMX_U32 nLatencyFrames = 0;
+OMX_S64 nLatencyMin = 0, nLatencyMax = 0, nLatencySum = 0;
+
+/** input buffers are stamped with their sequence number, and the time each one is emptied is kept
+  * so that output time stamps are checked as they come out of the decoder.
+  * Buffers are stamped from main and from EmptyBufferDone, and checked from FillBufferDone:
+  * stampMutex guards the table, which realloc moves
+  */
+OMX_S64 *pInputEmptyTime = NULL;
+OMX_U32 nInputStamps = 0, nInputStampsAlloc = 0;
+pthread_mutex_t stampMutex = PTHREAD_MUTEX_INITIALIZER;
+OMX_TICKS nLastOutputStamp = -1;
+OMX_U32 nTimeStampErrors = 0;
 
 static OMX_BOOL bEOS = OMX_FALSE;
 
@@ -101,6 +119,74 @@ static void setHeader(OMX_PTR header, OMX_U32 size) {
   ver->s.nStep = VERSIONSTEP;
 }
 
+/** current time in microseconds, used to measure the latency */
+static OMX_S64 getTimeUs() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (OMX_S64)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/** stamps an input buffer with the next sequence number and records the time it is emptied.
+  * The time stamps of the stream are only replaced when the latency is checked (-p)
+  */
+static void stampInputBuffer(OMX_BUFFERHEADERTYPE* pBuffer) {
+  OMX_S64* pGrown;
+
+  if(!flagIsLatencyRequested) {
+    return;
+  }
+  pthread_mutex_lock(&stampMutex);
+  if(nInputStamps == nInputStampsAlloc) {
+    pGrown = realloc(pInputEmptyTime, (nInputStampsAlloc + 256) * sizeof(OMX_S64));
+    if(!pGrown) {
+      DEBUG(DEB_LEV_ERR, "Out of memory recording the input time stamps\n");
+      exit(1);
+    }
+    pInputEmptyTime = pGrown;
+    nInputStampsAlloc += 256;
+  }
+  pInputEmptyTime[nInputStamps] = getTimeUs();
+  pBuffer->nTimeStamp = nInputStamps++;
+  pthread_mutex_unlock(&stampMutex);
+}
+
+/** checks the time stamp the decoder put on an output frame, and accounts its latency.
+  * It must be the stamp of an input buffer already emptied; in low delay mode frames come
+  * out in decoding order, so the stamps never go back
+  */
+static void checkOutputTimeStamp(OMX_BUFFERHEADERTYPE* pBuffer) {
+  OMX_TICKS nStamp = pBuffer->nTimeStamp;
+  OMX_S64 nEmptyTime;
+  OMX_S64 nLatency;
+
+  pthread_mutex_lock(&stampMutex);
+  if(nStamp < 0 || nStamp >= (OMX_TICKS)nInputStamps) {
+    pthread_mutex_unlock(&stampMutex);
+    DEBUG(DEB_LEV_ERR, "Frame %d carries time stamp %lld, which no input buffer had\n", (int)nLatencyFrames + 1, (long long)nStamp);
+    nTimeStampErrors++;
+    return;
+  }
+  nEmptyTime = pInputEmptyTime[nStamp];
+  pthread_mutex_unlock(&stampMutex);
+  if(flagIsLowDelayRequested && nStamp < nLastOutputStamp) {
+    DEBUG(DEB_LEV_ERR, "Frame %d of input buffer %lld comes after a frame of input buffer %lld in low delay mode\n",
+      (int)nLatencyFrames + 1, (long long)nStamp, (long long)nLastOutputStamp);
+    nTimeStampErrors++;
+  }
+  nLastOutputStamp = nStamp;
+
+  nLatency = getTimeUs() - nEmptyTime;
+  if(nLatencyFrames == 0 || nLatency < nLatencyMin) {
+    nLatencyMin = nLatency;
+  }
+  if(nLatencyFrames == 0 || nLatency > nLatencyMax) {
+    nLatencyMax = nLatency;
+  }
+  nLatencySum += nLatency;
+  nLatencyFrames++;
+  DEBUG(DEFAULT_MESSAGES, "Frame %d of input buffer %lld latency %lld us\n", (int)nLatencyFrames, (long long)nStamp, (long long)nLatency);
+}
+
 
 /** this function sets the color converter and video sink port characteristics
   * based on the video decoder output port settings
@@ -228,7 +314,7 @@ int find_resolution(char* searchname) {
 /** help display */
 void display_help() {
   printf("\n");
-  printf("Usage: omxvideodectest -o outfile [-t] [-c] [-h] [-f input_fmt] [-s] input_filename\n");
+  printf("Usage: omxvideodectest -o outfile [-t] [-c] [-h] [-f input_fmt] [-s] [-l] [-p] input_filename\n");
   printf("\n");
   printf("       -o outfile: If this option is specified, the output is written to user specified outfile\n");
   printf("                   Else, the output is written in the same directory of input file\n");
@@ -260,6 +346,14 @@ void display_help() {
   printf("       -x: If the rendering is selected the video is displayed in a xvideo window \n");
   printf("           instead of on the frame buffer\n");
   printf("\n");
+  printf("       -l: Low delay option - the decoder outputs each frame as soon as it is decoded\n");
+  printf("\n");
+  printf("       -p: Prints the latency of each decoded frame, from the time the input buffer\n");
+  printf("           carrying it is emptied to the time it is output, and a summary at the end\n");
+  printf("           Input buffers are stamped with their sequence number: the test fails if a\n");
+  printf("           frame comes out with a stamp no input buffer had, or, with -l, out of order\n");
+  printf("           N.B : Not available in the tunneled case\n");
+  printf("\n");
   exit(1);
 }
 
@@ -410,6 +504,8 @@ int main(int argc, char** argv) {
     flagIsSinkRequested = 0;
     flagIsFormatRequested = 0;
     flagIsXrequired = 0;
+    flagIsLowDelayRequested = 0;
+    flagIsLatencyRequested = 0;
 
     argn_dec = 1;
     while (argn_dec < argc) {
@@ -441,6 +537,12 @@ int main(int argc, char** argv) {
           case 'x' :
         	  flagIsXrequired = 1;
             break;
+          case 'l' :
+            flagIsLowDelayRequested = 1;
+            break;
+          case 'p' :
+            flagIsLatencyRequested = 1;
+            break;
           default:
             display_help();
         }
@@ -668,6 +770,26 @@ int main(int argc, char** argv) {
   }
   DEBUG(DEB_LEV_SIMPLE_SEQ, "The role currently set is %s\n", paramRole.cRole);
 
+  /** enabling the low delay mode of the video decoder, if specified */
+  if(flagIsLowDelayRequested) {
+    OMX_INDEXTYPE eIndexLowDelay;
+    OMX_CONFIG_BOOLEANTYPE sLowDelay;
+
+    err = OMX_GetExtensionIndex(appPriv->videodechandle, LOWDELAY_EXTENSION, &eIndexLowDelay);
+    if(err != OMX_ErrorNone) {
+      DEBUG(DEB_LEV_ERR, "The video decoder has no low delay mode err = %i\n", err);
+      exit(1);
+    }
+    setHeader(&sLowDelay, sizeof(OMX_CONFIG_BOOLEANTYPE));
+    sLowDelay.bEnabled = OMX_TRUE;
+    err = OMX_SetConfig(appPriv->videodechandle, eIndexLowDelay, &sLowDelay);
+    if(err != OMX_ErrorNone) {
+      DEBUG(DEB_LEV_ERR, "The low delay mode can not be set err = %i\n", err);
+      exit(1);
+    }
+    DEBUG(DEFAULT_MESSAGES, "Low delay decoding enabled\n");
+  }
+
   /** output buffer size calculation based on input dimension speculation */
   buffer_out_size = out_width * out_height * 10; //yuv420 format -- bpp = 12
   DEBUG(DEB_LEV_SIMPLE_SEQ, "\n buffer_out_size : %d \n", (int)buffer_out_size);
@@ -738,6 +860,7 @@ int main(int argc, char** argv) {
   data_read = fread(pInBuffer1->pBuffer, 1, buffer_in_size, fd);
   pInBuffer1->nFilledLen = data_read;
   pInBuffer1->nOffset = 0;
+  stampInputBuffer(pInBuffer1);
 
   /** in non tunneled case use the 2nd input buffer for input read and procesing
     * in tunneled case, it will be used afterwards
@@ -746,6 +869,7 @@ int main(int argc, char** argv) {
     data_read = fread(pInBuffer2->pBuffer, 1, buffer_in_size, fd);
     pInBuffer2->nFilledLen = data_read;
     pInBuffer2->nOffset = 0;
+    stampInputBuffer(pInBuffer2);
   }
 
   DEBUG(DEB_LEV_PARAMS, "Empty first  buffer %p\n", pInBuffer1->pBuffer);
@@ -842,12 +966,20 @@ int main(int argc, char** argv) {
     data_read = fread(pInBuffer2->pBuffer, 1, buffer_in_size, fd);
     pInBuffer2->nFilledLen = data_read;
     pInBuffer2->nOffset = 0;
+    stampInputBuffer(pInBuffer2);
     DEBUG(DEB_LEV_PARAMS, "Empty second buffer %p\n", pInBuffer2->pBuffer);
     err = OMX_EmptyThisBuffer(appPriv->videodechandle, pInBuffer2);
   }
   tsem_down(appPriv->eofSem);
 
   DEBUG(DEFAULT_MESSAGES, "The execution of the video decoding process is terminated\n");
+  if(flagIsLatencyRequested && nLatencyFrames > 0) {
+    DEBUG(DEFAULT_MESSAGES, "Latency over %d frames: min %lld us avg %lld us max %lld us\n", (int)nLatencyFrames,
+      (long long)nLatencyMin, (long long)(nLatencySum / nLatencyFrames), (long long)nLatencyMax);
+  }
+  if(flagIsLatencyRequested && nTimeStampErrors > 0) {
+    DEBUG(DEB_LEV_ERR, "%d output frames carry a wrong time stamp\n", (int)nTimeStampErrors);
+  }
 
   /** state change of all components from executing to idle */
   err = OMX_SendCommand(appPriv->videodechandle, OMX_CommandStateSet, OMX_StateIdle, NULL);
@@ -940,8 +1072,10 @@ int main(int argc, char** argv) {
   }
   /** closing the input file */
   fclose(fd);
+  free(pInputEmptyTime);
 
-  return 0;
+  /** a wrong output time stamp fails the test */
+  return (nTimeStampErrors > 0) ? 1 : 0;
 }
 
 
@@ -1348,6 +1482,7 @@ OMX_ERRORTYPE videodecEmptyBufferDone(
     return OMX_ErrorNone;
   }
   pBuffer->nFilledLen = data_read;
+  stampInputBuffer(pBuffer);
   if(!bEOS) {
     DEBUG(DEB_LEV_FULL_SEQ, "Empty buffer %p\n", pBuffer);
     err = OMX_EmptyThisBuffer(hComponent, pBuffer);
@@ -1367,6 +1502,10 @@ OMX_ERRORTYPE videodecFillBufferDone(
   OMX_STATETYPE eState;
 
   if(pBuffer != NULL) {
+    /** the decoder stamps each frame with the time stamp of the input buffer it was decoded from */
+    if(flagIsLatencyRequested && pBuffer->nFilledLen > 0) {
+      checkOutputTimeStamp(pBuffer);
+    }
     if(!bEOS) {
       /** if there is color conv component in processing state then send this buffer, in non tunneled case
         * else in non tunneled case, write the output buffer contents in the specified output file
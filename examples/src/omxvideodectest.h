@@ -31,6 +31,7 @@
 #include <string.h>
 #include <pthread.h>
 #include <ctype.h>
+#include <sys/time.h>
 
 #include <OMX_Core.h>
 #include <OMX_Component.h>
@@ -30,6 +30,8 @@
 #define COMPONENT_NAME_BASE "OMX.st.alsa.alsasrc"
 #define BASE_ROLE "alsa.alsasrc"
 #define COMPONENT_NAME_BASE_LEN 20
+#define LOWLATENCY_SRC_EXTENSION "OMX.ST.index.param.alsasrc.lowlatency"
+#define LOWLATENCY_SINK_EXTENSION "OMX.ST.index.param.alsasink.lowlatency"
 
 OMX_CALLBACKTYPE audiosrccallbacks = {
     .EventHandler = audiosrcEventHandler,
@@ -248,6 +250,29 @@ int main(int argc, char** argv) {
     }
   }
 
+  /** voice needs short device buffers, use the low latency profile of the alsa components when they have one */
+  {
+    OMX_INDEXTYPE eIndexLowLatency;
+    OMX_CONFIG_BOOLEANTYPE sLowLatency;
+
+    setHeader(&sLowLatency, sizeof(OMX_CONFIG_BOOLEANTYPE));
+    sLowLatency.bEnabled = OMX_TRUE;
+    err = OMX_GetExtensionIndex(appPriv->audiosrcHandle, LOWLATENCY_SRC_EXTENSION, &eIndexLowLatency);
+    if(err == OMX_ErrorNone) {
+      err = OMX_SetParameter(appPriv->audiosrcHandle, eIndexLowLatency, &sLowLatency);
+    }
+    if(err != OMX_ErrorNone) {
+      DEBUG(DEB_LEV_ERR, "The low latency profile can not be set in AlsaSrc err = %i\n", err);
+    }
+    err = OMX_GetExtensionIndex(appPriv->audiosinkHandle, LOWLATENCY_SINK_EXTENSION, &eIndexLowLatency);
+    if(err == OMX_ErrorNone) {
+      err = OMX_SetParameter(appPriv->audiosinkHandle, eIndexLowLatency, &sLowLatency);
+    }
+    if(err != OMX_ErrorNone) {
+      DEBUG(DEB_LEV_ERR, "The low latency profile can not be set in AlsaSink err = %i\n", err);
+    }
+  }
+
   /** if tunneling option is given then set up the tunnel between the components */
   DEBUG(DEFAULT_MESSAGES, "Setting up Tunnel\n");
   err = OMX_SetupTunnel(appPriv->audiosrcHandle, 0, appPriv->audioencHandle, 0);
@@ -28,6 +28,17 @@
 #include <bellagio/omxcore.h>
 #include <omx_fbdev_sink_component.h>
 #include <config.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+/** SSSE3 and AVX2 row blitters are built with a function target attribute and picked at run time */
+#define FBDEV_HAVE_SSSE3 1
+#define FBDEV_HAVE_AVX2 1
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+/** NEON row blitters are built when the target has NEON, so they need no run time check */
+#define FBDEV_HAVE_NEON 1
+#endif
 
 
 /** height offset - reqd tadjust the display position - at the centre of upper half of screen */
@@ -36,13 +47,7 @@
 #define FBDEV_SINK_COMP_ROLE "fbdev.fbdev_sink"
 
 /** we assume, frame rate = 25 fps ; so one frame processing time = 40000 us */
-static OMX_U32 nFrameProcessTime = 40000; // in micro second
-
-/** Counter of sink component instance*/
-static OMX_U32 nofbdev_sinkInstance=0;
-
-/** Maximum number of sink component instances */
-#define MAX_COMPONENT_FBDEVSINK 2
+#define FBDEV_SINK_FRAME_PROCESS_TIME 40000
 
 /** Returns a time value in milliseconds based on a clock starting at
  *  some arbitrary base. Given a call to GetTime that returns a value
@@ -87,11 +92,14 @@ OMX_ERRORTYPE omx_fbdev_sink_component_Constructor(OMX_COMPONENTTYPE *openmaxSta
   omx_fbdev_sink_component_Private->sPortTypesParam[OMX_PortDomainVideo].nStartPortNumber = 0;
   omx_fbdev_sink_component_Private->sPortTypesParam[OMX_PortDomainVideo].nPorts = 1;
 
+  omx_fbdev_sink_component_Private->sPortTypesParam[OMX_PortDomainOther].nStartPortNumber = 1;
+  omx_fbdev_sink_component_Private->sPortTypesParam[OMX_PortDomainOther].nPorts = 1;
+
   /** Allocate Ports and call port constructor. */
-  if (omx_fbdev_sink_component_Private->sPortTypesParam[OMX_PortDomainVideo].nPorts /*+
-       omx_fbdev_sink_component_Private->sPortTypesParam[OMX_PortDomainOther].nPorts)*/  && !omx_fbdev_sink_component_Private->ports) {
-    omx_fbdev_sink_component_Private->ports = calloc((omx_fbdev_sink_component_Private->sPortTypesParam[OMX_PortDomainVideo].nPorts /* +
-                                                      omx_fbdev_sink_component_Private->sPortTypesParam[OMX_PortDomainOther].nPorts*/), sizeof(omx_base_PortType *));
+  if ((omx_fbdev_sink_component_Private->sPortTypesParam[OMX_PortDomainVideo].nPorts +
+       omx_fbdev_sink_component_Private->sPortTypesParam[OMX_PortDomainOther].nPorts) && !omx_fbdev_sink_component_Private->ports) {
+    omx_fbdev_sink_component_Private->ports = calloc((omx_fbdev_sink_component_Private->sPortTypesParam[OMX_PortDomainVideo].nPorts +
+                                                      omx_fbdev_sink_component_Private->sPortTypesParam[OMX_PortDomainOther].nPorts), sizeof(omx_base_PortType *));
     if (!omx_fbdev_sink_component_Private->ports) {
       return OMX_ErrorInsufficientResources;
     }
@@ -100,6 +108,13 @@ OMX_ERRORTYPE omx_fbdev_sink_component_Constructor(OMX_COMPONENTTYPE *openmaxSta
       return OMX_ErrorInsufficientResources;
     }
     base_video_port_Constructor(openmaxStandComp, &omx_fbdev_sink_component_Private->ports[0], 0, OMX_TRUE);
+
+    omx_fbdev_sink_component_Private->ports[1] = calloc(1, sizeof(omx_base_clock_PortType));
+    if (!omx_fbdev_sink_component_Private->ports[1]) {
+      return OMX_ErrorInsufficientResources;
+    }
+    base_clock_port_Constructor(openmaxStandComp, &omx_fbdev_sink_component_Private->ports[1], 1, OMX_TRUE);
+    omx_fbdev_sink_component_Private->ports[1]->sPortParam.bEnabled = OMX_FALSE;
   }
 
   pPort = (omx_fbdev_sink_component_PortType *) omx_fbdev_sink_component_Private->ports[OMX_BASE_SINK_INPUTPORT_INDEX];
@@ -144,19 +159,44 @@ OMX_ERRORTYPE omx_fbdev_sink_component_Constructor(OMX_COMPONENTTYPE *openmaxSta
   pPort->omxConfigOutputPosition.nPortIndex = OMX_BASE_SINK_INPUTPORT_INDEX;
   pPort->omxConfigOutputPosition.nX = pPort->omxConfigOutputPosition.nY = 0; //Default: No shift in output position (0,0)
 
+  setHeader(&omx_fbdev_sink_component_Private->sLateThreshold, sizeof(OMX_FBDEV_SINK_CONFIG_LATETHRESHOLDTYPE));
+  omx_fbdev_sink_component_Private->sLateThreshold.nPortIndex = OMX_BASE_SINK_INPUTPORT_INDEX;
+  omx_fbdev_sink_component_Private->sLateThreshold.nLateThreshold = FBDEV_SINK_DEFAULT_LATE_THRESHOLD;
+
+  /** the media clock stays stopped until the clock component says otherwise */
+  omx_fbdev_sink_component_Private->eState = OMX_TIME_ClockStateStopped;
+  omx_fbdev_sink_component_Private->xScale = 1<<16;
+  omx_fbdev_sink_component_Private->last_frame_time = 0;
+  omx_fbdev_sink_component_Private->nFrameProcessTime = FBDEV_SINK_FRAME_PROCESS_TIME;
+
+  setHeader(&omx_fbdev_sink_component_Private->sDevice, sizeof(OMX_FBDEV_SINK_PARAM_DEVICETYPE));
+  omx_fbdev_sink_component_Private->sDevice.nPortIndex = OMX_BASE_SINK_INPUTPORT_INDEX;
+  strcpy((char*) omx_fbdev_sink_component_Private->sDevice.cDeviceName, FBDEV_FILENAME);
+  omx_fbdev_sink_component_Private->sDevice.nWidth = 0;
+  omx_fbdev_sink_component_Private->sDevice.nHeight = 0;
+  omx_fbdev_sink_component_Private->sDevice.eColorFormat = OMX_COLOR_FormatUnused;
+
   /** set the function pointers */
   omx_fbdev_sink_component_Private->destructor = omx_fbdev_sink_component_Destructor;
   omx_fbdev_sink_component_Private->BufferMgmtCallback = omx_fbdev_sink_component_BufferMgmtCallback;
   pPort->Port_SendBufferFunction = omx_fbdev_sink_component_port_SendBufferFunction;
-//  pPort->FlushProcessingBuffers  = omx_fbdev_sink_component_port_FlushProcessingBuffers;
+  pPort->FlushProcessingBuffers  = omx_fbdev_sink_component_port_FlushProcessingBuffers;
+  pPort->Port_AllocateBuffer = omx_fbdev_sink_component_port_AllocateBuffer;
+  pPort->Port_FreeBuffer = omx_fbdev_sink_component_port_FreeBuffer;
+  pPort->ReturnBufferFunction = omx_fbdev_sink_component_port_ReturnBufferFunction;
   openmaxStandComp->SetParameter = omx_fbdev_sink_component_SetParameter;
   openmaxStandComp->GetParameter = omx_fbdev_sink_component_GetParameter;
+  openmaxStandComp->SetConfig = omx_fbdev_sink_component_SetConfig;
+  openmaxStandComp->GetConfig = omx_fbdev_sink_component_GetConfig;
+  openmaxStandComp->GetExtensionIndex = omx_fbdev_sink_component_GetExtensionIndex;
   omx_fbdev_sink_component_Private->messageHandler = omx_fbdev_sink_component_MessageHandler;
 
-  nofbdev_sinkInstance++;
-  if(nofbdev_sinkInstance > MAX_COMPONENT_FBDEVSINK) {
-    DEBUG(DEB_LEV_ERR, "Reached Max Instances %d\n",(int)nofbdev_sinkInstance);
-    return OMX_ErrorInsufficientResources;
+  if(!omx_fbdev_sink_component_Private->fbdevSyncSem) {
+    omx_fbdev_sink_component_Private->fbdevSyncSem = calloc(1,sizeof(tsem_t));
+    if(omx_fbdev_sink_component_Private->fbdevSyncSem == NULL) {
+      return OMX_ErrorInsufficientResources;
+    }
+    tsem_init(omx_fbdev_sink_component_Private->fbdevSyncSem, 0);
   }
 
   return err;
@@ -179,8 +219,13 @@ OMX_ERRORTYPE omx_fbdev_sink_component_Destructor(OMX_COMPONENTTYPE *openmaxStan
     omx_fbdev_sink_component_Private->ports=NULL;
   }
 
+  if(omx_fbdev_sink_component_Private->fbdevSyncSem) {
+    tsem_deinit(omx_fbdev_sink_component_Private->fbdevSyncSem);
+    free(omx_fbdev_sink_component_Private->fbdevSyncSem);
+    omx_fbdev_sink_component_Private->fbdevSyncSem = NULL;
+  }
+
   omx_base_sink_Destructor(openmaxStandComp);
-  nofbdev_sinkInstance--;
 
   return OMX_ErrorNone;
 }
@@ -191,6 +236,276 @@ OMX_S32 calcStride2(omx_fbdev_sink_component_PrivateType* omx_fbdev_sink_compone
   stride = omx_fbdev_sink_component_Private->fscr_info.line_length;
   return stride;
 }
+/** Sets up the screen a regular file stands in for, as described by sDevice
+  */
+static OMX_ERRORTYPE omx_fbdev_sink_component_SetupFileScreen(omx_fbdev_sink_component_PrivateType* omx_fbdev_sink_component_Private,
+                                                              omx_fbdev_sink_component_PortType* pPort) {
+  struct fb_var_screeninfo* vscr_info = &omx_fbdev_sink_component_Private->file_vscr_info;
+  struct fb_fix_screeninfo* fscr_info = &omx_fbdev_sink_component_Private->file_fscr_info;
+  struct stat file_stat;
+
+  memset(vscr_info, 0, sizeof(struct fb_var_screeninfo));
+  memset(fscr_info, 0, sizeof(struct fb_fix_screeninfo));
+  vscr_info->xres = omx_fbdev_sink_component_Private->sDevice.nWidth;
+  if (vscr_info->xres == 0) {
+    vscr_info->xres = pPort->sPortParam.format.video.nFrameWidth;
+  }
+  vscr_info->yres = omx_fbdev_sink_component_Private->sDevice.nHeight;
+  if (vscr_info->yres == 0) {
+    vscr_info->yres = pPort->sPortParam.format.video.nFrameHeight + HEIGHT_OFFSET;
+  }
+  switch (omx_fbdev_sink_component_Private->sDevice.eColorFormat) {
+    case OMX_COLOR_Format16bitRGB565:
+      vscr_info->bits_per_pixel = 16;
+      vscr_info->red.offset = 11; vscr_info->red.length = 5;
+      vscr_info->green.offset = 5; vscr_info->green.length = 6;
+      vscr_info->blue.offset = 0; vscr_info->blue.length = 5;
+      break;
+    case OMX_COLOR_Format16bitBGR565:
+      vscr_info->bits_per_pixel = 16;
+      vscr_info->red.offset = 0; vscr_info->red.length = 5;
+      vscr_info->green.offset = 5; vscr_info->green.length = 6;
+      vscr_info->blue.offset = 11; vscr_info->blue.length = 5;
+      break;
+    case OMX_COLOR_Format16bitARGB1555:
+      vscr_info->bits_per_pixel = 16;
+      vscr_info->transp.offset = 15; vscr_info->transp.length = 1;
+      vscr_info->red.offset = 10; vscr_info->red.length = 5;
+      vscr_info->green.offset = 5; vscr_info->green.length = 5;
+      vscr_info->blue.offset = 0; vscr_info->blue.length = 5;
+      break;
+    case OMX_COLOR_Format24bitRGB888:
+      vscr_info->bits_per_pixel = 24;
+      vscr_info->red.offset = 16; vscr_info->red.length = 8;
+      vscr_info->green.offset = 8; vscr_info->green.length = 8;
+      vscr_info->blue.offset = 0; vscr_info->blue.length = 8;
+      break;
+    case OMX_COLOR_FormatUnused:
+    case OMX_COLOR_Format32bitARGB8888:
+      vscr_info->bits_per_pixel = 32;
+      vscr_info->transp.offset = 24; vscr_info->transp.length = 8;
+      vscr_info->red.offset = 16; vscr_info->red.length = 8;
+      vscr_info->green.offset = 8; vscr_info->green.length = 8;
+      vscr_info->blue.offset = 0; vscr_info->blue.length = 8;
+      break;
+    default:
+      DEBUG(DEB_LEV_ERR, "In %s screen format %x cannot be emulated\n", __func__, (int)omx_fbdev_sink_component_Private->sDevice.eColorFormat);
+      return OMX_ErrorUnsupportedSetting;
+  }
+  vscr_info->xres_virtual = vscr_info->xres;
+  fscr_info->line_length = vscr_info->xres * vscr_info->bits_per_pixel / 8;
+  fscr_info->ypanstep = 1;
+  fscr_info->type = FB_TYPE_PACKED_PIXELS;
+  fscr_info->visual = FB_VISUAL_TRUECOLOR;
+  strncpy(fscr_info->id, "file", sizeof(fscr_info->id));
+
+  /** pages the file already holds stay part of the virtual screen, and it holds one at least */
+  if (fstat(omx_fbdev_sink_component_Private->fd, &file_stat) != 0) {
+    return OMX_ErrorHardware;
+  }
+  vscr_info->yres_virtual = (OMX_U32) (file_stat.st_size / fscr_info->line_length);
+  vscr_info->yres_virtual -= vscr_info->yres_virtual % vscr_info->yres;
+  if (vscr_info->yres_virtual < vscr_info->yres) {
+    vscr_info->yres_virtual = vscr_info->yres;
+  }
+  fscr_info->smem_len = fscr_info->line_length * vscr_info->yres_virtual;
+  if (file_stat.st_size < (off_t) fscr_info->smem_len && ftruncate(omx_fbdev_sink_component_Private->fd, fscr_info->smem_len) != 0) {
+    DEBUG(DEB_LEV_ERR, "In %s unable to grow %s, errno=%d\n", __func__, omx_fbdev_sink_component_Private->sDevice.cDeviceName, errno);
+    return OMX_ErrorInsufficientResources;
+  }
+  return OMX_ErrorNone;
+}
+
+/** Frame buffer ioctl; for a file standing in for the device the requests the sink makes are emulated.
+  * FBIO_WAITFORVSYNC sleeps until the next refresh of the emulated screen.
+  */
+static int omx_fbdev_sink_component_Ioctl(omx_fbdev_sink_component_PrivateType* omx_fbdev_sink_component_Private, unsigned long request, void* arg) {
+  struct fb_var_screeninfo* vscr_info = &omx_fbdev_sink_component_Private->file_vscr_info;
+  struct fb_fix_screeninfo* fscr_info = &omx_fbdev_sink_component_Private->file_fscr_info;
+  struct fb_var_screeninfo* new_vscr_info = arg;
+  struct timespec now, wait;
+  long long period, ns;
+
+  if (!omx_fbdev_sink_component_Private->bFileBacked) {
+    return ioctl(omx_fbdev_sink_component_Private->fd, request, arg);
+  }
+  switch (request) {
+    case FBIOGET_VSCREENINFO:
+      memcpy(arg, vscr_info, sizeof(struct fb_var_screeninfo));
+      return 0;
+    case FBIOGET_FSCREENINFO:
+      memcpy(arg, fscr_info, sizeof(struct fb_fix_screeninfo));
+      return 0;
+    case FBIOPUT_VSCREENINFO:
+      /** only the virtual height and the panning offsets can change */
+      if (new_vscr_info->xres != vscr_info->xres || new_vscr_info->yres != vscr_info->yres ||
+          new_vscr_info->bits_per_pixel != vscr_info->bits_per_pixel ||
+          new_vscr_info->yres_virtual < new_vscr_info->yres ||
+          new_vscr_info->yoffset + new_vscr_info->yres > new_vscr_info->yres_virtual) {
+        errno = EINVAL;
+        return -1;
+      }
+      if (ftruncate(omx_fbdev_sink_component_Private->fd, (off_t) fscr_info->line_length * new_vscr_info->yres_virtual) != 0) {
+        return -1;
+      }
+      vscr_info->yres_virtual = new_vscr_info->yres_virtual;
+      vscr_info->yoffset = new_vscr_info->yoffset;
+      fscr_info->smem_len = fscr_info->line_length * vscr_info->yres_virtual;
+      return 0;
+    case FBIOPAN_DISPLAY:
+      if (new_vscr_info->yoffset + vscr_info->yres > vscr_info->yres_virtual) {
+        errno = EINVAL;
+        return -1;
+      }
+      vscr_info->yoffset = new_vscr_info->yoffset;
+      return 0;
+    case FBIO_WAITFORVSYNC:
+      period = 1000000000LL / FBDEV_SINK_FILE_REFRESH_RATE;
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      ns = period - (((long long) now.tv_sec * 1000000000LL + now.tv_nsec) % period);
+      wait.tv_sec = (time_t) (ns / 1000000000LL);
+      wait.tv_nsec = (long) (ns % 1000000000LL);
+      nanosleep(&wait, NULL);
+      return 0;
+    default:
+      errno = ENOTTY;
+      return -1;
+  }
+}
+
+/** Sets up the frame buffer pages used for page flipping
+  * The virtual screen is grown to nWantedPages pages if needed; nPages is left at 1
+  * when the driver cannot pan, so that frames are copied into the visible page instead
+  */
+static void omx_fbdev_sink_component_SetupPages(omx_fbdev_sink_component_PrivateType* omx_fbdev_sink_component_Private, OMX_U32 nWantedPages) {
+  struct fb_var_screeninfo vscr_info = omx_fbdev_sink_component_Private->vscr_info;
+  OMX_U32 nPages;
+
+  omx_fbdev_sink_component_Private->nPages = 1;
+  omx_fbdev_sink_component_Private->nBackPage = 0;
+
+  if (omx_fbdev_sink_component_Private->fscr_info.ypanstep == 0) {
+    DEBUG(DEB_LEV_SIMPLE_SEQ, "In %s framebuffer cannot pan, copying frames to the visible page\n", __func__);
+    return;
+  }
+
+  if (vscr_info.yres_virtual < nWantedPages * vscr_info.yres) {
+    vscr_info.yres_virtual = nWantedPages * vscr_info.yres;
+    vscr_info.xoffset = vscr_info.yoffset = 0;
+    if (omx_fbdev_sink_component_Ioctl(omx_fbdev_sink_component_Private, FBIOPUT_VSCREENINFO, &vscr_info) != 0 ||
+        omx_fbdev_sink_component_Ioctl(omx_fbdev_sink_component_Private, FBIOGET_VSCREENINFO, &omx_fbdev_sink_component_Private->vscr_info) != 0 ||
+        omx_fbdev_sink_component_Ioctl(omx_fbdev_sink_component_Private, FBIOGET_FSCREENINFO, &omx_fbdev_sink_component_Private->fscr_info) != 0) {
+      DEBUG(DEB_LEV_ERR, "In %s unable to grow the virtual screen to %d pages, errno=%d\n", __func__, (int)nWantedPages, errno);
+      return;
+    }
+  }
+
+  nPages = omx_fbdev_sink_component_Private->vscr_info.yres_virtual / omx_fbdev_sink_component_Private->vscr_info.yres;
+  if (nPages > nWantedPages) {
+    nPages = nWantedPages;
+  }
+  if (nPages < 2 ||
+      omx_fbdev_sink_component_Private->fscr_info.smem_len <
+      omx_fbdev_sink_component_Private->fscr_info.line_length * omx_fbdev_sink_component_Private->vscr_info.yres * nPages) {
+    DEBUG(DEB_LEV_ERR, "In %s not enough framebuffer memory for page flipping\n", __func__);
+    return;
+  }
+  omx_fbdev_sink_component_Private->nPages = nPages;
+  omx_fbdev_sink_component_Private->nBackPage = (omx_fbdev_sink_component_Private->vscr_info.yoffset == 0) ? 1 : 0;
+}
+
+/** Returns the number of frame buffer rows a frame takes once turned by the configured rotation */
+static OMX_U32 omx_fbdev_sink_component_ShownHeight(omx_fbdev_sink_component_PortType* pPort) {
+  OMX_U32 rotation = (OMX_U32) (((pPort->omxConfigRotate.nRotation % 360) + 360) % 360);
+
+  if (rotation == 90 || rotation == 270) {
+    return pPort->sPortParam.format.video.nFrameWidth;
+  }
+  return pPort->sPortParam.format.video.nFrameHeight;
+}
+
+/** Tells whether the input frames are laid out like the screen, same pixel format and line
+  * length, so that input buffers can be frame buffer pages and showing a frame is a pan.
+  * A pan cannot turn the picture, so rotated frames are always copied
+  */
+static OMX_BOOL omx_fbdev_sink_component_FbBuffersFit(omx_fbdev_sink_component_PrivateType* omx_fbdev_sink_component_Private,
+                                                      omx_fbdev_sink_component_PortType* pPort) {
+  if (pPort->sVideoParam.eColorFormat != omx_fbdev_sink_component_Private->fbpxlfmt ||
+      pPort->sPortParam.format.video.nStride != (OMX_S32) omx_fbdev_sink_component_Private->fscr_info.line_length ||
+      pPort->omxConfigRotate.nRotation % 360 != 0 ||
+      omx_fbdev_sink_component_ShownHeight(pPort) > omx_fbdev_sink_component_Private->vscr_info.yres ||
+      pPort->sPortParam.nBufferCountActual < 2) {
+    /** one buffer is always held on screen, the producer needs another one to fill */
+    return OMX_FALSE;
+  }
+  return OMX_TRUE;
+}
+
+/** Returns the frame buffer page pBuffer points to, or -1 if it is not frame buffer memory */
+static int omx_fbdev_sink_component_BufferPage(omx_fbdev_sink_component_PrivateType* omx_fbdev_sink_component_Private, OMX_U8* pBuffer) {
+  OMX_U8* scr_ptr = omx_fbdev_sink_component_Private->scr_ptr;
+
+  if (scr_ptr == NULL || pBuffer < scr_ptr || pBuffer >= scr_ptr + omx_fbdev_sink_component_Private->product) {
+    return -1;
+  }
+  return (int) ((pBuffer - scr_ptr) / omx_fbdev_sink_component_Private->page_size);
+}
+
+/** Pans the display to a frame buffer page and waits until the pan is latched */
+static void omx_fbdev_sink_component_ShowPage(omx_fbdev_sink_component_PrivateType* omx_fbdev_sink_component_Private, OMX_U32 nPage) {
+  omx_fbdev_sink_component_Private->vscr_info.xoffset = 0;
+  omx_fbdev_sink_component_Private->vscr_info.yoffset = nPage * omx_fbdev_sink_component_Private->vscr_info.yres;
+  if (omx_fbdev_sink_component_Ioctl(omx_fbdev_sink_component_Private, FBIOPAN_DISPLAY, &omx_fbdev_sink_component_Private->vscr_info) != 0) {
+    DEBUG(DEB_LEV_ERR, "In %s FBIOPAN_DISPLAY failed, errno=%d\n", __func__, errno);
+  }
+  if (omx_fbdev_sink_component_Private->bVsync) {
+    /** wait until the pan is latched, the old front page is scanned out until then */
+    __u32 crtc = 0;
+    omx_fbdev_sink_component_Ioctl(omx_fbdev_sink_component_Private, FBIO_WAITFORVSYNC, &crtc);
+  }
+}
+
+/** Tells whether omx_img_copy takes a color format as planar YUV, which it copies unrotated */
+static OMX_BOOL omx_fbdev_sink_component_IsPlanarYUV(OMX_COLOR_FORMATTYPE colorformat) {
+  return (colorformat == OMX_COLOR_FormatYUV411Planar ||
+          colorformat == OMX_COLOR_FormatYUV411PackedPlanar ||
+          colorformat == OMX_COLOR_FormatYUV420Planar ||
+          colorformat == OMX_COLOR_FormatYUV420PackedPlanar ||
+          colorformat == OMX_COLOR_FormatYUV422Planar ||
+          colorformat == OMX_COLOR_FormatYUV422PackedPlanar) ? OMX_TRUE : OMX_FALSE;
+}
+
+/** Picks the row blitter from the input color format to the frame buffer one */
+static void omx_fbdev_sink_component_SelectBlitter(omx_fbdev_sink_component_PrivateType* omx_fbdev_sink_component_Private) {
+  omx_fbdev_sink_component_PortType* pPort = (omx_fbdev_sink_component_PortType *) omx_fbdev_sink_component_Private->ports[OMX_BASE_SINK_INPUTPORT_INDEX];
+
+  omx_fbdev_sink_component_Private->blitRow = omx_fbdev_find_blitter(pPort->sVideoParam.eColorFormat, omx_fbdev_sink_component_Private->fbpxlfmt);
+  if (omx_fbdev_sink_component_Private->blitRow == NULL &&
+      omx_fbdev_sink_component_IsPlanarYUV(pPort->sVideoParam.eColorFormat)) {
+    DEBUG(DEB_LEV_ERR, "In %s no conversion from planar YUV to the frame buffer format, planes are copied as they are\n", __func__);
+  }
+}
+
+/** Unmaps the frame buffer, gives the console back the virtual screen it had and closes the device */
+static OMX_ERRORTYPE omx_fbdev_sink_component_CloseDevice(omx_fbdev_sink_component_PrivateType* omx_fbdev_sink_component_Private) {
+  if (omx_fbdev_sink_component_Private->scr_ptr) {
+    munmap(omx_fbdev_sink_component_Private->scr_ptr, omx_fbdev_sink_component_Private->product);
+    omx_fbdev_sink_component_Private->scr_ptr = NULL;
+  }
+  /** give the console back its own page and virtual screen */
+  if (omx_fbdev_sink_component_Private->vscr_info.yres_virtual != omx_fbdev_sink_component_Private->orig_vscr_info.yres_virtual) {
+    omx_fbdev_sink_component_Ioctl(omx_fbdev_sink_component_Private, FBIOPUT_VSCREENINFO, &omx_fbdev_sink_component_Private->orig_vscr_info);
+  } else if (omx_fbdev_sink_component_Private->vscr_info.yoffset != omx_fbdev_sink_component_Private->orig_vscr_info.yoffset) {
+    omx_fbdev_sink_component_Ioctl(omx_fbdev_sink_component_Private, FBIOPAN_DISPLAY, &omx_fbdev_sink_component_Private->orig_vscr_info);
+  }
+  if (close(omx_fbdev_sink_component_Private->fd) == -1) {
+    omx_fbdev_sink_component_Private->fd = -1;
+    return OMX_ErrorHardware;
+  }
+  omx_fbdev_sink_component_Private->fd = -1;
+  return OMX_ErrorNone;
+}
+
 /** The initialization function
   * This function opens the frame buffer device and allocates memory for display
   * also it finds the frame buffer supported display formats
@@ -199,18 +514,46 @@ OMX_ERRORTYPE omx_fbdev_sink_component_Init(OMX_COMPONENTTYPE *openmaxStandComp)
   omx_fbdev_sink_component_PrivateType* omx_fbdev_sink_component_Private = openmaxStandComp->pComponentPrivate;
   omx_fbdev_sink_component_PortType* pPort = (omx_fbdev_sink_component_PortType *) omx_fbdev_sink_component_Private->ports[OMX_BASE_SINK_INPUTPORT_INDEX];
 
-  omx_fbdev_sink_component_Private->fd = open(FBDEV_FILENAME, O_RDWR);
+  char* device_name = (char*) omx_fbdev_sink_component_Private->sDevice.cDeviceName;
+  struct stat device_stat;
+  OMX_ERRORTYPE err;
+
+  omx_fbdev_sink_component_Private->fd = open(device_name, O_RDWR);
   if (omx_fbdev_sink_component_Private->fd < 0) {
-    DEBUG(DEB_LEV_ERR, "Unable to open framebuffer %s!  open returned: %i, errno=%d  ENODEV : %d \n", FBDEV_FILENAME, omx_fbdev_sink_component_Private->fd,errno,ENODEV);
+    DEBUG(DEB_LEV_ERR, "Unable to open framebuffer %s!  open returned: %i, errno=%d  ENODEV : %d \n", device_name, omx_fbdev_sink_component_Private->fd,errno,ENODEV);
     return OMX_ErrorHardware;
   }
+  /** nothing is mapped, and there is no screen configuration to give back, until the screen info is read */
+  omx_fbdev_sink_component_Private->scr_ptr = NULL;
+  omx_fbdev_sink_component_Private->bFileBacked = OMX_FALSE;
+  memset(&omx_fbdev_sink_component_Private->vscr_info, 0, sizeof(struct fb_var_screeninfo));
+  omx_fbdev_sink_component_Private->orig_vscr_info = omx_fbdev_sink_component_Private->vscr_info;
+
+  /** any number of sinks may run, but only one per frame buffer */
+  if (flock(omx_fbdev_sink_component_Private->fd, LOCK_EX | LOCK_NB) != 0) {
+    DEBUG(DEB_LEV_ERR, "In %s framebuffer %s is in use by another sink\n", __func__, device_name);
+    err = OMX_ErrorInsufficientResources;
+    goto error;
+  }
+
+  if (fstat(omx_fbdev_sink_component_Private->fd, &device_stat) == 0 && S_ISREG(device_stat.st_mode)) {
+    DEBUG(DEB_LEV_SIMPLE_SEQ, "In %s %s is a regular file, emulating a framebuffer over it\n", __func__, device_name);
+    err = omx_fbdev_sink_component_SetupFileScreen(omx_fbdev_sink_component_Private, pPort);
+    if (err != OMX_ErrorNone) {
+      goto error;
+    }
+    omx_fbdev_sink_component_Private->bFileBacked = OMX_TRUE;
+  }
 
   /** frame buffer display configuration get */
-  if(ioctl(omx_fbdev_sink_component_Private->fd, FBIOGET_VSCREENINFO, &omx_fbdev_sink_component_Private->vscr_info) != 0 ||
-    ioctl(omx_fbdev_sink_component_Private->fd, FBIOGET_FSCREENINFO, &omx_fbdev_sink_component_Private->fscr_info) != 0) {
+  if(omx_fbdev_sink_component_Ioctl(omx_fbdev_sink_component_Private, FBIOGET_VSCREENINFO, &omx_fbdev_sink_component_Private->vscr_info) != 0 ||
+    omx_fbdev_sink_component_Ioctl(omx_fbdev_sink_component_Private, FBIOGET_FSCREENINFO, &omx_fbdev_sink_component_Private->fscr_info) != 0) {
     DEBUG(DEB_LEV_ERR, "Error during ioctl to get framebuffer parameters!\n");
-    return OMX_ErrorHardware;
+    memset(&omx_fbdev_sink_component_Private->vscr_info, 0, sizeof(struct fb_var_screeninfo));
+    err = OMX_ErrorHardware;
+    goto error;
   }
+  omx_fbdev_sink_component_Private->orig_vscr_info = omx_fbdev_sink_component_Private->vscr_info;
 
   /** From the frame buffer display rgb formats, find the corresponding standard OMX format
     * It is needed to convert the input rgb content onto frame buffer supported rgb content
@@ -218,7 +561,8 @@ OMX_ERRORTYPE omx_fbdev_sink_component_Init(OMX_COMPONENTTYPE *openmaxStandComp)
   omx_fbdev_sink_component_Private->fbpxlfmt = find_omx_pxlfmt(&omx_fbdev_sink_component_Private->vscr_info);
   if (omx_fbdev_sink_component_Private->fbpxlfmt == OMX_COLOR_FormatUnused) {
     DEBUG(DEB_LEV_ERR,"\n in %s finding omx pixel format returned error\n", __func__);
-    return OMX_ErrorUnsupportedSetting;
+    err = OMX_ErrorUnsupportedSetting;
+    goto error;
   }
 
   DEBUG(DEB_LEV_PARAMS, "xres=%u,yres=%u,xres_virtual %u,yres_virtual=%u,xoffset=%u,yoffset=%u,bits_per_pixel=%u,grayscale=%u,nonstd=%u,height=%u,width=%u\n",
@@ -241,8 +585,29 @@ OMX_ERRORTYPE omx_fbdev_sink_component_Init(OMX_COMPONENTTYPE *openmaxStandComp)
   omx_fbdev_sink_component_Private->vscr_info.transp.offset,omx_fbdev_sink_component_Private->vscr_info.transp.length);
 
 
+  omx_fbdev_sink_component_Private->pShownBuffer = NULL;
+  omx_fbdev_sink_component_Private->pHeldBuffer = NULL;
+  if (omx_fbdev_sink_component_FbBuffersFit(omx_fbdev_sink_component_Private, pPort) &&
+      pPort->sPortParam.nBufferCountActual > FBDEV_SINK_PAGES) {
+    /** a page for each input buffer, so that the buffers can be handed out of frame buffer memory */
+    omx_fbdev_sink_component_SetupPages(omx_fbdev_sink_component_Private, pPort->sPortParam.nBufferCountActual);
+    if (omx_fbdev_sink_component_Private->nPages < pPort->sPortParam.nBufferCountActual) {
+      omx_fbdev_sink_component_SetupPages(omx_fbdev_sink_component_Private, FBDEV_SINK_PAGES);
+    }
+  } else if (omx_fbdev_sink_component_ShownHeight(pPort) + HEIGHT_OFFSET <= omx_fbdev_sink_component_Private->vscr_info.yres ||
+             omx_fbdev_sink_component_FbBuffersFit(omx_fbdev_sink_component_Private, pPort)) {
+    omx_fbdev_sink_component_SetupPages(omx_fbdev_sink_component_Private, FBDEV_SINK_PAGES);
+  } else {
+    //  The picture does not fit a page: draw into the visible page as before
+    omx_fbdev_sink_component_Private->nPages = 1;
+    omx_fbdev_sink_component_Private->nBackPage = 0;
+  }
+
+  /** A disabled port can still get a new format later, SetParameter picks the blitter again */
+  omx_fbdev_sink_component_SelectBlitter(omx_fbdev_sink_component_Private);
+
   omx_fbdev_sink_component_Private->fbwidth = omx_fbdev_sink_component_Private->vscr_info.xres;
-  omx_fbdev_sink_component_Private->fbheight = pPort->sPortParam.format.video.nFrameHeight;
+  omx_fbdev_sink_component_Private->fbheight = omx_fbdev_sink_component_ShownHeight(pPort);
   omx_fbdev_sink_component_Private->fbbpp = omx_fbdev_sink_component_Private->vscr_info.bits_per_pixel;
   //omx_fbdev_sink_component_Private->fbstride = calcStride(omx_fbdev_sink_component_Private->fbwidth, omx_fbdev_sink_component_Private->fbpxlfmt);
   //omx_fbdev_sink_component_Private->fbstride = omx_fbdev_sink_component_Private->fscr_info.line_length*
@@ -253,24 +618,95 @@ OMX_ERRORTYPE omx_fbdev_sink_component_Init(OMX_COMPONENTTYPE *openmaxStandComp)
     * output displayed not at the corner of screen, but at the centre of upper part of screen
     */
   omx_fbdev_sink_component_Private->product = omx_fbdev_sink_component_Private->fbstride * (omx_fbdev_sink_component_Private->fbheight + HEIGHT_OFFSET);
+  omx_fbdev_sink_component_Private->page_size = omx_fbdev_sink_component_Private->fbstride * omx_fbdev_sink_component_Private->vscr_info.yres;
+  if (omx_fbdev_sink_component_Private->nPages > 1) {
+    /** with page flipping all the pages are mapped */
+    omx_fbdev_sink_component_Private->product = omx_fbdev_sink_component_Private->page_size * omx_fbdev_sink_component_Private->nPages;
+  } else if (!omx_fbdev_sink_component_Private->bFileBacked &&
+             omx_fbdev_sink_component_Private->product > omx_fbdev_sink_component_Private->fscr_info.smem_len) {
+    /** a picture taller than the frame buffer memory is cut at its end when copied */
+    omx_fbdev_sink_component_Private->product = omx_fbdev_sink_component_Private->fscr_info.smem_len;
+  }
+
+  if (omx_fbdev_sink_component_Private->bFileBacked &&
+      omx_fbdev_sink_component_Private->product > omx_fbdev_sink_component_Private->file_fscr_info.smem_len) {
+    /** the picture reaches below the emulated screen, the file must back the whole mapping */
+    if (ftruncate(omx_fbdev_sink_component_Private->fd, omx_fbdev_sink_component_Private->product) != 0) {
+      DEBUG(DEB_LEV_ERR, "In %s unable to grow %s, errno=%d\n", __func__, device_name, errno);
+      err = OMX_ErrorInsufficientResources;
+      goto error;
+    }
+  }
 
   /** memory map frame buf memory */
   omx_fbdev_sink_component_Private->scr_ptr = (unsigned char*) mmap(0, omx_fbdev_sink_component_Private->product, PROT_READ | PROT_WRITE, MAP_SHARED, omx_fbdev_sink_component_Private->fd,0);
-  if (omx_fbdev_sink_component_Private->scr_ptr == NULL) {
+  if (omx_fbdev_sink_component_Private->scr_ptr == MAP_FAILED || omx_fbdev_sink_component_Private->scr_ptr == NULL) {
     DEBUG(DEB_LEV_ERR, "in %s Failed to mmap framebuffer memory!\n", __func__);
-    close (omx_fbdev_sink_component_Private->fd);
-    return OMX_ErrorHardware;
+    omx_fbdev_sink_component_Private->scr_ptr = NULL;
+    err = OMX_ErrorHardware;
+    goto error;
+  }
+
+  if (omx_fbdev_sink_component_Private->nPages > 1) {
+    OMX_U32 i;
+    OMX_U8* visible_page = omx_fbdev_sink_component_Private->scr_ptr +
+                           omx_fbdev_sink_component_Private->vscr_info.yoffset * omx_fbdev_sink_component_Private->fbstride;
+    /** hidden pages start as a copy of the visible one, so the screen around the picture does not change on flips */
+    for (i = 0; i < omx_fbdev_sink_component_Private->nPages; i++) {
+      OMX_U8* page = omx_fbdev_sink_component_Private->scr_ptr + i * omx_fbdev_sink_component_Private->page_size;
+      if (page != visible_page) {
+        memcpy(page, visible_page, omx_fbdev_sink_component_Private->page_size);
+      }
+    }
+  }
+
+  /** probe vertical sync support; frames are then shown on the vsync following their pacing time */
+  {
+    __u32 crtc = 0;
+    omx_fbdev_sink_component_Private->bVsync =
+      (omx_fbdev_sink_component_Ioctl(omx_fbdev_sink_component_Private, FBIO_WAITFORVSYNC, &crtc) == 0) ? OMX_TRUE : OMX_FALSE;
   }
+  DEBUG(DEB_LEV_SIMPLE_SEQ, "Pages: %d, vsync: %s\n", (int)omx_fbdev_sink_component_Private->nPages,
+        omx_fbdev_sink_component_Private->bVsync ? "yes" : "no");
 
   DEBUG(DEB_LEV_SIMPLE_SEQ, "mmap framebuffer memory =%p omx_fbdev_sink_component_Private->product=%d stride=%d\n",
 		  omx_fbdev_sink_component_Private->scr_ptr,
 		  (unsigned int)omx_fbdev_sink_component_Private->product,
 		  (int)omx_fbdev_sink_component_Private->fbstride);
-  DEBUG(DEB_LEV_SIMPLE_SEQ, "Successfully opened %s for display.\n", "/dev/fb0");
+  DEBUG(DEB_LEV_SIMPLE_SEQ, "Successfully opened %s for display.\n", device_name);
   DEBUG(DEB_LEV_SIMPLE_SEQ, "Display Size: %u x %u\n", (int)omx_fbdev_sink_component_Private->fbwidth, (int)omx_fbdev_sink_component_Private->fbheight);
   DEBUG(DEB_LEV_SIMPLE_SEQ, "Bitdepth: %u\n", (int)omx_fbdev_sink_component_Private->fbbpp);
 
+  /** what the set up depends on, to tell whether a port enable needs a new one */
+  omx_fbdev_sink_component_Private->sInitPortDef = pPort->sPortParam;
+  omx_fbdev_sink_component_Private->eInitColorFormat = pPort->sVideoParam.eColorFormat;
+  omx_fbdev_sink_component_Private->nInitShownHeight = omx_fbdev_sink_component_ShownHeight(pPort);
+
   return OMX_ErrorNone;
+
+error:
+  /** every failure once the device is open gives back what was set up so far */
+  omx_fbdev_sink_component_CloseDevice(omx_fbdev_sink_component_Private);
+  return err;
+}
+
+/** Tells whether the frame buffer must be set up again for the input port: it is not set up,
+  * or the frame geometry, the color format, the buffer count or the rotated height changed since
+  */
+static OMX_BOOL omx_fbdev_sink_component_SetupChanged(omx_fbdev_sink_component_PrivateType* omx_fbdev_sink_component_Private,
+                                                      omx_fbdev_sink_component_PortType* pPort) {
+  OMX_VIDEO_PORTDEFINITIONTYPE* pInitVideo = &omx_fbdev_sink_component_Private->sInitPortDef.format.video;
+
+  if (omx_fbdev_sink_component_Private->scr_ptr == NULL ||
+      pInitVideo->nFrameWidth != pPort->sPortParam.format.video.nFrameWidth ||
+      pInitVideo->nFrameHeight != pPort->sPortParam.format.video.nFrameHeight ||
+      pInitVideo->nStride != pPort->sPortParam.format.video.nStride ||
+      omx_fbdev_sink_component_Private->sInitPortDef.nBufferCountActual != pPort->sPortParam.nBufferCountActual ||
+      omx_fbdev_sink_component_Private->eInitColorFormat != pPort->sVideoParam.eColorFormat ||
+      omx_fbdev_sink_component_Private->nInitShownHeight != omx_fbdev_sink_component_ShownHeight(pPort)) {
+    return OMX_TRUE;
+  }
+  return OMX_FALSE;
 }
 
 /** The deinitialization function
@@ -279,13 +715,7 @@ OMX_ERRORTYPE omx_fbdev_sink_component_Init(OMX_COMPONENTTYPE *openmaxStandComp)
 OMX_ERRORTYPE omx_fbdev_sink_component_Deinit(OMX_COMPONENTTYPE *openmaxStandComp) {
   omx_fbdev_sink_component_PrivateType* omx_fbdev_sink_component_Private = openmaxStandComp->pComponentPrivate;
 
-  if (omx_fbdev_sink_component_Private->scr_ptr) {
-    munmap(omx_fbdev_sink_component_Private->scr_ptr, omx_fbdev_sink_component_Private->product);
-  }
-  if (close(omx_fbdev_sink_component_Private->fd) == -1) {
-    return OMX_ErrorHardware;
-  }
-  return OMX_ErrorNone;
+  return omx_fbdev_sink_component_CloseDevice(omx_fbdev_sink_component_Private);
 }
 
 /**  This function takes two inputs -
@@ -487,9 +917,868 @@ OMX_COLOR_FORMATTYPE find_omx_pxlfmt(struct fb_var_screeninfo *vscr_info) {
       omx_pxlfmt = OMX_COLOR_FormatUnused;
     }
   }
-  return omx_pxlfmt;
+  return omx_pxlfmt;
+}
+
+
+/**  Writes a converted chunk of a row to the frame buffer.
+  *  The frame buffer is usually mapped write-combined, so on SSE2 the bulk of the row is written
+  *  with non-temporal stores, which neither read the destination lines nor pollute the cache.
+  */
+static inline void omx_fbdev_stream_row(OMX_U8* dest, const OMX_U8* chunk, OMX_U32 bytes) {
+#if defined(FBDEV_HAVE_SSSE3) && defined(__SSE2__)
+  OMX_U32 head = (OMX_U32) ((16 - ((unsigned long) dest & 15)) & 15);
+  if (head > bytes) {
+    head = bytes;
+  }
+  memcpy(dest, chunk, head);
+  dest += head;
+  chunk += head;
+  bytes -= head;
+  for (; bytes >= 16; bytes -= 16, dest += 16, chunk += 16) {
+    _mm_stream_si128((__m128i*) dest, _mm_loadu_si128((const __m128i*) chunk));
+  }
+#endif
+  memcpy(dest, chunk, bytes);
+}
+
+/**  Row blitters: convert width pixels of one row from src into the frame buffer row at dest.
+  *  Each converts FBDEV_BLIT_CHUNK pixels at a time into a buffer on the stack with a plain loop
+  *  the compiler can vectorize, then streams the chunk out with omx_fbdev_stream_row.
+  */
+static void omx_fbdev_blit_rgb888_to_rgb565(const OMX_U8* src, OMX_U8* dest, OMX_U32 width) {
+  OMX_U16 chunk[FBDEV_BLIT_CHUNK];
+  OMX_U32 i, n;
+
+  for (; width > 0; width -= n, src += 3 * n, dest += 2 * n) {
+    n = (width < FBDEV_BLIT_CHUNK) ? width : FBDEV_BLIT_CHUNK;
+    for (i = 0; i < n; i++) {
+      chunk[i] = (OMX_U16) (((src[3 * i] & 0xf8) << 8) | ((src[3 * i + 1] & 0xfc) << 3) | (src[3 * i + 2] >> 3));
+    }
+    omx_fbdev_stream_row(dest, (const OMX_U8*) chunk, 2 * n);
+  }
+}
+
+static void omx_fbdev_blit_rgb888_to_bgr565(const OMX_U8* src, OMX_U8* dest, OMX_U32 width) {
+  OMX_U16 chunk[FBDEV_BLIT_CHUNK];
+  OMX_U32 i, n;
+
+  for (; width > 0; width -= n, src += 3 * n, dest += 2 * n) {
+    n = (width < FBDEV_BLIT_CHUNK) ? width : FBDEV_BLIT_CHUNK;
+    for (i = 0; i < n; i++) {
+      chunk[i] = (OMX_U16) (((src[3 * i + 2] & 0xf8) << 8) | ((src[3 * i + 1] & 0xfc) << 3) | (src[3 * i] >> 3));
+    }
+    omx_fbdev_stream_row(dest, (const OMX_U8*) chunk, 2 * n);
+  }
+}
+
+static void omx_fbdev_blit_rgb888_to_argb1555(const OMX_U8* src, OMX_U8* dest, OMX_U32 width) {
+  OMX_U16 chunk[FBDEV_BLIT_CHUNK];
+  OMX_U32 i, n;
+
+  for (; width > 0; width -= n, src += 3 * n, dest += 2 * n) {
+    n = (width < FBDEV_BLIT_CHUNK) ? width : FBDEV_BLIT_CHUNK;
+    for (i = 0; i < n; i++) {
+      chunk[i] = (OMX_U16) (((src[3 * i] & 0xf8) << 7) | ((src[3 * i + 1] & 0xf8) << 2) | (src[3 * i + 2] >> 3));
+    }
+    omx_fbdev_stream_row(dest, (const OMX_U8*) chunk, 2 * n);
+  }
+}
+
+/**  The 32 bit frame buffer rows are written as bytes b, g, r, a */
+static void omx_fbdev_blit_rgb888_to_argb8888(const OMX_U8* src, OMX_U8* dest, OMX_U32 width) {
+  OMX_U8 chunk[4 * FBDEV_BLIT_CHUNK];
+  OMX_U32 i, n;
+
+  for (; width > 0; width -= n, src += 3 * n, dest += 4 * n) {
+    n = (width < FBDEV_BLIT_CHUNK) ? width : FBDEV_BLIT_CHUNK;
+    for (i = 0; i < n; i++) {
+      chunk[4 * i + 0] = src[3 * i + 2];
+      chunk[4 * i + 1] = src[3 * i + 1];
+      chunk[4 * i + 2] = src[3 * i + 0];
+      chunk[4 * i + 3] = 0xff;
+    }
+    omx_fbdev_stream_row(dest, chunk, 4 * n);
+  }
+}
+
+static void omx_fbdev_blit_bgr888_to_argb8888(const OMX_U8* src, OMX_U8* dest, OMX_U32 width) {
+  OMX_U8 chunk[4 * FBDEV_BLIT_CHUNK];
+  OMX_U32 i, n;
+
+  for (; width > 0; width -= n, src += 3 * n, dest += 4 * n) {
+    n = (width < FBDEV_BLIT_CHUNK) ? width : FBDEV_BLIT_CHUNK;
+    for (i = 0; i < n; i++) {
+      chunk[4 * i + 0] = src[3 * i + 0];
+      chunk[4 * i + 1] = src[3 * i + 1];
+      chunk[4 * i + 2] = src[3 * i + 2];
+      chunk[4 * i + 3] = 0xff;
+    }
+    omx_fbdev_stream_row(dest, chunk, 4 * n);
+  }
+}
+
+static void omx_fbdev_blit_argb8888_to_argb8888(const OMX_U8* src, OMX_U8* dest, OMX_U32 width) {
+  omx_fbdev_stream_row(dest, src, 4 * width);
+}
+
+static void omx_fbdev_blit_argb1555_to_argb8888(const OMX_U8* src, OMX_U8* dest, OMX_U32 width) {
+  OMX_U8 chunk[4 * FBDEV_BLIT_CHUNK];
+  OMX_U32 i, n;
+  OMX_U16 pixel;
+
+  for (; width > 0; width -= n, src += 2 * n, dest += 4 * n) {
+    n = (width < FBDEV_BLIT_CHUNK) ? width : FBDEV_BLIT_CHUNK;
+    for (i = 0; i < n; i++) {
+      pixel = ((const OMX_U16*) src)[i];
+      chunk[4 * i + 0] = (OMX_U8) ((pixel & 0x001f) << 3);
+      chunk[4 * i + 1] = (OMX_U8) (((pixel >> 5) & 0x001f) << 3);
+      chunk[4 * i + 2] = (OMX_U8) (((pixel >> 10) & 0x001f) << 3);
+      chunk[4 * i + 3] = (OMX_U8) ((pixel >> 15) << 7);
+    }
+    omx_fbdev_stream_row(dest, chunk, 4 * n);
+  }
+}
+
+static void omx_fbdev_blit_rgb565_to_argb8888(const OMX_U8* src, OMX_U8* dest, OMX_U32 width) {
+  OMX_U8 chunk[4 * FBDEV_BLIT_CHUNK];
+  OMX_U32 i, n;
+  OMX_U16 pixel;
+
+  for (; width > 0; width -= n, src += 2 * n, dest += 4 * n) {
+    n = (width < FBDEV_BLIT_CHUNK) ? width : FBDEV_BLIT_CHUNK;
+    for (i = 0; i < n; i++) {
+      pixel = ((const OMX_U16*) src)[i];
+      chunk[4 * i + 0] = (OMX_U8) ((pixel & 0x001f) << 3);
+      chunk[4 * i + 1] = (OMX_U8) (((pixel >> 5) & 0x003f) << 2);
+      chunk[4 * i + 2] = (OMX_U8) (((pixel >> 11) & 0x001f) << 3);
+      chunk[4 * i + 3] = 0xff;
+    }
+    omx_fbdev_stream_row(dest, chunk, 4 * n);
+  }
+}
+
+#ifdef FBDEV_HAVE_SSSE3
+/**  SSSE3 row blitters.
+  *  Each 16 byte load holds at least four whole pixels, which pshufb spreads into 32 bit
+  *  pixels or into one 16 bit lane per component; the loops stop early enough that the
+  *  loads never read past the end of the row, the last pixels being converted one by one.
+  */
+static inline __attribute__((target("ssse3"))) void omx_fbdev_rgb24_to_argb8888_ssse3(const OMX_U8* src, OMX_U8* dest, OMX_U32 width, int swap_rb) {
+  OMX_U8 chunk[4 * FBDEV_BLIT_CHUNK];
+  const __m128i shuffle = swap_rb ? _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1)
+                                  : _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+  const __m128i alpha = _mm_set1_epi32((int) 0xff000000);
+  OMX_U32 i, n;
+
+  for (; width > 0; width -= n, src += 3 * n, dest += 4 * n) {
+    n = (width < FBDEV_BLIT_CHUNK) ? width : FBDEV_BLIT_CHUNK;
+    for (i = 0; i + 6 <= width && i + 4 <= n; i += 4) {
+      __m128i pixels = _mm_loadu_si128((const __m128i*) (src + 3 * i));
+      _mm_storeu_si128((__m128i*) (chunk + 4 * i), _mm_or_si128(_mm_shuffle_epi8(pixels, shuffle), alpha));
+    }
+    for (; i < n; i++) {
+      chunk[4 * i + 0] = src[3 * i + (swap_rb ? 0 : 2)];
+      chunk[4 * i + 1] = src[3 * i + 1];
+      chunk[4 * i + 2] = src[3 * i + (swap_rb ? 2 : 0)];
+      chunk[4 * i + 3] = 0xff;
+    }
+    omx_fbdev_stream_row(dest, chunk, 4 * n);
+  }
+}
+
+static __attribute__((target("ssse3"))) void omx_fbdev_blit_rgb888_to_argb8888_ssse3(const OMX_U8* src, OMX_U8* dest, OMX_U32 width) {
+  omx_fbdev_rgb24_to_argb8888_ssse3(src, dest, width, 0);
+}
+
+static __attribute__((target("ssse3"))) void omx_fbdev_blit_bgr888_to_argb8888_ssse3(const OMX_U8* src, OMX_U8* dest, OMX_U32 width) {
+  omx_fbdev_rgb24_to_argb8888_ssse3(src, dest, width, 1);
+}
+
+/**  Converts RGB888 rows to 16 bit pixels (r & r_mask) << r_shift | (g & g_mask) << g_shift | b >> 3,
+  *  with red and blue swapped when swap_rb is set
+  */
+static inline __attribute__((target("ssse3"))) void omx_fbdev_rgb888_to_16bit_ssse3(const OMX_U8* src, OMX_U8* dest, OMX_U32 width,
+                                                                                       int swap_rb, int r_shift, int g_mask, int g_shift) {
+  OMX_U16 chunk[FBDEV_BLIT_CHUNK];
+  const __m128i spread = _mm_setr_epi8(0, -1, 3, -1, 6, -1, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+  const __m128i r_mask_v = _mm_set1_epi16(0xf8);
+  const __m128i g_mask_v = _mm_set1_epi16((short) g_mask);
+  const __m128i r_shift_v = _mm_cvtsi32_si128(r_shift);
+  const __m128i g_shift_v = _mm_cvtsi32_si128(g_shift);
+  OMX_U32 i, n;
+  OMX_U8 r, g, b;
+
+  for (; width > 0; width -= n, src += 3 * n, dest += 2 * n) {
+    n = (width < FBDEV_BLIT_CHUNK) ? width : FBDEV_BLIT_CHUNK;
+    for (i = 0; i + 10 <= width && i + 8 <= n; i += 8) {
+      //  Eight pixels: four from each load, spread into the low and high halves of the component vectors
+      __m128i lo = _mm_loadu_si128((const __m128i*) (src + 3 * i));
+      __m128i hi = _mm_loadu_si128((const __m128i*) (src + 3 * i + 12));
+      __m128i first = _mm_unpacklo_epi64(_mm_shuffle_epi8(lo, spread), _mm_shuffle_epi8(hi, spread));
+      __m128i green = _mm_unpacklo_epi64(_mm_shuffle_epi8(_mm_srli_si128(lo, 1), spread), _mm_shuffle_epi8(_mm_srli_si128(hi, 1), spread));
+      __m128i third = _mm_unpacklo_epi64(_mm_shuffle_epi8(_mm_srli_si128(lo, 2), spread), _mm_shuffle_epi8(_mm_srli_si128(hi, 2), spread));
+      __m128i red = swap_rb ? third : first;
+      __m128i blue = swap_rb ? first : third;
+      __m128i pixels = _mm_or_si128(_mm_or_si128(_mm_sll_epi16(_mm_and_si128(red, r_mask_v), r_shift_v),
+                                                 _mm_sll_epi16(_mm_and_si128(green, g_mask_v), g_shift_v)),
+                                    _mm_srli_epi16(blue, 3));
+      _mm_storeu_si128((__m128i*) (chunk + i), pixels);
+    }
+    for (; i < n; i++) {
+      r = src[3 * i + (swap_rb ? 2 : 0)];
+      g = src[3 * i + 1];
+      b = src[3 * i + (swap_rb ? 0 : 2)];
+      chunk[i] = (OMX_U16) (((r & 0xf8) << r_shift) | ((g & g_mask) << g_shift) | (b >> 3));
+    }
+    omx_fbdev_stream_row(dest, (const OMX_U8*) chunk, 2 * n);
+  }
+}
+
+static __attribute__((target("ssse3"))) void omx_fbdev_blit_rgb888_to_rgb565_ssse3(const OMX_U8* src, OMX_U8* dest, OMX_U32 width) {
+  omx_fbdev_rgb888_to_16bit_ssse3(src, dest, width, 0, 8, 0xfc, 3);
+}
+
+static __attribute__((target("ssse3"))) void omx_fbdev_blit_rgb888_to_bgr565_ssse3(const OMX_U8* src, OMX_U8* dest, OMX_U32 width) {
+  omx_fbdev_rgb888_to_16bit_ssse3(src, dest, width, 1, 8, 0xfc, 3);
+}
+
+static __attribute__((target("ssse3"))) void omx_fbdev_blit_rgb888_to_argb1555_ssse3(const OMX_U8* src, OMX_U8* dest, OMX_U32 width) {
+  omx_fbdev_rgb888_to_16bit_ssse3(src, dest, width, 0, 7, 0xf8, 2);
+}
+
+/**  Converts 16 bit rows to 32 bit pixels, eight at a time: the components are widened in
+  *  16 bit lanes, paired as blue/green and red/alpha, then interleaved into b, g, r, a pixels
+  */
+static inline __attribute__((target("ssse3"))) void omx_fbdev_16bit_to_argb8888_ssse3(const OMX_U8* src, OMX_U8* dest, OMX_U32 width, int is_argb1555) {
+  OMX_U8 chunk[4 * FBDEV_BLIT_CHUNK];
+  const __m128i five_bits = _mm_set1_epi16(0x1f);
+  const __m128i six_bits = _mm_set1_epi16(0x3f);
+  const __m128i opaque = _mm_set1_epi16((short) 0xff00);
+  OMX_U32 i, n;
+  OMX_U16 pixel;
+
+  for (; width > 0; width -= n, src += 2 * n, dest += 4 * n) {
+    n = (width < FBDEV_BLIT_CHUNK) ? width : FBDEV_BLIT_CHUNK;
+    for (i = 0; i + 8 <= n; i += 8) {
+      __m128i pixels = _mm_loadu_si128((const __m128i*) (src + 2 * i));
+      __m128i blue = _mm_slli_epi16(_mm_and_si128(pixels, five_bits), 3);
+      __m128i green, red, alpha;
+      if (is_argb1555) {
+        green = _mm_slli_epi16(_mm_and_si128(_mm_srli_epi16(pixels, 5), five_bits), 3);
+        red = _mm_slli_epi16(_mm_and_si128(_mm_srli_epi16(pixels, 10), five_bits), 3);
+        alpha = _mm_slli_epi16(_mm_srli_epi16(pixels, 15), 15);
+      } else {
+        green = _mm_slli_epi16(_mm_and_si128(_mm_srli_epi16(pixels, 5), six_bits), 2);
+        red = _mm_slli_epi16(_mm_srli_epi16(pixels, 11), 3);
+        alpha = opaque;
+      }
+      __m128i blue_green = _mm_or_si128(blue, _mm_slli_epi16(green, 8));
+      __m128i red_alpha = _mm_or_si128(red, alpha);
+      _mm_storeu_si128((__m128i*) (chunk + 4 * i), _mm_unpacklo_epi16(blue_green, red_alpha));
+      _mm_storeu_si128((__m128i*) (chunk + 4 * i + 16), _mm_unpackhi_epi16(blue_green, red_alpha));
+    }
+    for (; i < n; i++) {
+      pixel = ((const OMX_U16*) src)[i];
+      chunk[4 * i + 0] = (OMX_U8) ((pixel & 0x001f) << 3);
+      if (is_argb1555) {
+        chunk[4 * i + 1] = (OMX_U8) (((pixel >> 5) & 0x001f) << 3);
+        chunk[4 * i + 2] = (OMX_U8) (((pixel >> 10) & 0x001f) << 3);
+        chunk[4 * i + 3] = (OMX_U8) ((pixel >> 15) << 7);
+      } else {
+        chunk[4 * i + 1] = (OMX_U8) (((pixel >> 5) & 0x003f) << 2);
+        chunk[4 * i + 2] = (OMX_U8) (((pixel >> 11) & 0x001f) << 3);
+        chunk[4 * i + 3] = 0xff;
+      }
+    }
+    omx_fbdev_stream_row(dest, chunk, 4 * n);
+  }
+}
+
+static __attribute__((target("ssse3"))) void omx_fbdev_blit_argb1555_to_argb8888_ssse3(const OMX_U8* src, OMX_U8* dest, OMX_U32 width) {
+  omx_fbdev_16bit_to_argb8888_ssse3(src, dest, width, 1);
+}
+
+static __attribute__((target("ssse3"))) void omx_fbdev_blit_rgb565_to_argb8888_ssse3(const OMX_U8* src, OMX_U8* dest, OMX_U32 width) {
+  omx_fbdev_16bit_to_argb8888_ssse3(src, dest, width, 0);
+}
+#endif
+
+#ifdef FBDEV_HAVE_AVX2
+/**  AVX2 row blitters.
+  *  They work like the SSSE3 ones on twice the pixels: vpshufb shuffles each 128 bit lane on
+  *  its own, so each lane is loaded with the source bytes of its own pixels.
+  */
+static inline __attribute__((target("avx2"))) __m256i omx_fbdev_load_lanes_avx2(const OMX_U8* lo, const OMX_U8* hi) {
+  return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*) lo)), _mm_loadu_si128((const __m128i*) hi), 1);
+}
+
+static inline __attribute__((target("avx2"))) void omx_fbdev_rgb24_to_argb8888_avx2(const OMX_U8* src, OMX_U8* dest, OMX_U32 width, int swap_rb) {
+  OMX_U8 chunk[4 * FBDEV_BLIT_CHUNK];
+  const __m256i shuffle = swap_rb ? _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                                     0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1)
+                                  : _mm256_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1,
+                                                     2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+  const __m256i alpha = _mm256_set1_epi32((int) 0xff000000);
+  OMX_U32 i, n;
+
+  for (; width > 0; width -= n, src += 3 * n, dest += 4 * n) {
+    n = (width < FBDEV_BLIT_CHUNK) ? width : FBDEV_BLIT_CHUNK;
+    for (i = 0; i + 10 <= width && i + 8 <= n; i += 8) {
+      __m256i pixels = omx_fbdev_load_lanes_avx2(src + 3 * i, src + 3 * i + 12);
+      _mm256_storeu_si256((__m256i*) (chunk + 4 * i), _mm256_or_si256(_mm256_shuffle_epi8(pixels, shuffle), alpha));
+    }
+    for (; i < n; i++) {
+      chunk[4 * i + 0] = src[3 * i + (swap_rb ? 0 : 2)];
+      chunk[4 * i + 1] = src[3 * i + 1];
+      chunk[4 * i + 2] = src[3 * i + (swap_rb ? 2 : 0)];
+      chunk[4 * i + 3] = 0xff;
+    }
+    omx_fbdev_stream_row(dest, chunk, 4 * n);
+  }
+}
+
+static __attribute__((target("avx2"))) void omx_fbdev_blit_rgb888_to_argb8888_avx2(const OMX_U8* src, OMX_U8* dest, OMX_U32 width) {
+  omx_fbdev_rgb24_to_argb8888_avx2(src, dest, width, 0);
+}
+
+static __attribute__((target("avx2"))) void omx_fbdev_blit_bgr888_to_argb8888_avx2(const OMX_U8* src, OMX_U8* dest, OMX_U32 width) {
+  omx_fbdev_rgb24_to_argb8888_avx2(src, dest, width, 1);
+}
+
+/**  Same conversion as omx_fbdev_rgb888_to_16bit_ssse3, sixteen pixels at a time */
+static inline __attribute__((target("avx2"))) void omx_fbdev_rgb888_to_16bit_avx2(const OMX_U8* src, OMX_U8* dest, OMX_U32 width,
+                                                                                     int swap_rb, int r_shift, int g_mask, int g_shift) {
+  OMX_U16 chunk[FBDEV_BLIT_CHUNK];
+  const __m256i spread = _mm256_setr_epi8(0, -1, 3, -1, 6, -1, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                          0, -1, 3, -1, 6, -1, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+  const __m256i r_mask_v = _mm256_set1_epi16(0xf8);
+  const __m256i g_mask_v = _mm256_set1_epi16((short) g_mask);
+  const __m128i r_shift_v = _mm_cvtsi32_si128(r_shift);
+  const __m128i g_shift_v = _mm_cvtsi32_si128(g_shift);
+  OMX_U32 i, n;
+  OMX_U8 r, g, b;
+
+  for (; width > 0; width -= n, src += 3 * n, dest += 2 * n) {
+    n = (width < FBDEV_BLIT_CHUNK) ? width : FBDEV_BLIT_CHUNK;
+    for (i = 0; i + 18 <= width && i + 16 <= n; i += 16) {
+      //  Pixels 0-3 and 8-11 in the first vector, 4-7 and 12-15 in the second, so that
+      //  unpacking their low halves keeps the pixels in order
+      __m256i lo = omx_fbdev_load_lanes_avx2(src + 3 * i, src + 3 * i + 24);
+      __m256i hi = omx_fbdev_load_lanes_avx2(src + 3 * i + 12, src + 3 * i + 36);
+      __m256i first = _mm256_unpacklo_epi64(_mm256_shuffle_epi8(lo, spread), _mm256_shuffle_epi8(hi, spread));
+      __m256i green = _mm256_unpacklo_epi64(_mm256_shuffle_epi8(_mm256_srli_si256(lo, 1), spread), _mm256_shuffle_epi8(_mm256_srli_si256(hi, 1), spread));
+      __m256i third = _mm256_unpacklo_epi64(_mm256_shuffle_epi8(_mm256_srli_si256(lo, 2), spread), _mm256_shuffle_epi8(_mm256_srli_si256(hi, 2), spread));
+      __m256i red = swap_rb ? third : first;
+      __m256i blue = swap_rb ? first : third;
+      __m256i pixels = _mm256_or_si256(_mm256_or_si256(_mm256_sll_epi16(_mm256_and_si256(red, r_mask_v), r_shift_v),
+                                                       _mm256_sll_epi16(_mm256_and_si256(green, g_mask_v), g_shift_v)),
+                                       _mm256_srli_epi16(blue, 3));
+      _mm256_storeu_si256((__m256i*) (chunk + i), pixels);
+    }
+    for (; i < n; i++) {
+      r = src[3 * i + (swap_rb ? 2 : 0)];
+      g = src[3 * i + 1];
+      b = src[3 * i + (swap_rb ? 0 : 2)];
+      chunk[i] = (OMX_U16) (((r & 0xf8) << r_shift) | ((g & g_mask) << g_shift) | (b >> 3));
+    }
+    omx_fbdev_stream_row(dest, (const OMX_U8*) chunk, 2 * n);
+  }
+}
+
+static __attribute__((target("avx2"))) void omx_fbdev_blit_rgb888_to_rgb565_avx2(const OMX_U8* src, OMX_U8* dest, OMX_U32 width) {
+  omx_fbdev_rgb888_to_16bit_avx2(src, dest, width, 0, 8, 0xfc, 3);
+}
+
+static __attribute__((target("avx2"))) void omx_fbdev_blit_rgb888_to_bgr565_avx2(const OMX_U8* src, OMX_U8* dest, OMX_U32 width) {
+  omx_fbdev_rgb888_to_16bit_avx2(src, dest, width, 1, 8, 0xfc, 3);
+}
+
+static __attribute__((target("avx2"))) void omx_fbdev_blit_rgb888_to_argb1555_avx2(const OMX_U8* src, OMX_U8* dest, OMX_U32 width) {
+  omx_fbdev_rgb888_to_16bit_avx2(src, dest, width, 0, 7, 0xf8, 2);
+}
+
+/**  Same conversion as omx_fbdev_16bit_to_argb8888_ssse3, sixteen pixels at a time: the
+  *  interleaving works per lane, so the two halves are swapped back into pixel order
+  */
+static inline __attribute__((target("avx2"))) void omx_fbdev_16bit_to_argb8888_avx2(const OMX_U8* src, OMX_U8* dest, OMX_U32 width, int is_argb1555) {
+  OMX_U8 chunk[4 * FBDEV_BLIT_CHUNK];
+  const __m256i five_bits = _mm256_set1_epi16(0x1f);
+  const __m256i six_bits = _mm256_set1_epi16(0x3f);
+  const __m256i opaque = _mm256_set1_epi16((short) 0xff00);
+  OMX_U32 i, n;
+  OMX_U16 pixel;
+
+  for (; width > 0; width -= n, src += 2 * n, dest += 4 * n) {
+    n = (width < FBDEV_BLIT_CHUNK) ? width : FBDEV_BLIT_CHUNK;
+    for (i = 0; i + 16 <= n; i += 16) {
+      __m256i pixels = _mm256_loadu_si256((const __m256i*) (src + 2 * i));
+      __m256i blue = _mm256_slli_epi16(_mm256_and_si256(pixels, five_bits), 3);
+      __m256i green, red, alpha;
+      if (is_argb1555) {
+        green = _mm256_slli_epi16(_mm256_and_si256(_mm256_srli_epi16(pixels, 5), five_bits), 3);
+        red = _mm256_slli_epi16(_mm256_and_si256(_mm256_srli_epi16(pixels, 10), five_bits), 3);
+        alpha = _mm256_slli_epi16(_mm256_srli_epi16(pixels, 15), 15);
+      } else {
+        green = _mm256_slli_epi16(_mm256_and_si256(_mm256_srli_epi16(pixels, 5), six_bits), 2);
+        red = _mm256_slli_epi16(_mm256_srli_epi16(pixels, 11), 3);
+        alpha = opaque;
+      }
+      __m256i blue_green = _mm256_or_si256(blue, _mm256_slli_epi16(green, 8));
+      __m256i red_alpha = _mm256_or_si256(red, alpha);
+      __m256i low = _mm256_unpacklo_epi16(blue_green, red_alpha);
+      __m256i high = _mm256_unpackhi_epi16(blue_green, red_alpha);
+      _mm256_storeu_si256((__m256i*) (chunk + 4 * i), _mm256_permute2x128_si256(low, high, 0x20));
+      _mm256_storeu_si256((__m256i*) (chunk + 4 * i + 32), _mm256_permute2x128_si256(low, high, 0x31));
+    }
+    for (; i < n; i++) {
+      pixel = ((const OMX_U16*) src)[i];
+      chunk[4 * i + 0] = (OMX_U8) ((pixel & 0x001f) << 3);
+      if (is_argb1555) {
+        chunk[4 * i + 1] = (OMX_U8) (((pixel >> 5) & 0x001f) << 3);
+        chunk[4 * i + 2] = (OMX_U8) (((pixel >> 10) & 0x001f) << 3);
+        chunk[4 * i + 3] = (OMX_U8) ((pixel >> 15) << 7);
+      } else {
+        chunk[4 * i + 1] = (OMX_U8) (((pixel >> 5) & 0x003f) << 2);
+        chunk[4 * i + 2] = (OMX_U8) (((pixel >> 11) & 0x001f) << 3);
+        chunk[4 * i + 3] = 0xff;
+      }
+    }
+    omx_fbdev_stream_row(dest, chunk, 4 * n);
+  }
+}
+
+static __attribute__((target("avx2"))) void omx_fbdev_blit_argb1555_to_argb8888_avx2(const OMX_U8* src, OMX_U8* dest, OMX_U32 width) {
+  omx_fbdev_16bit_to_argb8888_avx2(src, dest, width, 1);
+}
+
+static __attribute__((target("avx2"))) void omx_fbdev_blit_rgb565_to_argb8888_avx2(const OMX_U8* src, OMX_U8* dest, OMX_U32 width) {
+  omx_fbdev_16bit_to_argb8888_avx2(src, dest, width, 0);
+}
+#endif
+
+#ifdef FBDEV_HAVE_NEON
+/**  NEON row blitters.
+  *  vld3 and vst4 split and merge the components of sixteen or eight pixels, so the
+  *  conversions are done on whole component vectors, the last pixels one by one.
+  */
+static inline void omx_fbdev_rgb24_to_argb8888_neon(const OMX_U8* src, OMX_U8* dest, OMX_U32 width, int swap_rb) {
+  OMX_U8 chunk[4 * FBDEV_BLIT_CHUNK];
+  OMX_U32 i, n;
+  uint8x16x3_t pixels;
+  uint8x16x4_t out;
+
+  out.val[3] = vdupq_n_u8(0xff);
+  for (; width > 0; width -= n, src += 3 * n, dest += 4 * n) {
+    n = (width < FBDEV_BLIT_CHUNK) ? width : FBDEV_BLIT_CHUNK;
+    for (i = 0; i + 16 <= n; i += 16) {
+      pixels = vld3q_u8(src + 3 * i);
+      out.val[0] = pixels.val[swap_rb ? 0 : 2];
+      out.val[1] = pixels.val[1];
+      out.val[2] = pixels.val[swap_rb ? 2 : 0];
+      vst4q_u8(chunk + 4 * i, out);
+    }
+    for (; i < n; i++) {
+      chunk[4 * i + 0] = src[3 * i + (swap_rb ? 0 : 2)];
+      chunk[4 * i + 1] = src[3 * i + 1];
+      chunk[4 * i + 2] = src[3 * i + (swap_rb ? 2 : 0)];
+      chunk[4 * i + 3] = 0xff;
+    }
+    omx_fbdev_stream_row(dest, chunk, 4 * n);
+  }
+}
+
+static void omx_fbdev_blit_rgb888_to_argb8888_neon(const OMX_U8* src, OMX_U8* dest, OMX_U32 width) {
+  omx_fbdev_rgb24_to_argb8888_neon(src, dest, width, 0);
+}
+
+static void omx_fbdev_blit_bgr888_to_argb8888_neon(const OMX_U8* src, OMX_U8* dest, OMX_U32 width) {
+  omx_fbdev_rgb24_to_argb8888_neon(src, dest, width, 1);
+}
+
+/**  Same conversion as omx_fbdev_rgb888_to_16bit_ssse3, eight pixels at a time */
+static inline void omx_fbdev_rgb888_to_16bit_neon(const OMX_U8* src, OMX_U8* dest, OMX_U32 width,
+                                                  int swap_rb, int r_shift, int g_mask, int g_shift) {
+  OMX_U16 chunk[FBDEV_BLIT_CHUNK];
+  const int16x8_t r_shift_v = vdupq_n_s16((int16_t) r_shift);
+  const int16x8_t g_shift_v = vdupq_n_s16((int16_t) g_shift);
+  const uint8x8_t r_mask_v = vdup_n_u8(0xf8);
+  const uint8x8_t g_mask_v = vdup_n_u8((uint8_t) g_mask);
+  OMX_U32 i, n;
+  OMX_U8 r, g, b;
+  uint8x8x3_t pixels;
+
+  for (; width > 0; width -= n, src += 3 * n, dest += 2 * n) {
+    n = (width < FBDEV_BLIT_CHUNK) ? width : FBDEV_BLIT_CHUNK;
+    for (i = 0; i + 8 <= n; i += 8) {
+      pixels = vld3_u8(src + 3 * i);
+      uint16x8_t red = vshlq_u16(vmovl_u8(vand_u8(pixels.val[swap_rb ? 2 : 0], r_mask_v)), r_shift_v);
+      uint16x8_t green = vshlq_u16(vmovl_u8(vand_u8(pixels.val[1], g_mask_v)), g_shift_v);
+      uint16x8_t blue = vmovl_u8(vshr_n_u8(pixels.val[swap_rb ? 0 : 2], 3));
+      vst1q_u16(chunk + i, vorrq_u16(vorrq_u16(red, green), blue));
+    }
+    for (; i < n; i++) {
+      r = src[3 * i + (swap_rb ? 2 : 0)];
+      g = src[3 * i + 1];
+      b = src[3 * i + (swap_rb ? 0 : 2)];
+      chunk[i] = (OMX_U16) (((r & 0xf8) << r_shift) | ((g & g_mask) << g_shift) | (b >> 3));
+    }
+    omx_fbdev_stream_row(dest, (const OMX_U8*) chunk, 2 * n);
+  }
+}
+
+static void omx_fbdev_blit_rgb888_to_rgb565_neon(const OMX_U8* src, OMX_U8* dest, OMX_U32 width) {
+  omx_fbdev_rgb888_to_16bit_neon(src, dest, width, 0, 8, 0xfc, 3);
+}
+
+static void omx_fbdev_blit_rgb888_to_bgr565_neon(const OMX_U8* src, OMX_U8* dest, OMX_U32 width) {
+  omx_fbdev_rgb888_to_16bit_neon(src, dest, width, 1, 8, 0xfc, 3);
+}
+
+static void omx_fbdev_blit_rgb888_to_argb1555_neon(const OMX_U8* src, OMX_U8* dest, OMX_U32 width) {
+  omx_fbdev_rgb888_to_16bit_neon(src, dest, width, 0, 7, 0xf8, 2);
+}
+
+/**  Same conversion as omx_fbdev_16bit_to_argb8888_ssse3, eight pixels at a time */
+static inline void omx_fbdev_16bit_to_argb8888_neon(const OMX_U8* src, OMX_U8* dest, OMX_U32 width, int is_argb1555) {
+  OMX_U8 chunk[4 * FBDEV_BLIT_CHUNK];
+  const uint16x8_t five_bits = vdupq_n_u16(0x1f);
+  const uint16x8_t six_bits = vdupq_n_u16(0x3f);
+  OMX_U32 i, n;
+  OMX_U16 pixel;
+  uint8x8x4_t out;
+
+  for (; width > 0; width -= n, src += 2 * n, dest += 4 * n) {
+    n = (width < FBDEV_BLIT_CHUNK) ? width : FBDEV_BLIT_CHUNK;
+    for (i = 0; i + 8 <= n; i += 8) {
+      uint16x8_t pixels = vld1q_u16((const uint16_t*) (src + 2 * i));
+      out.val[0] = vmovn_u16(vshlq_n_u16(vandq_u16(pixels, five_bits), 3));
+      if (is_argb1555) {
+        out.val[1] = vmovn_u16(vshlq_n_u16(vandq_u16(vshrq_n_u16(pixels, 5), five_bits), 3));
+        out.val[2] = vmovn_u16(vshlq_n_u16(vandq_u16(vshrq_n_u16(pixels, 10), five_bits), 3));
+        out.val[3] = vmovn_u16(vshlq_n_u16(vshrq_n_u16(pixels, 15), 7));
+      } else {
+        out.val[1] = vmovn_u16(vshlq_n_u16(vandq_u16(vshrq_n_u16(pixels, 5), six_bits), 2));
+        out.val[2] = vmovn_u16(vshlq_n_u16(vshrq_n_u16(pixels, 11), 3));
+        out.val[3] = vdup_n_u8(0xff);
+      }
+      vst4_u8(chunk + 4 * i, out);
+    }
+    for (; i < n; i++) {
+      pixel = ((const OMX_U16*) src)[i];
+      chunk[4 * i + 0] = (OMX_U8) ((pixel & 0x001f) << 3);
+      if (is_argb1555) {
+        chunk[4 * i + 1] = (OMX_U8) (((pixel >> 5) & 0x001f) << 3);
+        chunk[4 * i + 2] = (OMX_U8) (((pixel >> 10) & 0x001f) << 3);
+        chunk[4 * i + 3] = (OMX_U8) ((pixel >> 15) << 7);
+      } else {
+        chunk[4 * i + 1] = (OMX_U8) (((pixel >> 5) & 0x003f) << 2);
+        chunk[4 * i + 2] = (OMX_U8) (((pixel >> 11) & 0x001f) << 3);
+        chunk[4 * i + 3] = 0xff;
+      }
+    }
+    omx_fbdev_stream_row(dest, chunk, 4 * n);
+  }
+}
+
+static void omx_fbdev_blit_argb1555_to_argb8888_neon(const OMX_U8* src, OMX_U8* dest, OMX_U32 width) {
+  omx_fbdev_16bit_to_argb8888_neon(src, dest, width, 1);
+}
+
+static void omx_fbdev_blit_rgb565_to_argb8888_neon(const OMX_U8* src, OMX_U8* dest, OMX_U32 width) {
+  omx_fbdev_16bit_to_argb8888_neon(src, dest, width, 0);
+}
+#endif
+
+/**  Row blitters of one instruction set, NULL where it has none */
+typedef struct omx_fbdev_blitter_set {
+  omx_fbdev_blit_row rgb888_to_rgb565;
+  omx_fbdev_blit_row rgb888_to_bgr565;
+  omx_fbdev_blit_row rgb888_to_argb1555;
+  omx_fbdev_blit_row rgb888_to_argb8888;
+  omx_fbdev_blit_row bgr888_to_argb8888;
+  omx_fbdev_blit_row argb8888_to_argb8888;
+  omx_fbdev_blit_row argb1555_to_argb8888;
+  omx_fbdev_blit_row rgb565_to_argb8888;
+} omx_fbdev_blitter_set;
+
+static const omx_fbdev_blitter_set omx_fbdev_blitters_c = {
+  omx_fbdev_blit_rgb888_to_rgb565, omx_fbdev_blit_rgb888_to_bgr565, omx_fbdev_blit_rgb888_to_argb1555,
+  omx_fbdev_blit_rgb888_to_argb8888, omx_fbdev_blit_bgr888_to_argb8888, omx_fbdev_blit_argb8888_to_argb8888,
+  omx_fbdev_blit_argb1555_to_argb8888, omx_fbdev_blit_rgb565_to_argb8888
+};
+
+#ifdef FBDEV_HAVE_SSSE3
+static const omx_fbdev_blitter_set omx_fbdev_blitters_ssse3 = {
+  omx_fbdev_blit_rgb888_to_rgb565_ssse3, omx_fbdev_blit_rgb888_to_bgr565_ssse3, omx_fbdev_blit_rgb888_to_argb1555_ssse3,
+  omx_fbdev_blit_rgb888_to_argb8888_ssse3, omx_fbdev_blit_bgr888_to_argb8888_ssse3, NULL,
+  omx_fbdev_blit_argb1555_to_argb8888_ssse3, omx_fbdev_blit_rgb565_to_argb8888_ssse3
+};
+#endif
+
+#ifdef FBDEV_HAVE_AVX2
+static const omx_fbdev_blitter_set omx_fbdev_blitters_avx2 = {
+  omx_fbdev_blit_rgb888_to_rgb565_avx2, omx_fbdev_blit_rgb888_to_bgr565_avx2, omx_fbdev_blit_rgb888_to_argb1555_avx2,
+  omx_fbdev_blit_rgb888_to_argb8888_avx2, omx_fbdev_blit_bgr888_to_argb8888_avx2, NULL,
+  omx_fbdev_blit_argb1555_to_argb8888_avx2, omx_fbdev_blit_rgb565_to_argb8888_avx2
+};
+#endif
+
+#ifdef FBDEV_HAVE_NEON
+static const omx_fbdev_blitter_set omx_fbdev_blitters_neon = {
+  omx_fbdev_blit_rgb888_to_rgb565_neon, omx_fbdev_blit_rgb888_to_bgr565_neon, omx_fbdev_blit_rgb888_to_argb1555_neon,
+  omx_fbdev_blit_rgb888_to_argb8888_neon, omx_fbdev_blit_bgr888_to_argb8888_neon, NULL,
+  omx_fbdev_blit_argb1555_to_argb8888_neon, omx_fbdev_blit_rgb565_to_argb8888_neon
+};
+#endif
+
+/**  Returns the blitter of set converting colorformat rows to fbpxlfmt rows, NULL if the set has none.
+  *  The conversions are the same as the pixel by pixel ones of omx_img_copy.
+  *  Planar YUV rows are turned into RGB888 by omx_img_copy, so they get the RGB888 blitter.
+  */
+static omx_fbdev_blit_row omx_fbdev_blitter_of_set(const omx_fbdev_blitter_set* set, OMX_COLOR_FORMATTYPE colorformat, OMX_COLOR_FORMATTYPE fbpxlfmt) {
+  switch (colorformat) {
+    case OMX_COLOR_FormatYUV411Planar:
+    case OMX_COLOR_FormatYUV411PackedPlanar:
+    case OMX_COLOR_FormatYUV420Planar:
+    case OMX_COLOR_FormatYUV420PackedPlanar:
+    case OMX_COLOR_FormatYUV422Planar:
+    case OMX_COLOR_FormatYUV422PackedPlanar:
+      return omx_fbdev_blitter_of_set(set, OMX_COLOR_Format24bitRGB888, fbpxlfmt);
+    default:
+      break;
+  }
+  if (colorformat == OMX_COLOR_Format24bitRGB888) {
+    switch (fbpxlfmt) {
+      case OMX_COLOR_Format16bitRGB565:
+        return set->rgb888_to_rgb565;
+      case OMX_COLOR_Format16bitBGR565:
+        return set->rgb888_to_bgr565;
+      case OMX_COLOR_Format16bitARGB1555:
+        return set->rgb888_to_argb1555;
+      case OMX_COLOR_Format8bitRGB332:
+      case OMX_COLOR_Format32bitARGB8888:
+        return set->rgb888_to_argb8888;
+      default:
+        return NULL;
+    }
+  }
+  if (fbpxlfmt != OMX_COLOR_Format32bitARGB8888) {
+    return NULL;
+  }
+  switch (colorformat) {
+    case OMX_COLOR_Format24bitBGR888:
+      return set->bgr888_to_argb8888;
+    case OMX_COLOR_Format32bitBGRA8888:
+    case OMX_COLOR_Format32bitARGB8888:
+      return set->argb8888_to_argb8888;
+    case OMX_COLOR_Format16bitARGB1555:
+      return set->argb1555_to_argb8888;
+    case OMX_COLOR_Format16bitRGB565:
+    case OMX_COLOR_Format16bitBGR565:
+      return set->rgb565_to_argb8888;
+    default:
+      return NULL;
+  }
+}
+
+OMX_U32 omx_fbdev_simd_support(void) {
+  OMX_U32 simd = FBDEV_SIMD_NONE;
+#ifdef FBDEV_HAVE_SSSE3
+  if (__builtin_cpu_supports("ssse3")) {
+    simd |= FBDEV_SIMD_SSSE3;
+  }
+#endif
+#ifdef FBDEV_HAVE_AVX2
+  if (__builtin_cpu_supports("avx2")) {
+    simd |= FBDEV_SIMD_AVX2;
+  }
+#endif
+#ifdef FBDEV_HAVE_NEON
+  simd |= FBDEV_SIMD_NEON;
+#endif
+  return simd;
 }
 
+/**  Returns the row blitter converting colorformat rows to fbpxlfmt rows with the widest of
+  *  the simd extensions that has one, the plain C one otherwise,
+  *  or NULL if omx_img_copy has to convert them pixel by pixel
+  */
+omx_fbdev_blit_row omx_fbdev_find_blitter_simd(OMX_COLOR_FORMATTYPE colorformat, OMX_COLOR_FORMATTYPE fbpxlfmt, OMX_U32 simd) {
+  omx_fbdev_blit_row blit_row = NULL;
+
+#ifdef FBDEV_HAVE_AVX2
+  if (blit_row == NULL && (simd & FBDEV_SIMD_AVX2)) {
+    blit_row = omx_fbdev_blitter_of_set(&omx_fbdev_blitters_avx2, colorformat, fbpxlfmt);
+  }
+#endif
+#ifdef FBDEV_HAVE_SSSE3
+  if (blit_row == NULL && (simd & FBDEV_SIMD_SSSE3)) {
+    blit_row = omx_fbdev_blitter_of_set(&omx_fbdev_blitters_ssse3, colorformat, fbpxlfmt);
+  }
+#endif
+#ifdef FBDEV_HAVE_NEON
+  if (blit_row == NULL && (simd & FBDEV_SIMD_NEON)) {
+    blit_row = omx_fbdev_blitter_of_set(&omx_fbdev_blitters_neon, colorformat, fbpxlfmt);
+  }
+#endif
+  if (blit_row == NULL) {
+    blit_row = omx_fbdev_blitter_of_set(&omx_fbdev_blitters_c, colorformat, fbpxlfmt);
+  }
+  return blit_row;
+}
+
+/**  Returns the fastest row blitter the processor runs converting colorformat rows to fbpxlfmt rows,
+  *  or NULL if omx_img_copy has to convert them pixel by pixel
+  */
+omx_fbdev_blit_row omx_fbdev_find_blitter(OMX_COLOR_FORMATTYPE colorformat, OMX_COLOR_FORMATTYPE fbpxlfmt) {
+  return omx_fbdev_find_blitter_simd(colorformat, fbpxlfmt, omx_fbdev_simd_support());
+}
+
+/**  Clamps value to 0..255 without branches, colors saturate too often for them to predict well */
+static inline OMX_U8 omx_fbdev_clip(int value) {
+  value &= ~(value >> 31);
+  return (OMX_U8) (value | ((255 - value) >> 31));
+}
+
+/**  Converts width pixels of a planar YUV row to RGB888 with the BT.601 video range coefficients
+  *  in 8 bit fixed point, the ones swscale uses by default in the color converter.
+  *  Pixel i takes its chroma from sample (phase + i) >> chroma_shift of the u and v rows.
+  *  The chroma terms are worked out once per chroma sample, not once per pixel.
+  */
+static void omx_fbdev_yuv_row_to_rgb888(const OMX_U8* y, const OMX_U8* u, const OMX_U8* v,
+                                        OMX_U32 phase, OMX_U32 chroma_shift, OMX_U8* rgb, OMX_U32 width) {
+  OMX_U32 group = 1 << chroma_shift;
+  OMX_U32 i = 0, j, n;
+  for (; i < width; u++, v++) {
+    int d = *u - 128;
+    int e = *v - 128;
+    int r = 409 * e;
+    int g = -100 * d - 208 * e;
+    int b = 516 * d;
+    //  The first chroma sample may cover fewer pixels when the row starts at an odd phase
+    n = group - ((i == 0) ? phase : 0);
+    if (n > width - i) {
+      n = width - i;
+    }
+    for (j = 0; j < n; j++, i++, rgb += 3) {
+      int c = 298 * (y[i] - 16) + 128;
+      rgb[0] = omx_fbdev_clip((c + r) >> 8);
+      rgb[1] = omx_fbdev_clip((c + g) >> 8);
+      rgb[2] = omx_fbdev_clip((c + b) >> 8);
+    }
+  }
+}
+
+#ifdef FBDEV_HAVE_SSSE3
+/**  Horizontally subsampled (4:2:0 and 4:2:2) rows with SSSE3, 16 pixels at a time.
+  *  Every sum of omx_fbdev_yuv_row_to_rgb888 is made exactly, in 32 bit lanes by pmaddwd on
+  *  (luma, chroma) pairs, and clamped by the saturating packs, so the result is the same.
+  */
+static __attribute__((target("ssse3"))) void omx_fbdev_yuv_row_to_rgb888_ssse3(const OMX_U8* y, const OMX_U8* u, const OMX_U8* v,
+                                                                                OMX_U32 phase, OMX_U32 chroma_shift, OMX_U8* rgb, OMX_U32 width) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i y_bias = _mm_set1_epi16(16);
+  const __m128i c_bias = _mm_set1_epi16(128);
+  const __m128i round = _mm_set1_epi32(128);
+  const __m128i k_r = _mm_set1_epi32((409 << 16) | 298);
+  const __m128i k_g = _mm_set1_epi32((int) ((OMX_U32) (-100 << 16) | 298));
+  const __m128i k_g_e = _mm_set1_epi32(-208 & 0xffff);
+  const __m128i k_b = _mm_set1_epi32((516 << 16) | 298);
+  //  Interleave 16 red, green and blue bytes into 48 bytes of RGB888
+  const __m128i r0 = _mm_setr_epi8(0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1, 5);
+  const __m128i g0 = _mm_setr_epi8(-1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1);
+  const __m128i b0 = _mm_setr_epi8(-1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1);
+  const __m128i r1 = _mm_setr_epi8(-1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10, -1);
+  const __m128i g1 = _mm_setr_epi8(5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10);
+  const __m128i b1 = _mm_setr_epi8(-1, 5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1);
+  const __m128i r2 = _mm_setr_epi8(-1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1, -1);
+  const __m128i g2 = _mm_setr_epi8(-1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1);
+  const __m128i b2 = _mm_setr_epi8(10, -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15);
+  OMX_U32 i = 0, k;
+
+  if (phase != 0) {
+    //  The row starts on the second pixel of a chroma sample
+    omx_fbdev_yuv_row_to_rgb888(y, u, v, phase, chroma_shift, rgb, 1);
+    i = 1;
+    u++;
+    v++;
+    rgb += 3;
+  }
+  for (; i + 16 <= width; i += 16, u += 8, v += 8, rgb += 48) {
+    __m128i luma = _mm_loadu_si128((const __m128i*) (y + i));
+    __m128i d = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*) u), zero), c_bias);
+    __m128i e = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*) v), zero), c_bias);
+    __m128i r8, g8, b8, r16[2], g16[2], b16[2];
+
+    for (k = 0; k < 2; k++) {
+      __m128i yk = _mm_sub_epi16(k ? _mm_unpackhi_epi8(luma, zero) : _mm_unpacklo_epi8(luma, zero), y_bias);
+      __m128i dk = k ? _mm_unpackhi_epi16(d, d) : _mm_unpacklo_epi16(d, d);
+      __m128i ek = k ? _mm_unpackhi_epi16(e, e) : _mm_unpacklo_epi16(e, e);
+      __m128i ye_lo = _mm_unpacklo_epi16(yk, ek), ye_hi = _mm_unpackhi_epi16(yk, ek);
+      __m128i yd_lo = _mm_unpacklo_epi16(yk, dk), yd_hi = _mm_unpackhi_epi16(yk, dk);
+      __m128i e_lo = _mm_unpacklo_epi16(ek, zero), e_hi = _mm_unpackhi_epi16(ek, zero);
+
+      r16[k] = _mm_packs_epi32(_mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(ye_lo, k_r), round), 8),
+                               _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(ye_hi, k_r), round), 8));
+      g16[k] = _mm_packs_epi32(_mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(yd_lo, k_g), _mm_madd_epi16(e_lo, k_g_e)), round), 8),
+                               _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(yd_hi, k_g), _mm_madd_epi16(e_hi, k_g_e)), round), 8));
+      b16[k] = _mm_packs_epi32(_mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yd_lo, k_b), round), 8),
+                               _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yd_hi, k_b), round), 8));
+    }
+    r8 = _mm_packus_epi16(r16[0], r16[1]);
+    g8 = _mm_packus_epi16(g16[0], g16[1]);
+    b8 = _mm_packus_epi16(b16[0], b16[1]);
+    _mm_storeu_si128((__m128i*) rgb, _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r8, r0), _mm_shuffle_epi8(g8, g0)), _mm_shuffle_epi8(b8, b0)));
+    _mm_storeu_si128((__m128i*) (rgb + 16), _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r8, r1), _mm_shuffle_epi8(g8, g1)), _mm_shuffle_epi8(b8, b1)));
+    _mm_storeu_si128((__m128i*) (rgb + 32), _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r8, r2), _mm_shuffle_epi8(g8, g2)), _mm_shuffle_epi8(b8, b2)));
+  }
+  if (i < width) {
+    omx_fbdev_yuv_row_to_rgb888(y + i, u, v, 0, chroma_shift, rgb, width - i);
+  }
+}
+#endif
+
+/**  Converts a crop rectangle of planar YUV straight into the frame buffer.
+  *  Each row goes a chunk at a time through RGB888 in a buffer on the stack and the RGB888 row
+  *  blitter of the frame buffer format, so no intermediate RGB frame is ever written.
+  *  The plane pointers and strides are the ones omx_img_copy computes for the crop rectangle,
+  *  chroma_shift_x and chroma_shift_y are the chroma subsampling as powers of two.
+  */
+static void omx_fbdev_blit_yuv_rows(const OMX_U8* src_Y_ptr, OMX_S32 src_luma_stride,
+                                    const OMX_U8* src_U_ptr, const OMX_U8* src_V_ptr, OMX_S32 src_chroma_stride,
+                                    OMX_U32 chroma_shift_x, OMX_U32 chroma_shift_y,
+                                    OMX_U32 src_offset_x, OMX_U32 src_offset_y,
+                                    OMX_U8* dest_ptr, OMX_S32 dest_row_step, OMX_U32 dest_pixel_bytes,
+                                    OMX_U32 cpy_width, OMX_U32 cpy_height, omx_fbdev_blit_row blit_row) {
+  OMX_U8 rgb[3 * FBDEV_BLIT_CHUNK];
+  OMX_U32 phase_x = src_offset_x & ((1 << chroma_shift_x) - 1);
+  OMX_U32 phase_y = src_offset_y & ((1 << chroma_shift_y) - 1);
+  OMX_U32 i, x, n;
+  void (*yuv_row)(const OMX_U8*, const OMX_U8*, const OMX_U8*, OMX_U32, OMX_U32, OMX_U8*, OMX_U32) = omx_fbdev_yuv_row_to_rgb888;
+
+#ifdef FBDEV_HAVE_SSSE3
+  if (chroma_shift_x == 1 && __builtin_cpu_supports("ssse3")) {
+    yuv_row = omx_fbdev_yuv_row_to_rgb888_ssse3;
+  }
+#endif
+  for (i = 0; i < cpy_height; i++, src_Y_ptr += src_luma_stride, dest_ptr += dest_row_step) {
+    OMX_S32 chroma_row = (OMX_S32) ((phase_y + i) >> chroma_shift_y) * src_chroma_stride;
+    const OMX_U8* u = src_U_ptr + chroma_row;
+    const OMX_U8* v = src_V_ptr + chroma_row;
+    for (x = 0; x < cpy_width; x += n) {
+      n = (cpy_width - x < FBDEV_BLIT_CHUNK) ? cpy_width - x : FBDEV_BLIT_CHUNK;
+      //  Each chunk starts from the chroma sample of its first pixel
+      yuv_row(src_Y_ptr + x, u + ((phase_x + x) >> chroma_shift_x), v + ((phase_x + x) >> chroma_shift_x),
+                                  (phase_x + x) & ((1 << chroma_shift_x) - 1), chroma_shift_x, rgb, n);
+      blit_row(rgb, dest_ptr + x * dest_pixel_bytes, n);
+    }
+  }
+#if defined(FBDEV_HAVE_SSSE3) && defined(__SSE2__)
+  /** make the non-temporal stores visible before the page is shown */
+  _mm_sfence();
+#endif
+}
 
 /**  This function copies source image to destination image of required dimension and color formats
   * @param src_ptr is the source image string pointer
@@ -508,12 +1797,16 @@ OMX_COLOR_FORMATTYPE find_omx_pxlfmt(struct fb_var_screeninfo *vscr_info) {
   * @param cpy_height is the source image copy height - it determines the portion of source image to be copied from source to destination image
   * @param colorformat is the source image color format
   * @param fbpxlfmt undocumented
+  * @param rotation is the clockwise rotation of the copied image, 0, 90, 180 or 270 degrees
+  * @param blit_row is the row blitter for colorformat and fbpxlfmt, or NULL to convert pixel by pixel.
+  *  Planar YUV images are converted into the frame buffer when there is one, otherwise their planes are copied as they are
   */
 void omx_img_copy(OMX_U8* src_ptr, OMX_S32 src_stride, OMX_U32 src_width, OMX_U32 src_height,
                   OMX_S32 src_offset_x, OMX_S32 src_offset_y,
                   OMX_U8* dest_ptr, OMX_S32 dest_stride, OMX_U32 dest_width,  OMX_U32 dest_height,
                   OMX_S32 dest_offset_x, OMX_S32 dest_offset_y,
-                  OMX_S32 cpy_width, OMX_U32 cpy_height, OMX_COLOR_FORMATTYPE colorformat,OMX_COLOR_FORMATTYPE fbpxlfmt) {
+                  OMX_S32 cpy_width, OMX_U32 cpy_height, OMX_COLOR_FORMATTYPE colorformat,OMX_COLOR_FORMATTYPE fbpxlfmt,
+                  OMX_U32 rotation, omx_fbdev_blit_row blit_row) {
 
   OMX_U32 i,j;
   OMX_U32 cp_byte; //equal to source image byte per pixel value
@@ -564,6 +1857,13 @@ void omx_img_copy(OMX_U8* src_ptr, OMX_S32 src_stride, OMX_U32 src_width, OMX_U3
     OMX_U32 chroma_crop_width;   //  Width in bytes of a chroma row in the crop rectangle
     OMX_U32 chroma_crop_height;  //  Number of chroma rows in crop rectangle
 
+    OMX_U32 chroma_shift_x;      //  Horizontal chroma subsampling as a power of two
+    OMX_U32 chroma_shift_y;      //  Vertical chroma subsampling as a power of two
+
+    if (rotation != 0) {
+      DEBUG(DEB_LEV_ERR, "rotation of planar YUV images is not supported, copying unrotated\n");
+    }
+
     switch (colorformat) {
       /**  Watch out for odd or non-multiple-of-4 (4:1:1) luma resolutions (I don't check)  */
       /**  Planar vs. PackedPlanar will have to be handled differently if/when slicing is implemented */
@@ -601,6 +1901,8 @@ void omx_img_copy(OMX_U8* src_ptr, OMX_S32 src_stride, OMX_U32 src_width, OMX_U3
         luma_crop_height = cpy_height;
         chroma_crop_width = luma_crop_width  >> 2;
         chroma_crop_height = luma_crop_height;
+        chroma_shift_x = 2;
+        chroma_shift_y = 0;
         break;
 
       /**  Planar vs. PackedPlanar will have to be handled differently if/when slicing is implemented */
@@ -634,6 +1936,8 @@ void omx_img_copy(OMX_U8* src_ptr, OMX_S32 src_stride, OMX_U32 src_width, OMX_U3
         luma_crop_height = cpy_height;
         chroma_crop_width = luma_crop_width >> 1;
         chroma_crop_height = luma_crop_height >> 1;
+        chroma_shift_x = 1;
+        chroma_shift_y = 1;
         break;
       /**  Planar vs. PackedPlanar will have to be handled differently if/when slicing is implemented */
       case OMX_COLOR_FormatYUV422Planar:
@@ -666,6 +1970,8 @@ void omx_img_copy(OMX_U8* src_ptr, OMX_S32 src_stride, OMX_U32 src_width, OMX_U3
         luma_crop_height = cpy_height;
         chroma_crop_width = luma_crop_width >> 1;
         chroma_crop_height = luma_crop_height;
+        chroma_shift_x = 1;
+        chroma_shift_y = 0;
         break;
       default:
         DEBUG(DEB_LEV_ERR,"\n color format not supported --error \n");
@@ -700,6 +2006,27 @@ void omx_img_copy(OMX_U8* src_ptr, OMX_S32 src_stride, OMX_U32 src_width, OMX_U3
     OMX_U8* src_U_ptr = U_input_ptr + src_chroma_offset;
     OMX_U8*  src_V_ptr = V_input_ptr + src_chroma_offset;
 
+    if (blit_row != NULL) {
+      /**  The frame buffer is RGB: convert the crop rectangle straight into it */
+      OMX_U32 fb_pixel_bytes = (fbpxlfmt == OMX_COLOR_Format16bitRGB565 ||
+                                fbpxlfmt == OMX_COLOR_Format16bitBGR565 ||
+                                fbpxlfmt == OMX_COLOR_Format16bitARGB1555) ? 2 : 4;
+      OMX_U32 fb_line = (OMX_U32) abs(dest_stride);
+      OMX_U8* fb_ptr = dest_ptr + dest_offset_y * fb_line + dest_offset_x * fb_pixel_bytes;
+      OMX_S32 fb_row_step = (OMX_S32) fb_line;
+
+      //  A negative output stride draws the picture upside down
+      if (dest_stride < 0) {
+        fb_ptr += (luma_crop_height - 1) * fb_line;
+        fb_row_step = -fb_row_step;
+      }
+      omx_fbdev_blit_yuv_rows(src_Y_ptr, src_luma_stride, src_U_ptr, src_V_ptr, src_chroma_stride,
+                              chroma_shift_x, chroma_shift_y, src_luma_offset_x, src_luma_offset_y,
+                              fb_ptr, fb_row_step, fb_pixel_bytes,
+                              (OMX_U32) abs(cpy_width), luma_crop_height, blit_row);
+      return;
+    }
+
     /**  Pointers to destination planes to make things easier */
     OMX_U8* Y_output_ptr = dest_ptr;
     OMX_U8* U_output_ptr = Y_output_ptr + ((OMX_U32) abs(dest_luma_stride) * dest_luma_height);
@@ -740,6 +2067,46 @@ void omx_img_copy(OMX_U8* src_ptr, OMX_S32 src_stride, OMX_U32 src_width, OMX_U3
     }
   } else {
 
+    if (rotation != 0) {
+      /**  Cut the turned picture to the part that falls inside dest_width x dest_height. The rows and
+        *  columns of the crop rectangle that would land past the right or bottom edge are left out
+        */
+      OMX_U32 turned_width = (rotation == 180) ? (OMX_U32) abs(cpy_width) : cpy_height;
+      OMX_U32 turned_height = (rotation == 180) ? cpy_height : (OMX_U32) abs(cpy_width);
+      OMX_U32 room_x = (dest_offset_x < (OMX_S32) dest_width) ? dest_width - (OMX_U32) dest_offset_x : 0;
+      OMX_U32 room_y = (dest_offset_y < (OMX_S32) dest_height) ? dest_height - (OMX_U32) dest_offset_y : 0;
+      OMX_U32 cut_x = (turned_width > room_x) ? turned_width - room_x : 0;
+      OMX_U32 cut_y = (turned_height > room_y) ? turned_height - room_y : 0;
+      OMX_U32 skip_rows = 0, cut_rows = 0, skip_columns = 0, cut_columns = 0;
+
+      if (room_x == 0 || room_y == 0) {
+        return;
+      }
+      switch (rotation) {
+        case 90:    //  rows run right to left, columns top to bottom
+          skip_rows = cut_x;
+          cut_columns = cut_y;
+          break;
+        case 180:   //  rows run bottom to top, columns right to left
+          skip_rows = cut_y;
+          skip_columns = cut_x;
+          break;
+        default:    //  270: rows run left to right, columns bottom to top
+          cut_rows = cut_x;
+          skip_columns = cut_y;
+          break;
+      }
+      //  Rows are read bottom row first when mirrored, the rows skipped are then at the bottom of the rectangle
+      if ((src_stride < 0) != (dest_stride < 0)) {
+        src_offset_y += (OMX_S32) cut_rows;
+      } else {
+        src_offset_y += (OMX_S32) skip_rows;
+      }
+      cpy_height -= skip_rows + cut_rows;
+      src_offset_x += (OMX_S32) skip_columns;
+      cpy_width = (OMX_S32) ((OMX_U32) abs(cpy_width) - skip_columns - cut_columns);
+    }
+
     OMX_U32 cpy_byte_width = calcStride((OMX_U32) abs(cpy_width), colorformat);  //  Bytes width to copy
     OMX_U32 src_byte_offset_x = calcStride((OMX_U32) abs(src_offset_x), colorformat);
     OMX_U32 dest_byte_offset_x = calcStride((OMX_U32) abs(dest_offset_x), colorformat);
@@ -766,6 +2133,81 @@ void omx_img_copy(OMX_U8* src_ptr, OMX_S32 src_stride, OMX_U32 src_width, OMX_U3
 
     DEBUG(DEB_LEV_SIMPLE_SEQ, "height=%d,width=%d,dest_stride=%d\n",(int)cpy_height,(int)cpy_byte_width,(int)dest_stride);
 
+    /**  Rotation by quarter turns: the crop rectangle is read top row first (bottom row first when
+      *  mirrored) and written so that its rows run along the rotated frame buffer axes.
+      */
+    OMX_U32 rect_width = (OMX_U32) abs(cpy_width);
+    OMX_S32 dest_pixel_step = (fbpxlfmt == OMX_COLOR_Format16bitRGB565 ||
+                               fbpxlfmt == OMX_COLOR_Format16bitBGR565 ||
+                               fbpxlfmt == OMX_COLOR_Format16bitARGB1555) ? 2 : 4;
+    OMX_S32 src_row_step = src_stride;
+    OMX_S32 dest_row_step = dest_stride;
+
+    if (rotation != 0 && rect_width > FBDEV_ROTATE_STRIPE_WIDTH) {
+      /**  Wide rotated pictures are copied as stripes a few pixels wide, each one a crop rectangle
+        *  of its own, so the frame buffer lines written by a stripe stay in the cache until it is done
+        */
+      OMX_U32 stripe_x, stripe_width;
+      for (stripe_x = 0; stripe_x < rect_width; stripe_x += FBDEV_ROTATE_STRIPE_WIDTH) {
+        stripe_width = (rect_width - stripe_x < FBDEV_ROTATE_STRIPE_WIDTH) ? rect_width - stripe_x : FBDEV_ROTATE_STRIPE_WIDTH;
+        omx_img_copy(src_ptr, src_stride, src_width, src_height, src_offset_x + (OMX_S32) stripe_x, src_offset_y,
+                     dest_ptr, dest_stride, dest_width, dest_height,
+                     dest_offset_x + ((rotation == 180) ? (OMX_S32) (rect_width - stripe_x - stripe_width) : 0),
+                     dest_offset_y + ((rotation == 90) ? (OMX_S32) stripe_x :
+                                      (rotation == 270) ? (OMX_S32) (rect_width - stripe_x - stripe_width) : 0),
+                     (OMX_S32) stripe_width, cpy_height, colorformat, fbpxlfmt, rotation, blit_row);
+      }
+      return;
+    }
+
+    if (rotation != 0) {
+      OMX_S32 src_line = abs(src_stride);
+      OMX_S32 fb_line = abs(dest_stride);
+      OMX_S32 fb_pixel = dest_pixel_step;
+      OMX_BOOL mirror = ((src_stride < 0) != (dest_stride < 0)) ? OMX_TRUE : OMX_FALSE;
+      OMX_U32 first_row = src_offset_y + (mirror ? cpy_height - 1 : 0);
+
+      //  A negative input stride means the rows are stored bottom-to-top
+      if (src_stride < 0) {
+        src_cpy_ptr = src_ptr + (src_height - 1 - first_row) * src_line + src_byte_offset_x;
+        src_row_step = mirror ? src_line : -src_line;
+      } else {
+        src_cpy_ptr = src_ptr + first_row * src_line + src_byte_offset_x;
+        src_row_step = mirror ? -src_line : src_line;
+      }
+
+      dest_cpy_ptr = dest_ptr + dest_offset_y * fb_line + dest_offset_x * fb_pixel;
+      switch (rotation) {
+        case 90:
+          dest_cpy_ptr += (cpy_height - 1) * fb_pixel;
+          dest_pixel_step = fb_line;
+          dest_row_step = -fb_pixel;
+          break;
+        case 180:
+          dest_cpy_ptr += (cpy_height - 1) * fb_line + (rect_width - 1) * fb_pixel;
+          dest_pixel_step = -fb_pixel;
+          dest_row_step = -fb_line;
+          break;
+        default:  //  270
+          dest_cpy_ptr += (rect_width - 1) * fb_line;
+          dest_pixel_step = -fb_line;
+          dest_row_step = fb_pixel;
+          break;
+      }
+    }
+
+    if (rotation == 0 && blit_row != NULL) {
+      /** unrotated rows are converted a chunk at a time by the row blitter */
+      for (i = 0; i < cpy_height; ++i, src_cpy_ptr += src_row_step, dest_cpy_ptr += dest_row_step) {
+        blit_row(src_cpy_ptr, dest_cpy_ptr, rect_width);
+      }
+#if defined(FBDEV_HAVE_SSSE3) && defined(__SSE2__)
+      /** make the non-temporal stores visible before the page is shown */
+      _mm_sfence();
+#endif
+      return;
+    }
+
     if(fbpxlfmt == OMX_COLOR_Format8bitRGB332 && colorformat == OMX_COLOR_Format24bitRGB888) {
       cp_byte = 3;
       for (i = 0; i < cpy_height; ++i) {
@@ -784,12 +2226,12 @@ void omx_img_copy(OMX_U8* src_ptr, OMX_S32 src_stride, OMX_U32 src_width, OMX_U3
           //last byte - all 1
           *(dest_cpy_ptr + 3) = 0xff;
           src_cpy_ptr += cp_byte;
-          dest_cpy_ptr += 4;
+          dest_cpy_ptr += dest_pixel_step;
 
 
         }
-        dest_cpy_ptr = org_dst_cpy_ptr + dest_stride;
-        src_cpy_ptr =  org_src_cpy_ptr + src_stride;
+        dest_cpy_ptr = org_dst_cpy_ptr + dest_row_step;
+        src_cpy_ptr =  org_src_cpy_ptr + src_row_step;
       }
     } else if(fbpxlfmt == OMX_COLOR_Format16bitRGB565 && colorformat == OMX_COLOR_Format24bitRGB888) {
       cp_byte = 3;
@@ -806,10 +2248,10 @@ void omx_img_copy(OMX_U8* src_ptr, OMX_S32 src_stride, OMX_U32 src_width, OMX_U3
           *(dest_cpy_ptr + 1) = ((g>>5) & 0x07) | (r & 0xf8);
           //last byte - all 1
           src_cpy_ptr += cp_byte;
-          dest_cpy_ptr += 2;
+          dest_cpy_ptr += dest_pixel_step;
         }
-        dest_cpy_ptr = org_dst_cpy_ptr + dest_stride;
-        src_cpy_ptr =  org_src_cpy_ptr + src_stride;
+        dest_cpy_ptr = org_dst_cpy_ptr + dest_row_step;
+        src_cpy_ptr =  org_src_cpy_ptr + src_row_step;
       }
     } else if(fbpxlfmt == OMX_COLOR_Format16bitBGR565 && colorformat == OMX_COLOR_Format24bitRGB888) {
     	cp_byte = 3;
@@ -826,10 +2268,10 @@ void omx_img_copy(OMX_U8* src_ptr, OMX_S32 src_stride, OMX_U32 src_width, OMX_U3
     			*(dest_cpy_ptr + 1) = ((g>>5) & 0x07) | (b & 0xf8);
     			//last byte - all 1
     			src_cpy_ptr += cp_byte;
-    			dest_cpy_ptr += 2;
+    			dest_cpy_ptr += dest_pixel_step;
     		}
-    		dest_cpy_ptr = org_dst_cpy_ptr + dest_stride;
-    		src_cpy_ptr =  org_src_cpy_ptr + src_stride;
+    		dest_cpy_ptr = org_dst_cpy_ptr + dest_row_step;
+    		src_cpy_ptr =  org_src_cpy_ptr + src_row_step;
     	}
     } else if(fbpxlfmt == OMX_COLOR_Format24bitRGB888 && colorformat == OMX_COLOR_Format24bitRGB888) {
       cp_byte = 3;
@@ -849,10 +2291,10 @@ void omx_img_copy(OMX_U8* src_ptr, OMX_S32 src_stride, OMX_U32 src_width, OMX_U3
           //last byte - all 1
 //          *(dest_cpy_ptr + 3) = 0xff;
           src_cpy_ptr += cp_byte;
-          dest_cpy_ptr += 4;
+          dest_cpy_ptr += dest_pixel_step;
         }
-        dest_cpy_ptr = org_dst_cpy_ptr + dest_stride;
-        src_cpy_ptr =  org_src_cpy_ptr + src_stride;
+        dest_cpy_ptr = org_dst_cpy_ptr + dest_row_step;
+        src_cpy_ptr =  org_src_cpy_ptr + src_row_step;
       }
     }else if(fbpxlfmt == OMX_COLOR_Format32bitARGB8888 && colorformat == OMX_COLOR_Format24bitRGB888) {
       cp_byte = 3;
@@ -872,10 +2314,10 @@ void omx_img_copy(OMX_U8* src_ptr, OMX_S32 src_stride, OMX_U32 src_width, OMX_U3
           //last byte - all 1
           *(dest_cpy_ptr + 3) = 0xff;
           src_cpy_ptr += cp_byte;
-          dest_cpy_ptr += 4;
+          dest_cpy_ptr += dest_pixel_step;
         }
-        dest_cpy_ptr = org_dst_cpy_ptr + dest_stride;
-        src_cpy_ptr =  org_src_cpy_ptr + src_stride;
+        dest_cpy_ptr = org_dst_cpy_ptr + dest_row_step;
+        src_cpy_ptr =  org_src_cpy_ptr + src_row_step;
       }
     } else if(fbpxlfmt == OMX_COLOR_Format32bitARGB8888 && colorformat == OMX_COLOR_Format24bitBGR888) {
       cp_byte = 3;
@@ -895,15 +2337,22 @@ void omx_img_copy(OMX_U8* src_ptr, OMX_S32 src_stride, OMX_U32 src_width, OMX_U3
           //last byte - all 1
           *(dest_cpy_ptr + 3) = 0xff;
           src_cpy_ptr += cp_byte;
-          dest_cpy_ptr += 4;
+          dest_cpy_ptr += dest_pixel_step;
         }
-        dest_cpy_ptr = org_dst_cpy_ptr + dest_stride;
-        src_cpy_ptr =  org_src_cpy_ptr + src_stride;
+        dest_cpy_ptr = org_dst_cpy_ptr + dest_row_step;
+        src_cpy_ptr =  org_src_cpy_ptr + src_row_step;
       }
     } else if(fbpxlfmt == OMX_COLOR_Format32bitARGB8888 && (colorformat == OMX_COLOR_Format32bitBGRA8888 || colorformat == OMX_COLOR_Format32bitARGB8888)) {
-      for (i = 0; i < cpy_height; ++i, src_cpy_ptr += src_stride, dest_cpy_ptr += dest_stride ) {
-        // same color format - so no extraction - only simple memcpy
-        memcpy(dest_cpy_ptr, src_cpy_ptr, cpy_byte_width);  //  Copy rows
+      for (i = 0; i < cpy_height; ++i, src_cpy_ptr += src_row_step, dest_cpy_ptr += dest_row_step ) {
+        if (rotation == 0) {
+          // same color format - so no extraction - only simple memcpy
+          memcpy(dest_cpy_ptr, src_cpy_ptr, cpy_byte_width);  //  Copy rows
+        } else {
+          // rotated rows run down the frame buffer columns - copy pixel by pixel
+          for (j = 0; j < cpy_byte_width; j += 4) {
+            memcpy(dest_cpy_ptr + (OMX_S32) (j >> 2) * dest_pixel_step, src_cpy_ptr + j, 4);
+          }
+        }
       }
     } else if(fbpxlfmt == OMX_COLOR_Format32bitARGB8888 && colorformat == OMX_COLOR_Format16bitARGB1555) {
       cp_byte = 2;
@@ -931,10 +2380,10 @@ void omx_img_copy(OMX_U8* src_ptr, OMX_S32 src_stride, OMX_U32 src_width, OMX_U3
           *(dest_cpy_ptr + 2) = r<<3;
           *(dest_cpy_ptr + 3) = a<<7;
           src_cpy_ptr += cp_byte;
-          dest_cpy_ptr += 4;
+          dest_cpy_ptr += dest_pixel_step;
         }
-        dest_cpy_ptr = org_dst_cpy_ptr + dest_stride;
-        src_cpy_ptr =  org_src_cpy_ptr + src_stride;
+        dest_cpy_ptr = org_dst_cpy_ptr + dest_row_step;
+        src_cpy_ptr =  org_src_cpy_ptr + src_row_step;
       }
     } else if(fbpxlfmt == OMX_COLOR_Format32bitARGB8888 && (colorformat == OMX_COLOR_Format16bitRGB565 || OMX_COLOR_Format16bitBGR565)) {
       cp_byte = 2;
@@ -961,10 +2410,10 @@ void omx_img_copy(OMX_U8* src_ptr, OMX_S32 src_stride, OMX_U32 src_width, OMX_U3
           // last byte  - all 1
           *(dest_cpy_ptr + 3) = 0xff;
           src_cpy_ptr += cp_byte;
-          dest_cpy_ptr += 4;
+          dest_cpy_ptr += dest_pixel_step;
         }
-        dest_cpy_ptr = org_dst_cpy_ptr + dest_stride;
-        src_cpy_ptr =  org_src_cpy_ptr + src_stride;
+        dest_cpy_ptr = org_dst_cpy_ptr + dest_row_step;
+        src_cpy_ptr =  org_src_cpy_ptr + src_row_step;
       }
     }
     else if(fbpxlfmt == OMX_COLOR_Format16bitARGB1555 && colorformat == OMX_COLOR_Format24bitRGB888)
@@ -986,10 +2435,10 @@ void omx_img_copy(OMX_U8* src_ptr, OMX_S32 src_stride, OMX_U32 src_width, OMX_U3
           *(dest_cpy_ptr + 1) = ((g>>6) & 0x03) | ((r>>1) & 0x7c);
 
           src_cpy_ptr += cp_byte;
-          dest_cpy_ptr += 2;
+          dest_cpy_ptr += dest_pixel_step;
         }
-        dest_cpy_ptr = org_dst_cpy_ptr + dest_stride;
-        src_cpy_ptr =  org_src_cpy_ptr + src_stride;
+        dest_cpy_ptr = org_dst_cpy_ptr + dest_row_step;
+        src_cpy_ptr =  org_src_cpy_ptr + src_row_step;
       }
     } else {
       DEBUG(DEB_LEV_ERR, "the frame buffer pixel format %d and colorformat %d NOT supported\n",fbpxlfmt,colorformat);
@@ -1009,6 +2458,8 @@ OMX_ERRORTYPE omx_fbdev_sink_component_port_SendBufferFunction(omx_base_PortType
   OMX_U32                         portIndex;
   OMX_COMPONENTTYPE*              omxComponent = openmaxStandPort->standCompContainer;
   omx_base_component_PrivateType* omx_base_component_Private = (omx_base_component_PrivateType*)omxComponent->pComponentPrivate;
+  OMX_BOOL                        SendFrame;
+  omx_base_clock_PortType*        pClockPort;
   int errQue;
 #if NO_GST_OMX_PATCH
   unsigned int i;
@@ -1064,6 +2515,15 @@ OMX_ERRORTYPE omx_fbdev_sink_component_port_SendBufferFunction(omx_base_PortType
     return err;
   }
 
+  pClockPort  = (omx_base_clock_PortType*)omx_base_component_Private->ports[OMX_BASE_SINK_CLOCKPORT_INDEX];
+  if(PORT_IS_TUNNELED(pClockPort) && !PORT_IS_BEING_FLUSHED(openmaxStandPort) &&
+      (omx_base_component_Private->transientState != OMX_TransStateExecutingToIdle) &&
+      ((pBuffer->nFlags & OMX_BUFFERFLAG_EOS) != OMX_BUFFERFLAG_EOS)){
+    SendFrame = omx_fbdev_sink_component_ClockPortHandleFunction((omx_fbdev_sink_component_PrivateType*)omx_base_component_Private, pBuffer);
+    /* drop the frame */
+    if(!SendFrame) pBuffer->nFilledLen=0;
+  }
+
   /* And notify the buffer management thread we have a fresh new buffer to manage */
   if(!PORT_IS_BEING_FLUSHED(openmaxStandPort) && !(PORT_IS_BEING_DISABLED(openmaxStandPort) && PORT_IS_TUNNELED_N_BUFFER_SUPPLIER(openmaxStandPort))){
       errQue = queue(openmaxStandPort->pBufferQueue, pBuffer);
@@ -1087,13 +2547,362 @@ OMX_ERRORTYPE omx_fbdev_sink_component_port_SendBufferFunction(omx_base_PortType
   return OMX_ErrorNone;
 }
 
+/** Waits at most nTimeout milliseconds for a buffer from the clock component, so that a clock that
+ * stops sending cannot block the caller for ever. The wait ends early when either port is flushed or
+ * the component goes to idle. Returns OMX_TRUE when a clock buffer is ready to be dequeued.
+ */
+static OMX_BOOL omx_fbdev_sink_component_ClockWait(omx_fbdev_sink_component_PrivateType* omx_fbdev_sink_component_Private, OMX_U32 nTimeout) {
+  omx_base_clock_PortType* pClockPort = (omx_base_clock_PortType*)omx_fbdev_sink_component_Private->ports[OMX_BASE_SINK_CLOCKPORT_INDEX];
+  omx_base_PortType*       pPort = omx_fbdev_sink_component_Private->ports[OMX_BASE_SINK_INPUTPORT_INDEX];
+  tsem_t*                  pSem = pClockPort->pBufferSem;
+  struct timeval           now;
+  struct timespec          slice;
+  OMX_S64                  nNow;
+  OMX_S64                  nEnd;
+  OMX_BOOL                 bReady;
+
+  gettimeofday(&now, NULL);
+  nNow = (OMX_S64)now.tv_sec * 1000000 + now.tv_usec;
+  nEnd = nNow + (OMX_S64)nTimeout * 1000;
+
+  pthread_mutex_lock(&pSem->mutex);
+  while(pSem->semval == 0 && nNow < nEnd &&
+        !PORT_IS_BEING_FLUSHED(pPort) && !PORT_IS_BEING_FLUSHED(pClockPort) &&
+        omx_fbdev_sink_component_Private->transientState != OMX_TransStateExecutingToIdle) {
+    nNow += FBDEV_SINK_CLOCK_WAIT_SLICE * 1000;
+    if(nNow > nEnd) {
+      nNow = nEnd;
+    }
+    slice.tv_sec  = nNow / 1000000;
+    slice.tv_nsec = (nNow % 1000000) * 1000;
+    pthread_cond_timedwait(&pSem->condition, &pSem->mutex, &slice);
+    gettimeofday(&now, NULL);
+    nNow = (OMX_S64)now.tv_sec * 1000000 + now.tv_usec;
+  }
+  bReady = (pSem->semval > 0) ? OMX_TRUE : OMX_FALSE;
+  if(bReady) {
+    pSem->semval--;
+  }
+  pthread_mutex_unlock(&pSem->mutex);
+
+  if(!bReady && nNow >= nEnd) {
+    DEBUG(DEB_LEV_ERR, "In %s no answer from the clock after %d ms\n", __func__, (int)nTimeout);
+  }
+  return bReady;
+}
+
+/** Waits until the presentation time of the input buffer, as told by the clock component
+  * @return OMX_FALSE if the frame must be dropped: the clock is not running, or the frame is
+  * later than the late threshold by the time it could be shown
+  */
+OMX_BOOL omx_fbdev_sink_component_ClockPortHandleFunction(omx_fbdev_sink_component_PrivateType* omx_fbdev_sink_component_Private, OMX_BUFFERHEADERTYPE* inputbuffer){
+  omx_base_clock_PortType*            pClockPort;
+  OMX_BUFFERHEADERTYPE*               clockBuffer;
+  OMX_TIME_MEDIATIMETYPE*             pMediaTime;
+  OMX_HANDLETYPE                      hclkComponent;
+  OMX_TIME_CONFIG_TIMESTAMPTYPE       sClientTimeStamp;
+  OMX_ERRORTYPE                       err;
+  OMX_BOOL                            SendFrame=OMX_TRUE;
+  OMX_BOOL                            bFulfilled=OMX_FALSE;
+  omx_fbdev_sink_component_PortType   *pPort;
+
+  pClockPort    = (omx_base_clock_PortType*)omx_fbdev_sink_component_Private->ports[OMX_BASE_SINK_CLOCKPORT_INDEX];
+  pPort         = (omx_fbdev_sink_component_PortType *) omx_fbdev_sink_component_Private->ports[OMX_BASE_SINK_INPUTPORT_INDEX];
+  hclkComponent = pClockPort->hTunneledComponent;
+  setHeader(&pClockPort->sMediaTimeRequest, sizeof(OMX_TIME_CONFIG_MEDIATIMEREQUESTTYPE));
+
+  /* if  first time stamp is received then notify the clock component */
+  if((inputbuffer->nFlags & OMX_BUFFERFLAG_STARTTIME) == OMX_BUFFERFLAG_STARTTIME) {
+    DEBUG(DEB_LEV_FULL_SEQ,"In %s  first time stamp = %llx \n", __func__,(long long)inputbuffer->nTimeStamp);
+    inputbuffer->nFlags = 0;
+    setHeader(&sClientTimeStamp, sizeof(OMX_TIME_CONFIG_TIMESTAMPTYPE));
+    sClientTimeStamp.nPortIndex = pClockPort->nTunneledPort;
+    sClientTimeStamp.nTimestamp = inputbuffer->nTimeStamp;
+    err = OMX_SetConfig(hclkComponent, OMX_IndexConfigTimeClientStartTime, &sClientTimeStamp);
+    if(err!=OMX_ErrorNone) {
+      DEBUG(DEB_LEV_ERR,"Error %08x In OMX_SetConfig in func=%s \n",err,__func__);
+    }
+
+    /* wait for state change notification from clock src; if it comes later it is handled below */
+    if(omx_fbdev_sink_component_ClockWait(omx_fbdev_sink_component_Private, FBDEV_SINK_CLOCK_START_TIMEOUT)) {
+      /* update the clock state and clock scale info into the fbdev sink private data */
+      if(pClockPort->pBufferQueue->nelem > 0) {
+        clockBuffer = dequeue(pClockPort->pBufferQueue);
+        pMediaTime  = (OMX_TIME_MEDIATIMETYPE*)clockBuffer->pBuffer;
+        omx_fbdev_sink_component_Private->eState = pMediaTime->eState;
+        omx_fbdev_sink_component_Private->xScale = pMediaTime->xScale;
+        pClockPort->ReturnBufferFunction((omx_base_PortType*)pClockPort,clockBuffer);
+      }
+    }
+  }
+
+  /* take the state or scale changes the clock component sent meanwhile, and any late fulfillment */
+  while(pClockPort->pBufferSem->semval > 0) {
+    tsem_down(pClockPort->pBufferSem);
+    if(pClockPort->pBufferQueue->nelem == 0) {
+      break;
+    }
+    clockBuffer = dequeue(pClockPort->pBufferQueue);
+    pMediaTime  = (OMX_TIME_MEDIATIMETYPE*)clockBuffer->pBuffer;
+    if(pMediaTime->eUpdateType==OMX_TIME_UpdateScaleChanged) {
+      omx_fbdev_sink_component_Private->xScale = pMediaTime->xScale;
+    } else if(pMediaTime->eUpdateType==OMX_TIME_UpdateClockStateChanged) {
+      omx_fbdev_sink_component_Private->eState = pMediaTime->eState;
+    }
+    pClockPort->ReturnBufferFunction((omx_base_PortType*)pClockPort,clockBuffer);
+  }
+
+  /* do not show the frame, if the clock is not running */
+  if(omx_fbdev_sink_component_Private->eState != OMX_TIME_ClockStateRunning){
+    return OMX_FALSE;
+  }
+
+  /* request the presentation time of the frame; the clock fulfills it once media time gets there,
+   * or at once with a negative offset if that time has already passed */
+  if(!PORT_IS_BEING_FLUSHED(pPort) && !PORT_IS_BEING_FLUSHED(pClockPort) &&
+      omx_fbdev_sink_component_Private->transientState != OMX_TransStateExecutingToIdle) {
+    pClockPort->sMediaTimeRequest.nOffset         = 0;
+    pClockPort->sMediaTimeRequest.nPortIndex      = pClockPort->nTunneledPort;
+    pClockPort->sMediaTimeRequest.pClientPrivate  = NULL;
+    pClockPort->sMediaTimeRequest.nMediaTimestamp = inputbuffer->nTimeStamp;
+    err = OMX_SetConfig(hclkComponent, OMX_IndexConfigTimeMediaTimeRequest, &pClockPort->sMediaTimeRequest);
+    if(err!=OMX_ErrorNone) {
+      DEBUG(DEB_LEV_ERR,"Error %08x In OMX_SetConfig in func=%s \n",err,__func__);
+      return SendFrame;
+    }
+
+    /* scale and state changes may come before the fulfillment */
+    while(!bFulfilled && !PORT_IS_BEING_FLUSHED(pPort) && !PORT_IS_BEING_FLUSHED(pClockPort) &&
+          omx_fbdev_sink_component_Private->transientState != OMX_TransStateExecutingToIdle) {
+      /* wait for the request fullfillment; one that comes later is returned with the notifications above.
+       * At a scale of 0 the media time stands still, the frame waits until the clock moves again */
+      if(!omx_fbdev_sink_component_ClockWait(omx_fbdev_sink_component_Private, FBDEV_SINK_CLOCK_REQUEST_TIMEOUT)) {
+        if(omx_fbdev_sink_component_Private->xScale == 0) {
+          continue;
+        }
+        break;
+      }
+      if(pClockPort->pBufferQueue->nelem == 0) {
+        break;
+      }
+      clockBuffer = dequeue(pClockPort->pBufferQueue);
+      pMediaTime  = (OMX_TIME_MEDIATIMETYPE*)clockBuffer->pBuffer;
+      if(pMediaTime->eUpdateType==OMX_TIME_UpdateScaleChanged) {
+        omx_fbdev_sink_component_Private->xScale = pMediaTime->xScale;
+      } else if(pMediaTime->eUpdateType==OMX_TIME_UpdateClockStateChanged) {
+        omx_fbdev_sink_component_Private->eState = pMediaTime->eState;
+        if(pMediaTime->eState != OMX_TIME_ClockStateRunning) {
+          SendFrame = OMX_FALSE;
+          bFulfilled = OMX_TRUE;
+        }
+      } else if(pMediaTime->eUpdateType==OMX_TIME_UpdateRequestFulfillment) {
+        bFulfilled = OMX_TRUE;
+        if(pMediaTime->nOffset < -((OMX_TICKS) omx_fbdev_sink_component_Private->sLateThreshold.nLateThreshold)) {
+          DEBUG(DEB_LEV_SIMPLE_SEQ,"In %s dropping frame %lld late by %lld us\n", __func__,
+                (long long)inputbuffer->nTimeStamp, (long long)-pMediaTime->nOffset);
+          SendFrame = OMX_FALSE;
+        }
+      }
+      pClockPort->ReturnBufferFunction((omx_base_PortType*)pClockPort,clockBuffer);
+    }
+  }
+
+  return(SendFrame);
+}
+
+/** @brief Releases buffers under processing.
+ * This function must be implemented in the derived classes, for the
+ * specific processing
+ */
+OMX_ERRORTYPE omx_fbdev_sink_component_port_FlushProcessingBuffers(omx_base_PortType *openmaxStandPort) {
+  omx_base_component_PrivateType* omx_base_component_Private;
+  omx_fbdev_sink_component_PrivateType* omx_fbdev_sink_component_Private;
+  OMX_BUFFERHEADERTYPE* pBuffer;
+  omx_base_clock_PortType               *pClockPort;
+  int errQue;
+
+  DEBUG(DEB_LEV_FUNCTION_NAME, "In %s\n", __func__);
+  omx_base_component_Private        = (omx_base_component_PrivateType*)openmaxStandPort->standCompContainer->pComponentPrivate;
+  omx_fbdev_sink_component_Private  = (omx_fbdev_sink_component_PrivateType*) omx_base_component_Private;
+
+  pClockPort    = (omx_base_clock_PortType*) omx_fbdev_sink_component_Private->ports[OMX_BASE_SINK_CLOCKPORT_INDEX];
+
+  if(openmaxStandPort->sPortParam.eDomain!=OMX_PortDomainOther) { /* clock buffers not used in the clients buffer managment function */
+    pthread_mutex_lock(&omx_base_component_Private->flush_mutex);
+    openmaxStandPort->bIsPortFlushed=OMX_TRUE;
+    /*Signal the buffer management thread of port flush,if it is waiting for buffers*/
+    if(omx_base_component_Private->bMgmtSem->semval==0) {
+      tsem_up(omx_base_component_Private->bMgmtSem);
+    }
+
+    if(omx_base_component_Private->state==OMX_StatePause ) {
+      /*Waiting at paused state*/
+      tsem_signal(omx_base_component_Private->bStateSem);
+    }
+    DEBUG(DEB_LEV_FULL_SEQ, "In %s waiting for flush all condition port index =%d\n", __func__,(int)openmaxStandPort->sPortParam.nPortIndex);
+    /* Wait until flush is completed */
+    pthread_mutex_unlock(&omx_base_component_Private->flush_mutex);
+
+    /*Dummy signal to clock port, in case a frame is waiting for its presentation time*/
+    if(pClockPort->pBufferSem->semval == 0) {
+      tsem_up(pClockPort->pBufferSem);
+      tsem_reset(pClockPort->pBufferSem);
+    }
+    tsem_down(omx_base_component_Private->flush_all_condition);
+
+    /** the buffer held on screen goes back with the others */
+    if (omx_fbdev_sink_component_Private->pHeldBuffer != NULL) {
+      pBuffer = omx_fbdev_sink_component_Private->pHeldBuffer;
+      omx_fbdev_sink_component_Private->pHeldBuffer = NULL;
+      base_port_ReturnBufferFunction(openmaxStandPort, pBuffer);
+    }
+    omx_fbdev_sink_component_Private->pShownBuffer = NULL;
+  }
+
+  tsem_reset(omx_base_component_Private->bMgmtSem);
+
+  /* Flush all the buffers not under processing */
+  while (openmaxStandPort->pBufferSem->semval > 0) {
+    DEBUG(DEB_LEV_FULL_SEQ, "In %s TFlag=%x Flusing Port=%d,Semval=%d Qelem=%d\n",
+    __func__,(int)openmaxStandPort->nTunnelFlags,(int)openmaxStandPort->sPortParam.nPortIndex,
+    (int)openmaxStandPort->pBufferSem->semval,(int)openmaxStandPort->pBufferQueue->nelem);
+
+    tsem_down(openmaxStandPort->pBufferSem);
+    pBuffer = dequeue(openmaxStandPort->pBufferQueue);
+    if (PORT_IS_TUNNELED(openmaxStandPort) && !PORT_IS_BUFFER_SUPPLIER(openmaxStandPort)) {
+      DEBUG(DEB_LEV_FULL_SEQ, "In %s: Comp %s is returning io:%d buffer\n",
+        __func__,omx_base_component_Private->name,(int)openmaxStandPort->sPortParam.nPortIndex);
+      if (openmaxStandPort->sPortParam.eDir == OMX_DirInput) {
+        ((OMX_COMPONENTTYPE*)(openmaxStandPort->hTunneledComponent))->FillThisBuffer(openmaxStandPort->hTunneledComponent, pBuffer);
+      } else {
+        ((OMX_COMPONENTTYPE*)(openmaxStandPort->hTunneledComponent))->EmptyThisBuffer(openmaxStandPort->hTunneledComponent, pBuffer);
+      }
+    } else if (PORT_IS_TUNNELED_N_BUFFER_SUPPLIER(openmaxStandPort)) {
+      errQue = queue(openmaxStandPort->pBufferQueue,pBuffer);
+      if (errQue) {
+        return OMX_ErrorInsufficientResources;
+      }
+    } else {
+      (*(openmaxStandPort->BufferProcessedCallback))(
+        openmaxStandPort->standCompContainer,
+        omx_base_component_Private->callbackData,
+        pBuffer);
+    }
+  }
+  /*Port is tunneled and supplier and didn't received all it's buffer then wait for the buffers*/
+  if (PORT_IS_TUNNELED_N_BUFFER_SUPPLIER(openmaxStandPort)) {
+    while(openmaxStandPort->pBufferQueue->nelem!= openmaxStandPort->nNumAssignedBuffers){
+      tsem_down(openmaxStandPort->pBufferSem);
+      DEBUG(DEB_LEV_PARAMS, "In %s Got a buffer qelem=%d\n",__func__,openmaxStandPort->pBufferQueue->nelem);
+    }
+    tsem_reset(openmaxStandPort->pBufferSem);
+  }
+
+  pthread_mutex_lock(&omx_base_component_Private->flush_mutex);
+  openmaxStandPort->bIsPortFlushed=OMX_FALSE;
+  pthread_mutex_unlock(&omx_base_component_Private->flush_mutex);
+
+  tsem_up(omx_base_component_Private->flush_condition);
+
+  DEBUG(DEB_LEV_FUNCTION_NAME, "Out %s Port Index=%d\n", __func__,(int)openmaxStandPort->sPortParam.nPortIndex);
+
+  return OMX_ErrorNone;
+}
+
+/** Input buffers are pages of the mapped frame buffer when the frames are laid out like the screen
+  * and there is a page for each of them, so that the producer writes straight into display memory.
+  * Otherwise they are allocated by the base port as usual.
+  */
+OMX_ERRORTYPE omx_fbdev_sink_component_port_AllocateBuffer(
+  omx_base_PortType *openmaxStandPort,
+  OMX_BUFFERHEADERTYPE** pBuffer,
+  OMX_U32 nPortIndex,
+  OMX_PTR pAppPrivate,
+  OMX_U32 nSizeBytes) {
+
+  omx_fbdev_sink_component_PrivateType* omx_fbdev_sink_component_Private = openmaxStandPort->standCompContainer->pComponentPrivate;
+  omx_fbdev_sink_component_PortType* pPort = (omx_fbdev_sink_component_PortType*) openmaxStandPort;
+  OMX_U8* page = NULL;
+  OMX_ERRORTYPE err;
+  OMX_U32 i, j;
+
+  if (omx_fbdev_sink_component_Private->transientState == OMX_TransStateLoadedToIdle || openmaxStandPort->bIsTransientToEnabled) {
+    /** the frame buffer is set up for the port on the way to idle or when the port is enabled, wait until it is */
+    tsem_down(omx_fbdev_sink_component_Private->fbdevSyncSem);
+    tsem_up(omx_fbdev_sink_component_Private->fbdevSyncSem);
+  }
+
+  if (omx_fbdev_sink_component_Private->scr_ptr != NULL &&
+      omx_fbdev_sink_component_FbBuffersFit(omx_fbdev_sink_component_Private, pPort) &&
+      openmaxStandPort->sPortParam.nBufferCountActual <= omx_fbdev_sink_component_Private->nPages &&
+      nSizeBytes <= omx_fbdev_sink_component_Private->page_size) {
+    /** first page no other buffer has */
+    for (i = 0; i < omx_fbdev_sink_component_Private->nPages && page == NULL; i++) {
+      page = omx_fbdev_sink_component_Private->scr_ptr + i * omx_fbdev_sink_component_Private->page_size;
+      for (j = 0; j < openmaxStandPort->sPortParam.nBufferCountActual; j++) {
+        if (openmaxStandPort->bBufferStateAllocated[j] != BUFFER_FREE &&
+            openmaxStandPort->pInternalBufferStorage[j] != NULL &&
+            openmaxStandPort->pInternalBufferStorage[j]->pBuffer == page) {
+          page = NULL;
+          break;
+        }
+      }
+    }
+  }
+
+  err = base_port_AllocateBuffer(openmaxStandPort, pBuffer, nPortIndex, pAppPrivate, nSizeBytes);
+  if (err != OMX_ErrorNone || page == NULL) {
+    return err;
+  }
+  DEBUG(DEB_LEV_SIMPLE_SEQ, "In %s input buffer %p is frame buffer page %d\n", __func__, *pBuffer,
+        omx_fbdev_sink_component_BufferPage(omx_fbdev_sink_component_Private, page));
+  free((*pBuffer)->pBuffer);
+  (*pBuffer)->pBuffer = page;
+  return OMX_ErrorNone;
+}
+
+/** Frame buffer pages are unmapped with the screen, only the memory the base port allocated is freed
+  */
+OMX_ERRORTYPE omx_fbdev_sink_component_port_FreeBuffer(
+  omx_base_PortType *openmaxStandPort,
+  OMX_U32 nPortIndex,
+  OMX_BUFFERHEADERTYPE* pBuffer) {
+
+  omx_fbdev_sink_component_PrivateType* omx_fbdev_sink_component_Private = openmaxStandPort->standCompContainer->pComponentPrivate;
+
+  if (pBuffer != NULL && omx_fbdev_sink_component_BufferPage(omx_fbdev_sink_component_Private, pBuffer->pBuffer) >= 0) {
+    pBuffer->pBuffer = NULL;
+  }
+  return base_port_FreeBuffer(openmaxStandPort, nPortIndex, pBuffer);
+}
+
+/** The frame buffer page just panned to is on screen until the next one is shown, so its buffer
+  * is held and the one held before, no longer on screen, is returned in its place
+  */
+OMX_ERRORTYPE omx_fbdev_sink_component_port_ReturnBufferFunction(omx_base_PortType *openmaxStandPort, OMX_BUFFERHEADERTYPE* pBuffer) {
+  omx_fbdev_sink_component_PrivateType* omx_fbdev_sink_component_Private = openmaxStandPort->standCompContainer->pComponentPrivate;
+  OMX_BUFFERHEADERTYPE* pHeldBuffer;
+
+  if (pBuffer == NULL || pBuffer != omx_fbdev_sink_component_Private->pShownBuffer) {
+    return base_port_ReturnBufferFunction(openmaxStandPort, pBuffer);
+  }
+  omx_fbdev_sink_component_Private->pShownBuffer = NULL;
+  pHeldBuffer = omx_fbdev_sink_component_Private->pHeldBuffer;
+  omx_fbdev_sink_component_Private->pHeldBuffer = pBuffer;
+  if (pHeldBuffer == NULL) {
+    return OMX_ErrorNone;
+  }
+  return base_port_ReturnBufferFunction(openmaxStandPort, pHeldBuffer);
+}
+
 /** buffer management callback function
   * takes one input buffer and displays its contents
   */
 void omx_fbdev_sink_component_BufferMgmtCallback(OMX_COMPONENTTYPE *openmaxStandComp, OMX_BUFFERHEADERTYPE* pInputBuffer) {
   omx_fbdev_sink_component_PrivateType* omx_fbdev_sink_component_Private = openmaxStandComp->pComponentPrivate;
   omx_fbdev_sink_component_PortType     *pPort = (omx_fbdev_sink_component_PortType *) omx_fbdev_sink_component_Private->ports[OMX_BASE_SINK_INPUTPORT_INDEX];
-  static long                           old_time = 0, new_time = 0;
+  omx_base_clock_PortType               *pClockPort = (omx_base_clock_PortType *) omx_fbdev_sink_component_Private->ports[OMX_BASE_SINK_CLOCKPORT_INDEX];
+  long                                  new_time = 0;
   long                                  timediff=0;
 
   OMX_COLOR_FORMATTYPE input_colorformat = pPort->sVideoParam.eColorFormat;
@@ -1112,7 +2921,16 @@ void omx_fbdev_sink_component_BufferMgmtCallback(OMX_COMPONENTTYPE *openmaxStand
   OMX_S32 input_src_offset_x = pPort->omxConfigCrop.nLeft;    //  Offset (in columns) to left side of crop rectangle
   OMX_S32 input_src_offset_y = pPort->omxConfigCrop.nTop;    //  Offset (in rows) from top of the image to crop rectangle
 
-  OMX_U8* input_dest_ptr = (OMX_U8*) omx_fbdev_sink_component_Private->scr_ptr + (omx_fbdev_sink_component_Private->fbstride * HEIGHT_OFFSET);
+  /** a page holds one screen, or the mapping when there is a single page; frames turned by the rotation
+    * too tall to be moved down by HEIGHT_OFFSET are drawn from its top, and the copy is cut at its end
+    */
+  OMX_U32 input_page_rows = (omx_fbdev_sink_component_Private->nPages > 1) ? omx_fbdev_sink_component_Private->vscr_info.yres :
+                            (omx_fbdev_sink_component_Private->fbstride > 0) ?
+                            omx_fbdev_sink_component_Private->product / omx_fbdev_sink_component_Private->fbstride : 0;
+  OMX_U32 input_dest_top = (omx_fbdev_sink_component_ShownHeight(pPort) + HEIGHT_OFFSET > input_page_rows) ? 0 : HEIGHT_OFFSET;
+  OMX_U8* input_dest_ptr = (OMX_U8*) omx_fbdev_sink_component_Private->scr_ptr +
+                           (omx_fbdev_sink_component_Private->nBackPage * omx_fbdev_sink_component_Private->page_size) +
+                           (omx_fbdev_sink_component_Private->fbstride * input_dest_top);
   //OMX_U8* input_dest_ptr = (OMX_U8*) omx_fbdev_sink_component_Private->scr_ptr;
   OMX_S32 input_dest_stride = (input_src_stride < 0) ? -1 * omx_fbdev_sink_component_Private->fbstride : omx_fbdev_sink_component_Private->fbstride;
 
@@ -1122,21 +2940,52 @@ void omx_fbdev_sink_component_BufferMgmtCallback(OMX_COMPONENTTYPE *openmaxStand
   }
 
   OMX_U32 input_dest_width = omx_fbdev_sink_component_Private->fbwidth;
-  OMX_U32 input_dest_height = omx_fbdev_sink_component_Private->fbheight;
+  OMX_U32 input_dest_height = (input_page_rows > input_dest_top) ? input_page_rows - input_dest_top : 0;
 
   OMX_U32 input_dest_offset_x = pPort->omxConfigOutputPosition.nX;
   OMX_U32 input_dest_offset_y = pPort->omxConfigOutputPosition.nY;
 
-  /** getting current time */
-  new_time = GetTime();
-  if(old_time == 0) {
-    old_time = new_time;
+  OMX_U32 input_rotation = (OMX_U32) (((pPort->omxConfigRotate.nRotation % 360) + 360) % 360);
+
+  /** frames dropped by the clock port handling are not drawn, nor any frame when the frame buffer could not be set up */
+  if (pInputBuffer->nFilledLen == 0 || omx_fbdev_sink_component_Private->scr_ptr == NULL) {
+    pInputBuffer->nFilledLen = 0;
+    return;
+  }
+
+  if (PORT_IS_TUNNELED(pClockPort)) {
+    /** the frame was held until its presentation time by the clock port handling */
   } else {
-    timediff = nFrameProcessTime - ((new_time - old_time) * 1000);
-    if(timediff>0) {
-      usleep(timediff);
+    /** the frames are paced at the frame rate, vertical sync only snaps them to the next refresh: getting current time */
+    new_time = GetTime();
+    if(omx_fbdev_sink_component_Private->last_frame_time == 0) {
+      omx_fbdev_sink_component_Private->last_frame_time = new_time;
+    } else {
+      timediff = omx_fbdev_sink_component_Private->nFrameProcessTime - ((new_time - omx_fbdev_sink_component_Private->last_frame_time) * 1000);
+      if(timediff>0) {
+        usleep(timediff);
+      }
+      omx_fbdev_sink_component_Private->last_frame_time = GetTime();
+    }
+  }
+  if (omx_fbdev_sink_component_Private->bVsync && omx_fbdev_sink_component_Private->nPages == 1 && !PORT_IS_TUNNELED(pClockPort)) {
+    /** copy right after vertical sync, ahead of the beam */
+    __u32 crtc = 0;
+    omx_fbdev_sink_component_Ioctl(omx_fbdev_sink_component_Private, FBIO_WAITFORVSYNC, &crtc);
+  }
+
+  if (omx_fbdev_sink_component_BufferPage(omx_fbdev_sink_component_Private, input_src_ptr) >= 0) {
+    /** the frame was written straight into a frame buffer page, showing it is a pan;
+      * crop, position, mirroring and rotation do not apply to such frames.
+      * The buffer stays on screen, so it is held back until the next frame is shown
+      */
+    omx_fbdev_sink_component_ShowPage(omx_fbdev_sink_component_Private,
+                                      (OMX_U32) omx_fbdev_sink_component_BufferPage(omx_fbdev_sink_component_Private, input_src_ptr));
+    if ((pInputBuffer->nFlags & OMX_BUFFERFLAG_EOS) == 0) {
+      omx_fbdev_sink_component_Private->pShownBuffer = pInputBuffer;
     }
-    old_time = GetTime();
+    pInputBuffer->nFilledLen = 0;
+    return;
   }
 
   /**  Copy image data into in_buffer */
@@ -1144,7 +2993,14 @@ void omx_fbdev_sink_component_BufferMgmtCallback(OMX_COMPONENTTYPE *openmaxStand
                input_src_offset_x, input_src_offset_y,
                input_dest_ptr, input_dest_stride, input_dest_width, input_dest_height,
                input_dest_offset_x, input_dest_offset_y,
-               input_cpy_width, input_cpy_height, input_colorformat,omx_fbdev_sink_component_Private->fbpxlfmt);
+               input_cpy_width, input_cpy_height, input_colorformat,omx_fbdev_sink_component_Private->fbpxlfmt,
+               input_rotation, omx_fbdev_sink_component_Private->blitRow);
+
+  if (omx_fbdev_sink_component_Private->nPages > 1) {
+    /** show the page just drawn; the page it hides becomes the next back page */
+    omx_fbdev_sink_component_ShowPage(omx_fbdev_sink_component_Private, omx_fbdev_sink_component_Private->nBackPage);
+    omx_fbdev_sink_component_Private->nBackPage = (omx_fbdev_sink_component_Private->nBackPage + 1) % omx_fbdev_sink_component_Private->nPages;
+  }
   pInputBuffer->nFilledLen = 0;
 }
 
@@ -1197,8 +3053,13 @@ OMX_ERRORTYPE omx_fbdev_sink_component_SetConfig(
       }
       if (portIndex == 0) {
         pPort = (omx_fbdev_sink_component_PortType *) omx_fbdev_sink_component_Private->ports[portIndex];
-        if (omxConfigRotate->nRotation != 0) {
-          //  Rotation not supported (yet)
+        if (omxConfigRotate->nRotation % 90 != 0) {
+          //  Only quarter turns are supported
+          return OMX_ErrorUnsupportedSetting;
+        }
+        if (omxConfigRotate->nRotation % 360 != 0 && omx_fbdev_sink_component_IsPlanarYUV(pPort->sVideoParam.eColorFormat)) {
+          //  Planar YUV is converted straight into the frame buffer row by row, and only unrotated
+          DEBUG(DEB_LEV_ERR, "In %s planar YUV input cannot be rotated\n", __func__);
           return OMX_ErrorUnsupportedSetting;
         }
         pPort->omxConfigRotate.nRotation = omxConfigRotate->nRotation;
@@ -1241,6 +3102,18 @@ OMX_ERRORTYPE omx_fbdev_sink_component_SetConfig(
         return OMX_ErrorBadPortIndex;
       }
       break;
+    case OMX_IndexVendorFbdevSinkLateThreshold:
+      {
+        OMX_FBDEV_SINK_CONFIG_LATETHRESHOLDTYPE *pLateThreshold = pComponentConfigStructure;
+        if ((err = checkHeader(pComponentConfigStructure, sizeof(OMX_FBDEV_SINK_CONFIG_LATETHRESHOLDTYPE))) != OMX_ErrorNone) {
+          break;
+        }
+        if (pLateThreshold->nPortIndex != OMX_BASE_SINK_INPUTPORT_INDEX) {
+          return OMX_ErrorBadPortIndex;
+        }
+        omx_fbdev_sink_component_Private->sLateThreshold.nLateThreshold = pLateThreshold->nLateThreshold;
+        break;
+      }
     case OMX_IndexConfigCommonOutputPosition:
       omxConfigOutputPosition = (OMX_CONFIG_POINTTYPE*)pComponentConfigStructure;
       portIndex = omxConfigOutputPosition->nPortIndex;
@@ -1323,6 +3196,16 @@ OMX_ERRORTYPE omx_fbdev_sink_component_GetConfig(
         return OMX_ErrorBadPortIndex;
       }
       break;
+    case OMX_IndexVendorFbdevSinkLateThreshold:
+      {
+        OMX_FBDEV_SINK_CONFIG_LATETHRESHOLDTYPE *pLateThreshold = pComponentConfigStructure;
+        setHeader(pLateThreshold, sizeof(OMX_FBDEV_SINK_CONFIG_LATETHRESHOLDTYPE));
+        if (pLateThreshold->nPortIndex != OMX_BASE_SINK_INPUTPORT_INDEX) {
+          return OMX_ErrorBadPortIndex;
+        }
+        memcpy(pLateThreshold, &omx_fbdev_sink_component_Private->sLateThreshold, sizeof(OMX_FBDEV_SINK_CONFIG_LATETHRESHOLDTYPE));
+        break;
+      }
     case OMX_IndexConfigCommonOutputPosition:
       omxConfigOutputPosition = (OMX_CONFIG_POINTTYPE*)pComponentConfigStructure;
       setHeader(omxConfigOutputPosition, sizeof(OMX_CONFIG_POINTTYPE));
@@ -1349,7 +3232,9 @@ OMX_ERRORTYPE omx_fbdev_sink_component_SetParameter(
   OMX_ERRORTYPE err = OMX_ErrorNone;
   OMX_PARAM_PORTDEFINITIONTYPE *pPortDef;
   OMX_VIDEO_PARAM_PORTFORMATTYPE *pVideoPortFormat;
+  OMX_OTHER_PARAM_PORTFORMATTYPE *pOtherPortFormat;
   OMX_PARAM_COMPONENTROLETYPE *pComponentRole;
+  omx_base_clock_PortType *pClockPort;
   OMX_U32 portIndex;
 
   /* Check which structure we are being fed and make control its header */
@@ -1399,6 +3284,9 @@ OMX_ERRORTYPE omx_fbdev_sink_component_SetParameter(
         pPort->sPortParam.nBufferSize = (OMX_U32) abs(pPort->sPortParam.format.video.nStride) * pPort->sPortParam.format.video.nSliceHeight;
         pPort->omxConfigCrop.nWidth = pPort->sPortParam.format.video.nFrameWidth;
         pPort->omxConfigCrop.nHeight = pPort->sPortParam.format.video.nFrameHeight;
+        if (omx_fbdev_sink_component_Private->scr_ptr != NULL) {
+          omx_fbdev_sink_component_SelectBlitter(omx_fbdev_sink_component_Private);
+        }
       }
       break;
 
@@ -1419,9 +3307,14 @@ OMX_ERRORTYPE omx_fbdev_sink_component_SetParameter(
         //  No compression allowed
         return OMX_ErrorUnsupportedSetting;
       }
+      if (pPort->omxConfigRotate.nRotation % 360 != 0 && omx_fbdev_sink_component_IsPlanarYUV(pVideoPortFormat->eColorFormat)) {
+        //  A rotated picture cannot be given planar YUV, which is only copied unrotated
+        DEBUG(DEB_LEV_ERR, "In %s planar YUV input cannot be rotated\n", __func__);
+        return OMX_ErrorUnsupportedSetting;
+      }
 
       if(pVideoPortFormat->xFramerate > 0) {
-        nFrameProcessTime = 1000000 / pVideoPortFormat->xFramerate;
+        omx_fbdev_sink_component_Private->nFrameProcessTime = 1000000 / pVideoPortFormat->xFramerate;
       }
       pPort->sVideoParam.xFramerate = pVideoPortFormat->xFramerate;
       pPort->sVideoParam.eCompressionFormat = pVideoPortFormat->eCompressionFormat;
@@ -1429,6 +3322,23 @@ OMX_ERRORTYPE omx_fbdev_sink_component_SetParameter(
       //  Figure out stride, slice height, min buffer size
       pPort->sPortParam.format.video.nStride = calcStride(pPort->sPortParam.format.video.nFrameWidth, pPort->sVideoParam.eColorFormat);
       pPort->sPortParam.format.video.nSliceHeight = pPort->sPortParam.format.video.nFrameHeight;  //  No support for slices yet
+      if (omx_fbdev_sink_component_Private->scr_ptr != NULL) {
+        omx_fbdev_sink_component_SelectBlitter(omx_fbdev_sink_component_Private);
+      }
+      break;
+    case OMX_IndexParamOtherPortFormat:
+      pOtherPortFormat = (OMX_OTHER_PARAM_PORTFORMATTYPE*)ComponentParameterStructure;
+      portIndex = pOtherPortFormat->nPortIndex;
+      err = omx_base_component_ParameterSanityCheck(hComponent, portIndex, pOtherPortFormat, sizeof(OMX_OTHER_PARAM_PORTFORMATTYPE));
+      if(err!=OMX_ErrorNone) {
+        DEBUG(DEB_LEV_ERR, "In %s Parameter Check Error=%x\n",__func__,err);
+        break;
+      }
+      if(portIndex != OMX_BASE_SINK_CLOCKPORT_INDEX) {
+        return OMX_ErrorBadPortIndex;
+      }
+      pClockPort = (omx_base_clock_PortType *) omx_fbdev_sink_component_Private->ports[portIndex];
+      pClockPort->sOtherParam.eFormat = pOtherPortFormat->eFormat;
       break;
     case OMX_IndexParamStandardComponentRole:
       pComponentRole = (OMX_PARAM_COMPONENTROLETYPE*)ComponentParameterStructure;
@@ -1446,6 +3356,28 @@ OMX_ERRORTYPE omx_fbdev_sink_component_SetParameter(
         return OMX_ErrorBadParameter;
       }
       break;
+    case OMX_IndexVendorFbdevSinkDevice:
+      {
+        OMX_FBDEV_SINK_PARAM_DEVICETYPE *pDevice = ComponentParameterStructure;
+        portIndex = pDevice->nPortIndex;
+        err = omx_base_component_ParameterSanityCheck(hComponent, portIndex, pDevice, sizeof(OMX_FBDEV_SINK_PARAM_DEVICETYPE));
+        if(err!=OMX_ErrorNone) {
+          DEBUG(DEB_LEV_ERR, "In %s Parameter Check Error=%x\n",__func__,err);
+          break;
+        }
+        if (portIndex != OMX_BASE_SINK_INPUTPORT_INDEX) {
+          return OMX_ErrorBadPortIndex;
+        }
+        if (omx_fbdev_sink_component_Private->state != OMX_StateLoaded) {
+          DEBUG(DEB_LEV_ERR, "In %s Incorrect State=%x lineno=%d\n",__func__,omx_fbdev_sink_component_Private->state,__LINE__);
+          return OMX_ErrorIncorrectStateOperation;
+        }
+        if (pDevice->cDeviceName[0] == '\0' || memchr(pDevice->cDeviceName, '\0', OMX_MAX_STRINGNAME_SIZE) == NULL) {
+          return OMX_ErrorBadParameter;
+        }
+        memcpy(&omx_fbdev_sink_component_Private->sDevice, pDevice, sizeof(OMX_FBDEV_SINK_PARAM_DEVICETYPE));
+        break;
+      }
     default: /*Call the base component function*/
       return omx_base_component_SetParameter(hComponent, nParamIndex, ComponentParameterStructure);
   }
@@ -1500,6 +3432,18 @@ OMX_ERRORTYPE omx_fbdev_sink_component_GetParameter(
       }
       strcpy( (char*) pComponentRole->cRole, FBDEV_SINK_COMP_ROLE);
       break;
+    case OMX_IndexVendorFbdevSinkDevice:
+      {
+        OMX_FBDEV_SINK_PARAM_DEVICETYPE *pDevice = ComponentParameterStructure;
+        if ((err = checkHeader(ComponentParameterStructure, sizeof(OMX_FBDEV_SINK_PARAM_DEVICETYPE))) != OMX_ErrorNone) {
+          break;
+        }
+        if (pDevice->nPortIndex != OMX_BASE_SINK_INPUTPORT_INDEX) {
+          return OMX_ErrorBadPortIndex;
+        }
+        memcpy(pDevice, &omx_fbdev_sink_component_Private->sDevice, sizeof(OMX_FBDEV_SINK_PARAM_DEVICETYPE));
+        break;
+      }
     default: /*Call the base component function*/
       return omx_base_component_GetParameter(hComponent, nParamIndex, ComponentParameterStructure);
   }
@@ -1507,36 +3451,89 @@ OMX_ERRORTYPE omx_fbdev_sink_component_GetParameter(
 }
 
 
+OMX_ERRORTYPE omx_fbdev_sink_component_GetExtensionIndex(
+  OMX_HANDLETYPE hComponent,
+  OMX_STRING cParameterName,
+  OMX_INDEXTYPE* pIndexType) {
+
+  DEBUG(DEB_LEV_FUNCTION_NAME,"In  %s \n",__func__);
+
+  if(strcmp(cParameterName,FBDEV_SINK_LATE_THRESHOLD_EXTENSION) == 0) {
+    *pIndexType = OMX_IndexVendorFbdevSinkLateThreshold;
+  } else if(strcmp(cParameterName,FBDEV_SINK_DEVICE_EXTENSION) == 0) {
+    *pIndexType = OMX_IndexVendorFbdevSinkDevice;
+  } else {
+    return omx_base_component_GetExtensionIndex(hComponent, cParameterName, pIndexType);
+  }
+  return OMX_ErrorNone;
+}
+
 OMX_ERRORTYPE omx_fbdev_sink_component_MessageHandler(OMX_COMPONENTTYPE* openmaxStandComp,internalRequestMessageType *message) {
 
   omx_fbdev_sink_component_PrivateType* omx_fbdev_sink_component_Private = (omx_fbdev_sink_component_PrivateType*)openmaxStandComp->pComponentPrivate;
+  omx_fbdev_sink_component_PortType* pPort = (omx_fbdev_sink_component_PortType *) omx_fbdev_sink_component_Private->ports[OMX_BASE_SINK_INPUTPORT_INDEX];
   OMX_ERRORTYPE err;
+  OMX_ERRORTYPE initErr = OMX_ErrorNone;
   OMX_STATETYPE eState;
 
   DEBUG(DEB_LEV_FUNCTION_NAME, "In %s\n", __func__);
   eState = omx_fbdev_sink_component_Private->state; //storing current state
 
   if (message->messageType == OMX_CommandStateSet){
-    if ((message->messageParam == OMX_StateExecuting ) && (omx_fbdev_sink_component_Private->state == OMX_StateIdle)) {
+    if ((message->messageParam == OMX_StateIdle ) && (omx_fbdev_sink_component_Private->state == OMX_StateLoaded)) {
+      /** the frame buffer is mapped before the input buffers are allocated, they may be its pages */
       DEBUG(DEB_LEV_SIMPLE_SEQ, "In %s sink component from loaded to idle \n", __func__);
       err = omx_fbdev_sink_component_Init(openmaxStandComp);
+      /** signal the frame buffer set up, or given up on */
+      tsem_up(omx_fbdev_sink_component_Private->fbdevSyncSem);
       if(err!=OMX_ErrorNone) {
         DEBUG(DEB_LEV_ERR, "In %s Video Sink Init Failed Error=%x\n",__func__,err);
         return err;
       }
     }
+  } else if (message->messageType == OMX_CommandPortEnable &&
+             (message->messageParam == OMX_BASE_SINK_INPUTPORT_INDEX || message->messageParam == OMX_ALL) &&
+             !PORT_IS_ENABLED(pPort) &&
+             eState != OMX_StateLoaded && eState != OMX_StateWaitForResources) {
+    /** the port definition may have changed while the port was disabled: the geometry, the pages
+      * and the row blitter are set up again for it before its buffers are allocated. The screen is
+      * left alone when nothing it depends on changed
+      */
+    if (omx_fbdev_sink_component_SetupChanged(omx_fbdev_sink_component_Private, pPort)) {
+      DEBUG(DEB_LEV_SIMPLE_SEQ, "In %s input port enabled, setting the frame buffer up again\n", __func__);
+      omx_fbdev_sink_component_Deinit(openmaxStandComp);
+      initErr = omx_fbdev_sink_component_Init(openmaxStandComp);
+    }
+    tsem_up(omx_fbdev_sink_component_Private->fbdevSyncSem);
   }
   // Execute the base message handling
   err = omx_base_component_MessageHandler(openmaxStandComp,message);
 
+  if (initErr != OMX_ErrorNone) {
+    /** the port is enabled all the same, so that the command completes; its frames are dropped */
+    DEBUG(DEB_LEV_ERR, "In %s Video Sink Init Failed Error=%x\n",__func__,initErr);
+    (*(omx_fbdev_sink_component_Private->callbacks->EventHandler))
+      (openmaxStandComp,
+      omx_fbdev_sink_component_Private->callbackData,
+      OMX_EventError,
+      initErr,
+      OMX_BASE_SINK_INPUTPORT_INDEX,
+      NULL);
+  }
+
   if (message->messageType == OMX_CommandStateSet) {
-    if ((message->messageParam == OMX_StateIdle ) && (omx_fbdev_sink_component_Private->state == OMX_StateIdle) && eState == OMX_StateExecuting) {
+    if ((message->messageParam == OMX_StateLoaded ) && (omx_fbdev_sink_component_Private->state == OMX_StateLoaded) && eState == OMX_StateIdle) {
       err = omx_fbdev_sink_component_Deinit(openmaxStandComp);
+      tsem_reset(omx_fbdev_sink_component_Private->fbdevSyncSem);
       if(err!=OMX_ErrorNone) {
         DEBUG(DEB_LEV_ERR, "In %s Video Sink Deinit Failed Error=%x\n",__func__,err);
         return err;
       }
     }
+  } else if (message->messageType == OMX_CommandPortDisable &&
+             (message->messageParam == OMX_BASE_SINK_INPUTPORT_INDEX || message->messageParam == OMX_ALL)) {
+    /** buffers allocated when the port is enabled again wait for the frame buffer to be set up for it */
+    tsem_reset(omx_fbdev_sink_component_Private->fbdevSyncSem);
   }
   return err;
 }
@@ -36,17 +36,99 @@
 #include <sys/mman.h>
 #include <fcntl.h>
 #include <sys/time.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <time.h>
 
 #include <bellagio/omx_base_video_port.h>
 #include <bellagio/omx_base_clock_port.h>
 #include <bellagio/omx_base_sink.h>
 #include <linux/fb.h>
 
-/**  Filename of devnode for framebuffer device
-  *  Should somehow be passed from client
-  */
+/**  Default filename of devnode for framebuffer device, see OMX_FBDEV_SINK_PARAM_DEVICETYPE */
 #define FBDEV_FILENAME  "/dev/fb0"
 
+/**  Refresh rate in Hz of the screen emulated over a regular file, paced by FBIO_WAITFORVSYNC */
+#define FBDEV_SINK_FILE_REFRESH_RATE 60
+
+/**  Number of frame buffer pages used for page flipping; frames are rendered into the
+  *  hidden page and panned to, so the page being scanned out is never written.
+  *  Input buffers handed out of frame buffer memory get a page each, so there may be more.
+  */
+#define FBDEV_SINK_PAGES 2
+
+#ifndef FBIO_WAITFORVSYNC
+#define FBIO_WAITFORVSYNC _IOW('F', 0x20, __u32)
+#endif
+
+/**  Extension name of the late frame threshold config */
+#define FBDEV_SINK_LATE_THRESHOLD_EXTENSION "OMX.ST.index.config.fbdevsink.latethreshold"
+
+/**  Extension name of the device parameter */
+#define FBDEV_SINK_DEVICE_EXTENSION "OMX.ST.index.param.fbdevsink.device"
+
+/**  Default lateness in microseconds beyond which a frame is dropped instead of shown */
+#define FBDEV_SINK_DEFAULT_LATE_THRESHOLD 20000
+
+/** Longest waits in milliseconds for the clock component: for the clock to start after the start time
+  * is set, and for a media time request to be fulfilled, which takes as long as the frame is early.
+  * The waits check for flushes every FBDEV_SINK_CLOCK_WAIT_SLICE
+  */
+#define FBDEV_SINK_CLOCK_START_TIMEOUT 2000
+#define FBDEV_SINK_CLOCK_REQUEST_TIMEOUT 2000
+#define FBDEV_SINK_CLOCK_WAIT_SLICE 20
+
+/**  Pixels converted at a time by the row blitters before being written to the frame buffer */
+#define FBDEV_BLIT_CHUNK 256
+
+/**  Converts width pixels of a source row into a frame buffer row */
+typedef void (*omx_fbdev_blit_row)(const OMX_U8* src, OMX_U8* dest, OMX_U32 width);
+
+/**  Instruction set extensions the row blitters may be chosen among, or'ed together */
+#define FBDEV_SIMD_NONE  0x0
+#define FBDEV_SIMD_SSSE3 0x1
+#define FBDEV_SIMD_AVX2  0x2
+#define FBDEV_SIMD_NEON  0x4
+
+/**  Width in pixels of the source stripes a rotated image is copied by */
+#define FBDEV_ROTATE_STRIPE_WIDTH 16
+
+/** Vendor specific indexes of the fbdev sink */
+typedef enum OMX_FBDEV_SINK_INDEXVENDORTYPE {
+  OMX_IndexVendorFbdevSinkLateThreshold = OMX_IndexVendorStartUnused + 0x00d00200, /**< reference: OMX_FBDEV_SINK_CONFIG_LATETHRESHOLDTYPE */
+  OMX_IndexVendorFbdevSinkDevice                                                  /**< reference: OMX_FBDEV_SINK_PARAM_DEVICETYPE */
+} OMX_FBDEV_SINK_INDEXVENDORTYPE;
+
+/** Late frame threshold, used when the clock port is tunneled.
+  * A frame whose presentation time has passed by more than nLateThreshold is dropped without being drawn.
+  * @param nLateThreshold lateness in microseconds of media time
+  */
+typedef struct OMX_FBDEV_SINK_CONFIG_LATETHRESHOLDTYPE {
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U32 nPortIndex;
+  OMX_U32 nLateThreshold;
+} OMX_FBDEV_SINK_CONFIG_LATETHRESHOLDTYPE;
+
+/** Frame buffer device the sink draws to, opened when the component goes to Idle.
+  * A regular file stands in for a device: it is mapped as the screen memory, grown as pages are
+  * needed, and emulates a screen of nWidth x nHeight pixels of eColorFormat refreshed
+  * FBDEV_SINK_FILE_REFRESH_RATE times a second. The other fields are ignored for a device.
+  * @param cDeviceName path of the frame buffer device node or of the file
+  * @param nWidth emulated screen width, 0 for the input frame width
+  * @param nHeight emulated screen height, 0 for the input frame height plus HEIGHT_OFFSET
+  * @param eColorFormat emulated screen format: RGB565, BGR565, ARGB1555, RGB888, ARGB8888 or unused for ARGB8888
+  */
+typedef struct OMX_FBDEV_SINK_PARAM_DEVICETYPE {
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U32 nPortIndex;
+  OMX_U8 cDeviceName[OMX_MAX_STRINGNAME_SIZE];
+  OMX_U32 nWidth;
+  OMX_U32 nHeight;
+  OMX_COLOR_FORMATTYPE eColorFormat;
+} OMX_FBDEV_SINK_PARAM_DEVICETYPE;
+
 /** FBDEV sink port component port structure.
   */
 DERIVEDCLASS(omx_fbdev_sink_component_PortType, omx_base_video_PortType)
@@ -79,6 +161,25 @@ ENDCLASS(omx_fbdev_sink_component_PortType)
   * @param product frame buffer memory area
   * @param frameDropFlag the flag active on scale change indicates that frames are to be dropped
   * @param dropFrameCount counts the number of frames dropped
+  * @param orig_vscr_info The fb_var_screeninfo found at initialization, restored at deinitialization
+  * @param nPages number of frame buffer pages mapped, 1 when the driver cannot pan
+  * @param nBackPage the hidden page the next frame is rendered into
+  * @param page_size size in bytes of a frame buffer page
+  * @param bVsync OMX_TRUE if the driver supports FBIO_WAITFORVSYNC
+  * @param sLateThreshold lateness beyond which frames are dropped when the clock port is tunneled
+  * @param last_frame_time time in milliseconds the last frame was shown, for pacing without clock
+  * @param blitRow row blitter from the input color format to the frame buffer one, chosen at initialization and again when the input port format changes
+  * @param pShownBuffer input buffer in frame buffer memory just panned to, held when it is returned
+  * @param pHeldBuffer input buffer in frame buffer memory on screen, returned when the next one is shown
+  * @param sDevice frame buffer device or file the sink draws to
+  * @param bFileBacked OMX_TRUE when a regular file stands in for the device
+  * @param file_vscr_info screen info emulated for a file
+  * @param file_fscr_info fixed screen info emulated for a file
+  * @param nFrameProcessTime time in microseconds a frame is shown for when pacing without clock nor vsync
+  * @param fbdevSyncSem posted once the frame buffer is set up for the input port, whose buffers may be its pages
+  * @param sInitPortDef input port definition the frame buffer was last set up for
+  * @param eInitColorFormat input color format the frame buffer was last set up for
+  * @param nInitShownHeight rows of the rotated frame the frame buffer was last set up for
   */
 DERIVEDCLASS(omx_fbdev_sink_component_PrivateType, omx_base_sink_PrivateType)
 #define omx_fbdev_sink_component_PrivateType_FIELDS omx_base_sink_PrivateType_FIELDS \
@@ -95,7 +196,26 @@ DERIVEDCLASS(omx_fbdev_sink_component_PrivateType, omx_base_sink_PrivateType)
   OMX_TIME_CLOCKSTATE          eState; \
   OMX_U32                      product;\
   OMX_BOOL                     frameDropFlag;\
-  int                          dropFrameCount;
+  int                          dropFrameCount; \
+  struct                       fb_var_screeninfo orig_vscr_info; \
+  OMX_U32                      nPages; \
+  OMX_U32                      nBackPage; \
+  OMX_U32                      page_size; \
+  OMX_BOOL                     bVsync; \
+  OMX_FBDEV_SINK_CONFIG_LATETHRESHOLDTYPE sLateThreshold; \
+  long                         last_frame_time; \
+  omx_fbdev_blit_row           blitRow; \
+  OMX_BUFFERHEADERTYPE*        pShownBuffer; \
+  OMX_BUFFERHEADERTYPE*        pHeldBuffer; \
+  OMX_FBDEV_SINK_PARAM_DEVICETYPE sDevice; \
+  OMX_BOOL                     bFileBacked; \
+  struct                       fb_var_screeninfo file_vscr_info; \
+  struct                       fb_fix_screeninfo file_fscr_info; \
+  OMX_U32                      nFrameProcessTime; \
+  tsem_t*                      fbdevSyncSem; \
+  OMX_PARAM_PORTDEFINITIONTYPE sInitPortDef; \
+  OMX_COLOR_FORMATTYPE         eInitColorFormat; \
+  OMX_U32                      nInitShownHeight;
 ENDCLASS(omx_fbdev_sink_component_PrivateType)
 
 /* Component private entry points declaration */
@@ -113,6 +233,24 @@ OMX_ERRORTYPE omx_fbdev_sink_component_port_SendBufferFunction(
   omx_base_PortType *openmaxStandPort,
   OMX_BUFFERHEADERTYPE* pBuffer);
 
+OMX_ERRORTYPE omx_fbdev_sink_component_port_FlushProcessingBuffers(omx_base_PortType *openmaxStandPort);
+
+OMX_ERRORTYPE omx_fbdev_sink_component_port_AllocateBuffer(
+  omx_base_PortType *openmaxStandPort,
+  OMX_BUFFERHEADERTYPE** pBuffer,
+  OMX_U32 nPortIndex,
+  OMX_PTR pAppPrivate,
+  OMX_U32 nSizeBytes);
+
+OMX_ERRORTYPE omx_fbdev_sink_component_port_FreeBuffer(
+  omx_base_PortType *openmaxStandPort,
+  OMX_U32 nPortIndex,
+  OMX_BUFFERHEADERTYPE* pBuffer);
+
+OMX_ERRORTYPE omx_fbdev_sink_component_port_ReturnBufferFunction(
+  omx_base_PortType *openmaxStandPort,
+  OMX_BUFFERHEADERTYPE* pBuffer);
+
 /* to handle the communication at the clock port */
 OMX_BOOL omx_fbdev_sink_component_ClockPortHandleFunction(
   omx_fbdev_sink_component_PrivateType* omx_fbdev_sink_component_Private,
@@ -140,6 +278,11 @@ OMX_ERRORTYPE omx_fbdev_sink_component_GetConfig(
 
 /** function prototypes of some internal functions */
 
+OMX_ERRORTYPE omx_fbdev_sink_component_GetExtensionIndex(
+  OMX_HANDLETYPE hComponent,
+  OMX_STRING cParameterName,
+  OMX_INDEXTYPE* pIndexType);
+
 /** finds OpenMAX standard pixel format from screen info */
 OMX_COLOR_FORMATTYPE find_omx_pxlfmt(struct fb_var_screeninfo *vscr_info);
 
@@ -149,12 +292,22 @@ enum PixelFormat find_ffmpeg_pxlfmt(OMX_COLOR_FORMATTYPE omx_pxlfmt);
 /** finds video stride  from input dimension and color format */
 OMX_S32 calcStride(OMX_U32 width, OMX_COLOR_FORMATTYPE omx_pxlfmt);
 
+/** returns the FBDEV_SIMD_* extensions this build has row blitters for and the processor runs */
+OMX_U32 omx_fbdev_simd_support(void);
+
+/** finds the row blitter for an input and frame buffer color format using no other extensions than simd, NULL if there is none */
+omx_fbdev_blit_row omx_fbdev_find_blitter_simd(OMX_COLOR_FORMATTYPE colorformat, OMX_COLOR_FORMATTYPE fbpxlfmt, OMX_U32 simd);
+
+/** finds the row blitter for an input and frame buffer color format, NULL if there is none */
+omx_fbdev_blit_row omx_fbdev_find_blitter(OMX_COLOR_FORMATTYPE colorformat, OMX_COLOR_FORMATTYPE fbpxlfmt);
+
 /** image copy function */
 void omx_img_copy(OMX_U8* src_ptr, OMX_S32 src_stride, OMX_U32 src_width, OMX_U32 src_height,
                   OMX_S32 src_offset_x, OMX_S32 src_offset_y,
                   OMX_U8* dest_ptr, OMX_S32 dest_stride, OMX_U32 dest_width,  OMX_U32 dest_height,
                   OMX_S32 dest_offset_x, OMX_S32 dest_offset_y,
-                  OMX_S32 cpy_width, OMX_U32 cpy_height, OMX_COLOR_FORMATTYPE colorformat,OMX_COLOR_FORMATTYPE fbpxlfmt);
+                  OMX_S32 cpy_width, OMX_U32 cpy_height, OMX_COLOR_FORMATTYPE colorformat,OMX_COLOR_FORMATTYPE fbpxlfmt,
+                  OMX_U32 rotation, omx_fbdev_blit_row blit_row);
 
 /** Returns a time value in milliseconds based on a clock starting at
  *  some arbitrary base. Given a call to GetTime that returns a value
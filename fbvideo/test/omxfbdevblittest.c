@@ -0,0 +1,166 @@
+/**
+  test/omxfbdevblittest.c
+
+  Row blitter test program of the OpenMAX FBDEV sink component
+
+  Every row blitter of the FBDEV sink, for each instruction set the processor
+  runs, is checked to give the same frame buffer bytes as the pixel by pixel
+  conversion of omx_img_copy, then timed against it.
+  With -b only the timings are printed.
+
+  Copyright (C) 2007-2009  STMicroelectronics and Agere Systems
+
+  This library is free software; you can redistribute it and/or modify it under
+  the terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation; either version 2.1 of the License, or (at your option)
+  any later version.
+
+  This library is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+  FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin St, Fifth Floor, Boston, MA
+  02110-1301  USA
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "omxfbdevblittest.h"
+
+static const blitTestCase testCases[] = {
+  { OMX_COLOR_Format24bitRGB888,   OMX_COLOR_Format16bitRGB565,   3, 2, "RGB888 -> RGB565" },
+  { OMX_COLOR_Format24bitRGB888,   OMX_COLOR_Format16bitBGR565,   3, 2, "RGB888 -> BGR565" },
+  { OMX_COLOR_Format24bitRGB888,   OMX_COLOR_Format16bitARGB1555, 3, 2, "RGB888 -> ARGB1555" },
+  { OMX_COLOR_Format24bitRGB888,   OMX_COLOR_Format32bitARGB8888, 3, 4, "RGB888 -> ARGB8888" },
+  { OMX_COLOR_Format24bitBGR888,   OMX_COLOR_Format32bitARGB8888, 3, 4, "BGR888 -> ARGB8888" },
+  { OMX_COLOR_Format32bitARGB8888, OMX_COLOR_Format32bitARGB8888, 4, 4, "ARGB8888 -> ARGB8888" },
+  { OMX_COLOR_Format16bitARGB1555, OMX_COLOR_Format32bitARGB8888, 2, 4, "ARGB1555 -> ARGB8888" },
+  { OMX_COLOR_Format16bitRGB565,   OMX_COLOR_Format32bitARGB8888, 2, 4, "RGB565 -> ARGB8888" },
+};
+
+static const blitTestSimd testSimds[] = {
+  { FBDEV_SIMD_NONE,  "C" },
+  { FBDEV_SIMD_SSSE3, "SSSE3" },
+  { FBDEV_SIMD_AVX2,  "AVX2" },
+  { FBDEV_SIMD_NEON,  "NEON" },
+};
+
+void display_help() {
+  printf("\n");
+  printf("Usage: omxfbdevblittest [-b] [-h]\n");
+  printf("\n");
+  printf("       -b: only time the blitters, do not compare them\n");
+  printf("       -h: displays this help\n");
+  printf("\n");
+  exit(1);
+}
+
+static double getTime() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+/* Copies the frame into the frame buffer with blit_row, or pixel by pixel when it is NULL.
+ * The odd offsets and width make the rows start unaligned and end in the blitters' tails.
+ */
+static void copyFrame(const blitTestCase* testCase, OMX_U8* src, OMX_U8* fb, OMX_S32 offset, omx_fbdev_blit_row blit_row) {
+  OMX_U32 fb_width = BLIT_TEST_WIDTH + BLIT_TEST_MARGIN;
+  OMX_U32 fb_height = BLIT_TEST_HEIGHT + BLIT_TEST_MARGIN;
+
+  omx_img_copy(src, BLIT_TEST_WIDTH * testCase->src_pixel_bytes, BLIT_TEST_WIDTH, BLIT_TEST_HEIGHT, 0, 0,
+               fb, fb_width * testCase->fb_pixel_bytes, fb_width, fb_height, offset, 2 * offset,
+               BLIT_TEST_WIDTH - offset, BLIT_TEST_HEIGHT - 3 * offset,
+               testCase->colorformat, testCase->fbpxlfmt, 0, blit_row);
+}
+
+int main(int argc, char** argv) {
+  OMX_U32 fb_size = (BLIT_TEST_WIDTH + BLIT_TEST_MARGIN) * (BLIT_TEST_HEIGHT + BLIT_TEST_MARGIN) * 4;
+  OMX_U32 src_size = BLIT_TEST_WIDTH * BLIT_TEST_HEIGHT * 4;
+  OMX_U8 *src, *expected, *fb;
+  OMX_U32 supported, i, k, s;
+  omx_fbdev_blit_row blit_row;
+  double start, pixel_time, blit_time;
+  int benchmark_only = 0;
+  int failures = 0;
+
+  for (i = 1; i < (OMX_U32) argc; i++) {
+    if (strcmp(argv[i], "-b") == 0) {
+      benchmark_only = 1;
+    } else {
+      display_help();
+    }
+  }
+
+  src = malloc(src_size);
+  expected = malloc(fb_size);
+  fb = malloc(fb_size);
+  if (src == NULL || expected == NULL || fb == NULL) {
+    printf("Out of memory\n");
+    return 1;
+  }
+  for (i = 0; i < src_size; i++) {
+    src[i] = (OMX_U8) ((i * 2654435761u) >> 13);
+  }
+
+  supported = omx_fbdev_simd_support();
+  for (k = 0; k < sizeof(testCases) / sizeof(testCases[0]); k++) {
+    start = getTime();
+    for (i = 0; i < BLIT_TEST_ROUNDS; i++) {
+      copyFrame(&testCases[k], src, expected, 0, NULL);
+    }
+    pixel_time = (getTime() - start) / BLIT_TEST_ROUNDS;
+    printf("%-22s pixel by pixel %7.3f ms\n", testCases[k].name, pixel_time);
+
+    for (s = 0; s < sizeof(testSimds) / sizeof(testSimds[0]); s++) {
+      if (testSimds[s].simd != FBDEV_SIMD_NONE && !(supported & testSimds[s].simd)) {
+        continue;
+      }
+      blit_row = omx_fbdev_find_blitter_simd(testCases[k].colorformat, testCases[k].fbpxlfmt, testSimds[s].simd);
+      if (blit_row == NULL) {
+        printf("%-22s %-14s no blitter\n", "", testSimds[s].name);
+        failures++;
+        continue;
+      }
+
+      if (!benchmark_only) {
+        memset(expected, 0x5a, fb_size);
+        memset(fb, 0x5a, fb_size);
+        copyFrame(&testCases[k], src, expected, 1, NULL);
+        copyFrame(&testCases[k], src, fb, 1, blit_row);
+        if (memcmp(expected, fb, fb_size) != 0) {
+          printf("%-22s %-14s differs from the pixel by pixel conversion\n", "", testSimds[s].name);
+          failures++;
+          continue;
+        }
+      }
+
+      start = getTime();
+      for (i = 0; i < BLIT_TEST_ROUNDS; i++) {
+        copyFrame(&testCases[k], src, fb, 0, blit_row);
+      }
+      blit_time = (getTime() - start) / BLIT_TEST_ROUNDS;
+      printf("%-22s %-14s %7.3f ms, %.1fx\n", "", testSimds[s].name, blit_time, pixel_time / blit_time);
+    }
+  }
+
+  free(src);
+  free(expected);
+  free(fb);
+
+  if (failures) {
+    printf("%d blitter(s) failed\n", failures);
+    return 1;
+  }
+  if (!benchmark_only) {
+    printf("All blitters match the pixel by pixel conversion\n");
+  }
+  return 0;
+}
@@ -0,0 +1,60 @@
+/**
+  test/omxfbdevblittest.h
+
+  Row blitter test program of the OpenMAX FBDEV sink component
+
+  Every row blitter of the FBDEV sink, for each instruction set the processor
+  runs, is checked to give the same frame buffer bytes as the pixel by pixel
+  conversion of omx_img_copy, then timed against it.
+
+  Copyright (C) 2007-2009  STMicroelectronics and Agere Systems
+
+  This library is free software; you can redistribute it and/or modify it under
+  the terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation; either version 2.1 of the License, or (at your option)
+  any later version.
+
+  This library is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+  FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin St, Fifth Floor, Boston, MA
+  02110-1301  USA
+
+*/
+
+#include <OMX_Types.h>
+#include <OMX_Core.h>
+#include <OMX_IVCommon.h>
+
+#include <omx_fbdev_sink_component.h>
+
+/* Size of the test frames */
+#define BLIT_TEST_WIDTH  1280
+#define BLIT_TEST_HEIGHT 720
+
+/* Frame buffer margin around the frames, in pixels */
+#define BLIT_TEST_MARGIN 8
+
+/* Frames converted per timing */
+#define BLIT_TEST_ROUNDS 50
+
+/* A conversion from an input color format to a frame buffer one */
+typedef struct blitTestCase {
+  OMX_COLOR_FORMATTYPE colorformat;
+  OMX_COLOR_FORMATTYPE fbpxlfmt;
+  OMX_U32 src_pixel_bytes;
+  OMX_U32 fb_pixel_bytes;
+  const char* name;
+} blitTestCase;
+
+/* Instruction set the row blitters are taken from */
+typedef struct blitTestSimd {
+  OMX_U32 simd;
+  const char* name;
+} blitTestSimd;
+
+void display_help();
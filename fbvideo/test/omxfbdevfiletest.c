@@ -0,0 +1,303 @@
+/**
+  test/omxfbdevfiletest.c
+
+  File backend test program of the OpenMAX FBDEV sink component
+
+  This test program draws RGB888 frames with the FBDEV sink on a regular
+  file standing in for a RGB565 frame buffer, so it runs on machines
+  without a screen. It checks that the last frame sent reached the file
+  and reports how many frames a second the sink shows.
+
+  Copyright (C) 2007-2009  STMicroelectronics and Agere Systems
+
+  This library is free software; you can redistribute it and/or modify it under
+  the terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation; either version 2.1 of the License, or (at your option)
+  any later version.
+
+  This library is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+  FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin St, Fifth Floor, Boston, MA
+  02110-1301  USA
+
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/time.h>
+
+#include "omxfbdevfiletest.h"
+
+OMX_CALLBACKTYPE fbdev_sink_callbacks = {
+    .EventHandler = fb_sinkEventHandler,
+    .EmptyBufferDone = fb_sinkEmptyBufferDone,
+    .FillBufferDone = NULL
+  };
+
+appPrivateType* appPriv;
+
+void display_help() {
+  printf("\n");
+  printf("Usage: omxfbdevfiletest [-o outfile] [-w width] [-h height] [-n frames] [-r rate]\n");
+  printf("\n");
+  printf("       -o outfile: file standing in for the frame buffer, default /tmp/omxfbdevfiletest.fb\n");
+  printf("       -w width: frame width, default 640\n");
+  printf("       -h height: frame height, default 480\n");
+  printf("       -n frames: number of frames sent, default 120\n");
+  printf("       -r rate: frame rate the sink paces to, default 1000\n");
+  printf("\n");
+  exit(1);
+}
+
+static double getTime() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+/* Red, green and blue of pixel x, y of frame n: the green of the first row tells the frames apart */
+static void fillFrame(OMX_U8* buffer, OMX_U32 stride, OMX_U32 width, OMX_U32 height, OMX_U32 n) {
+  OMX_U32 x, y;
+  OMX_U8* pixel;
+
+  for (y = 0; y < height; y++) {
+    pixel = buffer + y * stride;
+    for (x = 0; x < width; x++, pixel += 3) {
+      pixel[0] = (OMX_U8) (x + n);
+      pixel[1] = (OMX_U8) (3 * y + n);
+      pixel[2] = (OMX_U8) ((x ^ y) + 7 * n);
+    }
+  }
+}
+
+/* First row of frame n as the sink writes it to a RGB565 frame buffer */
+static void firstRow565(OMX_U8* row, OMX_U32 width, OMX_U32 n) {
+  OMX_U8 pixel[3];
+  OMX_U16 value;
+  OMX_U32 x;
+
+  for (x = 0; x < width; x++) {
+    pixel[0] = (OMX_U8) (x + n);
+    pixel[1] = (OMX_U8) n;
+    pixel[2] = (OMX_U8) (x + 7 * n);
+    value = (OMX_U16) (((pixel[0] & 0xf8) << 8) | ((pixel[1] & 0xfc) << 3) | (pixel[2] >> 3));
+    memcpy(row + 2 * x, &value, 2);
+  }
+}
+
+int main(int argc, char** argv) {
+  OMX_ERRORTYPE err;
+  OMX_INDEXTYPE deviceIndex;
+  OMX_FBDEV_SINK_PARAM_DEVICETYPE device;
+  OMX_PARAM_PORTDEFINITIONTYPE portDefinition;
+  OMX_VIDEO_PARAM_PORTFORMATTYPE videoPortFormat;
+  char* output_file = "/tmp/omxfbdevfiletest.fb";
+  OMX_U32 width = 640, height = 480, frames = 120, rate = 1000;
+  OMX_U32 i, n;
+  OMX_U8 *file_data, *row;
+  struct stat file_stat;
+  double start, elapsed;
+  int fd, found;
+
+  for (i = 1; i < (OMX_U32) argc; i++) {
+    if (argv[i][0] != '-' || argv[i][1] == '\0' || argv[i][2] != '\0' || i + 1 >= (OMX_U32) argc) {
+      display_help();
+    }
+    switch (argv[i][1]) {
+      case 'o':
+        output_file = argv[++i];
+        break;
+      case 'w':
+        width = (OMX_U32) atoi(argv[++i]);
+        break;
+      case 'h':
+        height = (OMX_U32) atoi(argv[++i]);
+        break;
+      case 'n':
+        frames = (OMX_U32) atoi(argv[++i]);
+        break;
+      case 'r':
+        rate = (OMX_U32) atoi(argv[++i]);
+        break;
+      default:
+        display_help();
+    }
+  }
+  if (width == 0 || height == 0 || frames == 0 || rate == 0) {
+    display_help();
+  }
+
+  /* the sink grows the file to the pages it needs */
+  fd = open(output_file, O_CREAT | O_TRUNC | O_RDWR, 0644);
+  if (fd < 0) {
+    printf("Cannot create %s\n", output_file);
+    return 1;
+  }
+  close(fd);
+
+  appPriv = calloc(1, sizeof(appPrivateType));
+  tsem_init(&appPriv->eventSem, 0);
+  tsem_init(&appPriv->bufferSem, FILE_TEST_BUFFERS);
+
+  err = OMX_Init();
+  if (err != OMX_ErrorNone) {
+    printf("OMX_Init() failed\n");
+    return 1;
+  }
+  err = OMX_GetHandle(&appPriv->handle, "OMX.st.fbdev.fbdev_sink", NULL, &fbdev_sink_callbacks);
+  if (err != OMX_ErrorNone) {
+    printf("No fbdev sink component found, exiting\n");
+    return 1;
+  }
+
+  err = OMX_GetExtensionIndex(appPriv->handle, FBDEV_SINK_DEVICE_EXTENSION, &deviceIndex);
+  if (err != OMX_ErrorNone) {
+    printf("No device parameter in the fbdev sink, exiting\n");
+    return 1;
+  }
+  setHeader(&device, sizeof(OMX_FBDEV_SINK_PARAM_DEVICETYPE));
+  device.nPortIndex = 0;
+  OMX_GetParameter(appPriv->handle, deviceIndex, &device);
+  strncpy((char*) device.cDeviceName, output_file, OMX_MAX_STRINGNAME_SIZE - 1);
+  device.nWidth = 0;
+  device.nHeight = 0;
+  device.eColorFormat = OMX_COLOR_Format16bitRGB565;
+  err = OMX_SetParameter(appPriv->handle, deviceIndex, &device);
+  if (err != OMX_ErrorNone) {
+    printf("Cannot set the device to %s\n", output_file);
+    return 1;
+  }
+
+  setHeader(&videoPortFormat, sizeof(OMX_VIDEO_PARAM_PORTFORMATTYPE));
+  videoPortFormat.nPortIndex = 0;
+  OMX_GetParameter(appPriv->handle, OMX_IndexParamVideoPortFormat, &videoPortFormat);
+  videoPortFormat.eCompressionFormat = OMX_VIDEO_CodingUnused;
+  videoPortFormat.eColorFormat = OMX_COLOR_Format24bitRGB888;
+  videoPortFormat.xFramerate = rate;
+  OMX_SetParameter(appPriv->handle, OMX_IndexParamVideoPortFormat, &videoPortFormat);
+
+  setHeader(&portDefinition, sizeof(OMX_PARAM_PORTDEFINITIONTYPE));
+  portDefinition.nPortIndex = 0;
+  OMX_GetParameter(appPriv->handle, OMX_IndexParamPortDefinition, &portDefinition);
+  portDefinition.format.video.nFrameWidth = width;
+  portDefinition.format.video.nFrameHeight = height;
+  portDefinition.nBufferCountActual = FILE_TEST_BUFFERS;
+  OMX_SetParameter(appPriv->handle, OMX_IndexParamPortDefinition, &portDefinition);
+  OMX_GetParameter(appPriv->handle, OMX_IndexParamPortDefinition, &portDefinition);
+
+  err = OMX_SendCommand(appPriv->handle, OMX_CommandStateSet, OMX_StateIdle, NULL);
+  for (i = 0; i < FILE_TEST_BUFFERS; i++) {
+    err = OMX_AllocateBuffer(appPriv->handle, &appPriv->pInBuffer[i], 0, NULL, portDefinition.nBufferSize);
+    if (err != OMX_ErrorNone) {
+      printf("Unable to allocate buffer %d\n", (int) i);
+      return 1;
+    }
+  }
+  tsem_down(&appPriv->eventSem);
+  if (appPriv->nErrors) {
+    printf("The sink could not set up %s\n", output_file);
+    return 1;
+  }
+
+  err = OMX_SendCommand(appPriv->handle, OMX_CommandStateSet, OMX_StateExecuting, NULL);
+  tsem_down(&appPriv->eventSem);
+
+  start = getTime();
+  for (n = 0; n < frames; n++) {
+    /* buffers come back in the order they were sent */
+    tsem_down(&appPriv->bufferSem);
+    i = n % FILE_TEST_BUFFERS;
+    fillFrame(appPriv->pInBuffer[i]->pBuffer, (OMX_U32) portDefinition.format.video.nStride, width, height, n);
+    appPriv->pInBuffer[i]->nFilledLen = portDefinition.nBufferSize;
+    appPriv->pInBuffer[i]->nOffset = 0;
+    appPriv->pInBuffer[i]->nFlags = 0;
+    err = OMX_EmptyThisBuffer(appPriv->handle, appPriv->pInBuffer[i]);
+    if (err != OMX_ErrorNone) {
+      printf("EmptyThisBuffer failed on frame %d\n", (int) n);
+      return 1;
+    }
+  }
+  /* the last frame is on screen once the frame after it would be taken */
+  tsem_down(&appPriv->bufferSem);
+  elapsed = getTime() - start;
+  tsem_up(&appPriv->bufferSem);
+
+  err = OMX_SendCommand(appPriv->handle, OMX_CommandStateSet, OMX_StateIdle, NULL);
+  tsem_down(&appPriv->eventSem);
+  err = OMX_SendCommand(appPriv->handle, OMX_CommandStateSet, OMX_StateLoaded, NULL);
+  for (i = 0; i < FILE_TEST_BUFFERS; i++) {
+    OMX_FreeBuffer(appPriv->handle, 0, appPriv->pInBuffer[i]);
+  }
+  tsem_down(&appPriv->eventSem);
+  OMX_FreeHandle(appPriv->handle);
+  OMX_Deinit();
+
+  printf("%d frames of %dx%d in %.1f ms, %.1f frames/s\n", (int) frames, (int) width, (int) height,
+         elapsed, frames * 1000.0 / elapsed);
+
+  /* the first row of the last frame must be somewhere in the pages of the file */
+  found = 0;
+  fd = open(output_file, O_RDONLY);
+  if (fd >= 0 && fstat(fd, &file_stat) == 0 && file_stat.st_size > 0) {
+    file_data = malloc((size_t) file_stat.st_size);
+    row = malloc(2 * width);
+    if (file_data != NULL && row != NULL && read(fd, file_data, (size_t) file_stat.st_size) == file_stat.st_size) {
+      firstRow565(row, width, frames - 1);
+      found = memmem(file_data, (size_t) file_stat.st_size, row, 2 * width) != NULL;
+    }
+    free(file_data);
+    free(row);
+  }
+  if (fd >= 0) {
+    close(fd);
+  }
+
+  tsem_deinit(&appPriv->eventSem);
+  tsem_deinit(&appPriv->bufferSem);
+  if (appPriv->nErrors || !found) {
+    printf("The last frame is not in %s\n", output_file);
+    free(appPriv);
+    return 1;
+  }
+  free(appPriv);
+  printf("The last frame is in %s\n", output_file);
+  return 0;
+}
+
+OMX_ERRORTYPE fb_sinkEventHandler(
+  OMX_OUT OMX_HANDLETYPE hComponent,
+  OMX_OUT OMX_PTR pAppData,
+  OMX_OUT OMX_EVENTTYPE eEvent,
+  OMX_OUT OMX_U32 Data1,
+  OMX_OUT OMX_U32 Data2,
+  OMX_OUT OMX_PTR pEventData) {
+
+  if (eEvent == OMX_EventCmdComplete) {
+    tsem_up(&appPriv->eventSem);
+  } else if (eEvent == OMX_EventError) {
+    printf("Error %x from the fbdev sink\n", (int) Data1);
+    appPriv->nErrors++;
+    /* a state change that failed completes no command */
+    if (Data2 == OMX_CommandStateSet) {
+      tsem_up(&appPriv->eventSem);
+    }
+  }
+  return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE fb_sinkEmptyBufferDone(
+  OMX_OUT OMX_HANDLETYPE hComponent,
+  OMX_OUT OMX_PTR pAppData,
+  OMX_OUT OMX_BUFFERHEADERTYPE* pBuffer) {
+
+  tsem_up(&appPriv->bufferSem);
+  return OMX_ErrorNone;
+}
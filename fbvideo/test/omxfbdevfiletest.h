@@ -0,0 +1,69 @@
+/**
+  test/omxfbdevfiletest.h
+
+  File backend test program of the OpenMAX FBDEV sink component
+
+  This test program draws RGB888 frames with the FBDEV sink on a regular
+  file standing in for a RGB565 frame buffer, so it runs on machines
+  without a screen. It checks that the last frame sent reached the file
+  and reports how many frames a second the sink shows.
+
+  Copyright (C) 2007-2009  STMicroelectronics and Agere Systems
+
+  This library is free software; you can redistribute it and/or modify it under
+  the terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation; either version 2.1 of the License, or (at your option)
+  any later version.
+
+  This library is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+  FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin St, Fifth Floor, Boston, MA
+  02110-1301  USA
+
+*/
+
+#include <OMX_Types.h>
+#include <OMX_Core.h>
+#include <OMX_Component.h>
+#include <OMX_IVCommon.h>
+
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <bellagio/tsemaphore.h>
+
+#include <omx_fbdev_sink_component.h>
+
+/* Number of buffers requested to the component */
+#define FILE_TEST_BUFFERS 2
+
+/* Application's private data */
+typedef struct appPrivateType{
+  OMX_HANDLETYPE handle;
+  OMX_BUFFERHEADERTYPE* pInBuffer[FILE_TEST_BUFFERS];
+  tsem_t eventSem;
+  tsem_t bufferSem;
+  OMX_U32 nErrors;
+}appPrivateType;
+
+/* Callback prototypes */
+OMX_ERRORTYPE fb_sinkEventHandler(
+  OMX_OUT OMX_HANDLETYPE hComponent,
+  OMX_OUT OMX_PTR pAppData,
+  OMX_OUT OMX_EVENTTYPE eEvent,
+  OMX_OUT OMX_U32 Data1,
+  OMX_OUT OMX_U32 Data2,
+  OMX_OUT OMX_PTR pEventData);
+
+OMX_ERRORTYPE fb_sinkEmptyBufferDone(
+  OMX_OUT OMX_HANDLETYPE hComponent,
+  OMX_OUT OMX_PTR pAppData,
+  OMX_OUT OMX_BUFFERHEADERTYPE* pBuffer);
+
+void display_help();
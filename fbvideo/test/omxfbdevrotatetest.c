@@ -0,0 +1,190 @@
+/**
+  test/omxfbdevrotatetest.c
+
+  Rotation test program of the OpenMAX FBDEV sink component
+
+  Frames copied by omx_img_copy with a rotation of 90, 180 and 270 degrees
+  are checked against the unrotated copy turned pixel by pixel, and the
+  rotating copy is timed against that naive rotation. The frames are then
+  turned into a page as large as the unturned frame, followed by memory
+  that cannot be written, and must be cut to that page.
+
+  Copyright (C) 2007-2009  STMicroelectronics and Agere Systems
+
+  This library is free software; you can redistribute it and/or modify it under
+  the terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation; either version 2.1 of the License, or (at your option)
+  any later version.
+
+  This library is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+  FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin St, Fifth Floor, Boston, MA
+  02110-1301  USA
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "omxfbdevrotatetest.h"
+
+/* Planar YUV frames are copied unrotated by the sink, so only packed formats are tested */
+static const rotateTestCase testCases[] = {
+  { OMX_COLOR_Format24bitRGB888,    OMX_COLOR_Format32bitARGB8888, 4, "RGB888 -> ARGB8888" },
+  { OMX_COLOR_Format24bitRGB888,    OMX_COLOR_Format16bitRGB565,   2, "RGB888 -> RGB565" },
+  { OMX_COLOR_Format16bitRGB565,    OMX_COLOR_Format32bitARGB8888, 4, "RGB565 -> ARGB8888" },
+  { OMX_COLOR_Format32bitARGB8888,  OMX_COLOR_Format32bitARGB8888, 4, "ARGB8888 -> ARGB8888" },
+};
+
+static double getTime() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+/* Copies the frame to the top left corner of a frame buffer as large as the frame turned or not */
+static void copyFrame(const rotateTestCase* testCase, OMX_U8* src, OMX_U8* fb, OMX_U32 rotation, omx_fbdev_blit_row blit_row) {
+  OMX_U32 fb_width = (rotation == 90 || rotation == 270) ? ROTATE_TEST_HEIGHT : ROTATE_TEST_WIDTH;
+  OMX_U32 fb_height = (rotation == 90 || rotation == 270) ? ROTATE_TEST_WIDTH : ROTATE_TEST_HEIGHT;
+
+  omx_img_copy(src, calcStride(ROTATE_TEST_WIDTH, testCase->colorformat), ROTATE_TEST_WIDTH, ROTATE_TEST_HEIGHT, 0, 0,
+               fb, fb_width * testCase->fb_pixel_bytes, fb_width, fb_height, 0, 0,
+               ROTATE_TEST_WIDTH, ROTATE_TEST_HEIGHT, testCase->colorformat, testCase->fbpxlfmt, rotation, blit_row);
+}
+
+/* Turns the unrotated frame buffer pixel by pixel, clockwise by rotation degrees */
+static void rotateNaive(const OMX_U8* fb, OMX_U8* rotated, OMX_U32 pixel_bytes, OMX_U32 rotation) {
+  OMX_U32 x, y, dest_x, dest_y, dest_width;
+
+  dest_width = (rotation == 90 || rotation == 270) ? ROTATE_TEST_HEIGHT : ROTATE_TEST_WIDTH;
+  for (y = 0; y < ROTATE_TEST_HEIGHT; y++) {
+    for (x = 0; x < ROTATE_TEST_WIDTH; x++) {
+      switch (rotation) {
+        case 90:
+          dest_x = ROTATE_TEST_HEIGHT - 1 - y;
+          dest_y = x;
+          break;
+        case 180:
+          dest_x = ROTATE_TEST_WIDTH - 1 - x;
+          dest_y = ROTATE_TEST_HEIGHT - 1 - y;
+          break;
+        default:
+          dest_x = y;
+          dest_y = ROTATE_TEST_WIDTH - 1 - x;
+          break;
+      }
+      memcpy(rotated + (dest_y * dest_width + dest_x) * pixel_bytes, fb + (y * ROTATE_TEST_WIDTH + x) * pixel_bytes, pixel_bytes);
+    }
+  }
+}
+
+/* Turns the frame into a page of ROTATE_TEST_WIDTH x ROTATE_TEST_HEIGHT pixels ending where
+ * protected memory starts, and checks the page shows the top left corner of the naive rotation
+ */
+static int checkPage(const rotateTestCase* testCase, OMX_U8* src, OMX_U8* fb, OMX_U8* expected, OMX_U32 rotation, omx_fbdev_blit_row blit_row) {
+  OMX_U32 pixel_bytes = testCase->fb_pixel_bytes;
+  OMX_U32 page_size = ROTATE_TEST_WIDTH * ROTATE_TEST_HEIGHT * pixel_bytes;
+  OMX_U32 map_size, turned_width, y;
+  long system_page = sysconf(_SC_PAGESIZE);
+  OMX_U8 *map, *page;
+  int failed = 0;
+
+  map_size = (page_size + system_page - 1) / system_page * system_page;
+  map = mmap(NULL, map_size + system_page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (map == MAP_FAILED || mprotect(map + map_size, system_page, PROT_NONE) != 0) {
+    printf("Cannot map the test page\n");
+    return 1;
+  }
+  page = map + map_size - page_size;
+
+  memset(fb, 0, ROTATE_TEST_WIDTH * ROTATE_TEST_HEIGHT * 4);
+  copyFrame(testCase, src, fb, 0, blit_row);
+  rotateNaive(fb, expected, pixel_bytes, rotation);
+  omx_img_copy(src, calcStride(ROTATE_TEST_WIDTH, testCase->colorformat), ROTATE_TEST_WIDTH, ROTATE_TEST_HEIGHT, 0, 0,
+               page, ROTATE_TEST_WIDTH * pixel_bytes, ROTATE_TEST_WIDTH, ROTATE_TEST_HEIGHT, 0, 0,
+               ROTATE_TEST_WIDTH, ROTATE_TEST_HEIGHT, testCase->colorformat, testCase->fbpxlfmt, rotation, blit_row);
+
+  turned_width = (rotation == 90 || rotation == 270) ? ROTATE_TEST_HEIGHT : ROTATE_TEST_WIDTH;
+  for (y = 0; y < ROTATE_TEST_HEIGHT && !failed; y++) {
+    if (memcmp(page + y * ROTATE_TEST_WIDTH * pixel_bytes, expected + y * turned_width * pixel_bytes, turned_width * pixel_bytes) != 0) {
+      printf("%-20s %3d degrees into a page differs from the naive rotation at row %d\n", testCase->name, (int) rotation, (int) y);
+      failed = 1;
+    }
+  }
+  munmap(map, map_size + system_page);
+  return failed;
+}
+
+int main(int argc, char** argv) {
+  OMX_U32 fb_size = ROTATE_TEST_WIDTH * ROTATE_TEST_HEIGHT * 4;
+  OMX_U8 *src, *fb, *expected, *rotated;
+  OMX_U32 i, k, rotation;
+  omx_fbdev_blit_row blit_row;
+  double start, naive_time, rotate_time;
+  int failures = 0;
+
+  src = malloc(fb_size);
+  fb = malloc(fb_size);
+  expected = malloc(fb_size);
+  rotated = malloc(fb_size);
+  if (src == NULL || fb == NULL || expected == NULL || rotated == NULL) {
+    printf("Out of memory\n");
+    return 1;
+  }
+  for (i = 0; i < fb_size; i++) {
+    src[i] = (OMX_U8) ((i * 2654435761u) >> 13);
+  }
+
+  for (k = 0; k < sizeof(testCases) / sizeof(testCases[0]); k++) {
+    blit_row = omx_fbdev_find_blitter(testCases[k].colorformat, testCases[k].fbpxlfmt);
+    for (rotation = 90; rotation < 360; rotation += 90) {
+      memset(fb, 0, fb_size);
+      memset(rotated, 0, fb_size);
+      copyFrame(&testCases[k], src, fb, 0, blit_row);
+      rotateNaive(fb, expected, testCases[k].fb_pixel_bytes, rotation);
+      copyFrame(&testCases[k], src, rotated, rotation, blit_row);
+      if (memcmp(expected, rotated, ROTATE_TEST_WIDTH * ROTATE_TEST_HEIGHT * testCases[k].fb_pixel_bytes) != 0) {
+        printf("%-20s %3d degrees differs from the naive rotation\n", testCases[k].name, (int) rotation);
+        failures++;
+        continue;
+      }
+
+      start = getTime();
+      for (i = 0; i < ROTATE_TEST_ROUNDS; i++) {
+        copyFrame(&testCases[k], src, fb, 0, blit_row);
+        rotateNaive(fb, expected, testCases[k].fb_pixel_bytes, rotation);
+      }
+      naive_time = (getTime() - start) / ROTATE_TEST_ROUNDS;
+      start = getTime();
+      for (i = 0; i < ROTATE_TEST_ROUNDS; i++) {
+        copyFrame(&testCases[k], src, rotated, rotation, blit_row);
+      }
+      rotate_time = (getTime() - start) / ROTATE_TEST_ROUNDS;
+      printf("%-20s %3d degrees: copy and naive rotation %7.3f ms, rotating copy %7.3f ms, %.1fx\n",
+             testCases[k].name, (int) rotation, naive_time, rotate_time, naive_time / rotate_time);
+
+      failures += checkPage(&testCases[k], src, fb, expected, rotation, blit_row);
+    }
+  }
+
+  free(src);
+  free(fb);
+  free(expected);
+  free(rotated);
+
+  if (failures) {
+    printf("%d rotation(s) failed\n", failures);
+    return 1;
+  }
+  printf("All rotations match the naive rotation and stay in the page\n");
+  return 0;
+}
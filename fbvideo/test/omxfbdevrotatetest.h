@@ -0,0 +1,50 @@
+/**
+  test/omxfbdevrotatetest.h
+
+  Rotation test program of the OpenMAX FBDEV sink component
+
+  Frames copied by omx_img_copy with a rotation of 90, 180 and 270 degrees
+  are checked against the unrotated copy turned pixel by pixel, and the
+  rotating copy is timed against that naive rotation. The frames are then
+  turned into a page as large as the unturned frame, followed by memory
+  that cannot be written, and must be cut to that page.
+
+  Copyright (C) 2007-2009  STMicroelectronics and Agere Systems
+
+  This library is free software; you can redistribute it and/or modify it under
+  the terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation; either version 2.1 of the License, or (at your option)
+  any later version.
+
+  This library is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+  FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin St, Fifth Floor, Boston, MA
+  02110-1301  USA
+
+*/
+
+#include <OMX_Types.h>
+#include <OMX_Core.h>
+#include <OMX_IVCommon.h>
+
+#include <omx_fbdev_sink_component.h>
+
+/* Size of the test frames, odd so that the last stripe is partly filled */
+#define ROTATE_TEST_WIDTH  1281
+#define ROTATE_TEST_HEIGHT 719
+
+/* Frames copied per timing */
+#define ROTATE_TEST_ROUNDS 20
+
+/* A conversion from an input color format to a frame buffer one */
+typedef struct rotateTestCase {
+  OMX_COLOR_FORMATTYPE colorformat;
+  OMX_COLOR_FORMATTYPE fbpxlfmt;
+  OMX_U32 fb_pixel_bytes;
+  const char* name;
+} rotateTestCase;
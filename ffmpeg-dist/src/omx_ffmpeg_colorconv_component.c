@@ -25,7 +25,19 @@
 */
 
 #include <bellagio/omxcore.h>
+#include <unistd.h>
 #include <omx_ffmpeg_colorconv_component.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+/** SSSE3 and AVX2 kernels are built with a function target attribute and picked at run time */
+#define COLOR_CONV_HAVE_SSSE3 1
+#define COLOR_CONV_HAVE_AVX2 1
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+/** NEON kernels are built when the target has NEON, so they need no run time check */
+#define COLOR_CONV_HAVE_NEON 1
+#endif
 
 /** Maximum Number of Video Color Converter Component Instance*/
 #define MAX_COMPONENT_VIDEOCOLORCONV 2
@@ -85,6 +97,9 @@ enum AVPixelFormat find_ffmpeg_pxlfmt(OMX_COLOR_FORMATTYPE omx_pxlfmt) {
     case OMX_COLOR_FormatCbYCrY:
       ffmpeg_pxlfmt = AV_PIX_FMT_UYVY422;
       break;
+    case OMX_COLOR_FormatYCbYCr:
+      ffmpeg_pxlfmt = AV_PIX_FMT_YUYV422;
+      break;
     case OMX_COLOR_FormatMonochrome:  //  Better hope resolutions are multiples of 8
       ffmpeg_pxlfmt = AV_PIX_FMT_MONOBLACK;
       break;
@@ -103,7 +118,6 @@ enum AVPixelFormat find_ffmpeg_pxlfmt(OMX_COLOR_FORMATTYPE omx_pxlfmt) {
     case OMX_COLOR_Format25bitARGB1888:
     case OMX_COLOR_FormatYUV420SemiPlanar:
     case OMX_COLOR_FormatYUV422SemiPlanar:
-    case OMX_COLOR_FormatYCbYCr:
     case OMX_COLOR_FormatYCrYCb:
     case OMX_COLOR_FormatCrYCbY:
     case OMX_COLOR_FormatYUV444Interleaved:
@@ -198,6 +212,698 @@ OMX_S32 calcStride(OMX_U32 width, OMX_COLOR_FORMATTYPE omx_pxlfmt) {
   return (OMX_S32) stride;
 }
 
+/** Converts a RGB24 row into RGBA with an opaque alpha, as swscale does, from pixel x on */
+static inline void omx_ffmpeg_colorconv_component_Rgb24RowToRgba(const uint8_t* src, uint8_t* dest, int x, int width) {
+  for (; x < width; x++) {
+    dest[4 * x] = src[3 * x];
+    dest[4 * x + 1] = src[3 * x + 1];
+    dest[4 * x + 2] = src[3 * x + 2];
+    dest[4 * x + 3] = 0xff;
+  }
+}
+
+/** Converts the YUYV pixels of a pair of lines into planar YUV 4:2:0 from pixel x on, x even.
+  * The chroma is the rounded average of the two lines, as the SIMD converters of swscale do;
+  * next is src for the last line of an odd height, which has no pair
+  */
+static inline void omx_ffmpeg_colorconv_component_YuyvPairToYuv420(const uint8_t* src, const uint8_t* next,
+                                                                   uint8_t* luma, uint8_t* luma_next, uint8_t* u, uint8_t* v,
+                                                                   int x, int width) {
+  int i;
+
+  for (i = x; i < width; i++) {
+    luma[i] = src[2 * i];
+  }
+  if (next != src) {
+    for (i = x; i < width; i++) {
+      luma_next[i] = next[2 * i];
+    }
+  }
+  for (i = x / 2; i < width / 2; i++) {
+    u[i] = (uint8_t) ((src[4 * i + 1] + next[4 * i + 1] + 1) >> 1);
+    v[i] = (uint8_t) ((src[4 * i + 3] + next[4 * i + 3] + 1) >> 1);
+  }
+}
+
+/** The BT.601 coefficients swscale converts limited range YUV to RGB with, in Q14 so that
+  * the products fit 16 bit lanes; the 2.017 of blue is taken as 1 plus COLOR_CONV_YUV_CBU
+  */
+#define COLOR_CONV_YUV_CY  19077
+#define COLOR_CONV_YUV_CRV 26149
+#define COLOR_CONV_YUV_CGU 6419
+#define COLOR_CONV_YUV_CGV 13320
+#define COLOR_CONV_YUV_CBU 16666
+
+/** The high half of a product, as the 16 bit multiplies of the SIMD row converters give it */
+static inline int omx_ffmpeg_colorconv_component_MulHi(int a, int b) {
+  return (a * b) >> 16;
+}
+
+static inline uint8_t omx_ffmpeg_colorconv_component_Clip(int value) {
+  return (uint8_t) ((value < 0) ? 0 : (value > 255) ? 255 : value);
+}
+
+/** Converts a YUV pixel into RGB. The terms are in Q5 and computed as the SIMD row converters do,
+  * so that every instruction set gives the same bytes
+  */
+static inline void omx_ffmpeg_colorconv_component_YuvToRgb(int y, int u, int v, uint8_t* r, uint8_t* g, uint8_t* b) {
+  int luma = omx_ffmpeg_colorconv_component_MulHi((y - 16) * 128, COLOR_CONV_YUV_CY);
+  int cu = (u - 128) * 128;
+  int cv = (v - 128) * 128;
+
+  *r = omx_ffmpeg_colorconv_component_Clip((luma + omx_ffmpeg_colorconv_component_MulHi(cv, COLOR_CONV_YUV_CRV) + 16) >> 5);
+  *g = omx_ffmpeg_colorconv_component_Clip((luma - omx_ffmpeg_colorconv_component_MulHi(cu, COLOR_CONV_YUV_CGU) -
+                                            omx_ffmpeg_colorconv_component_MulHi(cv, COLOR_CONV_YUV_CGV) + 16) >> 5);
+  *b = omx_ffmpeg_colorconv_component_Clip((luma + cu / 4 + omx_ffmpeg_colorconv_component_MulHi(cu, COLOR_CONV_YUV_CBU) + 16) >> 5);
+}
+
+/** Converts a row of planar YUV 4:2:0 into RGBA with an opaque alpha from pixel x on, x even */
+static inline void omx_ffmpeg_colorconv_component_YuvRowToRgba(const uint8_t* luma, const uint8_t* u, const uint8_t* v,
+                                                               uint8_t* dest, int x, int width) {
+  for (; x < width; x++) {
+    omx_ffmpeg_colorconv_component_YuvToRgb(luma[x], u[x / 2], v[x / 2], &dest[4 * x], &dest[4 * x + 1], &dest[4 * x + 2]);
+    dest[4 * x + 3] = 0xff;
+  }
+}
+
+/** Converts a row of planar YUV 4:2:0 into native endian RGB565 from pixel x on, x even.
+  * The components are truncated, as swscale does before it dithers
+  */
+static inline void omx_ffmpeg_colorconv_component_YuvRowToRgb565(const uint8_t* luma, const uint8_t* u, const uint8_t* v,
+                                                                 uint8_t* dest, int x, int width) {
+  uint8_t r, g, b;
+  uint16_t pixel;
+
+  for (; x < width; x++) {
+    omx_ffmpeg_colorconv_component_YuvToRgb(luma[x], u[x / 2], v[x / 2], &r, &g, &b);
+    pixel = (uint16_t) (((r & 0xf8) << 8) | ((g & 0xfc) << 3) | (b >> 3));
+    memcpy(dest + 2 * x, &pixel, sizeof(pixel));
+  }
+}
+
+/** Row converters the kernels of each instruction set are made of */
+typedef void (*omx_ffmpeg_colorconv_rgb24_row)(const uint8_t* src, uint8_t* dest, int width);
+typedef void (*omx_ffmpeg_colorconv_yuyv_pair)(const uint8_t* src, const uint8_t* next,
+                                               uint8_t* luma, uint8_t* luma_next, uint8_t* u, uint8_t* v, int width);
+typedef void (*omx_ffmpeg_colorconv_yuv_row)(const uint8_t* luma, const uint8_t* u, const uint8_t* v, uint8_t* dest, int width);
+
+/** Converts packed RGB24 into RGBA row by row */
+static void omx_ffmpeg_colorconv_component_Rgb24ToRgbaRows(const uint8_t* const src_data[4], const int src_linesize[4],
+                                                           uint8_t* const dest_data[4], const int dest_linesize[4],
+                                                           int width, int height, omx_ffmpeg_colorconv_rgb24_row row) {
+  const uint8_t* src = src_data[0];
+  uint8_t* dest = dest_data[0];
+  int y;
+
+  for (y = 0; y < height; y++, src += src_linesize[0], dest += dest_linesize[0]) {
+    row(src, dest, width);
+  }
+}
+
+/** Converts packed YUYV into planar YUV 4:2:0 a pair of lines at a time */
+static void omx_ffmpeg_colorconv_component_YuyvToYuv420Pairs(const uint8_t* const src_data[4], const int src_linesize[4],
+                                                              uint8_t* const dest_data[4], const int dest_linesize[4],
+                                                              int width, int height, omx_ffmpeg_colorconv_yuyv_pair pair) {
+  const uint8_t* src = src_data[0];
+  uint8_t* luma = dest_data[0];
+  uint8_t* u = dest_data[1];
+  uint8_t* v = dest_data[2];
+  int y;
+
+  for (y = 0; y < height; y += 2) {
+    pair(src, (y + 1 < height) ? src + src_linesize[0] : src, luma, luma + dest_linesize[0], u, v, width);
+    src += 2 * src_linesize[0];
+    luma += 2 * dest_linesize[0];
+    u += dest_linesize[1];
+    v += dest_linesize[2];
+  }
+}
+
+/** Converts planar YUV 4:2:0 into packed RGB row by row, each chroma row serving two lines */
+static void omx_ffmpeg_colorconv_component_Yuv420ToRgbRows(const uint8_t* const src_data[4], const int src_linesize[4],
+                                                           uint8_t* const dest_data[4], const int dest_linesize[4],
+                                                           int width, int height, omx_ffmpeg_colorconv_yuv_row row) {
+  int y;
+
+  for (y = 0; y < height; y++) {
+    row(src_data[0] + y * src_linesize[0], src_data[1] + (y >> 1) * src_linesize[1], src_data[2] + (y >> 1) * src_linesize[2],
+        dest_data[0] + y * dest_linesize[0], width);
+  }
+}
+
+static void omx_ffmpeg_colorconv_component_Rgb24Row_c(const uint8_t* src, uint8_t* dest, int width) {
+  omx_ffmpeg_colorconv_component_Rgb24RowToRgba(src, dest, 0, width);
+}
+
+static void omx_ffmpeg_colorconv_component_YuyvPair_c(const uint8_t* src, const uint8_t* next,
+                                                      uint8_t* luma, uint8_t* luma_next, uint8_t* u, uint8_t* v, int width) {
+  omx_ffmpeg_colorconv_component_YuyvPairToYuv420(src, next, luma, luma_next, u, v, 0, width);
+}
+
+static void omx_ffmpeg_colorconv_component_YuvRgbaRow_c(const uint8_t* luma, const uint8_t* u, const uint8_t* v, uint8_t* dest, int width) {
+  omx_ffmpeg_colorconv_component_YuvRowToRgba(luma, u, v, dest, 0, width);
+}
+
+static void omx_ffmpeg_colorconv_component_YuvRgb565Row_c(const uint8_t* luma, const uint8_t* u, const uint8_t* v, uint8_t* dest, int width) {
+  omx_ffmpeg_colorconv_component_YuvRowToRgb565(luma, u, v, dest, 0, width);
+}
+
+#ifdef COLOR_CONV_HAVE_SSSE3
+/** SSSE3 row converters: the loops stop early enough that the 16 byte loads never read past the row */
+static __attribute__((target("ssse3"))) void omx_ffmpeg_colorconv_component_Rgb24Row_ssse3(const uint8_t* src, uint8_t* dest, int width) {
+  const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+  const __m128i alpha = _mm_set1_epi32((int) 0xff000000);
+  int x;
+
+  for (x = 0; x + 6 <= width; x += 4) {
+    __m128i pixels = _mm_loadu_si128((const __m128i*) (src + 3 * x));
+    _mm_storeu_si128((__m128i*) (dest + 4 * x), _mm_or_si128(_mm_shuffle_epi8(pixels, shuffle), alpha));
+  }
+  omx_ffmpeg_colorconv_component_Rgb24RowToRgba(src, dest, x, width);
+}
+
+/** Sixteen pixels at a time: the even bytes are the luma, the odd ones the interleaved chroma */
+static __attribute__((target("ssse3"))) void omx_ffmpeg_colorconv_component_YuyvPair_ssse3(const uint8_t* src, const uint8_t* next,
+                                                                                            uint8_t* luma, uint8_t* luma_next, uint8_t* u, uint8_t* v, int width) {
+  const __m128i low_bytes = _mm_set1_epi16(0x00ff);
+  const __m128i zero = _mm_setzero_si128();
+  int x;
+
+  for (x = 0; x + 16 <= width; x += 16) {
+    __m128i a0 = _mm_loadu_si128((const __m128i*) (src + 2 * x));
+    __m128i a1 = _mm_loadu_si128((const __m128i*) (src + 2 * x + 16));
+    __m128i b0 = _mm_loadu_si128((const __m128i*) (next + 2 * x));
+    __m128i b1 = _mm_loadu_si128((const __m128i*) (next + 2 * x + 16));
+    __m128i chroma = _mm_avg_epu8(_mm_packus_epi16(_mm_srli_epi16(a0, 8), _mm_srli_epi16(a1, 8)),
+                                  _mm_packus_epi16(_mm_srli_epi16(b0, 8), _mm_srli_epi16(b1, 8)));
+    _mm_storeu_si128((__m128i*) (luma + x), _mm_packus_epi16(_mm_and_si128(a0, low_bytes), _mm_and_si128(a1, low_bytes)));
+    if (next != src) {
+      _mm_storeu_si128((__m128i*) (luma_next + x), _mm_packus_epi16(_mm_and_si128(b0, low_bytes), _mm_and_si128(b1, low_bytes)));
+    }
+    _mm_storel_epi64((__m128i*) (u + x / 2), _mm_packus_epi16(_mm_and_si128(chroma, low_bytes), zero));
+    _mm_storel_epi64((__m128i*) (v + x / 2), _mm_packus_epi16(_mm_srli_epi16(chroma, 8), zero));
+  }
+  omx_ffmpeg_colorconv_component_YuyvPairToYuv420(src, next, luma, luma_next, u, v, x, width);
+}
+
+/** Converts sixteen YUV 4:2:0 pixels into their R, G and B bytes; each chroma term is computed once
+  * for the eight chroma samples, then doubled up for the two pixels of a sample
+  */
+static inline __attribute__((target("ssse3"))) void omx_ffmpeg_colorconv_component_YuvToRgb16_ssse3(const uint8_t* y, const uint8_t* u, const uint8_t* v,
+                                                                                                   __m128i* r, __m128i* g, __m128i* b) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i round = _mm_set1_epi16(16);
+  __m128i luma = _mm_loadu_si128((const __m128i*) y);
+  __m128i cu = _mm_slli_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*) u), zero), _mm_set1_epi16(128)), 7);
+  __m128i cv = _mm_slli_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*) v), zero), _mm_set1_epi16(128)), 7);
+  __m128i luma_lo = _mm_mulhi_epi16(_mm_slli_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(luma, zero), round), 7), _mm_set1_epi16(COLOR_CONV_YUV_CY));
+  __m128i luma_hi = _mm_mulhi_epi16(_mm_slli_epi16(_mm_sub_epi16(_mm_unpackhi_epi8(luma, zero), round), 7), _mm_set1_epi16(COLOR_CONV_YUV_CY));
+  __m128i red = _mm_mulhi_epi16(cv, _mm_set1_epi16(COLOR_CONV_YUV_CRV));
+  __m128i green = _mm_add_epi16(_mm_mulhi_epi16(cu, _mm_set1_epi16(COLOR_CONV_YUV_CGU)), _mm_mulhi_epi16(cv, _mm_set1_epi16(COLOR_CONV_YUV_CGV)));
+  __m128i blue = _mm_add_epi16(_mm_srai_epi16(cu, 2), _mm_mulhi_epi16(cu, _mm_set1_epi16(COLOR_CONV_YUV_CBU)));
+
+  *r = _mm_packus_epi16(_mm_srai_epi16(_mm_add_epi16(_mm_add_epi16(luma_lo, _mm_unpacklo_epi16(red, red)), round), 5),
+                        _mm_srai_epi16(_mm_add_epi16(_mm_add_epi16(luma_hi, _mm_unpackhi_epi16(red, red)), round), 5));
+  *g = _mm_packus_epi16(_mm_srai_epi16(_mm_add_epi16(_mm_sub_epi16(luma_lo, _mm_unpacklo_epi16(green, green)), round), 5),
+                        _mm_srai_epi16(_mm_add_epi16(_mm_sub_epi16(luma_hi, _mm_unpackhi_epi16(green, green)), round), 5));
+  *b = _mm_packus_epi16(_mm_srai_epi16(_mm_add_epi16(_mm_add_epi16(luma_lo, _mm_unpacklo_epi16(blue, blue)), round), 5),
+                        _mm_srai_epi16(_mm_add_epi16(_mm_add_epi16(luma_hi, _mm_unpackhi_epi16(blue, blue)), round), 5));
+}
+
+static __attribute__((target("ssse3"))) void omx_ffmpeg_colorconv_component_YuvRgbaRow_ssse3(const uint8_t* luma, const uint8_t* u, const uint8_t* v,
+                                                                                              uint8_t* dest, int width) {
+  const __m128i alpha = _mm_set1_epi8((char) 0xff);
+  __m128i r, g, b, rg, ba;
+  int x;
+
+  for (x = 0; x + 16 <= width; x += 16) {
+    omx_ffmpeg_colorconv_component_YuvToRgb16_ssse3(luma + x, u + x / 2, v + x / 2, &r, &g, &b);
+    rg = _mm_unpacklo_epi8(r, g);
+    ba = _mm_unpacklo_epi8(b, alpha);
+    _mm_storeu_si128((__m128i*) (dest + 4 * x), _mm_unpacklo_epi16(rg, ba));
+    _mm_storeu_si128((__m128i*) (dest + 4 * x + 16), _mm_unpackhi_epi16(rg, ba));
+    rg = _mm_unpackhi_epi8(r, g);
+    ba = _mm_unpackhi_epi8(b, alpha);
+    _mm_storeu_si128((__m128i*) (dest + 4 * x + 32), _mm_unpacklo_epi16(rg, ba));
+    _mm_storeu_si128((__m128i*) (dest + 4 * x + 48), _mm_unpackhi_epi16(rg, ba));
+  }
+  omx_ffmpeg_colorconv_component_YuvRowToRgba(luma, u, v, dest, x, width);
+}
+
+static __attribute__((target("ssse3"))) void omx_ffmpeg_colorconv_component_YuvRgb565Row_ssse3(const uint8_t* luma, const uint8_t* u, const uint8_t* v,
+                                                                                                uint8_t* dest, int width) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i red_bits = _mm_set1_epi16(0xf8);
+  const __m128i green_bits = _mm_set1_epi16(0xfc);
+  __m128i r, g, b;
+  int x;
+
+  for (x = 0; x + 16 <= width; x += 16) {
+    omx_ffmpeg_colorconv_component_YuvToRgb16_ssse3(luma + x, u + x / 2, v + x / 2, &r, &g, &b);
+    _mm_storeu_si128((__m128i*) (dest + 2 * x),
+                     _mm_or_si128(_mm_or_si128(_mm_slli_epi16(_mm_and_si128(_mm_unpacklo_epi8(r, zero), red_bits), 8),
+                                               _mm_slli_epi16(_mm_and_si128(_mm_unpacklo_epi8(g, zero), green_bits), 3)),
+                                  _mm_srli_epi16(_mm_unpacklo_epi8(b, zero), 3)));
+    _mm_storeu_si128((__m128i*) (dest + 2 * x + 16),
+                     _mm_or_si128(_mm_or_si128(_mm_slli_epi16(_mm_and_si128(_mm_unpackhi_epi8(r, zero), red_bits), 8),
+                                               _mm_slli_epi16(_mm_and_si128(_mm_unpackhi_epi8(g, zero), green_bits), 3)),
+                                  _mm_srli_epi16(_mm_unpackhi_epi8(b, zero), 3)));
+  }
+  omx_ffmpeg_colorconv_component_YuvRowToRgb565(luma, u, v, dest, x, width);
+}
+#endif
+
+#ifdef COLOR_CONV_HAVE_AVX2
+/** AVX2 row converters: the byte shuffles and packs work within each 128 bit lane,
+  * so lanes are loaded with their own pixels and packed results are put back in order
+  */
+static __attribute__((target("avx2"))) void omx_ffmpeg_colorconv_component_Rgb24Row_avx2(const uint8_t* src, uint8_t* dest, int width) {
+  const __m256i shuffle = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                           0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+  const __m256i alpha = _mm256_set1_epi32((int) 0xff000000);
+  int x;
+
+  for (x = 0; x + 10 <= width; x += 8) {
+    __m256i pixels = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*) (src + 3 * x))),
+                                             _mm_loadu_si128((const __m128i*) (src + 3 * x + 12)), 1);
+    _mm256_storeu_si256((__m256i*) (dest + 4 * x), _mm256_or_si256(_mm256_shuffle_epi8(pixels, shuffle), alpha));
+  }
+  omx_ffmpeg_colorconv_component_Rgb24RowToRgba(src, dest, x, width);
+}
+
+static __attribute__((target("avx2"))) void omx_ffmpeg_colorconv_component_YuyvPair_avx2(const uint8_t* src, const uint8_t* next,
+                                                                                          uint8_t* luma, uint8_t* luma_next, uint8_t* u, uint8_t* v, int width) {
+  const __m256i low_bytes = _mm256_set1_epi16(0x00ff);
+  int x;
+
+  for (x = 0; x + 32 <= width; x += 32) {
+    __m256i a0 = _mm256_loadu_si256((const __m256i*) (src + 2 * x));
+    __m256i a1 = _mm256_loadu_si256((const __m256i*) (src + 2 * x + 32));
+    __m256i b0 = _mm256_loadu_si256((const __m256i*) (next + 2 * x));
+    __m256i b1 = _mm256_loadu_si256((const __m256i*) (next + 2 * x + 32));
+    __m256i chroma = _mm256_avg_epu8(_mm256_permute4x64_epi64(_mm256_packus_epi16(_mm256_srli_epi16(a0, 8), _mm256_srli_epi16(a1, 8)), 0xd8),
+                                     _mm256_permute4x64_epi64(_mm256_packus_epi16(_mm256_srli_epi16(b0, 8), _mm256_srli_epi16(b1, 8)), 0xd8));
+    //  sixteen u then sixteen v
+    __m256i planar = _mm256_permute4x64_epi64(_mm256_packus_epi16(_mm256_and_si256(chroma, low_bytes), _mm256_srli_epi16(chroma, 8)), 0xd8);
+    _mm256_storeu_si256((__m256i*) (luma + x),
+                        _mm256_permute4x64_epi64(_mm256_packus_epi16(_mm256_and_si256(a0, low_bytes), _mm256_and_si256(a1, low_bytes)), 0xd8));
+    if (next != src) {
+      _mm256_storeu_si256((__m256i*) (luma_next + x),
+                          _mm256_permute4x64_epi64(_mm256_packus_epi16(_mm256_and_si256(b0, low_bytes), _mm256_and_si256(b1, low_bytes)), 0xd8));
+    }
+    _mm_storeu_si128((__m128i*) (u + x / 2), _mm256_castsi256_si128(planar));
+    _mm_storeu_si128((__m128i*) (v + x / 2), _mm256_extracti128_si256(planar, 1));
+  }
+  omx_ffmpeg_colorconv_component_YuyvPairToYuv420(src, next, luma, luma_next, u, v, x, width);
+}
+#endif
+
+#ifdef COLOR_CONV_HAVE_NEON
+/** NEON row converters: vld3 and vld4 split the components of sixteen or thirty-two pixels */
+static void omx_ffmpeg_colorconv_component_Rgb24Row_neon(const uint8_t* src, uint8_t* dest, int width) {
+  uint8x16x3_t pixels;
+  uint8x16x4_t out;
+  int x;
+
+  out.val[3] = vdupq_n_u8(0xff);
+  for (x = 0; x + 16 <= width; x += 16) {
+    pixels = vld3q_u8(src + 3 * x);
+    out.val[0] = pixels.val[0];
+    out.val[1] = pixels.val[1];
+    out.val[2] = pixels.val[2];
+    vst4q_u8(dest + 4 * x, out);
+  }
+  omx_ffmpeg_colorconv_component_Rgb24RowToRgba(src, dest, x, width);
+}
+
+static void omx_ffmpeg_colorconv_component_YuyvPair_neon(const uint8_t* src, const uint8_t* next,
+                                                         uint8_t* luma, uint8_t* luma_next, uint8_t* u, uint8_t* v, int width) {
+  uint8x16x4_t a, b;
+  uint8x16x2_t y;
+  int x;
+
+  for (x = 0; x + 32 <= width; x += 32) {
+    a = vld4q_u8(src + 2 * x);
+    b = vld4q_u8(next + 2 * x);
+    y.val[0] = a.val[0];
+    y.val[1] = a.val[2];
+    vst2q_u8(luma + x, y);
+    if (next != src) {
+      y.val[0] = b.val[0];
+      y.val[1] = b.val[2];
+      vst2q_u8(luma_next + x, y);
+    }
+    vst1q_u8(u + x / 2, vrhaddq_u8(a.val[1], b.val[1]));
+    vst1q_u8(v + x / 2, vrhaddq_u8(a.val[3], b.val[3]));
+  }
+  omx_ffmpeg_colorconv_component_YuyvPairToYuv420(src, next, luma, luma_next, u, v, x, width);
+}
+
+/** The high half of the products of eight lanes, as _mm_mulhi_epi16 gives it */
+static inline int16x8_t omx_ffmpeg_colorconv_component_MulHi_neon(int16x8_t a, int16_t b) {
+  return vcombine_s16(vshrn_n_s32(vmull_n_s16(vget_low_s16(a), b), 16), vshrn_n_s32(vmull_n_s16(vget_high_s16(a), b), 16));
+}
+
+/** Converts sixteen YUV 4:2:0 pixels into their R, G and B bytes, as the SSSE3 converter does */
+static inline void omx_ffmpeg_colorconv_component_YuvToRgb16_neon(const uint8_t* y, const uint8_t* u, const uint8_t* v,
+                                                                  uint8x16_t* r, uint8x16_t* g, uint8x16_t* b) {
+  const int16x8_t round = vdupq_n_s16(16);
+  uint8x16_t luma = vld1q_u8(y);
+  int16x8_t cu = vshlq_n_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(u))), vdupq_n_s16(128)), 7);
+  int16x8_t cv = vshlq_n_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(v))), vdupq_n_s16(128)), 7);
+  int16x8_t luma_lo = omx_ffmpeg_colorconv_component_MulHi_neon(
+    vshlq_n_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(luma))), round), 7), COLOR_CONV_YUV_CY);
+  int16x8_t luma_hi = omx_ffmpeg_colorconv_component_MulHi_neon(
+    vshlq_n_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(luma))), round), 7), COLOR_CONV_YUV_CY);
+  int16x8x2_t red = vzipq_s16(omx_ffmpeg_colorconv_component_MulHi_neon(cv, COLOR_CONV_YUV_CRV),
+                              omx_ffmpeg_colorconv_component_MulHi_neon(cv, COLOR_CONV_YUV_CRV));
+  int16x8_t green_terms = vaddq_s16(omx_ffmpeg_colorconv_component_MulHi_neon(cu, COLOR_CONV_YUV_CGU),
+                                    omx_ffmpeg_colorconv_component_MulHi_neon(cv, COLOR_CONV_YUV_CGV));
+  int16x8_t blue_terms = vaddq_s16(vshrq_n_s16(cu, 2), omx_ffmpeg_colorconv_component_MulHi_neon(cu, COLOR_CONV_YUV_CBU));
+  int16x8x2_t green = vzipq_s16(green_terms, green_terms);
+  int16x8x2_t blue = vzipq_s16(blue_terms, blue_terms);
+
+  *r = vcombine_u8(vqmovun_s16(vshrq_n_s16(vaddq_s16(vaddq_s16(luma_lo, red.val[0]), round), 5)),
+                   vqmovun_s16(vshrq_n_s16(vaddq_s16(vaddq_s16(luma_hi, red.val[1]), round), 5)));
+  *g = vcombine_u8(vqmovun_s16(vshrq_n_s16(vaddq_s16(vsubq_s16(luma_lo, green.val[0]), round), 5)),
+                   vqmovun_s16(vshrq_n_s16(vaddq_s16(vsubq_s16(luma_hi, green.val[1]), round), 5)));
+  *b = vcombine_u8(vqmovun_s16(vshrq_n_s16(vaddq_s16(vaddq_s16(luma_lo, blue.val[0]), round), 5)),
+                   vqmovun_s16(vshrq_n_s16(vaddq_s16(vaddq_s16(luma_hi, blue.val[1]), round), 5)));
+}
+
+static void omx_ffmpeg_colorconv_component_YuvRgbaRow_neon(const uint8_t* luma, const uint8_t* u, const uint8_t* v, uint8_t* dest, int width) {
+  uint8x16x4_t out;
+  int x;
+
+  out.val[3] = vdupq_n_u8(0xff);
+  for (x = 0; x + 16 <= width; x += 16) {
+    omx_ffmpeg_colorconv_component_YuvToRgb16_neon(luma + x, u + x / 2, v + x / 2, &out.val[0], &out.val[1], &out.val[2]);
+    vst4q_u8(dest + 4 * x, out);
+  }
+  omx_ffmpeg_colorconv_component_YuvRowToRgba(luma, u, v, dest, x, width);
+}
+
+/** The components are shifted into the top of each lane and inserted below one another */
+static void omx_ffmpeg_colorconv_component_YuvRgb565Row_neon(const uint8_t* luma, const uint8_t* u, const uint8_t* v, uint8_t* dest, int width) {
+  uint8x16_t r, g, b;
+  uint16x8_t pixels;
+  int x;
+
+  for (x = 0; x + 16 <= width; x += 16) {
+    omx_ffmpeg_colorconv_component_YuvToRgb16_neon(luma + x, u + x / 2, v + x / 2, &r, &g, &b);
+    pixels = vsriq_n_u16(vsriq_n_u16(vshll_n_u8(vget_low_u8(r), 8), vshll_n_u8(vget_low_u8(g), 8), 5), vshll_n_u8(vget_low_u8(b), 8), 11);
+    vst1q_u8(dest + 2 * x, vreinterpretq_u8_u16(pixels));
+    pixels = vsriq_n_u16(vsriq_n_u16(vshll_n_u8(vget_high_u8(r), 8), vshll_n_u8(vget_high_u8(g), 8), 5), vshll_n_u8(vget_high_u8(b), 8), 11);
+    vst1q_u8(dest + 2 * x + 16, vreinterpretq_u8_u16(pixels));
+  }
+  omx_ffmpeg_colorconv_component_YuvRowToRgb565(luma, u, v, dest, x, width);
+}
+#endif
+
+/** Defines the kernel of a pair of formats for the row converter of one instruction set */
+#define COLOR_CONV_KERNELS(isa) \
+static void omx_ffmpeg_colorconv_component_Rgb24ToRgba_##isa(const uint8_t* const src_data[4], const int src_linesize[4], \
+                                                             uint8_t* const dest_data[4], const int dest_linesize[4], \
+                                                             int width, int height) { \
+  omx_ffmpeg_colorconv_component_Rgb24ToRgbaRows(src_data, src_linesize, dest_data, dest_linesize, width, height, \
+                                                 omx_ffmpeg_colorconv_component_Rgb24Row_##isa); \
+} \
+static void omx_ffmpeg_colorconv_component_YuyvToYuv420_##isa(const uint8_t* const src_data[4], const int src_linesize[4], \
+                                                              uint8_t* const dest_data[4], const int dest_linesize[4], \
+                                                              int width, int height) { \
+  omx_ffmpeg_colorconv_component_YuyvToYuv420Pairs(src_data, src_linesize, dest_data, dest_linesize, width, height, \
+                                                   omx_ffmpeg_colorconv_component_YuyvPair_##isa); \
+}
+
+/** Defines the YUV 4:2:0 to RGB kernels for the row converters of one instruction set */
+#define COLOR_CONV_YUV_KERNELS(isa) \
+static void omx_ffmpeg_colorconv_component_Yuv420ToRgba_##isa(const uint8_t* const src_data[4], const int src_linesize[4], \
+                                                              uint8_t* const dest_data[4], const int dest_linesize[4], \
+                                                              int width, int height) { \
+  omx_ffmpeg_colorconv_component_Yuv420ToRgbRows(src_data, src_linesize, dest_data, dest_linesize, width, height, \
+                                                 omx_ffmpeg_colorconv_component_YuvRgbaRow_##isa); \
+} \
+static void omx_ffmpeg_colorconv_component_Yuv420ToRgb565_##isa(const uint8_t* const src_data[4], const int src_linesize[4], \
+                                                                uint8_t* const dest_data[4], const int dest_linesize[4], \
+                                                                int width, int height) { \
+  omx_ffmpeg_colorconv_component_Yuv420ToRgbRows(src_data, src_linesize, dest_data, dest_linesize, width, height, \
+                                                 omx_ffmpeg_colorconv_component_YuvRgb565Row_##isa); \
+}
+
+COLOR_CONV_KERNELS(c)
+COLOR_CONV_YUV_KERNELS(c)
+#ifdef COLOR_CONV_HAVE_SSSE3
+COLOR_CONV_KERNELS(ssse3)
+COLOR_CONV_YUV_KERNELS(ssse3)
+#endif
+#ifdef COLOR_CONV_HAVE_AVX2
+COLOR_CONV_KERNELS(avx2)
+#endif
+#ifdef COLOR_CONV_HAVE_NEON
+COLOR_CONV_KERNELS(neon)
+COLOR_CONV_YUV_KERNELS(neon)
+#endif
+
+#ifdef COLOR_CONV_HAVE_SSSE3
+#define COLOR_CONV_KERNEL_SSSE3(kernel) kernel##_ssse3
+#else
+#define COLOR_CONV_KERNEL_SSSE3(kernel) NULL
+#endif
+#ifdef COLOR_CONV_HAVE_AVX2
+#define COLOR_CONV_KERNEL_AVX2(kernel) kernel##_avx2
+#else
+#define COLOR_CONV_KERNEL_AVX2(kernel) NULL
+#endif
+#ifdef COLOR_CONV_HAVE_NEON
+#define COLOR_CONV_KERNEL_NEON(kernel) kernel##_neon
+#else
+#define COLOR_CONV_KERNEL_NEON(kernel) NULL
+#endif
+
+/** Same size conversion kernels, by pair of pixel formats and instruction set.
+  * The pairs that only move or average bytes give the same result as swscale. The YUV 4:2:0
+  * to RGB pairs use the coefficients of swscale in fixed point and come within a step of it;
+  * swscale dithers RGB565 where they truncate. They have no AVX2 kernel, the SSSE3 one is used.
+  * The other pairs stay with the swscale converters, which already pick their SIMD version at run time.
+  */
+static const struct {
+  enum AVPixelFormat in_pxlfmt;
+  enum AVPixelFormat out_pxlfmt;
+  omx_ffmpeg_colorconv_kernel kernel_c;
+  omx_ffmpeg_colorconv_kernel kernel_ssse3;
+  omx_ffmpeg_colorconv_kernel kernel_avx2;
+  omx_ffmpeg_colorconv_kernel kernel_neon;
+} omx_ffmpeg_colorconv_kernels[] = {
+  { AV_PIX_FMT_RGB24,   AV_PIX_FMT_RGBA,    omx_ffmpeg_colorconv_component_Rgb24ToRgba_c,
+    COLOR_CONV_KERNEL_SSSE3(omx_ffmpeg_colorconv_component_Rgb24ToRgba),
+    COLOR_CONV_KERNEL_AVX2(omx_ffmpeg_colorconv_component_Rgb24ToRgba),
+    COLOR_CONV_KERNEL_NEON(omx_ffmpeg_colorconv_component_Rgb24ToRgba) },
+  { AV_PIX_FMT_YUYV422, AV_PIX_FMT_YUV420P, omx_ffmpeg_colorconv_component_YuyvToYuv420_c,
+    COLOR_CONV_KERNEL_SSSE3(omx_ffmpeg_colorconv_component_YuyvToYuv420),
+    COLOR_CONV_KERNEL_AVX2(omx_ffmpeg_colorconv_component_YuyvToYuv420),
+    COLOR_CONV_KERNEL_NEON(omx_ffmpeg_colorconv_component_YuyvToYuv420) },
+  { AV_PIX_FMT_YUV420P, AV_PIX_FMT_RGBA,    omx_ffmpeg_colorconv_component_Yuv420ToRgba_c,
+    COLOR_CONV_KERNEL_SSSE3(omx_ffmpeg_colorconv_component_Yuv420ToRgba), NULL,
+    COLOR_CONV_KERNEL_NEON(omx_ffmpeg_colorconv_component_Yuv420ToRgba) },
+  { AV_PIX_FMT_YUV420P, AV_PIX_FMT_RGB565,  omx_ffmpeg_colorconv_component_Yuv420ToRgb565_c,
+    COLOR_CONV_KERNEL_SSSE3(omx_ffmpeg_colorconv_component_Yuv420ToRgb565), NULL,
+    COLOR_CONV_KERNEL_NEON(omx_ffmpeg_colorconv_component_Yuv420ToRgb565) },
+};
+
+OMX_U32 omx_ffmpeg_colorconv_simd_support(void) {
+  OMX_U32 simd = COLOR_CONV_SIMD_NONE;
+#ifdef COLOR_CONV_HAVE_SSSE3
+  if (__builtin_cpu_supports("ssse3")) {
+    simd |= COLOR_CONV_SIMD_SSSE3;
+  }
+#endif
+#ifdef COLOR_CONV_HAVE_AVX2
+  if (__builtin_cpu_supports("avx2")) {
+    simd |= COLOR_CONV_SIMD_AVX2;
+  }
+#endif
+#ifdef COLOR_CONV_HAVE_NEON
+  simd |= COLOR_CONV_SIMD_NEON;
+#endif
+  return simd;
+}
+
+omx_ffmpeg_colorconv_kernel omx_ffmpeg_colorconv_find_kernel(enum AVPixelFormat in_pxlfmt, enum AVPixelFormat out_pxlfmt, OMX_U32 simd) {
+  OMX_U32 i;
+
+  for (i = 0; i < sizeof(omx_ffmpeg_colorconv_kernels) / sizeof(omx_ffmpeg_colorconv_kernels[0]); i++) {
+    if (omx_ffmpeg_colorconv_kernels[i].in_pxlfmt == in_pxlfmt && omx_ffmpeg_colorconv_kernels[i].out_pxlfmt == out_pxlfmt) {
+      //  the widest allowed extension that has a kernel for the pair
+      if ((simd & COLOR_CONV_SIMD_AVX2) && omx_ffmpeg_colorconv_kernels[i].kernel_avx2) {
+        return omx_ffmpeg_colorconv_kernels[i].kernel_avx2;
+      }
+      if ((simd & COLOR_CONV_SIMD_SSSE3) && omx_ffmpeg_colorconv_kernels[i].kernel_ssse3) {
+        return omx_ffmpeg_colorconv_kernels[i].kernel_ssse3;
+      }
+      if ((simd & COLOR_CONV_SIMD_NEON) && omx_ffmpeg_colorconv_kernels[i].kernel_neon) {
+        return omx_ffmpeg_colorconv_kernels[i].kernel_neon;
+      }
+      return omx_ffmpeg_colorconv_kernels[i].kernel_c;
+    }
+  }
+  return NULL;
+}
+
+/** finds the fastest conversion kernel the processor runs for a pair of pixel formats, NULL if swscale has to be used */
+static omx_ffmpeg_colorconv_kernel omx_ffmpeg_colorconv_component_FindKernel(enum AVPixelFormat in_pxlfmt, enum AVPixelFormat out_pxlfmt) {
+  return omx_ffmpeg_colorconv_find_kernel(in_pxlfmt, out_pxlfmt, omx_ffmpeg_colorconv_simd_support());
+}
+
+/** Picks the kernel of the pair of port formats, each time one of them changes */
+static void omx_ffmpeg_colorconv_component_SelectKernel(omx_ffmpeg_colorconv_component_PrivateType* omx_ffmpeg_colorconv_component_Private) {
+  omx_ffmpeg_colorconv_component_PortType *inPort = (omx_ffmpeg_colorconv_component_PortType *)omx_ffmpeg_colorconv_component_Private->ports[OMX_BASE_FILTER_INPUTPORT_INDEX];
+  omx_ffmpeg_colorconv_component_PortType *outPort = (omx_ffmpeg_colorconv_component_PortType *)omx_ffmpeg_colorconv_component_Private->ports[OMX_BASE_FILTER_OUTPUTPORT_INDEX];
+
+  omx_ffmpeg_colorconv_component_Private->convKernel = omx_ffmpeg_colorconv_component_FindKernel(inPort->ffmpeg_pxlfmt, outPort->ffmpeg_pxlfmt);
+  DEBUG(DEB_LEV_SIMPLE_SEQ, "In %s %s conversion from %d to %d\n", __func__,
+    omx_ffmpeg_colorconv_component_Private->convKernel ? "kernel" : "swscale", inPort->ffmpeg_pxlfmt, outPort->ffmpeg_pxlfmt);
+}
+
+/** Tells whether a layout can not be addressed row by row and column by column,
+  * and the conversion has to go through the staging buffers
+  */
+static OMX_BOOL omx_ffmpeg_colorconv_component_NeedsStaging(omx_ffmpeg_colorconv_component_PrivateType* omx_ffmpeg_colorconv_component_Private) {
+  omx_ffmpeg_colorconv_component_PortType *inPort = (omx_ffmpeg_colorconv_component_PortType *)omx_ffmpeg_colorconv_component_Private->ports[OMX_BASE_FILTER_INPUTPORT_INDEX];
+  omx_ffmpeg_colorconv_component_PortType *outPort = (omx_ffmpeg_colorconv_component_PortType *)omx_ffmpeg_colorconv_component_Private->ports[OMX_BASE_FILTER_OUTPUTPORT_INDEX];
+
+  //  Monochrome pixels do not start on byte boundaries
+  if (inPort->ffmpeg_pxlfmt == AV_PIX_FMT_MONOBLACK || outPort->ffmpeg_pxlfmt == AV_PIX_FMT_MONOBLACK) {
+    return OMX_TRUE;
+  }
+  return OMX_FALSE;
+}
+
+/** finds the swscale flags of a scaling filter */
+static int omx_ffmpeg_colorconv_component_SwsFlags(OMX_COLORCONV_SCALEFILTERTYPE eFilter) {
+  switch (eFilter) {
+    case OMX_COLORCONV_ScaleBilinear:
+      return SWS_BILINEAR;
+    case OMX_COLORCONV_ScaleBicubic:
+      return SWS_BICUBIC;
+    case OMX_COLORCONV_ScaleArea:
+      return SWS_AREA;
+    case OMX_COLORCONV_ScaleFastBilinear:
+    default:
+      return SWS_FAST_BILINEAR;
+  }
+}
+
+/** Converts one band with the kernel if there is one, with the conversion context otherwise */
+static OMX_ERRORTYPE omx_ffmpeg_colorconv_component_ConvertBand(struct SwsContext* swsCtx, omx_ffmpeg_colorconv_kernel kernel,
+                  uint8_t* const src_data[4], const int src_linesize[4],
+                  uint8_t* const dest_data[4], const int dest_linesize[4], int width, int height) {
+  if (kernel) {
+    kernel((const uint8_t* const*) src_data, src_linesize, dest_data, dest_linesize, width, height);
+  } else if (sws_scale(swsCtx, (const uint8_t* const*) src_data, src_linesize, 0, height, dest_data, dest_linesize) <= 0) {
+    return OMX_ErrorUndefined;
+  }
+  return OMX_ErrorNone;
+}
+
+/** Reports a frame some band of which could not be converted: the output buffer is
+  * returned empty rather than with a partly converted picture
+  */
+static void omx_ffmpeg_colorconv_component_BandError(OMX_COMPONENTTYPE *openmaxStandComp, OMX_BUFFERHEADERTYPE* pOutputBuffer, OMX_ERRORTYPE err) {
+  omx_ffmpeg_colorconv_component_PrivateType* omx_ffmpeg_colorconv_component_Private = openmaxStandComp->pComponentPrivate;
+
+  DEBUG(DEB_LEV_ERR, "In %s the frame could not be converted Error=%x\n", __func__, err);
+  pOutputBuffer->nFilledLen = 0;
+  (*(omx_ffmpeg_colorconv_component_Private->callbacks->EventHandler))
+    (openmaxStandComp,
+    omx_ffmpeg_colorconv_component_Private->callbackData,
+    OMX_EventError, /* The frame could not be converted */
+    err,
+    OMX_BASE_FILTER_OUTPUTPORT_INDEX,
+    NULL);
+}
+
+/** Band conversion worker thread: converts the band it is given each time it is started */
+static void* omx_ffmpeg_colorconv_component_WorkerFunction(void* param) {
+  omx_ffmpeg_colorconv_WorkerType* worker = (omx_ffmpeg_colorconv_WorkerType*) param;
+
+  for (;;) {
+    tsem_down(&worker->startSem);
+    if (worker->bExit) {
+      break;
+    }
+    worker->err = omx_ffmpeg_colorconv_component_ConvertBand(worker->swsCtx, worker->kernel,
+                  worker->src_data, worker->src_linesize, worker->dest_data, worker->dest_linesize,
+                  worker->width, worker->height);
+    tsem_up(worker->doneSem);
+  }
+  return NULL;
+}
+
+/** Starts the band conversion workers asked for by the threading parameter.
+  * The staged conversion path is not split in bands and gets no worker.
+  */
+static OMX_ERRORTYPE omx_ffmpeg_colorconv_component_StartWorkers(omx_ffmpeg_colorconv_component_PrivateType* omx_ffmpeg_colorconv_component_Private) {
+  omx_ffmpeg_colorconv_WorkerType* worker;
+  OMX_U32 nThreads = omx_ffmpeg_colorconv_component_Private->sThreadingParam.nThreadCount;
+  OMX_U32 i;
+
+  if (nThreads == 0) {
+    long nCpus = sysconf(_SC_NPROCESSORS_ONLN);
+    nThreads = (nCpus > 0) ? (OMX_U32) nCpus : 1;
+  }
+  nThreads = MIN(nThreads, COLOR_CONV_MAX_THREADS);
+
+  omx_ffmpeg_colorconv_component_Private->nWorkers = 0;
+  if (nThreads <= 1 || omx_ffmpeg_colorconv_component_NeedsStaging(omx_ffmpeg_colorconv_component_Private)) {
+    return OMX_ErrorNone;
+  }
+
+  omx_ffmpeg_colorconv_component_Private->workers = calloc(nThreads - 1, sizeof(omx_ffmpeg_colorconv_WorkerType));
+  if (omx_ffmpeg_colorconv_component_Private->workers == NULL) {
+    return OMX_ErrorInsufficientResources;
+  }
+  tsem_init(&omx_ffmpeg_colorconv_component_Private->workersDoneSem, 0);
+
+  for (i = 0; i < nThreads - 1; i++) {
+    worker = &omx_ffmpeg_colorconv_component_Private->workers[i];
+    worker->doneSem = &omx_ffmpeg_colorconv_component_Private->workersDoneSem;
+    worker->bExit = OMX_FALSE;
+    tsem_init(&worker->startSem, 0);
+    if (pthread_create(&worker->thread, NULL, omx_ffmpeg_colorconv_component_WorkerFunction, worker) != 0) {
+      //  Go on with the workers already started
+      DEBUG(DEB_LEV_ERR, "In %s cannot start band worker %d\n", __func__, (int) i);
+      tsem_deinit(&worker->startSem);
+      break;
+    }
+    omx_ffmpeg_colorconv_component_Private->nWorkers++;
+  }
+  DEBUG(DEB_LEV_SIMPLE_SEQ, "In %s %d band workers started\n", __func__, (int) omx_ffmpeg_colorconv_component_Private->nWorkers);
+
+  return OMX_ErrorNone;
+}
+
+/** Stops the band conversion workers and frees their conversion contexts */
+static void omx_ffmpeg_colorconv_component_StopWorkers(omx_ffmpeg_colorconv_component_PrivateType* omx_ffmpeg_colorconv_component_Private) {
+  omx_ffmpeg_colorconv_WorkerType* worker;
+  OMX_U32 i;
+
+  if (omx_ffmpeg_colorconv_component_Private->workers == NULL) {
+    return;
+  }
+  for (i = 0; i < omx_ffmpeg_colorconv_component_Private->nWorkers; i++) {
+    worker = &omx_ffmpeg_colorconv_component_Private->workers[i];
+    worker->bExit = OMX_TRUE;
+    tsem_up(&worker->startSem);
+    pthread_join(worker->thread, NULL);
+    tsem_deinit(&worker->startSem);
+    sws_freeContext(worker->swsCtx);
+  }
+  tsem_deinit(&omx_ffmpeg_colorconv_component_Private->workersDoneSem);
+  free(omx_ffmpeg_colorconv_component_Private->workers);
+  omx_ffmpeg_colorconv_component_Private->workers = NULL;
+  omx_ffmpeg_colorconv_component_Private->nWorkers = 0;
+}
+
 /** The Constructor
   * @param openmaxStandComp the component handle to be constructed
   * @param cComponentName is the name of the constructed component
@@ -325,6 +1031,19 @@ OMX_ERRORTYPE omx_ffmpeg_colorconv_component_Constructor(OMX_COMPONENTTYPE *open
 
   omx_ffmpeg_colorconv_component_Private->in_buffer = NULL;
   omx_ffmpeg_colorconv_component_Private->conv_buffer = NULL;
+  omx_ffmpeg_colorconv_component_Private->imgConvertYuvCtx = NULL;
+  omx_ffmpeg_colorconv_component_Private->imgConvertRowCtx = NULL;
+  omx_ffmpeg_colorconv_component_Private->convKernel = NULL;
+
+  /** frames are converted by the buffer management thread alone unless the IL client asks for more threads */
+  setHeader(&omx_ffmpeg_colorconv_component_Private->sThreadingParam, sizeof(OMX_COLORCONV_PARAM_THREADINGTYPE));
+  omx_ffmpeg_colorconv_component_Private->sThreadingParam.nPortIndex = OMX_BASE_FILTER_INPUTPORT_INDEX;
+  omx_ffmpeg_colorconv_component_Private->sThreadingParam.nThreadCount = 1;
+  setHeader(&omx_ffmpeg_colorconv_component_Private->sScaleFilterConfig, sizeof(OMX_COLORCONV_CONFIG_SCALEFILTERTYPE));
+  omx_ffmpeg_colorconv_component_Private->sScaleFilterConfig.nPortIndex = OMX_BASE_FILTER_OUTPUTPORT_INDEX;
+  omx_ffmpeg_colorconv_component_Private->sScaleFilterConfig.eFilter = OMX_COLORCONV_ScaleFastBilinear;
+  omx_ffmpeg_colorconv_component_Private->nWorkers = 0;
+  omx_ffmpeg_colorconv_component_Private->workers = NULL;
 
   omx_ffmpeg_colorconv_component_Private->messageHandler = omx_video_colorconv_MessageHandler;
   omx_ffmpeg_colorconv_component_Private->destructor = omx_ffmpeg_colorconv_component_Destructor;
@@ -333,6 +1052,7 @@ OMX_ERRORTYPE omx_ffmpeg_colorconv_component_Constructor(OMX_COMPONENTTYPE *open
   openmaxStandComp->GetParameter = omx_ffmpeg_colorconv_component_GetParameter;
   openmaxStandComp->SetConfig = omx_ffmpeg_colorconv_component_SetConfig;
   openmaxStandComp->GetConfig = omx_ffmpeg_colorconv_component_GetConfig;
+  openmaxStandComp->GetExtensionIndex = omx_ffmpeg_colorconv_component_GetExtensionIndex;
   openmaxStandComp->UseEGLImage = omx_video_colorconv_UseEGLImage;
   noVideoColorConvInstance++;
 
@@ -385,6 +1105,29 @@ OMX_ERRORTYPE omx_ffmpeg_colorconv_component_Init(OMX_COMPONENTTYPE *openmaxStan
   out_width = outPort->sPortParam.format.video.nFrameWidth;
   out_height = outPort->sPortParam.format.video.nFrameHeight;
 
+  av_register_all();
+  omx_ffmpeg_colorconv_component_Private->in_frame = av_frame_alloc();
+  omx_ffmpeg_colorconv_component_Private->conv_frame = av_frame_alloc();
+  if (omx_ffmpeg_colorconv_component_Private->in_frame == NULL || omx_ffmpeg_colorconv_component_Private->conv_frame == NULL) {
+    DEBUG(DEB_LEV_ERR, "\nError allocating the frames!\n");
+    err = OMX_ErrorInsufficientResources;
+    goto error;
+  }
+
+  /** A disabled port can still get a new format later, SetParameter picks the kernel again */
+  omx_ffmpeg_colorconv_component_SelectKernel(omx_ffmpeg_colorconv_component_Private);
+
+  err = omx_ffmpeg_colorconv_component_StartWorkers(omx_ffmpeg_colorconv_component_Private);
+  if (err != OMX_ErrorNone) {
+    DEBUG(DEB_LEV_ERR, "\nError allocating the band workers!\n");
+    goto error;
+  }
+
+  /** The staging buffers are only needed by the layouts that can not be converted in place */
+  if (!omx_ffmpeg_colorconv_component_NeedsStaging(omx_ffmpeg_colorconv_component_Private)) {
+    return err;
+  }
+
   omx_ffmpeg_colorconv_component_Private->in_alloc_size = avpicture_get_size(inPort->ffmpeg_pxlfmt,
   inPort->sPortParam.format.video.nFrameWidth, inPort->sPortParam.format.video.nFrameHeight);
 
@@ -392,7 +1135,8 @@ OMX_ERRORTYPE omx_ffmpeg_colorconv_component_Init(OMX_COMPONENTTYPE *openmaxStan
 
   if (omx_ffmpeg_colorconv_component_Private->in_buffer == NULL) {
     DEBUG(DEB_LEV_ERR, "\nError allocating internal input buffer!\n");
-    return OMX_ErrorInsufficientResources;
+    err = OMX_ErrorInsufficientResources;
+    goto error;
   }
 
   omx_ffmpeg_colorconv_component_Private->conv_alloc_size = avpicture_get_size(outPort->ffmpeg_pxlfmt,
@@ -403,13 +1147,16 @@ OMX_ERRORTYPE omx_ffmpeg_colorconv_component_Init(OMX_COMPONENTTYPE *openmaxStan
   if (omx_ffmpeg_colorconv_component_Private->conv_buffer == NULL) {
     DEBUG(DEB_LEV_ERR, "\nError allocating internal conversion buffer! size : %d \n",
     omx_ffmpeg_colorconv_component_Private->conv_alloc_size);
-    return OMX_ErrorInsufficientResources;
+    err = OMX_ErrorInsufficientResources;
+    goto error;
   }
-  av_register_all();
-  omx_ffmpeg_colorconv_component_Private->in_frame = av_frame_alloc();
-  omx_ffmpeg_colorconv_component_Private->conv_frame = av_frame_alloc();
 
   return err;
+
+error:
+  /** The component stays loaded: stop the workers already started and free what was allocated */
+  omx_ffmpeg_colorconv_component_Deinit(openmaxStandComp);
+  return err;
 };
 
 /** The Deinitialization function
@@ -438,6 +1185,12 @@ OMX_ERRORTYPE omx_ffmpeg_colorconv_component_Deinit(OMX_COMPONENTTYPE *openmaxSt
     av_free(omx_ffmpeg_colorconv_component_Private->conv_frame);
     omx_ffmpeg_colorconv_component_Private->conv_frame = NULL;
   }
+  sws_freeContext(omx_ffmpeg_colorconv_component_Private->imgConvertYuvCtx);
+  omx_ffmpeg_colorconv_component_Private->imgConvertYuvCtx = NULL;
+  sws_freeContext(omx_ffmpeg_colorconv_component_Private->imgConvertRowCtx);
+  omx_ffmpeg_colorconv_component_Private->imgConvertRowCtx = NULL;
+  omx_ffmpeg_colorconv_component_Private->convKernel = NULL;
+  omx_ffmpeg_colorconv_component_StopWorkers(omx_ffmpeg_colorconv_component_Private);
 
   return err;
 }
@@ -709,11 +1462,223 @@ void omx_img_copy(OMX_U8* src_ptr, OMX_S32 src_stride, OMX_U32 src_width, OMX_U3
   }
 }
 
-struct SwsContext *imgConvertYuvCtx = NULL;
+/**  Figures out the plane pointers and line sizes of a picture laid out in an OMX buffer
+  * @param buffer_ptr is the start of the buffer
+  * @param colorformat is the OpenMAX color format of the picture
+  * @param stride is the port stride, negative means bottom-to-top
+  * @param width is the picture width
+  * @param height is the picture height
+  * @param offset_x is the column of the first pixel to address
+  * @param row is the picture row (counted from the top) of the first line to address
+  * @param dir is 1 to go down the picture line after line, -1 to go up
+  * @param data receives the plane pointers
+  * @param linesize receives the byte distance between two addressed lines of each plane
+  */
+static void omx_ffmpeg_colorconv_component_PlanePointers(OMX_U8* buffer_ptr, OMX_COLOR_FORMATTYPE colorformat,
+                  OMX_S32 stride, OMX_U32 width, OMX_U32 height, OMX_S32 offset_x, OMX_S32 row, OMX_S32 dir,
+                  uint8_t* data[4], int linesize[4]) {
+  OMX_U32 plane_width[3], plane_height[3], plane_offset_x[3], plane_row[3];
+  OMX_U32 nb_planes, i;
+  OMX_U32 chroma_shift_w, chroma_shift_h;
+  OMX_BOOL bottom_up = (stride < 0) ? OMX_TRUE : OMX_FALSE;
+  OMX_U8* plane_ptr = buffer_ptr;
+
+  switch (colorformat) {
+    //  Planes follow each other, each with its own width as stride (see omx_img_copy)
+    case OMX_COLOR_FormatYUV411Planar:
+    case OMX_COLOR_FormatYUV411PackedPlanar:
+      chroma_shift_w = 2;
+      chroma_shift_h = 0;
+      nb_planes = 3;
+      break;
+    case OMX_COLOR_FormatYUV420Planar:
+    case OMX_COLOR_FormatYUV420PackedPlanar:
+      chroma_shift_w = 1;
+      chroma_shift_h = 1;
+      nb_planes = 3;
+      break;
+    case OMX_COLOR_FormatYUV422Planar:
+    case OMX_COLOR_FormatYUV422PackedPlanar:
+      chroma_shift_w = 1;
+      chroma_shift_h = 0;
+      nb_planes = 3;
+      break;
+    default:
+      chroma_shift_w = 0;
+      chroma_shift_h = 0;
+      nb_planes = 1;
+      break;
+  }
+
+  if (nb_planes == 1) {
+    plane_width[0] = (stride != 0) ? (OMX_U32) abs(stride) : (OMX_U32) calcStride(width, colorformat);
+    plane_height[0] = height;
+    plane_offset_x[0] = calcStride((OMX_U32) offset_x, colorformat);
+    plane_row[0] = row;
+  } else {
+    plane_width[0] = width;
+    plane_height[0] = height;
+    plane_offset_x[0] = offset_x;
+    plane_row[0] = row;
+    for (i = 1; i < nb_planes; i++) {
+      plane_width[i] = width >> chroma_shift_w;
+      plane_height[i] = height >> chroma_shift_h;
+      plane_offset_x[i] = offset_x >> chroma_shift_w;
+      plane_row[i] = row >> chroma_shift_h;
+    }
+  }
 
-/** This function is used to process the input buffer and provide one output buffer
+  for (i = 0; i < 4; i++) {
+    data[i] = NULL;
+    linesize[i] = 0;
+  }
+  for (i = 0; i < nb_planes; i++) {
+    //  A bottom-to-top plane keeps the last picture row first
+    OMX_U32 mem_row = bottom_up ? plane_height[i] - 1 - plane_row[i] : plane_row[i];
+    data[i] = plane_ptr + mem_row * plane_width[i] + plane_offset_x[i];
+    linesize[i] = (int) plane_width[i] * ((bottom_up ? -1 : 1) * dir);
+    plane_ptr += plane_width[i] * plane_height[i];
+  }
+}
+
+/** Tells whether two rows of a picture share a chroma row */
+static OMX_BOOL omx_ffmpeg_colorconv_component_SharesChromaRows(OMX_COLOR_FORMATTYPE colorformat) {
+  return (colorformat == OMX_COLOR_FormatYUV420Planar || colorformat == OMX_COLOR_FormatYUV420PackedPlanar) ? OMX_TRUE : OMX_FALSE;
+}
+
+/** Tells how the planes of a picture are rotated
+  * @param colorformat is the OpenMAX color format of the picture
+  * @param rotation is the clockwise rotation, 90, 180 or 270 degrees
+  * @param nb_planes receives the number of planes
+  * @param chroma_shift_w receives the horizontal chroma subsampling of planar formats
+  * @param chroma_shift_h receives the vertical chroma subsampling of planar formats
+  * @param pixel_bytes receives the bytes of a pixel, in every plane
+  * @return OMX_FALSE if the pixels do not take whole bytes, share their chroma with their
+  * neighbours, or if the chroma subsampling would not be the same once rotated
   */
-void omx_ffmpeg_colorconv_component_BufferMgmtCallback(OMX_COMPONENTTYPE *openmaxStandComp, OMX_BUFFERHEADERTYPE* pInputBuffer, OMX_BUFFERHEADERTYPE* pOutputBuffer) {
+static OMX_BOOL omx_ffmpeg_colorconv_component_RotationLayout(OMX_COLOR_FORMATTYPE colorformat, OMX_U32 rotation,
+                  OMX_U32* nb_planes, OMX_U32* chroma_shift_w, OMX_U32* chroma_shift_h, OMX_U32* pixel_bytes) {
+  switch (colorformat) {
+    case OMX_COLOR_FormatYUV411Planar:
+    case OMX_COLOR_FormatYUV411PackedPlanar:
+      *chroma_shift_w = 2;
+      *chroma_shift_h = 0;
+      break;
+    case OMX_COLOR_FormatYUV420Planar:
+    case OMX_COLOR_FormatYUV420PackedPlanar:
+      *chroma_shift_w = 1;
+      *chroma_shift_h = 1;
+      break;
+    case OMX_COLOR_FormatYUV422Planar:
+    case OMX_COLOR_FormatYUV422PackedPlanar:
+      *chroma_shift_w = 1;
+      *chroma_shift_h = 0;
+      break;
+    case OMX_COLOR_FormatYCbYCr:
+    case OMX_COLOR_FormatYCrYCb:
+    case OMX_COLOR_FormatCbYCrY:
+    case OMX_COLOR_FormatCrYCbY:
+    case OMX_COLOR_FormatMonochrome:
+      return OMX_FALSE;
+    default:
+      *nb_planes = 1;
+      *chroma_shift_w = *chroma_shift_h = 0;
+      *pixel_bytes = (OMX_U32) calcStride(1, colorformat);
+      return (*pixel_bytes > 0 && (OMX_U32) calcStride(8, colorformat) == 8 * *pixel_bytes) ? OMX_TRUE : OMX_FALSE;
+  }
+  *nb_planes = 3;
+  *pixel_bytes = 1;
+  if (*chroma_shift_w != *chroma_shift_h && rotation != 180) {
+    return OMX_FALSE;
+  }
+  return OMX_TRUE;
+}
+
+/** Copies a plane to its rotated place tile by tile, so that the source and destination
+  * lines a tile touches stay in the cache while it is copied
+  * @param dest_step_x is the byte distance between the destinations of two neighbour pixels of a source line
+  * @param dest_step_y is the byte distance between the destinations of two neighbour source lines
+  */
+static inline void omx_ffmpeg_colorconv_component_RotateTiles(const OMX_U8* src, int src_linesize, OMX_U8* dest,
+                  int dest_step_x, int dest_step_y, int width, int height, int pixel_bytes) {
+  const OMX_U8* src_pixel;
+  OMX_U8* dest_pixel;
+  int tile_x, tile_y, x, y, x_end, y_end, i;
+
+  for (tile_y = 0; tile_y < height; tile_y += COLOR_CONV_ROTATE_TILE) {
+    y_end = MIN(tile_y + COLOR_CONV_ROTATE_TILE, height);
+    for (tile_x = 0; tile_x < width; tile_x += COLOR_CONV_ROTATE_TILE) {
+      x_end = MIN(tile_x + COLOR_CONV_ROTATE_TILE, width);
+      for (y = tile_y; y < y_end; y++) {
+        src_pixel = src + y * src_linesize + tile_x * pixel_bytes;
+        dest_pixel = dest + tile_x * dest_step_x + y * dest_step_y;
+        for (x = tile_x; x < x_end; x++, src_pixel += pixel_bytes, dest_pixel += dest_step_x) {
+          for (i = 0; i < pixel_bytes; i++) {
+            dest_pixel[i] = src_pixel[i];
+          }
+        }
+      }
+    }
+  }
+}
+
+/** Rotates a plane clockwise
+  * @param dest is the top-left corner of the rotated plane
+  * @param width is the width of the plane before rotation
+  * @param height is the height of the plane before rotation
+  * @param rotation is 90, 180 or 270 degrees
+  */
+static void omx_ffmpeg_colorconv_component_RotatePlane(const OMX_U8* src, int src_linesize, OMX_U8* dest, int dest_linesize,
+                  int width, int height, int pixel_bytes, OMX_U32 rotation) {
+  int dest_step_x, dest_step_y;
+
+  //  Where the first source pixel goes, and where its right and lower neighbours go from there
+  switch (rotation) {
+    case 90:
+      dest += (height - 1) * pixel_bytes;
+      dest_step_x = dest_linesize;
+      dest_step_y = -pixel_bytes;
+      break;
+    case 180:
+      dest += (height - 1) * dest_linesize + (width - 1) * pixel_bytes;
+      dest_step_x = -pixel_bytes;
+      dest_step_y = -dest_linesize;
+      break;
+    case 270:
+      dest += (width - 1) * dest_linesize;
+      dest_step_x = -dest_linesize;
+      dest_step_y = pixel_bytes;
+      break;
+    default:
+      dest_step_x = pixel_bytes;
+      dest_step_y = dest_linesize;
+      break;
+  }
+
+  //  Constant pixel sizes let the compiler turn the pixel copy into a single move
+  switch (pixel_bytes) {
+    case 1:
+      omx_ffmpeg_colorconv_component_RotateTiles(src, src_linesize, dest, dest_step_x, dest_step_y, width, height, 1);
+      break;
+    case 2:
+      omx_ffmpeg_colorconv_component_RotateTiles(src, src_linesize, dest, dest_step_x, dest_step_y, width, height, 2);
+      break;
+    case 3:
+      omx_ffmpeg_colorconv_component_RotateTiles(src, src_linesize, dest, dest_step_x, dest_step_y, width, height, 3);
+      break;
+    case 4:
+      omx_ffmpeg_colorconv_component_RotateTiles(src, src_linesize, dest, dest_step_x, dest_step_y, width, height, 4);
+      break;
+    default:
+      omx_ffmpeg_colorconv_component_RotateTiles(src, src_linesize, dest, dest_step_x, dest_step_y, width, height, pixel_bytes);
+      break;
+  }
+}
+
+/** Crops, mirrors and converts the input through the staging buffers, for the layouts
+  * omx_ffmpeg_colorconv_component_NeedsStaging reports
+  */
+static void omx_ffmpeg_colorconv_component_StagedConvert(OMX_COMPONENTTYPE *openmaxStandComp, OMX_BUFFERHEADERTYPE* pInputBuffer, OMX_BUFFERHEADERTYPE* pOutputBuffer) {
 
   omx_ffmpeg_colorconv_component_PrivateType* omx_ffmpeg_colorconv_component_Private = openmaxStandComp->pComponentPrivate;
   omx_ffmpeg_colorconv_component_PortType *inPort = (omx_ffmpeg_colorconv_component_PortType *)omx_ffmpeg_colorconv_component_Private->ports[OMX_BASE_FILTER_INPUTPORT_INDEX];
@@ -778,16 +1743,19 @@ void omx_ffmpeg_colorconv_component_BufferMgmtCallback(OMX_COMPONENTTYPE *openma
   pInputBuffer->nFilledLen = 0;
 
   //  Use swscale to convert the colors into conv_buffer
-  if ( !imgConvertYuvCtx ) {
-    imgConvertYuvCtx = sws_getContext(input_src_width,
+  omx_ffmpeg_colorconv_component_Private->imgConvertYuvCtx = sws_getCachedContext(omx_ffmpeg_colorconv_component_Private->imgConvertYuvCtx,
+                                      input_src_width,
                                       input_src_height,
                                       inPort->ffmpeg_pxlfmt,
                                       input_dest_width,
                                       input_dest_height,
                                       outPort->ffmpeg_pxlfmt, SWS_FAST_BILINEAR, NULL, NULL, NULL );
+  if (omx_ffmpeg_colorconv_component_Private->imgConvertYuvCtx == NULL) {
+    DEBUG(DEB_LEV_ERR, "In %s cannot create the conversion context\n", __func__);
+    return;
   }
 
-  sws_scale(imgConvertYuvCtx, omx_ffmpeg_colorconv_component_Private->in_frame->data,
+  sws_scale(omx_ffmpeg_colorconv_component_Private->imgConvertYuvCtx, omx_ffmpeg_colorconv_component_Private->in_frame->data,
             omx_ffmpeg_colorconv_component_Private->in_frame->linesize, 0,
             input_src_height,
             omx_ffmpeg_colorconv_component_Private->conv_frame->data,
@@ -804,6 +1772,376 @@ void omx_ffmpeg_colorconv_component_BufferMgmtCallback(OMX_COMPONENTTYPE *openma
           __func__, pOutputBuffer->pBuffer, (int)pOutputBuffer->nFilledLen);
 }
 
+/** This function is used to process the input buffer and provide one output buffer
+  *
+  * Crop and mirroring are done by pointing swscale at the cropped rows of the input
+  * buffer, in the order they are written out, and the result is written straight
+  * into the output buffer at the output position: the picture is read and written once.
+  * When there are band workers, the picture is split into horizontal bands converted
+  * in parallel, this thread converting the first one.
+  * A scaled picture is scaled in the same pass, as one band: the output crop rectangle is
+  * taken out of the scaled input crop rectangle, and only the input rectangle it comes
+  * from is handed to swscale.
+  * A rotated picture is converted a few rows at a time into the conversion buffer, and each
+  * strip is rotated into the output buffer while it is still in the cache.
+  */
+void omx_ffmpeg_colorconv_component_BufferMgmtCallback(OMX_COMPONENTTYPE *openmaxStandComp, OMX_BUFFERHEADERTYPE* pInputBuffer, OMX_BUFFERHEADERTYPE* pOutputBuffer) {
+
+  omx_ffmpeg_colorconv_component_PrivateType* omx_ffmpeg_colorconv_component_Private = openmaxStandComp->pComponentPrivate;
+  omx_ffmpeg_colorconv_component_PortType *inPort = (omx_ffmpeg_colorconv_component_PortType *)omx_ffmpeg_colorconv_component_Private->ports[OMX_BASE_FILTER_INPUTPORT_INDEX];
+  omx_ffmpeg_colorconv_component_PortType *outPort = (omx_ffmpeg_colorconv_component_PortType *)omx_ffmpeg_colorconv_component_Private->ports[OMX_BASE_FILTER_OUTPUTPORT_INDEX];
+
+  uint8_t* src_data[4];
+  int src_linesize[4];
+  uint8_t* dest_data[4];
+  int dest_linesize[4];
+
+  OMX_S32 input_width = inPort->sPortParam.format.video.nFrameWidth;
+  OMX_S32 input_height = inPort->sPortParam.format.video.nSliceHeight;
+  OMX_S32 output_width = outPort->sPortParam.format.video.nFrameWidth;
+  OMX_S32 output_height = outPort->sPortParam.format.video.nSliceHeight;
+  OMX_S32 output_stride = outPort->sPortParam.format.video.nStride;
+
+  //  Input crop rectangle, clamped to the input picture
+  OMX_S32 input_crop_x = MAX((OMX_S32) inPort->omxConfigCrop.nLeft, 0);
+  OMX_S32 input_crop_y = MAX((OMX_S32) inPort->omxConfigCrop.nTop, 0);
+  OMX_S32 input_crop_width = MIN((OMX_S32) inPort->omxConfigCrop.nWidth, input_width - input_crop_x);
+  OMX_S32 input_crop_height = MIN((OMX_S32) inPort->omxConfigCrop.nHeight, input_height - input_crop_y);
+
+  //  Size of the scaled input crop rectangle, the scale factors are Q16
+  OMX_S64 x_scale = (OMX_S64) inPort->omxConfigScale.xWidth * outPort->omxConfigScale.xWidth;
+  OMX_S64 y_scale = (OMX_S64) inPort->omxConfigScale.xHeight * outPort->omxConfigScale.xHeight;
+  OMX_S32 scaled_width = (OMX_S32) ((MAX(input_crop_width, 0) * x_scale + (1LL << 31)) >> 32);
+  OMX_S32 scaled_height = (OMX_S32) ((MAX(input_crop_height, 0) * y_scale + (1LL << 31)) >> 32);
+  OMX_BOOL bScaled = (scaled_width != input_crop_width || scaled_height != input_crop_height) ? OMX_TRUE : OMX_FALSE;
+
+  //  Output crop rectangle, taken out of the scaled input crop rectangle
+  OMX_S32 output_crop_x = MAX((OMX_S32) outPort->omxConfigCrop.nLeft, 0);
+  OMX_S32 output_crop_y = MAX((OMX_S32) outPort->omxConfigCrop.nTop, 0);
+  OMX_S32 cpy_width = MIN((OMX_S32) outPort->omxConfigCrop.nWidth, scaled_width - output_crop_x);
+  OMX_S32 cpy_height = MIN((OMX_S32) outPort->omxConfigCrop.nHeight, scaled_height - output_crop_y);
+
+  //  Rectangle of the input crop rectangle the copied rectangle is scaled from
+  OMX_S32 src_x, src_y, src_width, src_height;
+
+  //  Top-left corner in the output buffer
+  OMX_S32 dest_x = outPort->omxConfigOutputPosition.nX;
+  OMX_S32 dest_y = outPort->omxConfigOutputPosition.nY;
+
+  OMX_BOOL input_mirror = (inPort->omxConfigMirror.eMirror == OMX_MirrorVertical || inPort->omxConfigMirror.eMirror == OMX_MirrorBoth) ? OMX_TRUE : OMX_FALSE;
+  OMX_BOOL output_mirror = (outPort->omxConfigMirror.eMirror == OMX_MirrorVertical || outPort->omxConfigMirror.eMirror == OMX_MirrorBoth) ? OMX_TRUE : OMX_FALSE;
+  OMX_S32 src_row, src_dir, y;
+  OMX_S32 nb_bands, band_rows, band_y, band_height, band_src_height, band_parity, in_parity, out_parity, i;
+  OMX_BOOL in_shared, out_shared;
+  OMX_S32 clip_left, clip_right, clip_top, clip_bottom, placed_width, placed_height;
+  OMX_U32 rotation = (OMX_U32) (((inPort->omxConfigRotate.nRotation + outPort->omxConfigRotate.nRotation) % 360 + 360) % 360);
+  OMX_U32 nb_planes = 1, chroma_shift_w = 0, chroma_shift_h = 0, pixel_bytes = 1;
+  int sws_flags = omx_ffmpeg_colorconv_component_SwsFlags(omx_ffmpeg_colorconv_component_Private->sScaleFilterConfig.eFilter);
+  OMX_U32 nb_started = 0;
+  OMX_ERRORTYPE err = OMX_ErrorNone;
+  omx_ffmpeg_colorconv_kernel kernel;
+  omx_ffmpeg_colorconv_WorkerType* worker;
+
+  if (omx_ffmpeg_colorconv_component_NeedsStaging(omx_ffmpeg_colorconv_component_Private)) {
+    omx_ffmpeg_colorconv_component_StagedConvert(openmaxStandComp, pInputBuffer, pOutputBuffer);
+    return;
+  }
+
+  if (rotation != 0 && !omx_ffmpeg_colorconv_component_RotationLayout(outPort->sVideoParam.eColorFormat, rotation,
+                                         &nb_planes, &chroma_shift_w, &chroma_shift_h, &pixel_bytes)) {
+    DEBUG(DEB_LEV_ERR, "In %s color format %x can not be rotated by %d\n", __func__, outPort->sVideoParam.eColorFormat, (int) rotation);
+    rotation = 0;
+  }
+
+  /**  Keep the copied rectangle inside the output picture: what the rotated rectangle loses
+    *  on each side is taken off the side of the output crop rectangle it comes from
+    */
+  placed_width = (rotation == 90 || rotation == 270) ? cpy_height : cpy_width;
+  placed_height = (rotation == 90 || rotation == 270) ? cpy_width : cpy_height;
+  clip_left = MAX(-dest_x, 0);
+  clip_top = MAX(-dest_y, 0);
+  clip_right = MAX(dest_x + placed_width - output_width, 0);
+  clip_bottom = MAX(dest_y + placed_height - output_height, 0);
+  dest_x += clip_left;
+  dest_y += clip_top;
+  switch (rotation) {
+    case 90:
+      output_crop_x += clip_top;
+      output_crop_y += clip_right;
+      cpy_width -= clip_top + clip_bottom;
+      cpy_height -= clip_left + clip_right;
+      break;
+    case 180:
+      output_crop_x += clip_right;
+      output_crop_y += clip_bottom;
+      cpy_width -= clip_left + clip_right;
+      cpy_height -= clip_top + clip_bottom;
+      break;
+    case 270:
+      output_crop_x += clip_bottom;
+      output_crop_y += clip_left;
+      cpy_width -= clip_top + clip_bottom;
+      cpy_height -= clip_left + clip_right;
+      break;
+    default:
+      output_crop_x += clip_left;
+      output_crop_y += clip_top;
+      cpy_width -= clip_left + clip_right;
+      cpy_height -= clip_top + clip_bottom;
+      break;
+  }
+
+  /**  A rotated picture is cut to whole chroma samples, so that every strip starts on
+    *  a chroma row: an odd number of rows would shift the chroma of the next strip
+    */
+  if (rotation != 0) {
+    cpy_width &= ~((1 << chroma_shift_w) - 1);
+    cpy_height &= ~((1 << chroma_shift_h) - 1);
+  }
+
+  pInputBuffer->nFilledLen = 0;
+  pOutputBuffer->nFilledLen = (OMX_U32) abs(output_stride) * output_height;
+
+  if (cpy_width <= 0 || cpy_height <= 0) {
+    DEBUG(DEB_LEV_FULL_SEQ, "in %s nothing of the input falls in the output picture\n", __func__);
+    return;
+  }
+
+  if (bScaled) {
+    //  From the first source pixel under the copied rectangle to the last one
+    src_x = (OMX_S32) ((OMX_S64) output_crop_x * input_crop_width / scaled_width);
+    src_y = (OMX_S32) ((OMX_S64) output_crop_y * input_crop_height / scaled_height);
+    src_width = (OMX_S32) (((OMX_S64) (output_crop_x + cpy_width) * input_crop_width + scaled_width - 1) / scaled_width) - src_x;
+    src_height = (OMX_S32) (((OMX_S64) (output_crop_y + cpy_height) * input_crop_height + scaled_height - 1) / scaled_height) - src_y;
+    src_width = MAX(MIN(src_width, input_crop_width - src_x), 1);
+    src_height = MAX(MIN(src_height, input_crop_height - src_y), 1);
+  } else {
+    src_x = output_crop_x;
+    src_y = output_crop_y;
+    src_width = cpy_width;
+    src_height = cpy_height;
+  }
+
+  //  The kernels do not scale and work on whole pixel pairs
+  kernel = (!bScaled && (cpy_width & 1) == 0) ? omx_ffmpeg_colorconv_component_Private->convKernel : NULL;
+
+  /**  Bands have an even number of rows and start on even rows of the 4:2:0 pictures, counted
+    *  from the top of the picture, so that no chroma row is shared by two bands: band_parity is
+    *  the parity of band_y that puts the first row of a band, or the row after it when the band
+    *  is read upwards, on an even row. The first band is one row shorter when that parity is odd,
+    *  the last band takes the remaining rows. Input and output that need different parities are
+    *  converted as one band.
+    *  The filter of a scaled picture reaches across band boundaries, it is not split.
+    */
+  in_shared = omx_ffmpeg_colorconv_component_SharesChromaRows(inPort->sVideoParam.eColorFormat);
+  out_shared = omx_ffmpeg_colorconv_component_SharesChromaRows(outPort->sVideoParam.eColorFormat);
+  in_parity = (input_crop_y + (input_mirror ? input_crop_height : 0) + src_y + (output_mirror ? src_height : 0)) & 1;
+  out_parity = dest_y & 1;
+  band_parity = in_shared ? in_parity : (out_shared ? out_parity : 0);
+  nb_bands = bScaled ? 1 : MIN((OMX_S32) omx_ffmpeg_colorconv_component_Private->nWorkers + 1, MAX(cpy_height / COLOR_CONV_MIN_BAND_HEIGHT, 1));
+  if (in_shared && out_shared && in_parity != out_parity) {
+    nb_bands = 1;
+  }
+  band_rows = (nb_bands > 1) ? ((cpy_height / nb_bands) + 1) & ~1 : cpy_height;
+  src_dir = (input_mirror != output_mirror) ? -1 : 1;
+
+  if (rotation != 0) {
+    uint8_t* strip_data[4];
+    int strip_linesize[4];
+    OMX_S32 strip_rows, strip_y, strip_src_height, rotated_x, rotated_y;
+    OMX_U32 needed_size, p, shift_w, shift_h;
+
+    //  The filter of a scaled picture reaches across strips, it is converted as one strip
+    strip_rows = bScaled ? cpy_height : MIN(COLOR_CONV_ROTATE_STRIP_HEIGHT, cpy_height);
+    strip_src_height = bScaled ? src_height : strip_rows;
+
+    needed_size = (OMX_U32) calcStride(cpy_width, outPort->sVideoParam.eColorFormat) * strip_rows;
+    if (omx_ffmpeg_colorconv_component_Private->conv_alloc_size < needed_size) {
+      free(omx_ffmpeg_colorconv_component_Private->conv_buffer);
+      omx_ffmpeg_colorconv_component_Private->conv_buffer = malloc(needed_size);
+      if (omx_ffmpeg_colorconv_component_Private->conv_buffer == NULL) {
+        DEBUG(DEB_LEV_ERR, "In %s cannot allocate the rotation strip! size : %d\n", __func__, (int) needed_size);
+        omx_ffmpeg_colorconv_component_Private->conv_alloc_size = 0;
+        return;
+      }
+      omx_ffmpeg_colorconv_component_Private->conv_alloc_size = needed_size;
+    }
+    omx_ffmpeg_colorconv_component_PlanePointers(omx_ffmpeg_colorconv_component_Private->conv_buffer, outPort->sVideoParam.eColorFormat,
+                  0, cpy_width, strip_rows, 0, 0, 1, strip_data, strip_linesize);
+
+    if (kernel == NULL) {
+      omx_ffmpeg_colorconv_component_Private->imgConvertYuvCtx = sws_getCachedContext(omx_ffmpeg_colorconv_component_Private->imgConvertYuvCtx,
+                                          src_width,
+                                          strip_src_height,
+                                          inPort->ffmpeg_pxlfmt,
+                                          cpy_width,
+                                          strip_rows,
+                                          outPort->ffmpeg_pxlfmt, sws_flags, NULL, NULL, NULL );
+      if (omx_ffmpeg_colorconv_component_Private->imgConvertYuvCtx == NULL) {
+        omx_ffmpeg_colorconv_component_BandError(openmaxStandComp, pOutputBuffer, OMX_ErrorInsufficientResources);
+        return;
+      }
+    }
+
+    for (strip_y = 0; strip_y < cpy_height; strip_y += strip_rows) {
+      //  The last strip is moved up to keep the size of the others, some rows are converted twice
+      if (strip_y + strip_rows > cpy_height) {
+        strip_y = cpy_height - strip_rows;
+      }
+      y = src_y + (output_mirror ? src_height - 1 - strip_y : strip_y);
+      src_row = input_crop_y + (input_mirror ? input_crop_height - 1 - y : y);
+      omx_ffmpeg_colorconv_component_PlanePointers(pInputBuffer->pBuffer, inPort->sVideoParam.eColorFormat,
+                    inPort->sPortParam.format.video.nStride, input_width, input_height,
+                    input_crop_x + src_x, src_row, src_dir, src_data, src_linesize);
+      err = omx_ffmpeg_colorconv_component_ConvertBand(omx_ffmpeg_colorconv_component_Private->imgConvertYuvCtx, kernel,
+                    src_data, src_linesize, strip_data, strip_linesize, cpy_width, strip_src_height);
+      if (err != OMX_ErrorNone) {
+        omx_ffmpeg_colorconv_component_BandError(openmaxStandComp, pOutputBuffer, err);
+        return;
+      }
+
+      //  Top-left corner of the rotated strip in the output picture
+      rotated_x = dest_x + ((rotation == 90) ? cpy_height - strip_y - strip_rows : (rotation == 270) ? strip_y : 0);
+      rotated_y = dest_y + ((rotation == 180) ? cpy_height - strip_y - strip_rows : 0);
+      omx_ffmpeg_colorconv_component_PlanePointers(pOutputBuffer->pBuffer, outPort->sVideoParam.eColorFormat,
+                    output_stride, output_width, output_height,
+                    rotated_x, rotated_y, 1, dest_data, dest_linesize);
+      for (p = 0; p < nb_planes; p++) {
+        shift_w = (p > 0) ? chroma_shift_w : 0;
+        shift_h = (p > 0) ? chroma_shift_h : 0;
+        omx_ffmpeg_colorconv_component_RotatePlane(strip_data[p], strip_linesize[p], dest_data[p], dest_linesize[p],
+                      cpy_width >> shift_w, strip_rows >> shift_h, (int) pixel_bytes, rotation);
+      }
+    }
+
+    DEBUG(DEB_LEV_FULL_SEQ, "in %s One output buffer %p len=%d is full returning in color converter\n",
+            __func__, pOutputBuffer->pBuffer, (int)pOutputBuffer->nFilledLen);
+    return;
+  }
+
+  //  The workers are started first, the first band is left to this thread
+  for (i = nb_bands - 1; i >= 0; i--) {
+    band_y = (i > 0) ? i * band_rows - band_parity : 0;
+    band_height = (i == nb_bands - 1) ? cpy_height - band_y : (i + 1) * band_rows - band_parity - band_y;
+    band_src_height = bScaled ? src_height : band_height;
+
+    /**  The first output row of the band comes from the last source row if the output
+      *  is mirrored, which comes from the last row of the input crop rectangle if the
+      *  input is mirrored
+      */
+    y = src_y + (output_mirror ? src_height - 1 - band_y : band_y);
+    src_row = input_crop_y + (input_mirror ? input_crop_height - 1 - y : y);
+
+    omx_ffmpeg_colorconv_component_PlanePointers(pInputBuffer->pBuffer, inPort->sVideoParam.eColorFormat,
+                  inPort->sPortParam.format.video.nStride, input_width, input_height,
+                  input_crop_x + src_x, src_row, src_dir, src_data, src_linesize);
+    omx_ffmpeg_colorconv_component_PlanePointers(pOutputBuffer->pBuffer, outPort->sVideoParam.eColorFormat,
+                  output_stride, output_width, output_height,
+                  dest_x, dest_y + band_y, 1, dest_data, dest_linesize);
+    if (i == 0) {
+      break;
+    }
+
+    worker = &omx_ffmpeg_colorconv_component_Private->workers[i - 1];
+    memcpy(worker->src_data, src_data, sizeof(src_data));
+    memcpy(worker->src_linesize, src_linesize, sizeof(src_linesize));
+    memcpy(worker->dest_data, dest_data, sizeof(dest_data));
+    memcpy(worker->dest_linesize, dest_linesize, sizeof(dest_linesize));
+    worker->width = cpy_width;
+    worker->height = band_height;
+    worker->kernel = kernel;
+    if (kernel == NULL) {
+      //  Contexts are only set up here, swscale initialization is not meant to run concurrently
+      worker->swsCtx = sws_getCachedContext(worker->swsCtx,
+                                      cpy_width,
+                                      band_height,
+                                      inPort->ffmpeg_pxlfmt,
+                                      cpy_width,
+                                      band_height,
+                                      outPort->ffmpeg_pxlfmt, sws_flags, NULL, NULL, NULL );
+      if (worker->swsCtx == NULL) {
+        DEBUG(DEB_LEV_ERR, "In %s cannot create the conversion context of band %d\n", __func__, (int) i);
+        err = OMX_ErrorInsufficientResources;
+        continue;
+      }
+    }
+    worker->err = OMX_ErrorNone;
+    tsem_up(&worker->startSem);
+    nb_started++;
+  }
+
+  /**  The first row on an odd row of a 4:2:0 picture has a chroma row of its own: it is
+    *  converted alone, and the band goes on from the next row, which is even
+    */
+  if (band_parity && !bScaled) {
+    if (kernel == NULL) {
+      omx_ffmpeg_colorconv_component_Private->imgConvertRowCtx = sws_getCachedContext(omx_ffmpeg_colorconv_component_Private->imgConvertRowCtx,
+                                          cpy_width,
+                                          1,
+                                          inPort->ffmpeg_pxlfmt,
+                                          cpy_width,
+                                          1,
+                                          outPort->ffmpeg_pxlfmt, sws_flags, NULL, NULL, NULL );
+    }
+    if (kernel == NULL && omx_ffmpeg_colorconv_component_Private->imgConvertRowCtx == NULL) {
+      DEBUG(DEB_LEV_ERR, "In %s cannot create the conversion context of the first row\n", __func__);
+      err = OMX_ErrorInsufficientResources;
+    } else if (omx_ffmpeg_colorconv_component_ConvertBand(omx_ffmpeg_colorconv_component_Private->imgConvertRowCtx, kernel,
+                  src_data, src_linesize, dest_data, dest_linesize, cpy_width, 1) != OMX_ErrorNone) {
+      err = OMX_ErrorUndefined;
+    }
+    band_y = 1;
+    band_height--;
+    band_src_height--;
+    y = src_y + (output_mirror ? src_height - 1 - band_y : band_y);
+    src_row = input_crop_y + (input_mirror ? input_crop_height - 1 - y : y);
+    omx_ffmpeg_colorconv_component_PlanePointers(pInputBuffer->pBuffer, inPort->sVideoParam.eColorFormat,
+                  inPort->sPortParam.format.video.nStride, input_width, input_height,
+                  input_crop_x + src_x, src_row, src_dir, src_data, src_linesize);
+    omx_ffmpeg_colorconv_component_PlanePointers(pOutputBuffer->pBuffer, outPort->sVideoParam.eColorFormat,
+                  output_stride, output_width, output_height,
+                  dest_x, dest_y + band_y, 1, dest_data, dest_linesize);
+  }
+
+  //  The first row may have been the whole band
+  if (band_height > 0) {
+    if (kernel == NULL) {
+      omx_ffmpeg_colorconv_component_Private->imgConvertYuvCtx = sws_getCachedContext(omx_ffmpeg_colorconv_component_Private->imgConvertYuvCtx,
+                                          src_width,
+                                          band_src_height,
+                                          inPort->ffmpeg_pxlfmt,
+                                          cpy_width,
+                                          band_height,
+                                          outPort->ffmpeg_pxlfmt, sws_flags, NULL, NULL, NULL );
+    }
+    if (kernel != NULL || omx_ffmpeg_colorconv_component_Private->imgConvertYuvCtx != NULL) {
+      if (omx_ffmpeg_colorconv_component_ConvertBand(omx_ffmpeg_colorconv_component_Private->imgConvertYuvCtx, kernel,
+                    src_data, src_linesize, dest_data, dest_linesize, cpy_width, band_src_height) != OMX_ErrorNone) {
+        err = OMX_ErrorUndefined;
+      }
+    } else {
+      DEBUG(DEB_LEV_ERR, "In %s cannot create the conversion context\n", __func__);
+      err = OMX_ErrorInsufficientResources;
+    }
+  }
+
+  //  The output buffer is returned once every band is converted
+  while (nb_started > 0) {
+    tsem_down(&omx_ffmpeg_colorconv_component_Private->workersDoneSem);
+    nb_started--;
+  }
+  for (i = 1; i < nb_bands && err == OMX_ErrorNone; i++) {
+    err = omx_ffmpeg_colorconv_component_Private->workers[i - 1].err;
+  }
+  if (err != OMX_ErrorNone) {
+    omx_ffmpeg_colorconv_component_BandError(openmaxStandComp, pOutputBuffer, err);
+    return;
+  }
+
+  DEBUG(DEB_LEV_FULL_SEQ, "in %s One output buffer %p len=%d is full returning in color converter\n",
+          __func__, pOutputBuffer->pBuffer, (int)pOutputBuffer->nFilledLen);
+}
+
 
 OMX_ERRORTYPE omx_ffmpeg_colorconv_component_SetConfig(
   OMX_HANDLETYPE hComponent,
@@ -856,8 +2194,8 @@ OMX_ERRORTYPE omx_ffmpeg_colorconv_component_SetConfig(
       }
       if (portIndex <= 1) {
         pPort = (omx_ffmpeg_colorconv_component_PortType *) omx_ffmpeg_colorconv_component_Private->ports[portIndex];
-        if (omxConfigRotate->nRotation != 0) {
-          //  Rotation not supported (yet)
+        if (omxConfigRotate->nRotation % 90 != 0) {
+          //  Only quarter turns are supported
           return OMX_ErrorUnsupportedSetting;
         }
         pPort->omxConfigRotate.nRotation = omxConfigRotate->nRotation;
@@ -889,9 +2227,8 @@ OMX_ERRORTYPE omx_ffmpeg_colorconv_component_SetConfig(
         break;
       }
       if (portIndex <= 1) {
-        if (omxConfigScale->xWidth != 0x10000 || omxConfigScale->xHeight != 0x10000) {
-          //  Scaling not yet supported
-          return OMX_ErrorUnsupportedSetting;
+        if (omxConfigScale->xWidth <= 0 || omxConfigScale->xHeight <= 0) {
+          return OMX_ErrorBadParameter;
         }
         pPort = (omx_ffmpeg_colorconv_component_PortType *) omx_ffmpeg_colorconv_component_Private->ports[portIndex];
         pPort->omxConfigScale.xWidth = omxConfigScale->xWidth;
@@ -900,6 +2237,21 @@ OMX_ERRORTYPE omx_ffmpeg_colorconv_component_SetConfig(
         return OMX_ErrorBadPortIndex;
       }
       break;
+    case OMX_IndexVendorColorConvScaleFilter:
+      {
+        OMX_COLORCONV_CONFIG_SCALEFILTERTYPE *pScaleFilter = pComponentConfigStructure;
+        if ((err = checkHeader(pComponentConfigStructure, sizeof(OMX_COLORCONV_CONFIG_SCALEFILTERTYPE))) != OMX_ErrorNone) {
+          break;
+        }
+        if (pScaleFilter->nPortIndex != OMX_BASE_FILTER_OUTPUTPORT_INDEX) {
+          return OMX_ErrorBadPortIndex;
+        }
+        if (pScaleFilter->eFilter > OMX_COLORCONV_ScaleArea) {
+          return OMX_ErrorBadParameter;
+        }
+        omx_ffmpeg_colorconv_component_Private->sScaleFilterConfig.eFilter = pScaleFilter->eFilter;
+        break;
+      }
     case OMX_IndexConfigCommonOutputPosition:
       omxConfigOutputPosition = (OMX_CONFIG_POINTTYPE*)pComponentConfigStructure;
       portIndex = omxConfigOutputPosition->nPortIndex;
@@ -1010,6 +2362,18 @@ OMX_ERRORTYPE omx_ffmpeg_colorconv_component_GetConfig(
         return OMX_ErrorBadPortIndex;
       }
       break;
+    case OMX_IndexVendorColorConvScaleFilter:
+      {
+        OMX_COLORCONV_CONFIG_SCALEFILTERTYPE *pScaleFilter = pComponentConfigStructure;
+        if ((err = checkHeader(pComponentConfigStructure, sizeof(OMX_COLORCONV_CONFIG_SCALEFILTERTYPE))) != OMX_ErrorNone) {
+          break;
+        }
+        if (pScaleFilter->nPortIndex != OMX_BASE_FILTER_OUTPUTPORT_INDEX) {
+          return OMX_ErrorBadPortIndex;
+        }
+        memcpy(pScaleFilter, &omx_ffmpeg_colorconv_component_Private->sScaleFilterConfig, sizeof(OMX_COLORCONV_CONFIG_SCALEFILTERTYPE));
+        break;
+      }
     case OMX_IndexConfigCommonOutputPosition:
       omxConfigOutputPosition = (OMX_CONFIG_POINTTYPE*)pComponentConfigStructure;
       if ((err = checkHeader(pComponentConfigStructure, sizeof(OMX_CONFIG_POINTTYPE))) != OMX_ErrorNone) {
@@ -1078,6 +2442,7 @@ OMX_ERRORTYPE omx_ffmpeg_colorconv_component_SetParameter(
       pPort->omxConfigCrop.nWidth = pPort->sPortParam.format.video.nFrameWidth;
       pPort->omxConfigCrop.nHeight = pPort->sPortParam.format.video.nFrameHeight;
       pPort->ffmpeg_pxlfmt = find_ffmpeg_pxlfmt(pPort->sVideoParam.eColorFormat);
+      omx_ffmpeg_colorconv_component_SelectKernel(omx_ffmpeg_colorconv_component_Private);
       break;
     case OMX_IndexParamVideoPortFormat:
       //  FIXME: How do we handle the nIndex member?
@@ -1107,7 +2472,28 @@ OMX_ERRORTYPE omx_ffmpeg_colorconv_component_SetParameter(
       pPort->sPortParam.format.video.nStride = calcStride(pPort->sPortParam.format.video.nFrameWidth, pPort->sVideoParam.eColorFormat);
       pPort->sPortParam.format.video.nSliceHeight = pPort->sPortParam.format.video.nFrameHeight;  //  No support for slices yet
       pPort->sPortParam.nBufferSize = (OMX_U32) abs(pPort->sPortParam.format.video.nStride) * pPort->sPortParam.format.video.nSliceHeight;
+      omx_ffmpeg_colorconv_component_SelectKernel(omx_ffmpeg_colorconv_component_Private);
       break;
+    case OMX_IndexVendorColorConvThreading:
+      {
+        OMX_COLORCONV_PARAM_THREADINGTYPE *pThreading;
+        pThreading = ComponentParameterStructure;
+        portIndex = pThreading->nPortIndex;
+        err = omx_base_component_ParameterSanityCheck(hComponent, portIndex, pThreading, sizeof(OMX_COLORCONV_PARAM_THREADINGTYPE));
+        if(err!=OMX_ErrorNone) {
+          DEBUG(DEB_LEV_ERR, "In %s Parameter Check Error=%x\n",__func__,err);
+          break;
+        }
+        if (portIndex != OMX_BASE_FILTER_INPUTPORT_INDEX) {
+          return OMX_ErrorBadPortIndex;
+        }
+        if (pThreading->nThreadCount > COLOR_CONV_MAX_THREADS) {
+          DEBUG(DEB_LEV_ERR, "In %s Too many threads %d\n",__func__,(int)pThreading->nThreadCount);
+          return OMX_ErrorBadParameter;
+        }
+        memcpy(&omx_ffmpeg_colorconv_component_Private->sThreadingParam, pThreading, sizeof(OMX_COLORCONV_PARAM_THREADINGTYPE));
+        break;
+      }
     case OMX_IndexParamStandardComponentRole:
       pComponentRole = (OMX_PARAM_COMPONENTROLETYPE*)ComponentParameterStructure;
 
@@ -1173,6 +2559,19 @@ OMX_ERRORTYPE omx_ffmpeg_colorconv_component_GetParameter(
       }
       strcpy((char*) pComponentRole->cRole, COLOR_CONV_ROLE);
       break;
+    case OMX_IndexVendorColorConvThreading:
+      {
+        OMX_COLORCONV_PARAM_THREADINGTYPE *pThreading;
+        pThreading = ComponentParameterStructure;
+        if ((err = checkHeader(ComponentParameterStructure, sizeof(OMX_COLORCONV_PARAM_THREADINGTYPE))) != OMX_ErrorNone) {
+          break;
+        }
+        if (pThreading->nPortIndex != OMX_BASE_FILTER_INPUTPORT_INDEX) {
+          return OMX_ErrorBadPortIndex;
+        }
+        memcpy(pThreading, &omx_ffmpeg_colorconv_component_Private->sThreadingParam, sizeof(OMX_COLORCONV_PARAM_THREADINGTYPE));
+        break;
+      }
     default: /*Call the base component function*/
       return omx_base_component_GetParameter(hComponent, nParamIndex, ComponentParameterStructure);
   }
@@ -1235,3 +2634,20 @@ OMX_ERRORTYPE omx_video_colorconv_UseEGLImage (
                                 pPort->sPortParam.nBufferSize,
                                 eglImage);
 }
+
+OMX_ERRORTYPE omx_ffmpeg_colorconv_component_GetExtensionIndex(
+  OMX_HANDLETYPE hComponent,
+  OMX_STRING cParameterName,
+  OMX_INDEXTYPE* pIndexType) {
+
+  DEBUG(DEB_LEV_FUNCTION_NAME,"In  %s \n",__func__);
+
+  if(strcmp(cParameterName,COLOR_CONV_THREADING_EXTENSION) == 0) {
+    *pIndexType = OMX_IndexVendorColorConvThreading;
+  } else if(strcmp(cParameterName,COLOR_CONV_SCALEFILTER_EXTENSION) == 0) {
+    *pIndexType = OMX_IndexVendorColorConvScaleFilter;
+  } else {
+    return omx_base_component_GetExtensionIndex(hComponent, cParameterName, pIndexType);
+  }
+  return OMX_ErrorNone;
+}
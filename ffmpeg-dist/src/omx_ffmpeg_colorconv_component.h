@@ -57,6 +57,104 @@
 #define MIN(a,b)  (((a) < (b)) ? (a) : (b))
 #define MAX(a,b)  (((a) > (b)) ? (a) : (b))
 
+/** Extension name of the color converter threading parameter */
+#define COLOR_CONV_THREADING_EXTENSION "OMX.ST.index.param.colorconv.threading"
+
+/** Extension name of the color converter scaling filter config */
+#define COLOR_CONV_SCALEFILTER_EXTENSION "OMX.ST.index.config.colorconv.scalefilter"
+
+/** Most threads a color converter instance converts a frame with */
+#define COLOR_CONV_MAX_THREADS 16
+
+/** Fewest rows of a band, smaller frames are split in fewer bands */
+#define COLOR_CONV_MIN_BAND_HEIGHT 64
+
+/** Rows converted at once before being rotated into the output buffer, even so that strips start on a 4:2:0 chroma row */
+#define COLOR_CONV_ROTATE_STRIP_HEIGHT 16
+
+/** Side in pixels of the tiles a picture is rotated by */
+#define COLOR_CONV_ROTATE_TILE 16
+
+/** Vendor specific indexes of the color converter */
+typedef enum OMX_COLORCONV_INDEXVENDORTYPE {
+  OMX_IndexVendorColorConvThreading = OMX_IndexVendorStartUnused + 0x00d00100, /**< reference: OMX_COLORCONV_PARAM_THREADINGTYPE */
+  OMX_IndexVendorColorConvScaleFilter                                           /**< reference: OMX_COLORCONV_CONFIG_SCALEFILTERTYPE */
+} OMX_COLORCONV_INDEXVENDORTYPE;
+
+/** Color converter threading parameter. The workers are started by Init, when the component
+  * goes from Idle to Executing: a thread count set later applies from the next time it does.
+  * Each frame is split into horizontal bands converted in parallel, the buffer
+  * management thread converting the first band and nThreadCount-1 workers the others.
+  * @param nThreadCount number of converting threads, 0 selects one per CPU core
+  */
+typedef struct OMX_COLORCONV_PARAM_THREADINGTYPE {
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U32 nPortIndex;
+  OMX_U32 nThreadCount;
+} OMX_COLORCONV_PARAM_THREADINGTYPE;
+
+/** Filters the color converter scales with, from the fastest to the smoothest */
+typedef enum OMX_COLORCONV_SCALEFILTERTYPE {
+  OMX_COLORCONV_ScaleFastBilinear = 0, /**< bilinear, with a cheaper horizontal pass */
+  OMX_COLORCONV_ScaleBilinear,         /**< bilinear */
+  OMX_COLORCONV_ScaleBicubic,          /**< bicubic */
+  OMX_COLORCONV_ScaleArea              /**< averages the covered source pixels, suits large downscales */
+} OMX_COLORCONV_SCALEFILTERTYPE;
+
+/** Color converter scaling filter config, it can be changed while executing.
+  * The input crop rectangle is scaled by the product of the OMX_IndexConfigCommonScale
+  * factors of both ports, and the output crop rectangle is taken out of the scaled picture.
+  * @param eFilter scaling filter
+  */
+typedef struct OMX_COLORCONV_CONFIG_SCALEFILTERTYPE {
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U32 nPortIndex;
+  OMX_COLORCONV_SCALEFILTERTYPE eFilter;
+} OMX_COLORCONV_CONFIG_SCALEFILTERTYPE;
+
+/** Same size conversion kernel of a pair of pixel formats, taking the plane pointers and line sizes swscale takes */
+typedef void (*omx_ffmpeg_colorconv_kernel)(const uint8_t* const src_data[4], const int src_linesize[4],
+                                            uint8_t* const dest_data[4], const int dest_linesize[4],
+                                            int width, int height);
+
+/** Instruction set extensions the conversion kernels may be chosen among, or'ed together */
+#define COLOR_CONV_SIMD_NONE  0x0
+#define COLOR_CONV_SIMD_SSSE3 0x1
+#define COLOR_CONV_SIMD_AVX2  0x2
+#define COLOR_CONV_SIMD_NEON  0x4
+
+/** Band of a frame converted by a worker of the color converter */
+typedef struct omx_ffmpeg_colorconv_WorkerType {
+  /** @param thread the worker thread */
+  pthread_t thread;
+  /** @param startSem posted when the band is set up, or when the worker has to exit */
+  tsem_t startSem;
+  /** @param doneSem shared by the workers, posted when a band is converted */
+  tsem_t* doneSem;
+  /** @param bExit tells the worker to exit */
+  OMX_BOOL bExit;
+  /** @param swsCtx conversion context of the worker, set up by the buffer management thread */
+  struct SwsContext* swsCtx;
+  /** @param kernel conversion kernel used instead of swsCtx, NULL if there is none */
+  omx_ffmpeg_colorconv_kernel kernel;
+  /** @param src_data input planes of the band */
+  uint8_t* src_data[4];
+  /** @param src_linesize input line sizes of the band */
+  int src_linesize[4];
+  /** @param dest_data output planes of the band */
+  uint8_t* dest_data[4];
+  /** @param dest_linesize output line sizes of the band */
+  int dest_linesize[4];
+  /** @param width width of the band */
+  int width;
+  /** @param height height of the band */
+  int height;
+  /** @param err result of the conversion of the band, read once doneSem is posted */
+  OMX_ERRORTYPE err;
+} omx_ffmpeg_colorconv_WorkerType;
+
 /** FFmpeg color converter component port structure.
   */
 DERIVEDCLASS(omx_ffmpeg_colorconv_component_PortType, omx_base_video_PortType)
@@ -90,7 +188,23 @@ DERIVEDCLASS(omx_ffmpeg_colorconv_component_PrivateType, omx_base_filter_Private
   /** @param in_alloc_size Allocated size of the input buffer */ \
   unsigned int in_alloc_size; \
   /** @param conv_alloc_size Allocated size of the conversion buffer */ \
-  unsigned int conv_alloc_size;
+  unsigned int conv_alloc_size; \
+  /** @param convKernel kernel converting the configured pair of formats without swscale, NULL if there is none */ \
+  omx_ffmpeg_colorconv_kernel convKernel; \
+  /** @param imgConvertYuvCtx conversion context, rebuilt only when the port formats or crop size change */ \
+  struct SwsContext *imgConvertYuvCtx; \
+  /** @param imgConvertRowCtx conversion context of a first row that has a chroma row of its own */ \
+  struct SwsContext *imgConvertRowCtx; \
+  /** @param sScaleFilterConfig scaling filter configuration */ \
+  OMX_COLORCONV_CONFIG_SCALEFILTERTYPE sScaleFilterConfig; \
+  /** @param sThreadingParam threading configuration */ \
+  OMX_COLORCONV_PARAM_THREADINGTYPE sThreadingParam; \
+  /** @param nWorkers number of started workers */ \
+  OMX_U32 nWorkers; \
+  /** @param workers band conversion workers, started in Init and stopped in Deinit */ \
+  omx_ffmpeg_colorconv_WorkerType* workers; \
+  /** @param workersDoneSem counts the bands converted by the workers */ \
+  tsem_t workersDoneSem;
 ENDCLASS(omx_ffmpeg_colorconv_component_PrivateType)
 
 /* Component private entry points declaration */
@@ -125,9 +239,20 @@ OMX_ERRORTYPE omx_ffmpeg_colorconv_component_GetConfig(
   OMX_INDEXTYPE nIndex,
   OMX_PTR pComponentConfigStructure);
 
+OMX_ERRORTYPE omx_ffmpeg_colorconv_component_GetExtensionIndex(
+  OMX_HANDLETYPE hComponent,
+  OMX_STRING cParameterName,
+  OMX_INDEXTYPE* pIndexType);
+
 /** finds pixel format */
 enum AVPixelFormat find_ffmpeg_pxlfmt(OMX_COLOR_FORMATTYPE omx_pxlfmt);
 
+/** returns the COLOR_CONV_SIMD_* extensions this build has kernels for and the processor runs */
+OMX_U32 omx_ffmpeg_colorconv_simd_support(void);
+
+/** finds the same size conversion kernel of a pair of pixel formats using no other extensions than simd, NULL if swscale has to be used */
+omx_ffmpeg_colorconv_kernel omx_ffmpeg_colorconv_find_kernel(enum AVPixelFormat in_pxlfmt, enum AVPixelFormat out_pxlfmt, OMX_U32 simd);
+
 /** stride calculation */
 OMX_S32 calcStride(OMX_U32 width, OMX_COLOR_FORMATTYPE omx_pxlfmt);
 
@@ -138,9 +138,31 @@ OMX_ERRORTYPE omx_videodec_component_Constructor(OMX_COMPONENTTYPE *openmaxStand
     */
   omx_videodec_component_Private->avCodec = NULL;
   omx_videodec_component_Private->avCodecContext= NULL;
+  omx_videodec_component_Private->avParser = NULL;
   omx_videodec_component_Private->avcodecReady = OMX_FALSE;
   omx_videodec_component_Private->extradata = NULL;
   omx_videodec_component_Private->extradata_size = 0;
+  omx_videodec_component_Private->isDrainPending = OMX_FALSE;
+  omx_videodec_component_Private->isDraining = OMX_FALSE;
+  omx_videodec_component_Private->pEosBuffer = NULL;
+  omx_videodec_component_Private->framePool = NULL;
+  omx_videodec_component_Private->framePoolSize = 0;
+  omx_videodec_component_Private->imgConvertYuvCtx = NULL;
+
+  /** single threaded decoding unless the IL client asks for more threads */
+  setHeader(&omx_videodec_component_Private->sThreadingParam, sizeof(OMX_VIDEODEC_PARAM_THREADINGTYPE));
+  omx_videodec_component_Private->sThreadingParam.nPortIndex = OMX_BASE_FILTER_INPUTPORT_INDEX;
+  omx_videodec_component_Private->sThreadingParam.nThreadCount = 1;
+  omx_videodec_component_Private->sThreadingParam.eThreadType = OMX_VIDEODEC_ThreadAny;
+  omx_videodec_component_Private->bLowDelay = OMX_FALSE;
+
+  setHeader(&omx_videodec_component_Private->sSkipConfig, sizeof(OMX_VIDEODEC_CONFIG_SKIPTYPE));
+  omx_videodec_component_Private->sSkipConfig.nPortIndex = OMX_BASE_FILTER_INPUTPORT_INDEX;
+  omx_videodec_component_Private->sSkipConfig.eSkipFrame = OMX_VIDEODEC_SkipNone;
+  omx_videodec_component_Private->sSkipConfig.eSkipLoopFilter = OMX_VIDEODEC_SkipNone;
+  omx_videodec_component_Private->sSkipConfig.eSkipIdct = OMX_VIDEODEC_SkipNone;
+  pthread_mutex_init(&omx_videodec_component_Private->skip_mutex, NULL);
+
   omx_videodec_component_Private->BufferMgmtCallback = omx_videodec_component_BufferMgmtCallback;
 
   /** initializing the codec context etc that was done earlier by ffmpeglibinit function */
@@ -148,7 +170,16 @@ OMX_ERRORTYPE omx_videodec_component_Constructor(OMX_COMPONENTTYPE *openmaxStand
   omx_videodec_component_Private->destructor = omx_videodec_component_Destructor;
   openmaxStandComp->SetParameter = omx_videodec_component_SetParameter;
   openmaxStandComp->GetParameter = omx_videodec_component_GetParameter;
+  openmaxStandComp->SetConfig = omx_videodec_component_SetConfig;
+  openmaxStandComp->GetConfig = omx_videodec_component_GetConfig;
   openmaxStandComp->ComponentRoleEnum = omx_videodec_component_ComponentRoleEnum;
+  openmaxStandComp->GetExtensionIndex = omx_videodec_component_GetExtensionIndex;
+  inPort->Port_SendBufferFunction = omx_videodec_component_port_SendBufferFunction;
+  inPort->ReturnBufferFunction = omx_videodec_component_port_ReturnBufferFunction;
+  inPort->FlushProcessingBuffers = omx_videodec_component_port_FlushProcessingBuffers;
+  outPort->Port_SendBufferFunction = omx_videodec_component_port_SendBufferFunction;
+  outPort->Port_FreeBuffer = omx_videodec_component_port_FreeBuffer;
+  outPort->Port_FreeTunnelBuffer = omx_videodec_component_port_FreeTunnelBuffer;
 
   noVideoDecInstance++;
 
@@ -181,6 +212,8 @@ OMX_ERRORTYPE omx_videodec_component_Destructor(OMX_COMPONENTTYPE *openmaxStandC
   }
 
 
+  pthread_mutex_destroy(&omx_videodec_component_Private->skip_mutex);
+
   DEBUG(DEB_LEV_FUNCTION_NAME, "Destructor of video decoder component is called\n");
 
   omx_base_filter_Destructor(openmaxStandComp);
@@ -190,6 +223,122 @@ OMX_ERRORTYPE omx_videodec_component_Destructor(OMX_COMPONENTTYPE *openmaxStandC
 }
 
 
+/** Decoder picture allocator. YUV420 planar pictures whose lines need no padding are taken from
+  * framePool, with planes as high as the decoder writes them. When that height is the picture height
+  * the picture has exactly the layout of an output buffer and is handed out without copy; any other
+  * picture is allocated by FFmpeg.
+  */
+static int omx_videodec_component_GetBuffer2(AVCodecContext *avctx, AVFrame *frame, int flags) {
+  omx_videodec_component_PrivateType* omx_videodec_component_Private = avctx->opaque;
+  int linesize_align[AV_NUM_DATA_POINTERS];
+  int width = frame->width;
+  int height = frame->height;
+  int nPoolSize;
+
+  if(frame->format != AV_PIX_FMT_YUV420P || omx_videodec_component_Private->eOutFramePixFmt != AV_PIX_FMT_YUV420P ||
+     frame->width != avctx->width || frame->height != avctx->height || (frame->width & 1) || (frame->height & 1)) {
+    return avcodec_default_get_buffer2(avctx, frame, flags);
+  }
+
+  /** the decoder writes whole macroblocks and needs aligned lines, the output buffer has neither padding nor gaps */
+  avcodec_align_dimensions2(avctx, &width, &height, linesize_align);
+  if(width != frame->width || (frame->width % linesize_align[0]) ||
+     ((frame->width / 2) % linesize_align[1]) || ((frame->width / 2) % linesize_align[2])) {
+    return avcodec_default_get_buffer2(avctx, frame, flags);
+  }
+
+  /** the decoder writes whole macroblock rows down to the aligned height,
+    * and some motion compensation functions read a couple of lines past the picture */
+  height = (height + 1) & ~1;
+  nPoolSize = frame->width * height * 3 / 2 + 2 * frame->width + AV_INPUT_BUFFER_PADDING_SIZE;
+  if(!omx_videodec_component_Private->framePool || omx_videodec_component_Private->framePoolSize != nPoolSize) {
+    av_buffer_pool_uninit(&omx_videodec_component_Private->framePool);
+    omx_videodec_component_Private->framePool = av_buffer_pool_init(nPoolSize, NULL);
+    if(!omx_videodec_component_Private->framePool) {
+      return AVERROR(ENOMEM);
+    }
+    omx_videodec_component_Private->framePoolSize = nPoolSize;
+    DEBUG(DEB_LEV_SIMPLE_SEQ, "In %s direct rendering %dx%d pictures\n", __func__, frame->width, frame->height);
+  }
+
+  frame->buf[0] = av_buffer_pool_get(omx_videodec_component_Private->framePool);
+  if(!frame->buf[0]) {
+    return AVERROR(ENOMEM);
+  }
+  frame->data[0] = frame->buf[0]->data;
+  frame->data[1] = frame->data[0] + frame->width * height;
+  frame->data[2] = frame->data[1] + frame->width * height / 4;
+  frame->linesize[0] = frame->width;
+  frame->linesize[1] = frame->width / 2;
+  frame->linesize[2] = frame->width / 2;
+  frame->extended_data = frame->data;
+  /** with rows below the picture between the planes, the picture is copied into the output buffer */
+  frame->opaque = (height == frame->height) ? omx_videodec_component_Private : NULL;
+
+  return 0;
+}
+
+/** Returns the index of an output buffer allocated by the output port, -1 for client buffers
+  */
+static int omx_videodec_component_OutBufferIndex(omx_base_PortType *outPort, OMX_BUFFERHEADERTYPE* pBuffer) {
+  OMX_U32 i;
+
+  for(i = 0; i < outPort->sPortParam.nBufferCountActual && i < VIDEO_DEC_MAX_DR_BUFFERS; i++) {
+    if(outPort->pInternalBufferStorage[i] == pBuffer && (outPort->bBufferStateAllocated[i] & BUFFER_ALLOCATED)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/** Gives the picture lent to an output buffer back to the decoder and restores the buffer memory
+  */
+static void omx_videodec_component_ReleaseLentFrame(omx_videodec_component_PrivateType* omx_videodec_component_Private, int nIndex) {
+  omx_base_PortType *outPort = omx_videodec_component_Private->ports[OMX_BASE_FILTER_OUTPUTPORT_INDEX];
+
+  if(nIndex >= 0 && omx_videodec_component_Private->pLentFrame[nIndex]) {
+    outPort->pInternalBufferStorage[nIndex]->pBuffer = omx_videodec_component_Private->pOwnBuffer[nIndex];
+    av_buffer_unref(&omx_videodec_component_Private->pLentFrame[nIndex]);
+  }
+}
+
+/** Figure out the FFmpeg discard level of a skip type
+  */
+static enum AVDiscard omx_videodec_component_FindDiscard(OMX_VIDEODEC_SKIPTYPE eSkip) {
+  switch(eSkip) {
+    case OMX_VIDEODEC_SkipNonRef:
+      return AVDISCARD_NONREF;
+    case OMX_VIDEODEC_SkipBidir:
+      return AVDISCARD_BIDIR;
+    case OMX_VIDEODEC_SkipNonIntra:
+      return AVDISCARD_NONINTRA;
+    case OMX_VIDEODEC_SkipNonKey:
+      return AVDISCARD_NONKEY;
+    case OMX_VIDEODEC_SkipAll:
+      return AVDISCARD_ALL;
+    case OMX_VIDEODEC_SkipNone:
+    default:
+      return AVDISCARD_DEFAULT;
+  }
+}
+
+/** Applies the skip configuration to the decoder, the decoder reads it at every frame.
+  * Called on the decoding thread only, before each frame, so the codec context is never
+  * written while FFmpeg uses it
+  */
+static void omx_videodec_component_ApplySkip(omx_videodec_component_PrivateType* omx_videodec_component_Private) {
+  AVCodecContext *avCodecContext = omx_videodec_component_Private->avCodecContext;
+  OMX_VIDEODEC_CONFIG_SKIPTYPE sSkipConfig;
+
+  pthread_mutex_lock(&omx_videodec_component_Private->skip_mutex);
+  sSkipConfig = omx_videodec_component_Private->sSkipConfig;
+  pthread_mutex_unlock(&omx_videodec_component_Private->skip_mutex);
+
+  avCodecContext->skip_frame = omx_videodec_component_FindDiscard(sSkipConfig.eSkipFrame);
+  avCodecContext->skip_loop_filter = omx_videodec_component_FindDiscard(sSkipConfig.eSkipLoopFilter);
+  avCodecContext->skip_idct = omx_videodec_component_FindDiscard(sSkipConfig.eSkipIdct);
+}
+
 /** It initializates the FFmpeg framework, and opens an FFmpeg videodecoder of type specified by IL client
   */
 OMX_ERRORTYPE omx_videodec_component_ffmpegLibInit(omx_videodec_component_PrivateType* omx_videodec_component_Private) {
@@ -226,15 +375,49 @@ OMX_ERRORTYPE omx_videodec_component_ffmpegLibInit(omx_videodec_component_Privat
   if(omx_videodec_component_Private->extradata_size >0) {
     omx_videodec_component_Private->avCodecContext->extradata = omx_videodec_component_Private->extradata;
     omx_videodec_component_Private->avCodecContext->extradata_size = (int)omx_videodec_component_Private->extradata_size;
-  } else {
-    omx_videodec_component_Private->avCodecContext->flags |= CODEC_FLAG_TRUNCATED;
   }
 
+  /** The parser cuts the input into frames, whatever the size of the input buffers.
+    * Without it each input buffer goes to the decoder as is, in truncated bitstream mode
+    */
+  omx_videodec_component_Private->avParser = av_parser_init(target_codecID);
+  if (omx_videodec_component_Private->avParser == NULL) {
+    DEBUG(DEB_LEV_SIMPLE_SEQ, "No parser for the codec, input buffers are decoded as they come\n");
+    if(omx_videodec_component_Private->extradata_size == 0) {
+      omx_videodec_component_Private->avCodecContext->flags |= CODEC_FLAG_TRUNCATED;
+    }
+  }
+
+  omx_videodec_component_Private->avCodecContext->opaque = omx_videodec_component_Private;
+  omx_videodec_component_Private->avCodecContext->get_buffer2 = omx_videodec_component_GetBuffer2;
+
+  /** FFmpeg falls back to slice threading by itself where frame threading is not supported */
+  omx_videodec_component_Private->avCodecContext->thread_count = omx_videodec_component_Private->sThreadingParam.nThreadCount;
+  omx_videodec_component_Private->avCodecContext->thread_type = 0;
+  if(omx_videodec_component_Private->sThreadingParam.eThreadType & OMX_VIDEODEC_ThreadFrame) {
+    omx_videodec_component_Private->avCodecContext->thread_type |= FF_THREAD_FRAME;
+  }
+  if(omx_videodec_component_Private->sThreadingParam.eThreadType & OMX_VIDEODEC_ThreadSlice) {
+    omx_videodec_component_Private->avCodecContext->thread_type |= FF_THREAD_SLICE;
+  }
+
+  /** In low delay mode no frame is held back: B-frame reordering is disabled
+    * and frame threading, which delays the output by one frame per thread, is not used
+    */
+  if(omx_videodec_component_Private->bLowDelay) {
+    omx_videodec_component_Private->avCodecContext->flags |= CODEC_FLAG_LOW_DELAY;
+    omx_videodec_component_Private->avCodecContext->thread_type &= ~FF_THREAD_FRAME;
+  }
+
+  omx_videodec_component_ApplySkip(omx_videodec_component_Private);
+
   if (avcodec_open2(omx_videodec_component_Private->avCodecContext, omx_videodec_component_Private->avCodec, NULL) < 0) {
     DEBUG(DEB_LEV_ERR, "Could not open codec\n");
     return OMX_ErrorInsufficientResources;
   }
-  DEBUG(DEB_LEV_SIMPLE_SEQ, "done\n");
+  DEBUG(DEB_LEV_SIMPLE_SEQ, "done threads=%d active thread type=%x\n",
+    omx_videodec_component_Private->avCodecContext->thread_count,
+    omx_videodec_component_Private->avCodecContext->active_thread_type);
 
   return OMX_ErrorNone;
 }
@@ -256,6 +439,17 @@ void omx_videodec_component_ffmpegLibDeInit(omx_videodec_component_PrivateType*
 
   av_free(omx_videodec_component_Private->avFrame);
 
+  if (omx_videodec_component_Private->avParser) {
+    av_parser_close(omx_videodec_component_Private->avParser);
+    omx_videodec_component_Private->avParser = NULL;
+  }
+
+  /** the pool goes away with the last picture still lent to an output buffer */
+  av_buffer_pool_uninit(&omx_videodec_component_Private->framePool);
+  omx_videodec_component_Private->framePoolSize = 0;
+
+  sws_freeContext(omx_videodec_component_Private->imgConvertYuvCtx);
+  omx_videodec_component_Private->imgConvertYuvCtx = NULL;
 }
 
 /** internal function to set codec related parameters in the private type structure
@@ -343,6 +537,9 @@ OMX_ERRORTYPE omx_videodec_component_Init(OMX_COMPONENTTYPE *openmaxStandComp) {
   omx_videodec_component_Private->inputCurrLength = 0;
   omx_videodec_component_Private->isFirstBuffer = OMX_TRUE;
   omx_videodec_component_Private->isNewBuffer = 1;
+  omx_videodec_component_Private->isDrainPending = OMX_FALSE;
+  omx_videodec_component_Private->isDraining = OMX_FALSE;
+  omx_videodec_component_Private->pEosBuffer = NULL;
 
   return eError;
 }
@@ -384,16 +581,96 @@ static inline void UpdateFrameSize(OMX_COMPONENTTYPE *openmaxStandComp) {
   }
 }
 
-struct SwsContext *imgConvertYuvCtx_dec = NULL;
+/** Stamps the output buffer with the time stamp of the input data the last picture was decoded from,
+  * which differs from the current input buffer when the decoder reorders or delays frames
+  */
+static void omx_videodec_component_SetFrameTimeStamp(omx_videodec_component_PrivateType* omx_videodec_component_Private, OMX_BUFFERHEADERTYPE* pOutputBuffer) {
+  int64_t pts = omx_videodec_component_Private->avFrame->best_effort_timestamp;
+
+  if(pts != AV_NOPTS_VALUE) {
+    pOutputBuffer->nTimeStamp = pts;
+  }
+}
+
+/** Converts the last decoded picture into the output buffer
+  */
+static void omx_videodec_component_OutputFrame(omx_videodec_component_PrivateType* omx_videodec_component_Private, OMX_BUFFERHEADERTYPE* pOutputBuffer) {
+  AVPicture pic;
+  int nSize;
+  int nIndex;
+
+  nSize = avpicture_get_size (omx_videodec_component_Private->eOutFramePixFmt,
+                              omx_videodec_component_Private->avCodecContext->width,
+                              omx_videodec_component_Private->avCodecContext->height);
+  if(pOutputBuffer->nAllocLen < nSize) {
+    DEBUG(DEB_LEV_ERR, "Ouch!!!! Output buffer Alloc Len %d less than Frame Size %d\n",(int)pOutputBuffer->nAllocLen,nSize);
+    return;
+  }
+
+  /** A direct rendered picture already has the output layout: lend it to the buffer instead of copying */
+  if(omx_videodec_component_Private->avFrame->opaque == omx_videodec_component_Private) {
+    nIndex = omx_videodec_component_OutBufferIndex(omx_videodec_component_Private->ports[OMX_BASE_FILTER_OUTPUTPORT_INDEX], pOutputBuffer);
+    if(nIndex >= 0) {
+      if(omx_videodec_component_Private->pLentFrame[nIndex]) {
+        omx_videodec_component_ReleaseLentFrame(omx_videodec_component_Private, nIndex);
+      }
+      omx_videodec_component_Private->pLentFrame[nIndex] = av_buffer_ref(omx_videodec_component_Private->avFrame->buf[0]);
+      if(omx_videodec_component_Private->pLentFrame[nIndex]) {
+        omx_videodec_component_Private->pOwnBuffer[nIndex] = pOutputBuffer->pBuffer;
+        pOutputBuffer->pBuffer = omx_videodec_component_Private->avFrame->data[0];
+        pOutputBuffer->nFilledLen += nSize;
+        omx_videodec_component_SetFrameTimeStamp(omx_videodec_component_Private, pOutputBuffer);
+        return;
+      }
+    }
+  }
+
+  avpicture_fill (&pic, (unsigned char*)(pOutputBuffer->pBuffer),
+                  omx_videodec_component_Private->eOutFramePixFmt,
+                  omx_videodec_component_Private->avCodecContext->width,
+                  omx_videodec_component_Private->avCodecContext->height);
+
+  /** The conversion context is kept per instance and only rebuilt when the picture geometry or format changes */
+  omx_videodec_component_Private->imgConvertYuvCtx = sws_getCachedContext(omx_videodec_component_Private->imgConvertYuvCtx,
+                                          omx_videodec_component_Private->avCodecContext->width,
+                                          omx_videodec_component_Private->avCodecContext->height,
+                                          omx_videodec_component_Private->avCodecContext->pix_fmt,
+                                          omx_videodec_component_Private->avCodecContext->width,
+                                          omx_videodec_component_Private->avCodecContext->height,
+                                          omx_videodec_component_Private->eOutFramePixFmt, SWS_FAST_BILINEAR, NULL, NULL, NULL );
+  if(omx_videodec_component_Private->imgConvertYuvCtx == NULL) {
+    DEBUG(DEB_LEV_ERR, "In %s cannot create the conversion context\n", __func__);
+    return;
+  }
+
+  sws_scale(omx_videodec_component_Private->imgConvertYuvCtx, omx_videodec_component_Private->avFrame->data,
+            omx_videodec_component_Private->avFrame->linesize, 0,
+            omx_videodec_component_Private->avCodecContext->height, pic.data, pic.linesize );
+
+  DEBUG(DEB_LEV_FULL_SEQ, "nSize=%d,frame linesize=%d,height=%d,pic linesize=%d PixFmt=%d\n",nSize,
+    omx_videodec_component_Private->avFrame->linesize[0],
+    omx_videodec_component_Private->avCodecContext->height,
+    pic.linesize[0],omx_videodec_component_Private->eOutFramePixFmt);
+
+  pOutputBuffer->nFilledLen += nSize;
+  omx_videodec_component_SetFrameTimeStamp(omx_videodec_component_Private, pOutputBuffer);
+}
+
 /** This function is used to process the input buffer and provide one output buffer
+  *
+  * The input is cut into frames by the parser, so an input buffer may carry any
+  * number of frames, or part of one: it is kept until all of its frames have been
+  * output, and the part of a frame it ends with is kept by the parser.
+  * The decoder may hold back frames, for reordering or because of frame threading.
+  * Once the data of an EOS buffer has been consumed, that buffer is kept while the
+  * held frames are flushed, one per output buffer, and it is released when the
+  * decoder is empty so that the base filter forwards the EOS flag after the last frame.
   */
 void omx_videodec_component_BufferMgmtCallback(OMX_COMPONENTTYPE *openmaxStandComp, OMX_BUFFERHEADERTYPE* pInputBuffer, OMX_BUFFERHEADERTYPE* pOutputBuffer) {
 
   omx_videodec_component_PrivateType* omx_videodec_component_Private = openmaxStandComp->pComponentPrivate;
-  AVPicture pic;
 
   OMX_S32 nOutputFilled = 0;
-  OMX_U8* outputCurrBuffer;
   int nLen = 0;
   int internalOutputFilled=0;
   int nSize;
@@ -431,6 +708,15 @@ void omx_videodec_component_BufferMgmtCallback(OMX_COMPONENTTYPE *openmaxStandCo
     }
   }
 
+  /** The length of an empty EOS buffer has been faked by the port, there is nothing to decode */
+  if(omx_videodec_component_Private->isDrainPending &&
+     (pInputBuffer->nFlags & OMX_BUFFERFLAG_EOS) == OMX_BUFFERFLAG_EOS) {
+    omx_videodec_component_Private->isDrainPending = OMX_FALSE;
+    omx_videodec_component_Private->isDraining = OMX_TRUE;
+    omx_videodec_component_Private->isNewBuffer = 0;
+    omx_videodec_component_Private->inputCurrLength = 0;
+  }
+
   /** Fill up the current input buffer when a new buffer has arrived */
   if(omx_videodec_component_Private->isNewBuffer) {
     omx_videodec_component_Private->inputCurrBuffer = pInputBuffer->pBuffer;
@@ -447,112 +733,319 @@ void omx_videodec_component_BufferMgmtCallback(OMX_COMPONENTTYPE *openmaxStandCo
     }
   }
 
-  outputCurrBuffer = pOutputBuffer->pBuffer;
   pOutputBuffer->nFilledLen = 0;
   pOutputBuffer->nOffset = 0;
 
   while (!nOutputFilled) {
-    omx_videodec_component_Private->avCodecContext->frame_number++;
     AVPacket pkt;
+    int nParsed;
     av_init_packet(&pkt);
-    pkt.buf = av_buffer_create(omx_videodec_component_Private->inputCurrBuffer,
-                               omx_videodec_component_Private->inputCurrLength + AV_INPUT_BUFFER_PADDING_SIZE, NULL, NULL, 0);
-    pkt.data = omx_videodec_component_Private->inputCurrBuffer;
-    pkt.size = omx_videodec_component_Private->inputCurrLength;
+    pkt.data = NULL;
+    pkt.size = 0;
+    nLen = 0;
+    internalOutputFilled = 0;
+
+    /** No buffer reference is given with the packet: it is only valid during the call,
+      * and FFmpeg copies it for the frame threads that keep working on it afterwards
+      */
+    if(omx_videodec_component_Private->isDraining) {
+      /** The parser gives out the frame it still holds, then an empty packet
+        * makes the decoder return the frames it still holds
+        */
+      if(omx_videodec_component_Private->avParser) {
+        av_parser_parse2(omx_videodec_component_Private->avParser, omx_videodec_component_Private->avCodecContext,
+                         &pkt.data, &pkt.size, NULL, 0, AV_NOPTS_VALUE, AV_NOPTS_VALUE, 0);
+        pkt.pts = omx_videodec_component_Private->avParser->pts;
+      }
+    } else if(omx_videodec_component_Private->avParser) {
+      /** The time stamp of the buffer goes to the first frame starting in it */
+      nParsed = av_parser_parse2(omx_videodec_component_Private->avParser, omx_videodec_component_Private->avCodecContext,
+                                 &pkt.data, &pkt.size,
+                                 omx_videodec_component_Private->inputCurrBuffer,
+                                 omx_videodec_component_Private->inputCurrLength,
+                                 (omx_videodec_component_Private->inputCurrBuffer == pInputBuffer->pBuffer) ?
+                                   pInputBuffer->nTimeStamp : AV_NOPTS_VALUE,
+                                 AV_NOPTS_VALUE, 0);
+      omx_videodec_component_Private->inputCurrBuffer += nParsed;
+      omx_videodec_component_Private->inputCurrLength -= nParsed;
+      pInputBuffer->nFilledLen -= nParsed;
+      /** The decoder hands the time stamp back with the frame decoded from this data */
+      pkt.pts = omx_videodec_component_Private->avParser->pts;
+    } else {
+      pkt.data = omx_videodec_component_Private->inputCurrBuffer;
+      pkt.size = omx_videodec_component_Private->inputCurrLength;
+      pkt.pts = pInputBuffer->nTimeStamp;
+    }
 
-    nLen = avcodec_decode_video2(omx_videodec_component_Private->avCodecContext,
-                                 omx_videodec_component_Private->avFrame, (int*)&internalOutputFilled, &pkt);
+    if(pkt.size > 0 || omx_videodec_component_Private->isDraining) {
+      if(pkt.size > 0) {
+        omx_videodec_component_Private->avCodecContext->frame_number++;
+      }
+      omx_videodec_component_ApplySkip(omx_videodec_component_Private);
+      nLen = avcodec_decode_video2(omx_videodec_component_Private->avCodecContext,
+                                   omx_videodec_component_Private->avFrame, (int*)&internalOutputFilled, &pkt);
 
-    if (nLen < 0) {
-      DEBUG(DEB_LEV_ERR, "A general error or simply frame not decoded?\n");
-    }
+      if (nLen < 0) {
+        DEBUG(DEB_LEV_ERR, "A general error or simply frame not decoded?\n");
+      }
+
+      {
+        omx_base_video_PortType *inPort = (omx_base_video_PortType *)omx_videodec_component_Private->ports[OMX_BASE_FILTER_INPUTPORT_INDEX];
+        if((inPort->sPortParam.format.video.nFrameWidth != omx_videodec_component_Private->avCodecContext->width) ||
+           (inPort->sPortParam.format.video.nFrameHeight != omx_videodec_component_Private->avCodecContext->height)) {
+          DEBUG(DEB_LEV_SIMPLE_SEQ, "Sending Port Settings Change Event in video decoder\n");
+
+          switch(omx_videodec_component_Private->video_coding_type) {
+            case OMX_VIDEO_CodingMPEG4 :
+            case OMX_VIDEO_CodingAVC :
+              inPort->sPortParam.format.video.nFrameWidth = omx_videodec_component_Private->avCodecContext->width;
+              inPort->sPortParam.format.video.nFrameHeight = omx_videodec_component_Private->avCodecContext->height;
+              break;
+            default :
+              DEBUG(DEB_LEV_ERR, "Video formats other than MPEG-4 AVC not supported\nCodec not found\n");
+              break;
+          }
+
+          UpdateFrameSize (openmaxStandComp);
 
-    {
-      omx_base_video_PortType *inPort = (omx_base_video_PortType *)omx_videodec_component_Private->ports[OMX_BASE_FILTER_INPUTPORT_INDEX];
-      if((inPort->sPortParam.format.video.nFrameWidth != omx_videodec_component_Private->avCodecContext->width) ||
-         (inPort->sPortParam.format.video.nFrameHeight != omx_videodec_component_Private->avCodecContext->height)) {
-        DEBUG(DEB_LEV_SIMPLE_SEQ, "Sending Port Settings Change Event in video decoder\n");
-
-        switch(omx_videodec_component_Private->video_coding_type) {
-          case OMX_VIDEO_CodingMPEG4 :
-          case OMX_VIDEO_CodingAVC :
-            inPort->sPortParam.format.video.nFrameWidth = omx_videodec_component_Private->avCodecContext->width;
-            inPort->sPortParam.format.video.nFrameHeight = omx_videodec_component_Private->avCodecContext->height;
-            break;
-          default :
-            DEBUG(DEB_LEV_ERR, "Video formats other than MPEG-4 AVC not supported\nCodec not found\n");
-            break;
-        }
-
-        UpdateFrameSize (openmaxStandComp);
-
-        /** Send Port Settings changed call back */
-        (*(omx_videodec_component_Private->callbacks->EventHandler))
-          (openmaxStandComp,
-           omx_videodec_component_Private->callbackData,
-           OMX_EventPortSettingsChanged, // The command was completed
-           nLen,  //to adjust the file pointer to resume the correct decode process
-           0, // This is the input port index
-           NULL);
+          /** The new geometry needs a new conversion context */
+          sws_freeContext(omx_videodec_component_Private->imgConvertYuvCtx);
+          omx_videodec_component_Private->imgConvertYuvCtx = NULL;
+
+          /** Send Port Settings changed call back */
+          (*(omx_videodec_component_Private->callbacks->EventHandler))
+            (openmaxStandComp,
+             omx_videodec_component_Private->callbackData,
+             OMX_EventPortSettingsChanged, // The command was completed
+             nLen,  //to adjust the file pointer to resume the correct decode process
+             0, // This is the input port index
+             NULL);
+        }
       }
     }
 
-    if ( nLen >= 0 && internalOutputFilled) {
-      omx_videodec_component_Private->inputCurrBuffer += nLen;
-      omx_videodec_component_Private->inputCurrLength -= nLen;
-      pInputBuffer->nFilledLen -= nLen;
+    /** Without the parser the decoder tells how much of the input it has used,
+      * and what is left of a buffer that gives no frame is dropped
+      */
+    if(!omx_videodec_component_Private->avParser && !omx_videodec_component_Private->isDraining) {
+      nParsed = (nLen >= 0 && internalOutputFilled) ? nLen : (int)omx_videodec_component_Private->inputCurrLength;
+      omx_videodec_component_Private->inputCurrBuffer += nParsed;
+      omx_videodec_component_Private->inputCurrLength -= nParsed;
+      pInputBuffer->nFilledLen -= nParsed;
+    }
 
+    if (omx_videodec_component_Private->isDraining) {
+      if (nLen >= 0 && internalOutputFilled) {
+        omx_videodec_component_OutputFrame(omx_videodec_component_Private, pOutputBuffer);
+        /** Hold the EOS buffer until the decoder has nothing left */
+        pInputBuffer->nFilledLen = 1;
+        omx_videodec_component_Private->pEosBuffer = pInputBuffer;
+        nOutputFilled = 1;
+      } else if (pkt.data == NULL) {
+        DEBUG(DEB_LEV_FULL_SEQ, "In %s decoder drained at EOS\n", __func__);
+        omx_videodec_component_Private->isDraining = OMX_FALSE;
+        omx_videodec_component_Private->isNewBuffer = 1;
+        omx_videodec_component_Private->pEosBuffer = NULL;
+        pInputBuffer->nFilledLen = 0;
+        nOutputFilled = 1;
+      }
+      /** else the last frame of the parser went in without a frame coming out, go on flushing */
+    } else if ( nLen >= 0 && internalOutputFilled) {
       //Buffer is fully consumed. Request for new Input Buffer
       if(pInputBuffer->nFilledLen == 0) {
         omx_videodec_component_Private->isNewBuffer = 1;
+        if((pInputBuffer->nFlags & OMX_BUFFERFLAG_EOS) == OMX_BUFFERFLAG_EOS) {
+          omx_videodec_component_Private->isDraining = OMX_TRUE;
+          omx_videodec_component_Private->isNewBuffer = 0;
+          pInputBuffer->nFilledLen = 1;
+          omx_videodec_component_Private->pEosBuffer = pInputBuffer;
+        }
       }
 
+      omx_videodec_component_OutputFrame(omx_videodec_component_Private, pOutputBuffer);
+      nOutputFilled = 1;
+    } else if (omx_videodec_component_Private->inputCurrLength == 0) {
+      /** The input buffer has been consumed without giving a complete frame.
+        * Request for new Input Buffer
+        */
+      pInputBuffer->nFilledLen = 0;
+      omx_videodec_component_Private->isNewBuffer = 1;
+      pOutputBuffer->nFilledLen = 0;
+      if((pInputBuffer->nFlags & OMX_BUFFERFLAG_EOS) == OMX_BUFFERFLAG_EOS) {
+        /** Nothing came out of the last data, go on with the delayed frames */
+        omx_videodec_component_Private->isDraining = OMX_TRUE;
+        omx_videodec_component_Private->isNewBuffer = 0;
+      } else {
+        nOutputFilled = 1;
+      }
+    }
+    /** else the parser has more frames to cut out of this buffer */
+  }
+  DEBUG(DEB_LEV_FULL_SEQ, "One output buffer %p nLen=%d is full returning in video decoder\n",
+            pOutputBuffer->pBuffer, (int)pOutputBuffer->nFilledLen);
+}
 
-      avpicture_fill (&pic, (unsigned char*)(outputCurrBuffer),
-                      omx_videodec_component_Private->eOutFramePixFmt,
-                      omx_videodec_component_Private->avCodecContext->width,
-                      omx_videodec_component_Private->avCodecContext->height);
+/** @brief the entry point for sending buffers to the video decoder ports
+  *
+  * The base filter does not call BufferMgmtCallback for an empty input buffer,
+  * so an empty EOS buffer is given a dummy length to let the frames held by the
+  * decoder be flushed before the EOS flag is forwarded.
+  * An output buffer coming back gives its lent picture back to the decoder.
+  */
+OMX_ERRORTYPE omx_videodec_component_port_SendBufferFunction(omx_base_PortType *openmaxStandPort, OMX_BUFFERHEADERTYPE* pBuffer) {
+  omx_videodec_component_PrivateType* omx_videodec_component_Private = openmaxStandPort->standCompContainer->pComponentPrivate;
 
-      if ( !imgConvertYuvCtx_dec ) {
-        imgConvertYuvCtx_dec = sws_getContext( omx_videodec_component_Private->avCodecContext->width,
-                                              omx_videodec_component_Private->avCodecContext->height,
-                                              omx_videodec_component_Private->avCodecContext->pix_fmt,
-                                              omx_videodec_component_Private->avCodecContext->width,
-                                              omx_videodec_component_Private->avCodecContext->height,
-                                              omx_videodec_component_Private->eOutFramePixFmt, SWS_FAST_BILINEAR, NULL, NULL, NULL );
-      }
+  if(openmaxStandPort->sPortParam.eDir == OMX_DirOutput) {
+    omx_videodec_component_ReleaseLentFrame(omx_videodec_component_Private,
+      omx_videodec_component_OutBufferIndex(openmaxStandPort, pBuffer));
+    return base_port_SendBufferFunction(openmaxStandPort, pBuffer);
+  }
 
-      sws_scale(imgConvertYuvCtx_dec, omx_videodec_component_Private->avFrame->data,
-                omx_videodec_component_Private->avFrame->linesize, 0,
-                omx_videodec_component_Private->avCodecContext->height, pic.data, pic.linesize );
+  if(pBuffer != NULL && pBuffer->nFilledLen == 0 &&
+     (pBuffer->nFlags & OMX_BUFFERFLAG_EOS) == OMX_BUFFERFLAG_EOS &&
+     omx_videodec_component_Private->avcodecReady) {
+    DEBUG(DEB_LEV_FULL_SEQ, "In %s empty EOS buffer, draining the decoder\n", __func__);
+    omx_videodec_component_Private->isDrainPending = OMX_TRUE;
+    pBuffer->nFilledLen = 1;
+    omx_videodec_component_Private->pEosBuffer = pBuffer;
+  }
+  return base_port_SendBufferFunction(openmaxStandPort, pBuffer);
+}
 
-/*      if (imgConvertYuvCtx_dec ) {
-        sws_freeContext(imgConvertYuvCtx_dec);
-      }
-*/
-      DEBUG(DEB_LEV_FULL_SEQ, "nSize=%d,frame linesize=%d,height=%d,pic linesize=%d PixFmt=%d\n",nSize,
-        omx_videodec_component_Private->avFrame->linesize[0],
-        omx_videodec_component_Private->avCodecContext->height,
-        pic.linesize[0],omx_videodec_component_Private->eOutFramePixFmt);
+/** @brief the entry point for returning input buffers to the client
+  *
+  * An EOS buffer given back before the decoder is drained, when the port is
+  * flushed, still has the dummy length set to drain the decoder: it is cleared
+  * so that the client gets the buffer back as empty as it came.
+  */
+OMX_ERRORTYPE omx_videodec_component_port_ReturnBufferFunction(omx_base_PortType *openmaxStandPort, OMX_BUFFERHEADERTYPE* pBuffer) {
+  omx_videodec_component_PrivateType* omx_videodec_component_Private = openmaxStandPort->standCompContainer->pComponentPrivate;
 
-      pOutputBuffer->nFilledLen += nSize;
+  if(pBuffer != NULL && pBuffer == omx_videodec_component_Private->pEosBuffer) {
+    pBuffer->nFilledLen = 0;
+    omx_videodec_component_Private->pEosBuffer = NULL;
+  }
+  return base_port_ReturnBufferFunction(openmaxStandPort, pBuffer);
+}
 
+/** @brief Releases buffers under processing.
+  *
+  * Once the buffer management thread has let go of the input buffer, the
+  * frames held by the decoder and the data held by the parser are dropped,
+  * so that decoding starts afresh with the buffers sent after the flush
+  * instead of mixing them with what came before it.
+  */
+OMX_ERRORTYPE omx_videodec_component_port_FlushProcessingBuffers(omx_base_PortType *openmaxStandPort) {
+  omx_base_component_PrivateType* omx_base_component_Private;
+  omx_videodec_component_PrivateType* omx_videodec_component_Private;
+  OMX_BUFFERHEADERTYPE* pBuffer;
+  int errQue;
+
+  DEBUG(DEB_LEV_FUNCTION_NAME, "In %s\n", __func__);
+  omx_base_component_Private      = (omx_base_component_PrivateType*)openmaxStandPort->standCompContainer->pComponentPrivate;
+  omx_videodec_component_Private  = (omx_videodec_component_PrivateType*) omx_base_component_Private;
+
+  pthread_mutex_lock(&omx_base_component_Private->flush_mutex);
+  openmaxStandPort->bIsPortFlushed=OMX_TRUE;
+  /*Signal the buffer management thread of port flush,if it is waiting for buffers*/
+  if(omx_base_component_Private->bMgmtSem->semval==0) {
+    tsem_up(omx_base_component_Private->bMgmtSem);
+  }
+
+  if(omx_base_component_Private->state==OMX_StatePause ) {
+    /*Waiting at paused state*/
+    tsem_signal(omx_base_component_Private->bStateSem);
+  }
+  DEBUG(DEB_LEV_FULL_SEQ, "In %s waiting for flush all condition port index =%d\n", __func__,(int)openmaxStandPort->sPortParam.nPortIndex);
+  /* Wait until flush is completed */
+  pthread_mutex_unlock(&omx_base_component_Private->flush_mutex);
+  tsem_down(omx_base_component_Private->flush_all_condition);
+
+  /** The buffer management thread is waiting, the decoder and the parser can be reset */
+  if (omx_videodec_component_Private->avcodecReady) {
+    avcodec_flush_buffers(omx_videodec_component_Private->avCodecContext);
+    if (omx_videodec_component_Private->avParser) {
+      av_parser_close(omx_videodec_component_Private->avParser);
+      omx_videodec_component_Private->avParser = av_parser_init(omx_videodec_component_Private->avCodec->id);
+    }
+  }
+  omx_videodec_component_Private->inputCurrBuffer = NULL;
+  omx_videodec_component_Private->inputCurrLength = 0;
+  omx_videodec_component_Private->isNewBuffer = 1;
+  omx_videodec_component_Private->isDrainPending = OMX_FALSE;
+  omx_videodec_component_Private->isDraining = OMX_FALSE;
+
+  tsem_reset(omx_base_component_Private->bMgmtSem);
+
+  /* Flush all the buffers not under processing */
+  while (openmaxStandPort->pBufferSem->semval > 0) {
+    DEBUG(DEB_LEV_FULL_SEQ, "In %s TFlag=%x Flusing Port=%d,Semval=%d Qelem=%d\n",
+    __func__,(int)openmaxStandPort->nTunnelFlags,(int)openmaxStandPort->sPortParam.nPortIndex,
+    (int)openmaxStandPort->pBufferSem->semval,(int)openmaxStandPort->pBufferQueue->nelem);
+
+    tsem_down(openmaxStandPort->pBufferSem);
+    pBuffer = dequeue(openmaxStandPort->pBufferQueue);
+    /** an empty EOS buffer still in the queue has the dummy length as well */
+    if (pBuffer == omx_videodec_component_Private->pEosBuffer) {
+      pBuffer->nFilledLen = 0;
+      omx_videodec_component_Private->pEosBuffer = NULL;
+    }
+    if (PORT_IS_TUNNELED(openmaxStandPort) && !PORT_IS_BUFFER_SUPPLIER(openmaxStandPort)) {
+      DEBUG(DEB_LEV_FULL_SEQ, "In %s: Comp %s is returning io:%d buffer\n",
+        __func__,omx_base_component_Private->name,(int)openmaxStandPort->sPortParam.nPortIndex);
+      ((OMX_COMPONENTTYPE*)(openmaxStandPort->hTunneledComponent))->FillThisBuffer(openmaxStandPort->hTunneledComponent, pBuffer);
+    } else if (PORT_IS_TUNNELED_N_BUFFER_SUPPLIER(openmaxStandPort)) {
+      errQue = queue(openmaxStandPort->pBufferQueue,pBuffer);
+      if (errQue) {
+        return OMX_ErrorInsufficientResources;
+      }
     } else {
-      /**  This condition becomes true when the input buffer has completely be consumed.
-        * In this case is immediately switched because there is no real buffer consumption
-        */
-      pInputBuffer->nFilledLen = 0;
-      /** Few bytes may be left in the input buffer but can't generate one output frame.
-        *  Request for new Input Buffer
-        */
-      omx_videodec_component_Private->isNewBuffer = 1;
-      pOutputBuffer->nFilledLen = 0;
+      (*(openmaxStandPort->BufferProcessedCallback))(
+        openmaxStandPort->standCompContainer,
+        omx_base_component_Private->callbackData,
+        pBuffer);
     }
+  }
+  omx_videodec_component_Private->pEosBuffer = NULL;
 
-    nOutputFilled = 1;
+  /*Port is tunneled and supplier and didn't received all it's buffer then wait for the buffers*/
+  if (PORT_IS_TUNNELED_N_BUFFER_SUPPLIER(openmaxStandPort)) {
+    while(openmaxStandPort->pBufferQueue->nelem!= openmaxStandPort->nNumAssignedBuffers){
+      tsem_down(openmaxStandPort->pBufferSem);
+      DEBUG(DEB_LEV_PARAMS, "In %s Got a buffer qelem=%d\n",__func__,openmaxStandPort->pBufferQueue->nelem);
+    }
+    tsem_reset(openmaxStandPort->pBufferSem);
   }
-  DEBUG(DEB_LEV_FULL_SEQ, "One output buffer %p nLen=%d is full returning in video decoder\n",
-            pOutputBuffer->pBuffer, (int)pOutputBuffer->nFilledLen);
+
+  pthread_mutex_lock(&omx_base_component_Private->flush_mutex);
+  openmaxStandPort->bIsPortFlushed=OMX_FALSE;
+  pthread_mutex_unlock(&omx_base_component_Private->flush_mutex);
+
+  tsem_up(omx_base_component_Private->flush_condition);
+
+  DEBUG(DEB_LEV_FUNCTION_NAME, "Out %s Port Index=%d\n", __func__,(int)openmaxStandPort->sPortParam.nPortIndex);
+
+  return OMX_ErrorNone;
+}
+
+/** Output buffers are freed with the memory the port allocated, not a lent picture
+  */
+OMX_ERRORTYPE omx_videodec_component_port_FreeBuffer(omx_base_PortType *openmaxStandPort, OMX_U32 nPortIndex, OMX_BUFFERHEADERTYPE* pBuffer) {
+  omx_videodec_component_PrivateType* omx_videodec_component_Private = openmaxStandPort->standCompContainer->pComponentPrivate;
+
+  omx_videodec_component_ReleaseLentFrame(omx_videodec_component_Private,
+    omx_videodec_component_OutBufferIndex(openmaxStandPort, pBuffer));
+  return base_port_FreeBuffer(openmaxStandPort, nPortIndex, pBuffer);
+}
+
+OMX_ERRORTYPE omx_videodec_component_port_FreeTunnelBuffer(omx_base_PortType *openmaxStandPort, OMX_U32 nPortIndex) {
+  omx_videodec_component_PrivateType* omx_videodec_component_Private = openmaxStandPort->standCompContainer->pComponentPrivate;
+  int i;
+
+  for(i = 0; i < VIDEO_DEC_MAX_DR_BUFFERS; i++) {
+    omx_videodec_component_ReleaseLentFrame(omx_videodec_component_Private, i);
+  }
+  return base_port_FreeTunnelBuffer(openmaxStandPort, nPortIndex);
 }
 
 OMX_ERRORTYPE omx_videodec_component_SetParameter(
@@ -688,6 +1181,26 @@ OMX_ERRORTYPE omx_videodec_component_SetParameter(
         }
         break;
       }
+    case OMX_IndexVendorVideoDecThreading:
+      {
+        OMX_VIDEODEC_PARAM_THREADINGTYPE *pThreading;
+        pThreading = ComponentParameterStructure;
+        portIndex = pThreading->nPortIndex;
+        eError = omx_base_component_ParameterSanityCheck(hComponent, portIndex, pThreading, sizeof(OMX_VIDEODEC_PARAM_THREADINGTYPE));
+        if(eError!=OMX_ErrorNone) {
+          DEBUG(DEB_LEV_ERR, "In %s Parameter Check Error=%x\n",__func__,eError);
+          break;
+        }
+        if (portIndex != OMX_BASE_FILTER_INPUTPORT_INDEX) {
+          return OMX_ErrorBadPortIndex;
+        }
+        if (!(pThreading->eThreadType & OMX_VIDEODEC_ThreadAny) || (pThreading->eThreadType & ~OMX_VIDEODEC_ThreadAny)) {
+          DEBUG(DEB_LEV_ERR, "In %s Invalid thread type %x\n",__func__,(int)pThreading->eThreadType);
+          return OMX_ErrorBadParameter;
+        }
+        memcpy(&omx_videodec_component_Private->sThreadingParam, pThreading, sizeof(OMX_VIDEODEC_PARAM_THREADINGTYPE));
+        break;
+      }
     default: /*Call the base component function*/
       return omx_base_component_SetParameter(hComponent, nParamIndex, ComponentParameterStructure);
   }
@@ -773,12 +1286,126 @@ OMX_ERRORTYPE omx_videodec_component_GetParameter(
         }
         break;
       }
+    case OMX_IndexVendorVideoDecThreading:
+      {
+        OMX_VIDEODEC_PARAM_THREADINGTYPE *pThreading;
+        pThreading = ComponentParameterStructure;
+        if ((eError = checkHeader(ComponentParameterStructure, sizeof(OMX_VIDEODEC_PARAM_THREADINGTYPE))) != OMX_ErrorNone) {
+          break;
+        }
+        if (pThreading->nPortIndex != OMX_BASE_FILTER_INPUTPORT_INDEX) {
+          return OMX_ErrorBadPortIndex;
+        }
+        memcpy(pThreading, &omx_videodec_component_Private->sThreadingParam, sizeof(OMX_VIDEODEC_PARAM_THREADINGTYPE));
+        break;
+      }
     default: /*Call the base component function*/
       return omx_base_component_GetParameter(hComponent, nParamIndex, ComponentParameterStructure);
   }
   return OMX_ErrorNone;
 }
 
+OMX_ERRORTYPE omx_videodec_component_SetConfig(
+  OMX_HANDLETYPE hComponent,
+  OMX_INDEXTYPE nIndex,
+  OMX_PTR pComponentConfigStructure) {
+
+  OMX_ERRORTYPE eError = OMX_ErrorNone;
+  OMX_COMPONENTTYPE *openmaxStandComp = hComponent;
+  omx_videodec_component_PrivateType* omx_videodec_component_Private = openmaxStandComp->pComponentPrivate;
+
+  if (pComponentConfigStructure == NULL) {
+    return OMX_ErrorBadParameter;
+  }
+  DEBUG(DEB_LEV_SIMPLE_SEQ, "   Setting config %i\n", nIndex);
+
+  switch(nIndex) {
+    case OMX_IndexVendorVideoDecLowDelay:
+      {
+        OMX_CONFIG_BOOLEANTYPE *pLowDelay;
+        pLowDelay = pComponentConfigStructure;
+        if ((eError = checkHeader(pComponentConfigStructure, sizeof(OMX_CONFIG_BOOLEANTYPE))) != OMX_ErrorNone) {
+          break;
+        }
+        omx_videodec_component_Private->bLowDelay = pLowDelay->bEnabled;
+        if (omx_videodec_component_Private->avcodecReady) {
+          DEBUG(DEB_LEV_SIMPLE_SEQ, "In %s low delay mode change applies when the codec is reopened\n", __func__);
+        }
+        break;
+      }
+    case OMX_IndexVendorVideoDecSkip:
+      {
+        OMX_VIDEODEC_CONFIG_SKIPTYPE *pSkip;
+        pSkip = pComponentConfigStructure;
+        if ((eError = checkHeader(pComponentConfigStructure, sizeof(OMX_VIDEODEC_CONFIG_SKIPTYPE))) != OMX_ErrorNone) {
+          break;
+        }
+        if (pSkip->nPortIndex != OMX_BASE_FILTER_INPUTPORT_INDEX) {
+          return OMX_ErrorBadPortIndex;
+        }
+        if (pSkip->eSkipFrame > OMX_VIDEODEC_SkipAll ||
+            pSkip->eSkipLoopFilter > OMX_VIDEODEC_SkipAll ||
+            pSkip->eSkipIdct > OMX_VIDEODEC_SkipAll) {
+          return OMX_ErrorBadParameter;
+        }
+        /** the decoding thread picks it up before the next frame */
+        pthread_mutex_lock(&omx_videodec_component_Private->skip_mutex);
+        memcpy(&omx_videodec_component_Private->sSkipConfig, pSkip, sizeof(OMX_VIDEODEC_CONFIG_SKIPTYPE));
+        pthread_mutex_unlock(&omx_videodec_component_Private->skip_mutex);
+        break;
+      }
+    default: /*Call the base component function*/
+      return omx_base_component_SetConfig(hComponent, nIndex, pComponentConfigStructure);
+  }
+  return eError;
+}
+
+OMX_ERRORTYPE omx_videodec_component_GetConfig(
+  OMX_HANDLETYPE hComponent,
+  OMX_INDEXTYPE nIndex,
+  OMX_PTR pComponentConfigStructure) {
+
+  OMX_ERRORTYPE eError = OMX_ErrorNone;
+  OMX_COMPONENTTYPE *openmaxStandComp = hComponent;
+  omx_videodec_component_PrivateType* omx_videodec_component_Private = openmaxStandComp->pComponentPrivate;
+
+  if (pComponentConfigStructure == NULL) {
+    return OMX_ErrorBadParameter;
+  }
+  DEBUG(DEB_LEV_SIMPLE_SEQ, "   Getting config %i\n", nIndex);
+
+  switch(nIndex) {
+    case OMX_IndexVendorVideoDecLowDelay:
+      {
+        OMX_CONFIG_BOOLEANTYPE *pLowDelay;
+        pLowDelay = pComponentConfigStructure;
+        if ((eError = checkHeader(pComponentConfigStructure, sizeof(OMX_CONFIG_BOOLEANTYPE))) != OMX_ErrorNone) {
+          break;
+        }
+        pLowDelay->bEnabled = omx_videodec_component_Private->bLowDelay;
+        break;
+      }
+    case OMX_IndexVendorVideoDecSkip:
+      {
+        OMX_VIDEODEC_CONFIG_SKIPTYPE *pSkip;
+        pSkip = pComponentConfigStructure;
+        if ((eError = checkHeader(pComponentConfigStructure, sizeof(OMX_VIDEODEC_CONFIG_SKIPTYPE))) != OMX_ErrorNone) {
+          break;
+        }
+        if (pSkip->nPortIndex != OMX_BASE_FILTER_INPUTPORT_INDEX) {
+          return OMX_ErrorBadPortIndex;
+        }
+        pthread_mutex_lock(&omx_videodec_component_Private->skip_mutex);
+        memcpy(pSkip, &omx_videodec_component_Private->sSkipConfig, sizeof(OMX_VIDEODEC_CONFIG_SKIPTYPE));
+        pthread_mutex_unlock(&omx_videodec_component_Private->skip_mutex);
+        break;
+      }
+    default: /*Call the base component function*/
+      return omx_base_component_GetConfig(hComponent, nIndex, pComponentConfigStructure);
+  }
+  return eError;
+}
+
 OMX_ERRORTYPE omx_videodec_component_MessageHandler(OMX_COMPONENTTYPE* openmaxStandComp,internalRequestMessageType *message) {
   omx_videodec_component_PrivateType* omx_videodec_component_Private = (omx_videodec_component_PrivateType*)openmaxStandComp->pComponentPrivate;
   OMX_ERRORTYPE err;
@@ -789,6 +1416,10 @@ OMX_ERRORTYPE omx_videodec_component_MessageHandler(OMX_COMPONENTTYPE* openmaxSt
   if (message->messageType == OMX_CommandStateSet){
     if ((message->messageParam == OMX_StateExecuting ) && (omx_videodec_component_Private->state == OMX_StateIdle)) {
       omx_videodec_component_Private->isFirstBuffer = OMX_TRUE;
+      omx_videodec_component_Private->isNewBuffer = 1;
+      omx_videodec_component_Private->isDrainPending = OMX_FALSE;
+      omx_videodec_component_Private->isDraining = OMX_FALSE;
+      omx_videodec_component_Private->pEosBuffer = NULL;
     }
     else if ((message->messageParam == OMX_StateIdle ) && (omx_videodec_component_Private->state == OMX_StateLoaded)) {
       err = omx_videodec_component_Init(openmaxStandComp);
@@ -831,3 +1462,22 @@ OMX_ERRORTYPE omx_videodec_component_ComponentRoleEnum(
   }
   return OMX_ErrorNone;
 }
+
+OMX_ERRORTYPE omx_videodec_component_GetExtensionIndex(
+  OMX_HANDLETYPE hComponent,
+  OMX_STRING cParameterName,
+  OMX_INDEXTYPE* pIndexType) {
+
+  DEBUG(DEB_LEV_FUNCTION_NAME,"In  %s \n",__func__);
+
+  if(strcmp(cParameterName,VIDEO_DEC_THREADING_EXTENSION) == 0) {
+    *pIndexType = OMX_IndexVendorVideoDecThreading;
+  } else if(strcmp(cParameterName,VIDEO_DEC_LOWDELAY_EXTENSION) == 0) {
+    *pIndexType = OMX_IndexVendorVideoDecLowDelay;
+  } else if(strcmp(cParameterName,VIDEO_DEC_SKIP_EXTENSION) == 0) {
+    *pIndexType = OMX_IndexVendorVideoDecSkip;
+  } else {
+    return omx_base_component_GetExtensionIndex(hComponent, cParameterName, pIndexType);
+  }
+  return OMX_ErrorNone;
+}
@@ -57,6 +57,72 @@
 #define VIDEO_DEC_MPEG4_ROLE "video_decoder.mpeg4"
 #define VIDEO_DEC_H264_ROLE "video_decoder.avc"
 
+/** Maximum number of output buffers that can carry a direct rendered picture */
+#define VIDEO_DEC_MAX_DR_BUFFERS 32
+
+/** Extension name of the decoder threading parameter */
+#define VIDEO_DEC_THREADING_EXTENSION "OMX.ST.index.param.videodec.threading"
+
+/** Extension name of the decoder low delay config */
+#define VIDEO_DEC_LOWDELAY_EXTENSION "OMX.ST.index.config.videodec.lowdelay"
+
+/** Extension name of the decoder skip config */
+#define VIDEO_DEC_SKIP_EXTENSION "OMX.ST.index.config.videodec.skip"
+
+/** Vendor specific indexes of the video decoder */
+typedef enum OMX_VIDEODEC_INDEXVENDORTYPE {
+  OMX_IndexVendorVideoDecThreading = OMX_IndexVendorStartUnused + 0x00d00000, /**< reference: OMX_VIDEODEC_PARAM_THREADINGTYPE */
+  OMX_IndexVendorVideoDecLowDelay,                                             /**< reference: OMX_CONFIG_BOOLEANTYPE */
+  OMX_IndexVendorVideoDecSkip                                                  /**< reference: OMX_VIDEODEC_CONFIG_SKIPTYPE */
+} OMX_VIDEODEC_INDEXVENDORTYPE;
+
+/** Threading modes of the FFmpeg decoder, they can be or-ed together */
+typedef enum OMX_VIDEODEC_THREADTYPE {
+  OMX_VIDEODEC_ThreadFrame = 0x1, /**< one frame per thread, adds nThreadCount-1 frames of output delay */
+  OMX_VIDEODEC_ThreadSlice = 0x2, /**< the slices of one frame are decoded in parallel, no extra delay */
+  OMX_VIDEODEC_ThreadAny   = OMX_VIDEODEC_ThreadFrame | OMX_VIDEODEC_ThreadSlice
+} OMX_VIDEODEC_THREADTYPE;
+
+/** Decoder threading parameter, applied when the codec is opened.
+  * Frame threading is not available without codec extradata when FFmpeg has no
+  * parser for the codec, since the decoder then runs in truncated bitstream mode;
+  * slice threading is used instead.
+  * @param nThreadCount number of decoding threads, 0 selects one per CPU core
+  * @param eThreadType or-ed OMX_VIDEODEC_THREADTYPE values
+  */
+typedef struct OMX_VIDEODEC_PARAM_THREADINGTYPE {
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U32 nPortIndex;
+  OMX_U32 nThreadCount;
+  OMX_U32 eThreadType;
+} OMX_VIDEODEC_PARAM_THREADINGTYPE;
+
+/** Frames the decoder skips, or skips a decoding stage of, from the fewest to the most */
+typedef enum OMX_VIDEODEC_SKIPTYPE {
+  OMX_VIDEODEC_SkipNone = 0,  /**< nothing is skipped */
+  OMX_VIDEODEC_SkipNonRef,    /**< frames no other frame refers to */
+  OMX_VIDEODEC_SkipBidir,     /**< bidirectionally predicted frames */
+  OMX_VIDEODEC_SkipNonIntra,  /**< all frames but intra frames */
+  OMX_VIDEODEC_SkipNonKey,    /**< all frames but key frames */
+  OMX_VIDEODEC_SkipAll        /**< all frames */
+} OMX_VIDEODEC_SKIPTYPE;
+
+/** Decoder skip config, it can be changed while executing.
+  * A skipped frame gives no output buffer.
+  * @param eSkipFrame frames that are not decoded
+  * @param eSkipLoopFilter frames decoded without the loop filter
+  * @param eSkipIdct frames decoded without the inverse transform
+  */
+typedef struct OMX_VIDEODEC_CONFIG_SKIPTYPE {
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U32 nPortIndex;
+  OMX_VIDEODEC_SKIPTYPE eSkipFrame;
+  OMX_VIDEODEC_SKIPTYPE eSkipLoopFilter;
+  OMX_VIDEODEC_SKIPTYPE eSkipIdct;
+} OMX_VIDEODEC_CONFIG_SKIPTYPE;
+
 /** Video Decoder component private structure.
   */
 DERIVEDCLASS(omx_videodec_component_PrivateType, omx_base_filter_PrivateType)
@@ -65,6 +131,8 @@ DERIVEDCLASS(omx_videodec_component_PrivateType, omx_base_filter_PrivateType)
   AVCodec *avCodec; \
   /** @param avCodecContext pointer to FFmpeg decoder context  */ \
   AVCodecContext *avCodecContext;  \
+  /** @param avParser pointer to the FFmpeg parser that cuts the input into frames */ \
+  AVCodecParserContext *avParser; \
   /** @param picture pointer to FFmpeg AVFrame  */ \
   AVFrame *avFrame; \
   /** @param pVideoMpeg4 Reference to OMX_VIDEO_PARAM_MPEG4TYPE structure*/  \
@@ -90,7 +158,31 @@ DERIVEDCLASS(omx_videodec_component_PrivateType, omx_base_filter_PrivateType)
   /** @param extradata pointer to extradata*/ \
   OMX_U8* extradata; \
   /** @param extradata_size extradata size*/ \
-  OMX_U32 extradata_size;
+  OMX_U32 extradata_size; \
+  /** @param sThreadingParam decoder threading configuration */ \
+  OMX_VIDEODEC_PARAM_THREADINGTYPE sThreadingParam; \
+  /** @param bLowDelay Field that indicate each frame is output as soon as it is decoded, applied when the codec is opened */ \
+  OMX_BOOL bLowDelay; \
+  /** @param sSkipConfig decoder skip configuration */ \
+  OMX_VIDEODEC_CONFIG_SKIPTYPE sSkipConfig; \
+  /** @param skip_mutex guards sSkipConfig, set by the IL client and read by the decoding thread */ \
+  pthread_mutex_t skip_mutex; \
+  /** @param isDrainPending Field that indicate an empty EOS buffer has been queued */ \
+  OMX_BOOL isDrainPending; \
+  /** @param isDraining Field that indicate the delayed frames are being flushed at EOS */ \
+  OMX_BOOL isDraining; \
+  /** @param pEosBuffer EOS input buffer whose length is faked to 1 until the decoder is drained */ \
+  OMX_BUFFERHEADERTYPE* pEosBuffer; \
+  /** @param framePool pool of pictures laid out as output buffers, the decoder renders into them */ \
+  AVBufferPool *framePool; \
+  /** @param framePoolSize size in bytes of the pictures of framePool */ \
+  int framePoolSize; \
+  /** @param pLentFrame picture lent to each output buffer until it is given back */ \
+  AVBufferRef *pLentFrame[VIDEO_DEC_MAX_DR_BUFFERS]; \
+  /** @param pOwnBuffer memory allocated by the port for each output buffer carrying a lent picture */ \
+  OMX_U8 *pOwnBuffer[VIDEO_DEC_MAX_DR_BUFFERS]; \
+  /** @param imgConvertYuvCtx conversion context of this instance, rebuilt when the picture geometry or format changes */ \
+  struct SwsContext *imgConvertYuvCtx;
 ENDCLASS(omx_videodec_component_PrivateType)
 
 /* Component private entry points declaration */
@@ -105,6 +197,26 @@ void omx_videodec_component_BufferMgmtCallback(
   OMX_BUFFERHEADERTYPE* inputbuffer,
   OMX_BUFFERHEADERTYPE* outputbuffer);
 
+OMX_ERRORTYPE omx_videodec_component_port_SendBufferFunction(
+  omx_base_PortType *openmaxStandPort,
+  OMX_BUFFERHEADERTYPE* pBuffer);
+
+OMX_ERRORTYPE omx_videodec_component_port_ReturnBufferFunction(
+  omx_base_PortType *openmaxStandPort,
+  OMX_BUFFERHEADERTYPE* pBuffer);
+
+OMX_ERRORTYPE omx_videodec_component_port_FlushProcessingBuffers(
+  omx_base_PortType *openmaxStandPort);
+
+OMX_ERRORTYPE omx_videodec_component_port_FreeBuffer(
+  omx_base_PortType *openmaxStandPort,
+  OMX_U32 nPortIndex,
+  OMX_BUFFERHEADERTYPE* pBuffer);
+
+OMX_ERRORTYPE omx_videodec_component_port_FreeTunnelBuffer(
+  omx_base_PortType *openmaxStandPort,
+  OMX_U32 nPortIndex);
+
 OMX_ERRORTYPE omx_videodec_component_GetParameter(
   OMX_HANDLETYPE hComponent,
   OMX_INDEXTYPE nParamIndex,
@@ -127,4 +239,14 @@ OMX_ERRORTYPE omx_videodec_component_SetConfig(
   OMX_INDEXTYPE nIndex,
   OMX_PTR pComponentConfigStructure);
 
+OMX_ERRORTYPE omx_videodec_component_GetConfig(
+  OMX_HANDLETYPE hComponent,
+  OMX_INDEXTYPE nIndex,
+  OMX_PTR pComponentConfigStructure);
+
+OMX_ERRORTYPE omx_videodec_component_GetExtensionIndex(
+  OMX_HANDLETYPE hComponent,
+  OMX_STRING cParameterName,
+  OMX_INDEXTYPE* pIndexType);
+
 #endif
@@ -0,0 +1,272 @@
+/**
+  test/omxcolorconvkerneltest.c
+
+  Conversion kernel test program of the OpenMAX FFmpeg color converter
+
+  Every same size conversion kernel of the color converter, for each
+  instruction set the processor runs, is checked against sws_scale
+  converting the same frame, and its throughput is reported in Mpixel/s
+  next to the one of sws_scale. With -b only the throughputs are printed.
+
+  Copyright (C) 2007-2009  STMicroelectronics and Agere Systems
+
+  This library is free software; you can redistribute it and/or modify it under
+  the terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation; either version 2.1 of the License, or (at your option)
+  any later version.
+
+  This library is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+  FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin St, Fifth Floor, Boston, MA
+  02110-1301  USA
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "omxcolorconvkerneltest.h"
+
+/* The chroma of YUYV to 4:2:0 is the rounded average of two lines, as with the SIMD
+ * converters of swscale; its plain C converter truncates, so it may be one below.
+ * I420 to RGB is a step from the tables of swscale at most, and swscale dithers RGB565,
+ * which adds a step of the 5 and 6 bit components
+ */
+static const kernelTestCase testCases[] = {
+  { AV_PIX_FMT_RGB24,   AV_PIX_FMT_RGBA,    0, "RGB888 -> ARGB8888" },
+  { AV_PIX_FMT_YUYV422, AV_PIX_FMT_YUV420P, 1, "YUYV -> I420" },
+  { AV_PIX_FMT_YUV420P, AV_PIX_FMT_RGBA,    2, "I420 -> ARGB8888" },
+  { AV_PIX_FMT_YUV420P, AV_PIX_FMT_RGB565,  2, "I420 -> RGB565" },
+};
+
+static const kernelTestSimd testSimds[] = {
+  { COLOR_CONV_SIMD_NONE,  "C" },
+  { COLOR_CONV_SIMD_SSSE3, "SSSE3" },
+  { COLOR_CONV_SIMD_AVX2,  "AVX2" },
+  { COLOR_CONV_SIMD_NEON,  "NEON" },
+};
+
+void display_help() {
+  printf("\n");
+  printf("Usage: omxcolorconvkerneltest [-b] [-h]\n");
+  printf("\n");
+  printf("       -b: only time the kernels, do not compare them\n");
+  printf("       -h: displays this help\n");
+  printf("\n");
+  exit(1);
+}
+
+static double getTime() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+/* Allocates the planes of a frame; the line sizes are padded so that rows do not start aligned */
+static int allocFrame(kernelTestFrame* frame, enum AVPixelFormat pxlfmt) {
+  int i;
+
+  memset(frame, 0, sizeof(kernelTestFrame));
+  switch (pxlfmt) {
+    case AV_PIX_FMT_RGB24:
+      frame->linesize[0] = 3 * KERNEL_TEST_WIDTH + 5;
+      break;
+    case AV_PIX_FMT_RGBA:
+      frame->linesize[0] = 4 * KERNEL_TEST_WIDTH + 4;
+      break;
+    case AV_PIX_FMT_RGB565:
+      frame->linesize[0] = 2 * KERNEL_TEST_WIDTH + 6;
+      break;
+    case AV_PIX_FMT_YUYV422:
+      frame->linesize[0] = 2 * KERNEL_TEST_WIDTH + 6;
+      break;
+    case AV_PIX_FMT_YUV420P:
+      frame->linesize[0] = KERNEL_TEST_WIDTH + 3;
+      frame->linesize[1] = KERNEL_TEST_WIDTH / 2 + 5;
+      frame->linesize[2] = KERNEL_TEST_WIDTH / 2 + 7;
+      break;
+    default:
+      return -1;
+  }
+  for (i = 0; i < 4 && frame->linesize[i] != 0; i++) {
+    frame->size[i] = frame->linesize[i] * ((i == 0) ? KERNEL_TEST_HEIGHT : KERNEL_TEST_HEIGHT / 2);
+    frame->data[i] = malloc(frame->size[i]);
+    if (frame->data[i] == NULL) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+static void freeFrame(kernelTestFrame* frame) {
+  int i;
+
+  for (i = 0; i < 4; i++) {
+    free(frame->data[i]);
+  }
+}
+
+static void clearFrame(kernelTestFrame* frame) {
+  int i;
+
+  for (i = 0; i < 4 && frame->data[i] != NULL; i++) {
+    memset(frame->data[i], 0x5a, frame->size[i]);
+  }
+}
+
+/* Largest difference of a component of two RGB565 pixels, in steps of the component */
+static int comparePixels565(const uint8_t* a, const uint8_t* b) {
+  uint16_t pa, pb;
+  int diff, largest;
+
+  memcpy(&pa, a, sizeof(pa));
+  memcpy(&pb, b, sizeof(pb));
+  largest = abs((pa >> 11) - (pb >> 11));
+  diff = abs(((pa >> 5) & 0x3f) - ((pb >> 5) & 0x3f));
+  if (diff > largest) {
+    largest = diff;
+  }
+  diff = abs((pa & 0x1f) - (pb & 0x1f));
+  return (diff > largest) ? diff : largest;
+}
+
+/* Largest difference between two frames, padding included. The first plane of a planar frame
+ * must be the same, 256 is returned if it is not; RGB565 is compared component by component
+ */
+static int compareFrames(kernelTestFrame* a, kernelTestFrame* b, enum AVPixelFormat pxlfmt) {
+  int i, j, diff, largest = 0;
+
+  for (i = 0; i < 4 && a->data[i] != NULL; i++) {
+    for (j = 0; j < a->size[i]; j += (pxlfmt == AV_PIX_FMT_RGB565) ? 2 : 1) {
+      if (pxlfmt == AV_PIX_FMT_RGB565) {
+        diff = comparePixels565(a->data[i] + j, b->data[i] + j);
+      } else {
+        diff = abs(a->data[i][j] - b->data[i][j]);
+      }
+      if (diff > 0 && i == 0 && a->data[1] != NULL) {
+        return 256;
+      }
+      if (diff > largest) {
+        largest = diff;
+      }
+    }
+  }
+  return largest;
+}
+
+int main(int argc, char** argv) {
+  kernelTestFrame in, expected, out, reference;
+  struct SwsContext* swsCtx;
+  omx_ffmpeg_colorconv_kernel kernel, kernel_c;
+  OMX_U32 supported, k, s;
+  double start, sws_time, kernel_time;
+  double mpixels = KERNEL_TEST_WIDTH * KERNEL_TEST_HEIGHT / 1000000.0;
+  int benchmark_only = 0;
+  int failures = 0;
+  int i, j, diff;
+
+  for (i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-b") == 0) {
+      benchmark_only = 1;
+    } else {
+      display_help();
+    }
+  }
+
+  supported = omx_ffmpeg_colorconv_simd_support();
+  for (k = 0; k < sizeof(testCases) / sizeof(testCases[0]); k++) {
+    if (allocFrame(&in, testCases[k].in_pxlfmt) != 0 || allocFrame(&expected, testCases[k].out_pxlfmt) != 0 ||
+        allocFrame(&out, testCases[k].out_pxlfmt) != 0 || allocFrame(&reference, testCases[k].out_pxlfmt) != 0) {
+      printf("Out of memory\n");
+      return 1;
+    }
+    for (i = 0; i < 4 && in.data[i] != NULL; i++) {
+      for (j = 0; j < in.size[i]; j++) {
+        in.data[i][j] = (uint8_t) (((OMX_U32) j * 2654435761u) >> 13);
+      }
+    }
+
+    swsCtx = sws_getContext(KERNEL_TEST_WIDTH, KERNEL_TEST_HEIGHT, testCases[k].in_pxlfmt,
+                            KERNEL_TEST_WIDTH, KERNEL_TEST_HEIGHT, testCases[k].out_pxlfmt,
+                            SWS_FAST_BILINEAR, NULL, NULL, NULL);
+    if (swsCtx == NULL) {
+      printf("%-20s no swscale context\n", testCases[k].name);
+      return 1;
+    }
+    clearFrame(&expected);
+    sws_scale(swsCtx, (const uint8_t* const*) in.data, in.linesize, 0, KERNEL_TEST_HEIGHT, expected.data, expected.linesize);
+    start = getTime();
+    for (i = 0; i < KERNEL_TEST_ROUNDS; i++) {
+      sws_scale(swsCtx, (const uint8_t* const*) in.data, in.linesize, 0, KERNEL_TEST_HEIGHT, out.data, out.linesize);
+    }
+    sws_time = (getTime() - start) / KERNEL_TEST_ROUNDS;
+    sws_freeContext(swsCtx);
+    printf("%-20s %-6s %8.1f Mpixel/s\n", testCases[k].name, "swscale", mpixels * 1000.0 / sws_time);
+
+    clearFrame(&reference);
+    kernel_c = omx_ffmpeg_colorconv_find_kernel(testCases[k].in_pxlfmt, testCases[k].out_pxlfmt, COLOR_CONV_SIMD_NONE);
+    if (kernel_c == NULL) {
+      printf("%-20s no C kernel\n", "");
+      return 1;
+    }
+    kernel_c((const uint8_t* const*) in.data, in.linesize, reference.data, reference.linesize, KERNEL_TEST_WIDTH, KERNEL_TEST_HEIGHT);
+
+    for (s = 0; s < sizeof(testSimds) / sizeof(testSimds[0]); s++) {
+      if (testSimds[s].simd != COLOR_CONV_SIMD_NONE && !(supported & testSimds[s].simd)) {
+        continue;
+      }
+      kernel = omx_ffmpeg_colorconv_find_kernel(testCases[k].in_pxlfmt, testCases[k].out_pxlfmt, testSimds[s].simd);
+      if (testSimds[s].simd != COLOR_CONV_SIMD_NONE && kernel == kernel_c) {
+        /* the pair has no kernel of its own for the instruction set, a narrower one is used */
+        printf("%-20s %-6s no kernel\n", "", testSimds[s].name);
+        continue;
+      }
+
+      if (!benchmark_only) {
+        clearFrame(&out);
+        kernel((const uint8_t* const*) in.data, in.linesize, out.data, out.linesize, KERNEL_TEST_WIDTH, KERNEL_TEST_HEIGHT);
+        /* every instruction set gives the bytes of the C kernel, which are close to those of swscale */
+        if (compareFrames(&reference, &out, testCases[k].out_pxlfmt) != 0) {
+          printf("%-20s %-6s differs from the C kernel\n", "", testSimds[s].name);
+          failures++;
+          continue;
+        }
+        diff = compareFrames(&expected, &out, testCases[k].out_pxlfmt);
+        if (diff > testCases[k].tolerance) {
+          printf("%-20s %-6s differs from swscale\n", "", testSimds[s].name);
+          failures++;
+          continue;
+        }
+      }
+
+      start = getTime();
+      for (i = 0; i < KERNEL_TEST_ROUNDS; i++) {
+        kernel((const uint8_t* const*) in.data, in.linesize, out.data, out.linesize, KERNEL_TEST_WIDTH, KERNEL_TEST_HEIGHT);
+      }
+      kernel_time = (getTime() - start) / KERNEL_TEST_ROUNDS;
+      printf("%-20s %-6s %8.1f Mpixel/s, %.1fx%s\n", "", testSimds[s].name, mpixels * 1000.0 / kernel_time, sws_time / kernel_time,
+             (!benchmark_only && diff == 0) ? ", bit-exact" : "");
+    }
+
+    freeFrame(&in);
+    freeFrame(&expected);
+    freeFrame(&out);
+    freeFrame(&reference);
+  }
+
+  if (failures) {
+    printf("%d kernel(s) failed\n", failures);
+    return 1;
+  }
+  if (!benchmark_only) {
+    printf("All kernels match swscale\n");
+  }
+  return 0;
+}
@@ -0,0 +1,67 @@
+/**
+  test/omxcolorconvkerneltest.h
+
+  Conversion kernel test program of the OpenMAX FFmpeg color converter
+
+  Every same size conversion kernel of the color converter, for each
+  instruction set the processor runs, is checked against sws_scale
+  converting the same frame, and its throughput is reported in Mpixel/s
+  next to the one of sws_scale.
+
+  Copyright (C) 2007-2009  STMicroelectronics and Agere Systems
+
+  This library is free software; you can redistribute it and/or modify it under
+  the terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation; either version 2.1 of the License, or (at your option)
+  any later version.
+
+  This library is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+  FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin St, Fifth Floor, Boston, MA
+  02110-1301  USA
+
+*/
+
+#include <OMX_Types.h>
+#include <OMX_Core.h>
+#include <OMX_IVCommon.h>
+
+#include <omx_ffmpeg_colorconv_component.h>
+
+/* Size of the test frames */
+#define KERNEL_TEST_WIDTH  1280
+#define KERNEL_TEST_HEIGHT 720
+
+/* Frames converted per timing */
+#define KERNEL_TEST_ROUNDS 50
+
+/* Planes of a test frame */
+typedef struct kernelTestFrame {
+  uint8_t* data[4];
+  int linesize[4];
+  int size[4];
+} kernelTestFrame;
+
+/* A pair of pixel formats converted by a kernel */
+typedef struct kernelTestCase {
+  enum AVPixelFormat in_pxlfmt;
+  enum AVPixelFormat out_pxlfmt;
+  /* largest difference allowed to sws_scale: in the planes after the first one of a planar
+   * output, in each component of a packed output
+   */
+  int tolerance;
+  const char* name;
+} kernelTestCase;
+
+/* Instruction set the kernels are taken from */
+typedef struct kernelTestSimd {
+  OMX_U32 simd;
+  const char* name;
+} kernelTestSimd;
+
+void display_help();
@@ -0,0 +1,349 @@
+/**
+  test/omxcolorconvpasstest.c
+
+  Single pass test program of the OpenMAX FFmpeg color converter
+
+  The color converter converts a cropped, vertically mirrored I420 picture
+  into a RGB888 output buffer at an output position. Its output is checked
+  against the three passes the component made before: a copy of the input
+  crop rectangle into a staging buffer, sws_scale into a second staging
+  buffer, and a copy of that into the output buffer at the output position.
+  The bytes moved per frame by both ways and their time per frame are
+  reported, next to the time of the single sws_scale pass alone.
+
+  Copyright (C) 2007-2009  STMicroelectronics and Agere Systems
+
+  This library is free software; you can redistribute it and/or modify it under
+  the terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation; either version 2.1 of the License, or (at your option)
+  any later version.
+
+  This library is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+  FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin St, Fifth Floor, Boston, MA
+  02110-1301  USA
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "omxcolorconvpasstest.h"
+
+OMX_CALLBACKTYPE colorconv_callbacks = {
+    .EventHandler = colorconvEventHandler,
+    .EmptyBufferDone = colorconvEmptyBufferDone,
+    .FillBufferDone = colorconvFillBufferDone
+  };
+
+appPrivateType* appPriv;
+
+void display_help() {
+  printf("\n");
+  printf("Usage: omxcolorconvpasstest [-w width] [-h height] [-n frames]\n");
+  printf("\n");
+  printf("       -w width: frame width, even, default 352\n");
+  printf("       -h height: frame height, even, default 288\n");
+  printf("       -n frames: number of frames converted, default 200\n");
+  printf("\n");
+  exit(1);
+}
+
+static double getTime() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+/* Luma and chroma planes of frame n */
+static void fillFrame(OMX_U8* buffer, OMX_U32 width, OMX_U32 height, OMX_U32 n) {
+  OMX_U32 i, size = width * height * 3 / 2;
+
+  for (i = 0; i < size; i++) {
+    buffer[i] = (OMX_U8) (((i + 977 * n) * 2654435761u) >> 13);
+  }
+}
+
+/* The three passes of the color converter before it converted in a single pass */
+static void threePasses(OMX_U8* input, OMX_U32 width, OMX_U32 height, OMX_U8* in_buffer, OMX_U8* conv_buffer,
+                        struct SwsContext* swsCtx, OMX_U8* output, OMX_S32 output_stride) {
+  OMX_U32 cpy_width = width - 2 * PASS_TEST_BORDER, cpy_height = height - 2 * PASS_TEST_BORDER;
+  uint8_t* in_data[4] = { in_buffer, in_buffer + cpy_width * cpy_height, in_buffer + cpy_width * cpy_height * 5 / 4, NULL };
+  int in_linesize[4] = { (int) cpy_width, (int) cpy_width / 2, (int) cpy_width / 2, 0 };
+  uint8_t* conv_data[4] = { conv_buffer, NULL, NULL, NULL };
+  int conv_linesize[4] = { calcStride(cpy_width, OMX_COLOR_Format24bitRGB888), 0, 0, 0 };
+
+  /* the input mirror was a negative stride of the staging buffer */
+  omx_img_copy(input, calcStride(width, OMX_COLOR_FormatYUV420Planar), width, height, PASS_TEST_BORDER, PASS_TEST_BORDER,
+               in_buffer, -calcStride(cpy_width, OMX_COLOR_FormatYUV420Planar), cpy_width, cpy_height, 0, 0,
+               (OMX_S32) cpy_width, cpy_height, OMX_COLOR_FormatYUV420Planar);
+  sws_scale(swsCtx, (const uint8_t* const*) in_data, in_linesize, 0, (int) cpy_height, conv_data, conv_linesize);
+  omx_img_copy(conv_buffer, conv_linesize[0], cpy_width, cpy_height, 0, 0,
+               output, output_stride, width, height, PASS_TEST_BORDER, PASS_TEST_BORDER,
+               (OMX_S32) cpy_width, cpy_height, OMX_COLOR_Format24bitRGB888);
+}
+
+/* The single pass: the crop and the mirror are plane pointers and line sizes handed to sws_scale */
+static void onePass(OMX_U8* input, OMX_U32 width, OMX_U32 height, struct SwsContext* swsCtx, OMX_U8* output, OMX_S32 output_stride) {
+  OMX_U32 cpy_height = height - 2 * PASS_TEST_BORDER;
+  OMX_U32 last_row = PASS_TEST_BORDER + cpy_height - 1;
+  OMX_U8* u_plane = input + width * height;
+  OMX_U8* v_plane = u_plane + width * height / 4;
+  uint8_t* src_data[4] = { input + last_row * width + PASS_TEST_BORDER,
+                           u_plane + (last_row / 2) * (width / 2) + PASS_TEST_BORDER / 2,
+                           v_plane + (last_row / 2) * (width / 2) + PASS_TEST_BORDER / 2, NULL };
+  int src_linesize[4] = { -(int) width, -(int) width / 2, -(int) width / 2, 0 };
+  uint8_t* dest_data[4] = { output + PASS_TEST_BORDER * output_stride + calcStride(PASS_TEST_BORDER, OMX_COLOR_Format24bitRGB888), NULL, NULL, NULL };
+  int dest_linesize[4] = { (int) output_stride, 0, 0, 0 };
+
+  sws_scale(swsCtx, (const uint8_t* const*) src_data, src_linesize, 0, (int) cpy_height, dest_data, dest_linesize);
+}
+
+int main(int argc, char** argv) {
+  OMX_ERRORTYPE err;
+  OMX_PARAM_PORTDEFINITIONTYPE inputDefinition, outputDefinition;
+  OMX_CONFIG_RECTTYPE crop;
+  OMX_CONFIG_MIRRORTYPE mirror;
+  OMX_CONFIG_POINTTYPE position;
+  OMX_U32 width = 352, height = 288, frames = 200;
+  OMX_U32 cpy_width, cpy_height, in_crop_bytes, out_crop_bytes, i, n;
+  OMX_U8 *input, *in_buffer, *conv_buffer, *expected, *single;
+  struct SwsContext *swsCtx, *directCtx;
+  double start, component_time, three_time, one_time;
+  int mismatch = 0;
+
+  for (i = 1; i < (OMX_U32) argc; i++) {
+    if (argv[i][0] != '-' || argv[i][1] == '\0' || argv[i][2] != '\0' || i + 1 >= (OMX_U32) argc) {
+      display_help();
+    }
+    switch (argv[i][1]) {
+      case 'w':
+        width = (OMX_U32) atoi(argv[++i]);
+        break;
+      case 'h':
+        height = (OMX_U32) atoi(argv[++i]);
+        break;
+      case 'n':
+        frames = (OMX_U32) atoi(argv[++i]);
+        break;
+      default:
+        display_help();
+    }
+  }
+  if ((width & 1) || (height & 1) || width <= 4 * PASS_TEST_BORDER || height <= 4 * PASS_TEST_BORDER || frames == 0) {
+    display_help();
+  }
+  cpy_width = width - 2 * PASS_TEST_BORDER;
+  cpy_height = height - 2 * PASS_TEST_BORDER;
+
+  appPriv = calloc(1, sizeof(appPrivateType));
+  tsem_init(&appPriv->eventSem, 0);
+  tsem_init(&appPriv->inputSem, 0);
+  tsem_init(&appPriv->outputSem, 0);
+
+  err = OMX_Init();
+  if (err != OMX_ErrorNone) {
+    printf("OMX_Init() failed\n");
+    return 1;
+  }
+  err = OMX_GetHandle(&appPriv->handle, COLOR_CONV_BASE_NAME, NULL, &colorconv_callbacks);
+  if (err != OMX_ErrorNone) {
+    printf("No color converter component found, exiting\n");
+    return 1;
+  }
+
+  setHeader(&inputDefinition, sizeof(OMX_PARAM_PORTDEFINITIONTYPE));
+  inputDefinition.nPortIndex = OMX_BASE_FILTER_INPUTPORT_INDEX;
+  OMX_GetParameter(appPriv->handle, OMX_IndexParamPortDefinition, &inputDefinition);
+  inputDefinition.format.video.nFrameWidth = width;
+  inputDefinition.format.video.nFrameHeight = height;
+  inputDefinition.format.video.eColorFormat = OMX_COLOR_FormatYUV420Planar;
+  inputDefinition.nBufferCountActual = 1;
+  OMX_SetParameter(appPriv->handle, OMX_IndexParamPortDefinition, &inputDefinition);
+  OMX_GetParameter(appPriv->handle, OMX_IndexParamPortDefinition, &inputDefinition);
+
+  setHeader(&outputDefinition, sizeof(OMX_PARAM_PORTDEFINITIONTYPE));
+  outputDefinition.nPortIndex = OMX_BASE_FILTER_OUTPUTPORT_INDEX;
+  OMX_GetParameter(appPriv->handle, OMX_IndexParamPortDefinition, &outputDefinition);
+  outputDefinition.format.video.nFrameWidth = width;
+  outputDefinition.format.video.nFrameHeight = height;
+  outputDefinition.format.video.eColorFormat = OMX_COLOR_Format24bitRGB888;
+  outputDefinition.nBufferCountActual = 1;
+  OMX_SetParameter(appPriv->handle, OMX_IndexParamPortDefinition, &outputDefinition);
+  OMX_GetParameter(appPriv->handle, OMX_IndexParamPortDefinition, &outputDefinition);
+
+  /* crop a border off the input, mirror it and put it back at the same place in the output */
+  setHeader(&crop, sizeof(OMX_CONFIG_RECTTYPE));
+  crop.nPortIndex = OMX_BASE_FILTER_INPUTPORT_INDEX;
+  crop.nLeft = PASS_TEST_BORDER;
+  crop.nTop = PASS_TEST_BORDER;
+  crop.nWidth = cpy_width;
+  crop.nHeight = cpy_height;
+  OMX_SetConfig(appPriv->handle, OMX_IndexConfigCommonInputCrop, &crop);
+  crop.nPortIndex = OMX_BASE_FILTER_OUTPUTPORT_INDEX;
+  crop.nLeft = 0;
+  crop.nTop = 0;
+  OMX_SetConfig(appPriv->handle, OMX_IndexConfigCommonOutputCrop, &crop);
+
+  setHeader(&mirror, sizeof(OMX_CONFIG_MIRRORTYPE));
+  mirror.nPortIndex = OMX_BASE_FILTER_INPUTPORT_INDEX;
+  mirror.eMirror = OMX_MirrorVertical;
+  OMX_SetConfig(appPriv->handle, OMX_IndexConfigCommonMirror, &mirror);
+
+  setHeader(&position, sizeof(OMX_CONFIG_POINTTYPE));
+  position.nPortIndex = OMX_BASE_FILTER_OUTPUTPORT_INDEX;
+  position.nX = PASS_TEST_BORDER;
+  position.nY = PASS_TEST_BORDER;
+  OMX_SetConfig(appPriv->handle, OMX_IndexConfigCommonOutputPosition, &position);
+
+  err = OMX_SendCommand(appPriv->handle, OMX_CommandStateSet, OMX_StateIdle, NULL);
+  err = OMX_AllocateBuffer(appPriv->handle, &appPriv->pInBuffer, OMX_BASE_FILTER_INPUTPORT_INDEX, NULL, inputDefinition.nBufferSize);
+  if (err != OMX_ErrorNone) {
+    printf("Unable to allocate the input buffer\n");
+    return 1;
+  }
+  err = OMX_AllocateBuffer(appPriv->handle, &appPriv->pOutBuffer, OMX_BASE_FILTER_OUTPUTPORT_INDEX, NULL, outputDefinition.nBufferSize);
+  if (err != OMX_ErrorNone) {
+    printf("Unable to allocate the output buffer\n");
+    return 1;
+  }
+  tsem_down(&appPriv->eventSem);
+  err = OMX_SendCommand(appPriv->handle, OMX_CommandStateSet, OMX_StateExecuting, NULL);
+  tsem_down(&appPriv->eventSem);
+
+  input = malloc(inputDefinition.nBufferSize);
+  in_buffer = malloc(cpy_width * cpy_height * 3 / 2);
+  conv_buffer = malloc(calcStride(cpy_width, OMX_COLOR_Format24bitRGB888) * cpy_height);
+  expected = calloc(1, outputDefinition.nBufferSize);
+  single = calloc(1, outputDefinition.nBufferSize);
+  swsCtx = sws_getContext(cpy_width, cpy_height, AV_PIX_FMT_YUV420P, cpy_width, cpy_height, AV_PIX_FMT_RGB24,
+                          SWS_FAST_BILINEAR, NULL, NULL, NULL);
+  directCtx = sws_getContext(cpy_width, cpy_height, AV_PIX_FMT_YUV420P, cpy_width, cpy_height, AV_PIX_FMT_RGB24,
+                             SWS_FAST_BILINEAR, NULL, NULL, NULL);
+  if (input == NULL || in_buffer == NULL || conv_buffer == NULL || expected == NULL || single == NULL ||
+      swsCtx == NULL || directCtx == NULL) {
+    printf("Out of memory\n");
+    return 1;
+  }
+
+  /* every frame is checked against the three passes, which are timed on their own */
+  component_time = three_time = one_time = 0;
+  for (n = 0; n < frames; n++) {
+    fillFrame(appPriv->pInBuffer->pBuffer, width, height, n);
+    memcpy(input, appPriv->pInBuffer->pBuffer, inputDefinition.nBufferSize);
+    memset(appPriv->pOutBuffer->pBuffer, 0, outputDefinition.nBufferSize);
+    appPriv->pInBuffer->nFilledLen = inputDefinition.nBufferSize;
+    appPriv->pInBuffer->nOffset = 0;
+    appPriv->pInBuffer->nFlags = 0;
+    appPriv->pOutBuffer->nFilledLen = 0;
+
+    start = getTime();
+    OMX_FillThisBuffer(appPriv->handle, appPriv->pOutBuffer);
+    err = OMX_EmptyThisBuffer(appPriv->handle, appPriv->pInBuffer);
+    if (err != OMX_ErrorNone) {
+      printf("EmptyThisBuffer failed on frame %d\n", (int) n);
+      return 1;
+    }
+    tsem_down(&appPriv->inputSem);
+    tsem_down(&appPriv->outputSem);
+    component_time += getTime() - start;
+
+    start = getTime();
+    threePasses(input, width, height, in_buffer, conv_buffer, swsCtx, expected, outputDefinition.format.video.nStride);
+    three_time += getTime() - start;
+
+    start = getTime();
+    onePass(input, width, height, directCtx, single, outputDefinition.format.video.nStride);
+    one_time += getTime() - start;
+
+    if (memcmp(appPriv->pOutBuffer->pBuffer, expected, outputDefinition.nBufferSize) != 0 ||
+        memcmp(single, expected, outputDefinition.nBufferSize) != 0) {
+      printf("Frame %d differs from the three passes\n", (int) n);
+      mismatch = 1;
+      break;
+    }
+  }
+
+  err = OMX_SendCommand(appPriv->handle, OMX_CommandStateSet, OMX_StateIdle, NULL);
+  tsem_down(&appPriv->eventSem);
+  err = OMX_SendCommand(appPriv->handle, OMX_CommandStateSet, OMX_StateLoaded, NULL);
+  OMX_FreeBuffer(appPriv->handle, OMX_BASE_FILTER_INPUTPORT_INDEX, appPriv->pInBuffer);
+  OMX_FreeBuffer(appPriv->handle, OMX_BASE_FILTER_OUTPUTPORT_INDEX, appPriv->pOutBuffer);
+  tsem_down(&appPriv->eventSem);
+  OMX_FreeHandle(appPriv->handle);
+  OMX_Deinit();
+
+  /**  Each pass reads its source rectangle and writes its destination rectangle:
+    *  the three passes move the input crop rectangle three times and the output rectangle three times
+    */
+  in_crop_bytes = calcStride(cpy_width, OMX_COLOR_FormatYUV420Planar) * cpy_height;
+  out_crop_bytes = calcStride(cpy_width, OMX_COLOR_Format24bitRGB888) * cpy_height;
+  printf("I420 %dx%d cropped to %dx%d, mirrored, to RGB888\n", (int) width, (int) height, (int) cpy_width, (int) cpy_height);
+  printf("three passes: %8d bytes moved per frame, %.3f ms per frame\n", (int) (3 * in_crop_bytes + 3 * out_crop_bytes), three_time / n);
+  printf("single pass:  %8d bytes moved per frame, %.3f ms per frame\n", (int) (in_crop_bytes + out_crop_bytes), one_time / n);
+  printf("component:    %.3f ms per frame, buffer exchange included\n", component_time / n);
+
+  sws_freeContext(swsCtx);
+  sws_freeContext(directCtx);
+  free(input);
+  free(in_buffer);
+  free(conv_buffer);
+  free(expected);
+  free(single);
+  tsem_deinit(&appPriv->eventSem);
+  tsem_deinit(&appPriv->inputSem);
+  tsem_deinit(&appPriv->outputSem);
+  if (appPriv->nErrors || mismatch) {
+    free(appPriv);
+    return 1;
+  }
+  free(appPriv);
+  printf("The single pass matches the three passes\n");
+  return 0;
+}
+
+OMX_ERRORTYPE colorconvEventHandler(
+  OMX_OUT OMX_HANDLETYPE hComponent,
+  OMX_OUT OMX_PTR pAppData,
+  OMX_OUT OMX_EVENTTYPE eEvent,
+  OMX_OUT OMX_U32 Data1,
+  OMX_OUT OMX_U32 Data2,
+  OMX_OUT OMX_PTR pEventData) {
+
+  if (eEvent == OMX_EventCmdComplete) {
+    tsem_up(&appPriv->eventSem);
+  } else if (eEvent == OMX_EventError) {
+    printf("Error %x from the color converter\n", (int) Data1);
+    appPriv->nErrors++;
+    /* a state change that failed completes no command */
+    if (Data2 == OMX_CommandStateSet) {
+      tsem_up(&appPriv->eventSem);
+    }
+  }
+  return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE colorconvEmptyBufferDone(
+  OMX_OUT OMX_HANDLETYPE hComponent,
+  OMX_OUT OMX_PTR pAppData,
+  OMX_OUT OMX_BUFFERHEADERTYPE* pBuffer) {
+
+  tsem_up(&appPriv->inputSem);
+  return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE colorconvFillBufferDone(
+  OMX_OUT OMX_HANDLETYPE hComponent,
+  OMX_OUT OMX_PTR pAppData,
+  OMX_OUT OMX_BUFFERHEADERTYPE* pBuffer) {
+
+  tsem_up(&appPriv->outputSem);
+  return OMX_ErrorNone;
+}
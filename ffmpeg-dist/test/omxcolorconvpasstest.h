@@ -0,0 +1,75 @@
+/**
+  test/omxcolorconvpasstest.h
+
+  Single pass test program of the OpenMAX FFmpeg color converter
+
+  The color converter converts a cropped, mirrored I420 picture into a RGB888
+  output buffer at an output position. Its output is checked against the three
+  passes the component made before (crop copy, sws_scale, position copy), and
+  the bytes moved per frame and the time per frame of both are reported.
+
+  Copyright (C) 2007-2009  STMicroelectronics and Agere Systems
+
+  This library is free software; you can redistribute it and/or modify it under
+  the terms of the GNU Lesser General Public License as published by the Free
+  Software Foundation; either version 2.1 of the License, or (at your option)
+  any later version.
+
+  This library is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+  FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this library; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin St, Fifth Floor, Boston, MA
+  02110-1301  USA
+
+*/
+
+#include <OMX_Types.h>
+#include <OMX_Core.h>
+#include <OMX_Component.h>
+#include <OMX_IVCommon.h>
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include <bellagio/tsemaphore.h>
+
+#include <omx_ffmpeg_colorconv_component.h>
+
+/* Border cropped off each side of the input picture, and output position */
+#define PASS_TEST_BORDER 16
+
+/* Application's private data */
+typedef struct appPrivateType{
+  OMX_HANDLETYPE handle;
+  OMX_BUFFERHEADERTYPE* pInBuffer;
+  OMX_BUFFERHEADERTYPE* pOutBuffer;
+  tsem_t eventSem;
+  tsem_t inputSem;
+  tsem_t outputSem;
+  OMX_U32 nErrors;
+}appPrivateType;
+
+/* Callback prototypes */
+OMX_ERRORTYPE colorconvEventHandler(
+  OMX_OUT OMX_HANDLETYPE hComponent,
+  OMX_OUT OMX_PTR pAppData,
+  OMX_OUT OMX_EVENTTYPE eEvent,
+  OMX_OUT OMX_U32 Data1,
+  OMX_OUT OMX_U32 Data2,
+  OMX_OUT OMX_PTR pEventData);
+
+OMX_ERRORTYPE colorconvEmptyBufferDone(
+  OMX_OUT OMX_HANDLETYPE hComponent,
+  OMX_OUT OMX_PTR pAppData,
+  OMX_OUT OMX_BUFFERHEADERTYPE* pBuffer);
+
+OMX_ERRORTYPE colorconvFillBufferDone(
+  OMX_OUT OMX_HANDLETYPE hComponent,
+  OMX_OUT OMX_PTR pAppData,
+  OMX_OUT OMX_BUFFERHEADERTYPE* pBuffer);
+
+void display_help();
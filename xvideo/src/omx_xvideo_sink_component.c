@@ -29,11 +29,14 @@
 #define HEIGHT_OFFSET 10
 
 /** we assume, frame rate = 25 fps ; so one frame processing time = 40000 us */
-static OMX_U32 nFrameProcessTime = 40000; // in micro second
+#define XVIDEO_SINK_FRAME_PROCESS_TIME 40000
 
 /** Counter of sink component instance*/
 static OMX_U32 noxvideo_sinkInstance=0;
 
+/** Xlib is made thread safe once in the process, before any display is opened */
+static pthread_once_t xvideo_threads_once = PTHREAD_ONCE_INIT;
+
 /** Maximum number of sink component instances */
 #define MAX_COMPONENT_XVIDEOSINK 2
 
@@ -56,6 +59,13 @@ long GetTime() {
     return ((long)now.tv_sec) * 1000 + ((long)now.tv_usec) / 1000;
 }
 
+/** The display is used from the buffer management thread, the message handler and the client thread */
+static void omx_xvideo_sink_component_InitThreads(void) {
+  if (!XInitThreads()) {
+    DEBUG(DEB_LEV_ERR, "In %s Xlib has no thread support\n", __func__);
+  }
+}
+
 /** The Constructor
  *
  * @param openmaxStandComp is the handle to be constructed
@@ -88,9 +98,14 @@ OMX_ERRORTYPE omx_xvideo_sink_component_Constructor(OMX_COMPONENTTYPE *openmaxSt
   omx_xvideo_sink_component_Private->sPortTypesParam[OMX_PortDomainVideo].nStartPortNumber = 0;
   omx_xvideo_sink_component_Private->sPortTypesParam[OMX_PortDomainVideo].nPorts = 1;
 
+  omx_xvideo_sink_component_Private->sPortTypesParam[OMX_PortDomainOther].nStartPortNumber = 1;
+  omx_xvideo_sink_component_Private->sPortTypesParam[OMX_PortDomainOther].nPorts = 1;
+
   /** Allocate Ports and call port constructor. */
-  if ((omx_xvideo_sink_component_Private->sPortTypesParam[OMX_PortDomainVideo].nPorts )  && !omx_xvideo_sink_component_Private->ports) {
-    omx_xvideo_sink_component_Private->ports = calloc((omx_xvideo_sink_component_Private->sPortTypesParam[OMX_PortDomainVideo].nPorts ), sizeof(omx_base_PortType *));
+  if ((omx_xvideo_sink_component_Private->sPortTypesParam[OMX_PortDomainVideo].nPorts +
+       omx_xvideo_sink_component_Private->sPortTypesParam[OMX_PortDomainOther].nPorts) && !omx_xvideo_sink_component_Private->ports) {
+    omx_xvideo_sink_component_Private->ports = calloc((omx_xvideo_sink_component_Private->sPortTypesParam[OMX_PortDomainVideo].nPorts +
+                                                       omx_xvideo_sink_component_Private->sPortTypesParam[OMX_PortDomainOther].nPorts), sizeof(omx_base_PortType *));
     if (!omx_xvideo_sink_component_Private->ports) {
       return OMX_ErrorInsufficientResources;
     }
@@ -99,6 +114,13 @@ OMX_ERRORTYPE omx_xvideo_sink_component_Constructor(OMX_COMPONENTTYPE *openmaxSt
       return OMX_ErrorInsufficientResources;
     }
     base_video_port_Constructor(openmaxStandComp, &omx_xvideo_sink_component_Private->ports[0], 0, OMX_TRUE);
+
+    omx_xvideo_sink_component_Private->ports[1] = calloc(1, sizeof(omx_base_clock_PortType));
+    if (!omx_xvideo_sink_component_Private->ports[1]) {
+      return OMX_ErrorInsufficientResources;
+    }
+    base_clock_port_Constructor(openmaxStandComp, &omx_xvideo_sink_component_Private->ports[1], 1, OMX_TRUE);
+    omx_xvideo_sink_component_Private->ports[1]->sPortParam.bEnabled = OMX_FALSE;
   }
 
   pPort = (omx_xvideo_sink_component_PortType *) omx_xvideo_sink_component_Private->ports[OMX_BASE_SINK_INPUTPORT_INDEX];
@@ -144,14 +166,32 @@ OMX_ERRORTYPE omx_xvideo_sink_component_Constructor(OMX_COMPONENTTYPE *openmaxSt
   pPort->omxConfigOutputPosition.nPortIndex = OMX_BASE_SINK_INPUTPORT_INDEX;
   pPort->omxConfigOutputPosition.nX = pPort->omxConfigOutputPosition.nY = 0; //Default: No shift in output position (0,0)
 
+  setHeader(&omx_xvideo_sink_component_Private->sLateThreshold, sizeof(OMX_XVIDEO_SINK_CONFIG_LATETHRESHOLDTYPE));
+  omx_xvideo_sink_component_Private->sLateThreshold.nPortIndex = OMX_BASE_SINK_INPUTPORT_INDEX;
+  omx_xvideo_sink_component_Private->sLateThreshold.nLateThreshold = XVIDEO_SINK_DEFAULT_LATE_THRESHOLD;
+
+  /** the media clock stays stopped until the clock component says otherwise */
+  omx_xvideo_sink_component_Private->eState = OMX_TIME_ClockStateStopped;
+  omx_xvideo_sink_component_Private->xScale = 1<<16;
+  omx_xvideo_sink_component_Private->nFrameProcessTime = XVIDEO_SINK_FRAME_PROCESS_TIME;
+
   /** set the function pointers */
   omx_xvideo_sink_component_Private->destructor = omx_xvideo_sink_component_Destructor;
   omx_xvideo_sink_component_Private->BufferMgmtCallback = omx_xvideo_sink_component_BufferMgmtCallback;
   openmaxStandComp->SetParameter = omx_xvideo_sink_component_SetParameter;
   openmaxStandComp->GetParameter = omx_xvideo_sink_component_GetParameter;
+  openmaxStandComp->SetConfig = omx_xvideo_sink_component_SetConfig;
+  openmaxStandComp->GetConfig = omx_xvideo_sink_component_GetConfig;
+  openmaxStandComp->GetExtensionIndex = omx_xvideo_sink_component_GetExtensionIndex;
   omx_xvideo_sink_component_Private->messageHandler = omx_xvideo_sink_component_MessageHandler;
+  pPort->Port_SendBufferFunction = omx_xvideo_sink_component_port_SendBufferFunction;
+  pPort->Port_AllocateBuffer = omx_xvideo_sink_component_port_AllocateBuffer;
+  pPort->Port_FreeBuffer = omx_xvideo_sink_component_port_FreeBuffer;
+  pPort->ReturnBufferFunction = omx_xvideo_sink_component_port_ReturnBufferFunction;
+  pPort->FlushProcessingBuffers = omx_xvideo_sink_component_port_FlushProcessingBuffers;
 
   omx_xvideo_sink_component_Private->bIsXVideoInit = OMX_FALSE;
+  pthread_once(&xvideo_threads_once, omx_xvideo_sink_component_InitThreads);
   if(!omx_xvideo_sink_component_Private->xvideoSyncSem) {
     omx_xvideo_sink_component_Private->xvideoSyncSem = calloc(1,sizeof(tsem_t));
     if(omx_xvideo_sink_component_Private->xvideoSyncSem == NULL) {
@@ -177,7 +217,8 @@ OMX_ERRORTYPE omx_xvideo_sink_component_Destructor(OMX_COMPONENTTYPE *openmaxSta
 
   /* frees port/s */
   if (omx_xvideo_sink_component_Private->ports) {
-    for (i=0; i < (omx_xvideo_sink_component_Private->sPortTypesParam[OMX_PortDomainVideo].nPorts); i++) {
+    for (i=0; i < (omx_xvideo_sink_component_Private->sPortTypesParam[OMX_PortDomainVideo].nPorts +
+                   omx_xvideo_sink_component_Private->sPortTypesParam[OMX_PortDomainOther].nPorts); i++) {
       if(omx_xvideo_sink_component_Private->ports[i])
         omx_xvideo_sink_component_Private->ports[i]->PortDestructor(omx_xvideo_sink_component_Private->ports[i]);
     }
@@ -197,6 +238,52 @@ OMX_ERRORTYPE omx_xvideo_sink_component_Destructor(OMX_COMPONENTTYPE *openmaxSta
   return OMX_ErrorNone;
 }
 
+/** Gives back the ring images, the GC and the colormap and closes the display.
+  * @param nAttached the images of the ring the X server has attached, the others are only released here
+  */
+static void omx_xvideo_sink_component_CloseDisplay(omx_xvideo_sink_component_PrivateType* omx_xvideo_sink_component_Private, OMX_U32 nAttached) {
+  OMX_U32 i;
+
+  if (omx_xvideo_sink_component_Private->dpy == NULL) {
+    return;
+  }
+  for (i = 0; i < XVIDEO_SINK_IMAGES; i++) {
+    if (i < nAttached) {
+      XShmDetach(omx_xvideo_sink_component_Private->dpy,&omx_xvideo_sink_component_Private->yuv_shminfo[i]);
+    }
+    /** the segment is still attached here, so its id cannot have been reused yet */
+    if (omx_xvideo_sink_component_Private->yuv_shminfo[i].shmid != -1) {
+      shmctl(omx_xvideo_sink_component_Private->yuv_shminfo[i].shmid, IPC_RMID, 0);
+      omx_xvideo_sink_component_Private->yuv_shminfo[i].shmid = -1;
+    }
+    if (omx_xvideo_sink_component_Private->yuv_shminfo[i].shmaddr) {
+      shmdt(omx_xvideo_sink_component_Private->yuv_shminfo[i].shmaddr);
+      omx_xvideo_sink_component_Private->yuv_shminfo[i].shmaddr = NULL;
+    }
+    if (omx_xvideo_sink_component_Private->yuv_image[i]) {
+      XFree(omx_xvideo_sink_component_Private->yuv_image[i]);
+      omx_xvideo_sink_component_Private->yuv_image[i] = NULL;
+    }
+    omx_xvideo_sink_component_Private->bImageBusy[i] = OMX_FALSE;
+  }
+
+  if (omx_xvideo_sink_component_Private->gc) {
+    XFreeGC(omx_xvideo_sink_component_Private->dpy,omx_xvideo_sink_component_Private->gc);
+    omx_xvideo_sink_component_Private->gc = NULL;
+  }
+  if (omx_xvideo_sink_component_Private->window) {
+    XDestroyWindow(omx_xvideo_sink_component_Private->dpy,omx_xvideo_sink_component_Private->window);
+    omx_xvideo_sink_component_Private->window = 0;
+  }
+  if (omx_xvideo_sink_component_Private->xswa.colormap) {
+    XFreeColormap(omx_xvideo_sink_component_Private->dpy,omx_xvideo_sink_component_Private->xswa.colormap);
+    omx_xvideo_sink_component_Private->xswa.colormap = 0;
+  }
+
+  XCloseDisplay(omx_xvideo_sink_component_Private->dpy);
+  omx_xvideo_sink_component_Private->dpy = NULL;
+}
+
 /** The initialization function
   * This function opens the frame buffer device and allocates memory for display
   * also it finds the frame buffer supported display formats
@@ -207,8 +294,23 @@ OMX_ERRORTYPE omx_xvideo_sink_component_Init(OMX_COMPONENTTYPE *openmaxStandComp
   int yuv_width  = pPort->sPortParam.format.video.nFrameWidth;
   int yuv_height = pPort->sPortParam.format.video.nFrameHeight;
   unsigned int err,i;
+  OMX_U32 nAttached = 0;
+  OMX_ERRORTYPE omxErr;
 
   omx_xvideo_sink_component_Private->dpy = XOpenDisplay(NULL);
+  if (omx_xvideo_sink_component_Private->dpy == NULL) {
+    DEBUG(DEB_LEV_ERR, "In %s unable to open the X display\n", __func__);
+    return OMX_ErrorHardware;
+  }
+  /** nothing of the ring is made yet, a failure below only gives back what was */
+  omx_xvideo_sink_component_Private->gc = NULL;
+  omx_xvideo_sink_component_Private->window = 0;
+  omx_xvideo_sink_component_Private->xswa.colormap = 0;
+  for (i = 0; i < XVIDEO_SINK_IMAGES; i++) {
+    omx_xvideo_sink_component_Private->yuv_image[i] = NULL;
+    omx_xvideo_sink_component_Private->yuv_shminfo[i].shmid = -1;
+    omx_xvideo_sink_component_Private->yuv_shminfo[i].shmaddr = NULL;
+  }
   omx_xvideo_sink_component_Private->screen = DefaultScreen(omx_xvideo_sink_component_Private->dpy);
 
   XGetWindowAttributes(omx_xvideo_sink_component_Private->dpy,
@@ -254,8 +356,11 @@ OMX_ERRORTYPE omx_xvideo_sink_component_Init(OMX_COMPONENTTYPE *openmaxStandComp
 
   if (XShmQueryExtension(omx_xvideo_sink_component_Private->dpy))
     omx_xvideo_sink_component_Private->CompletionType = XShmGetEventBase(omx_xvideo_sink_component_Private->dpy) + ShmCompletion;
-  else
-    return OMX_ErrorUndefined;
+  else {
+    DEBUG(DEB_LEV_ERR, "In %s the X server has no MIT-SHM extension\n", __func__);
+    omxErr = OMX_ErrorUndefined;
+    goto error;
+  }
 
   if (Success !=
      XvQueryExtension(omx_xvideo_sink_component_Private->dpy,
@@ -281,29 +386,69 @@ OMX_ERRORTYPE omx_xvideo_sink_component_Init(OMX_COMPONENTTYPE *openmaxStandComp
 
   omx_xvideo_sink_component_Private->gc = XCreateGC(omx_xvideo_sink_component_Private->dpy, omx_xvideo_sink_component_Private->window, 0, 0);
 
-  omx_xvideo_sink_component_Private->yuv_image = XvShmCreateImage(omx_xvideo_sink_component_Private->dpy,
-                                                                  omx_xvideo_sink_component_Private->xv_port,
-                                                                  GUID_I420_PLANAR, 0, yuv_width,
-                                                                  yuv_height, &omx_xvideo_sink_component_Private->yuv_shminfo);
+  for (i = 0; i < XVIDEO_SINK_IMAGES; i++) {
+    omx_xvideo_sink_component_Private->yuv_image[i] = XvShmCreateImage(omx_xvideo_sink_component_Private->dpy,
+                                                                       omx_xvideo_sink_component_Private->xv_port,
+                                                                       GUID_I420_PLANAR, 0, yuv_width,
+                                                                       yuv_height, &omx_xvideo_sink_component_Private->yuv_shminfo[i]);
+    if (omx_xvideo_sink_component_Private->yuv_image[i] == NULL) {
+      DEBUG(DEB_LEV_ERR, "In %s unable to create XvShm image %d\n", __func__, (int)i);
+      omxErr = OMX_ErrorInsufficientResources;
+      goto error;
+    }
 
-  omx_xvideo_sink_component_Private->yuv_shminfo.shmid    = shmget(IPC_PRIVATE, omx_xvideo_sink_component_Private->yuv_image->data_size, IPC_CREAT | 0777);
-  omx_xvideo_sink_component_Private->yuv_shminfo.shmaddr  = (char *) shmat(omx_xvideo_sink_component_Private->yuv_shminfo.shmid, 0, 0);
-  omx_xvideo_sink_component_Private->yuv_image->data      = omx_xvideo_sink_component_Private->yuv_shminfo.shmaddr;
-  omx_xvideo_sink_component_Private->yuv_shminfo.readOnly = False;
+    omx_xvideo_sink_component_Private->yuv_shminfo[i].shmid    = shmget(IPC_PRIVATE, omx_xvideo_sink_component_Private->yuv_image[i]->data_size, IPC_CREAT | 0777);
+    if (omx_xvideo_sink_component_Private->yuv_shminfo[i].shmid == -1) {
+      DEBUG(DEB_LEV_ERR, "In %s unable to get a shared segment for image %d\n", __func__, (int)i);
+      omxErr = OMX_ErrorInsufficientResources;
+      goto error;
+    }
+    omx_xvideo_sink_component_Private->yuv_shminfo[i].shmaddr  = (char *) shmat(omx_xvideo_sink_component_Private->yuv_shminfo[i].shmid, 0, 0);
+    if (omx_xvideo_sink_component_Private->yuv_shminfo[i].shmaddr == (char *) -1) {
+      DEBUG(DEB_LEV_ERR, "In %s unable to attach the shared segment of image %d\n", __func__, (int)i);
+      omx_xvideo_sink_component_Private->yuv_shminfo[i].shmaddr = NULL;
+      omxErr = OMX_ErrorInsufficientResources;
+      goto error;
+    }
+    omx_xvideo_sink_component_Private->yuv_image[i]->data      = omx_xvideo_sink_component_Private->yuv_shminfo[i].shmaddr;
+    omx_xvideo_sink_component_Private->yuv_shminfo[i].readOnly = False;
+
+    if (!XShmAttach(omx_xvideo_sink_component_Private->dpy, &omx_xvideo_sink_component_Private->yuv_shminfo[i])) {
+      DEBUG(DEB_LEV_ERR, "In %s the X server could not attach image %d\n", __func__, (int)i);
+      omxErr = OMX_ErrorUndefined;
+      goto error;
+    }
+    nAttached = i + 1;
+    omx_xvideo_sink_component_Private->bImageBusy[i] = OMX_FALSE;
+  }
 
-  if (!XShmAttach(omx_xvideo_sink_component_Private->dpy, &omx_xvideo_sink_component_Private->yuv_shminfo)) {
-    printf("XShmAttach go boom boom!\n");
-    return OMX_ErrorUndefined;
+  /** once the server has attached the segments they can be marked for removal,
+    * so that they go away with the last detach even if the process dies
+    */
+  XSync(omx_xvideo_sink_component_Private->dpy, False);
+  for (i = 0; i < XVIDEO_SINK_IMAGES; i++) {
+    shmctl(omx_xvideo_sink_component_Private->yuv_shminfo[i].shmid, IPC_RMID, 0);
+    omx_xvideo_sink_component_Private->yuv_shminfo[i].shmid = -1;
   }
+  omx_xvideo_sink_component_Private->nNextImage = 0;
+  omx_xvideo_sink_component_Private->window_width = yuv_width;
+  omx_xvideo_sink_component_Private->window_height = yuv_height;
+  omx_xvideo_sink_component_Private->pShownBuffer = NULL;
+  omx_xvideo_sink_component_Private->nHeldBuffers = 0;
 
   omx_xvideo_sink_component_Private->old_time = 0;
   omx_xvideo_sink_component_Private->new_time = 0;
+  omx_xvideo_sink_component_Private->dropFrameCount = 0;
+  omx_xvideo_sink_component_Private->lateFrameCount = 0;
 
   omx_xvideo_sink_component_Private->bIsXVideoInit = OMX_TRUE;
-  /*Signal XVideo Initialized*/
-  tsem_up(omx_xvideo_sink_component_Private->xvideoSyncSem);
 
   return OMX_ErrorNone;
+
+error:
+  /** every failure once the display is open gives back what was made of the window and the ring so far */
+  omx_xvideo_sink_component_CloseDisplay(omx_xvideo_sink_component_Private, nAttached);
+  return omxErr;
 }
 
 /** The deinitialization function
@@ -314,65 +459,778 @@ OMX_ERRORTYPE omx_xvideo_sink_component_Deinit(OMX_COMPONENTTYPE *openmaxStandCo
 
   omx_xvideo_sink_component_Private->bIsXVideoInit = OMX_FALSE;
 
-  XShmDetach(omx_xvideo_sink_component_Private->dpy,&omx_xvideo_sink_component_Private->yuv_shminfo);
+  if (omx_xvideo_sink_component_Private->dpy) {
+    /** let the server finish reading the images still in flight */
+    XSync(omx_xvideo_sink_component_Private->dpy, False);
+    omx_xvideo_sink_component_CloseDisplay(omx_xvideo_sink_component_Private, XVIDEO_SINK_IMAGES);
+  }
+
+  if(omx_xvideo_sink_component_Private->xvideoSyncSem) {
+    tsem_reset(omx_xvideo_sink_component_Private->xvideoSyncSem);
+  }
 
-  shmdt(omx_xvideo_sink_component_Private->yuv_shminfo.shmaddr);
+  return OMX_ErrorNone;
+}
 
-  XFreeGC(omx_xvideo_sink_component_Private->dpy,omx_xvideo_sink_component_Private->gc);
 
-  XFreeColormap(omx_xvideo_sink_component_Private->dpy,omx_xvideo_sink_component_Private->xswa.colormap);
+/** @brief the entry point for sending buffers to the xvideo sink port
+ *
+ * This function can be called by the EmptyThisBuffer or FillThisBuffer. It depends on
+ * the nature of the port, that can be an input or output port.
+ */
+OMX_ERRORTYPE omx_xvideo_sink_component_port_SendBufferFunction(omx_base_PortType *openmaxStandPort, OMX_BUFFERHEADERTYPE* pBuffer) {
+
+  OMX_ERRORTYPE                   err;
+  OMX_U32                         portIndex;
+  OMX_COMPONENTTYPE*              omxComponent = openmaxStandPort->standCompContainer;
+  omx_base_component_PrivateType* omx_base_component_Private = (omx_base_component_PrivateType*)omxComponent->pComponentPrivate;
+  OMX_BOOL                        SendFrame;
+  omx_base_clock_PortType*        pClockPort;
+  int errQue;
+#if NO_GST_OMX_PATCH
+  unsigned int i;
+#endif
+
+  portIndex = (openmaxStandPort->sPortParam.eDir == OMX_DirInput)?pBuffer->nInputPortIndex:pBuffer->nOutputPortIndex;
+  DEBUG(DEB_LEV_FUNCTION_NAME, "In %s portIndex %lu\n", __func__, portIndex);
+
+  if (portIndex != openmaxStandPort->sPortParam.nPortIndex) {
+    DEBUG(DEB_LEV_ERR, "In %s: wrong port for this operation portIndex=%d port->portIndex=%d\n",
+           __func__, (int)portIndex, (int)openmaxStandPort->sPortParam.nPortIndex);
+    return OMX_ErrorBadPortIndex;
+  }
 
-  XCloseDisplay(omx_xvideo_sink_component_Private->dpy);
+  if(omx_base_component_Private->state == OMX_StateInvalid) {
+    DEBUG(DEB_LEV_ERR, "In %s: we are in OMX_StateInvalid\n", __func__);
+    return OMX_ErrorInvalidState;
+  }
+
+  if(omx_base_component_Private->state != OMX_StateExecuting &&
+    omx_base_component_Private->state != OMX_StatePause &&
+    omx_base_component_Private->state != OMX_StateIdle) {
+    DEBUG(DEB_LEV_ERR, "In %s: we are not in executing/paused/idle state, but in %d\n", __func__, omx_base_component_Private->state);
+    return OMX_ErrorIncorrectStateOperation;
+  }
+  if (!PORT_IS_ENABLED(openmaxStandPort) || (PORT_IS_BEING_DISABLED(openmaxStandPort) && !PORT_IS_TUNNELED_N_BUFFER_SUPPLIER(openmaxStandPort)) ||
+      (omx_base_component_Private->transientState == OMX_TransStateExecutingToIdle &&
+      (PORT_IS_TUNNELED(openmaxStandPort) && !PORT_IS_BUFFER_SUPPLIER(openmaxStandPort)))) {
+    DEBUG(DEB_LEV_ERR, "In %s: Port %d is disabled comp = %s \n", __func__, (int)portIndex,omx_base_component_Private->name);
+    return OMX_ErrorIncorrectStateOperation;
+  }
+
+  /* Temporarily disable this check for gst-openmax */
+#if NO_GST_OMX_PATCH
+  {
+  OMX_BOOL foundBuffer = OMX_FALSE;
+  if(pBuffer!=NULL && pBuffer->pBuffer!=NULL) {
+    for(i=0; i < openmaxStandPort->sPortParam.nBufferCountActual; i++){
+    if (pBuffer->pBuffer == openmaxStandPort->pInternalBufferStorage[i]->pBuffer) {
+      foundBuffer = OMX_TRUE;
+      break;
+    }
+    }
+  }
+  if (!foundBuffer) {
+    return OMX_ErrorBadParameter;
+  }
+  }
+#endif
+
+  if ((err = checkHeader(pBuffer, sizeof(OMX_BUFFERHEADERTYPE))) != OMX_ErrorNone) {
+    DEBUG(DEB_LEV_ERR, "In %s: received wrong buffer header on input port\n", __func__);
+    return err;
+  }
+
+  pClockPort  = (omx_base_clock_PortType*)omx_base_component_Private->ports[OMX_BASE_SINK_CLOCKPORT_INDEX];
+  if(PORT_IS_TUNNELED(pClockPort) && !PORT_IS_BEING_FLUSHED(openmaxStandPort) &&
+      (omx_base_component_Private->transientState != OMX_TransStateExecutingToIdle) &&
+      ((pBuffer->nFlags & OMX_BUFFERFLAG_EOS) != OMX_BUFFERFLAG_EOS)){
+    SendFrame = omx_xvideo_sink_component_ClockPortHandleFunction((omx_xvideo_sink_component_PrivateType*)omx_base_component_Private, pBuffer);
+    /* drop the frame */
+    if(!SendFrame) pBuffer->nFilledLen=0;
+  }
+
+  /* And notify the buffer management thread we have a fresh new buffer to manage */
+  if(!PORT_IS_BEING_FLUSHED(openmaxStandPort) && !(PORT_IS_BEING_DISABLED(openmaxStandPort) && PORT_IS_TUNNELED_N_BUFFER_SUPPLIER(openmaxStandPort))){
+      errQue = queue(openmaxStandPort->pBufferQueue, pBuffer);
+      if (errQue) {
+    	  return OMX_ErrorInsufficientResources;
+      }
+      tsem_up(openmaxStandPort->pBufferSem);
+      DEBUG(DEB_LEV_FULL_SEQ, "In %s Signalling bMgmtSem Port Index=%d\n",__func__, (int)portIndex);
+      tsem_up(omx_base_component_Private->bMgmtSem);
+  }else if(PORT_IS_BUFFER_SUPPLIER(openmaxStandPort)){
+      DEBUG(DEB_LEV_FULL_SEQ, "In %s: Comp %s received io:%d buffer\n", __func__,omx_base_component_Private->name,(int)openmaxStandPort->sPortParam.nPortIndex);
+      errQue = queue(openmaxStandPort->pBufferQueue, pBuffer);
+      if (errQue) {
+    	  return OMX_ErrorInsufficientResources;
+      }
+      tsem_up(openmaxStandPort->pBufferSem);
+  } else { // If port being flushed and not tunneled then return error
+    DEBUG(DEB_LEV_FULL_SEQ, "In %s \n", __func__);
+    return OMX_ErrorIncorrectStateOperation;
+  }
+  return OMX_ErrorNone;
+}
+
+/** Waits at most nTimeout milliseconds for a buffer from the clock component, so that a clock that
+ * stops sending cannot block the caller for ever. The wait ends early when either port is flushed or
+ * the component goes to idle. Returns OMX_TRUE when a clock buffer is ready to be dequeued.
+ */
+static OMX_BOOL omx_xvideo_sink_component_ClockWait(omx_xvideo_sink_component_PrivateType* omx_xvideo_sink_component_Private, OMX_U32 nTimeout) {
+  omx_base_clock_PortType* pClockPort = (omx_base_clock_PortType*)omx_xvideo_sink_component_Private->ports[OMX_BASE_SINK_CLOCKPORT_INDEX];
+  omx_base_PortType*       pPort = omx_xvideo_sink_component_Private->ports[OMX_BASE_SINK_INPUTPORT_INDEX];
+  tsem_t*                  pSem = pClockPort->pBufferSem;
+  struct timeval           now;
+  struct timespec          slice;
+  OMX_S64                  nNow;
+  OMX_S64                  nEnd;
+  OMX_BOOL                 bReady;
+
+  gettimeofday(&now, NULL);
+  nNow = (OMX_S64)now.tv_sec * 1000000 + now.tv_usec;
+  nEnd = nNow + (OMX_S64)nTimeout * 1000;
+
+  pthread_mutex_lock(&pSem->mutex);
+  while(pSem->semval == 0 && nNow < nEnd &&
+        !PORT_IS_BEING_FLUSHED(pPort) && !PORT_IS_BEING_FLUSHED(pClockPort) &&
+        omx_xvideo_sink_component_Private->transientState != OMX_TransStateExecutingToIdle) {
+    nNow += XVIDEO_SINK_CLOCK_WAIT_SLICE * 1000;
+    if(nNow > nEnd) {
+      nNow = nEnd;
+    }
+    slice.tv_sec  = nNow / 1000000;
+    slice.tv_nsec = (nNow % 1000000) * 1000;
+    pthread_cond_timedwait(&pSem->condition, &pSem->mutex, &slice);
+    gettimeofday(&now, NULL);
+    nNow = (OMX_S64)now.tv_sec * 1000000 + now.tv_usec;
+  }
+  bReady = (pSem->semval > 0) ? OMX_TRUE : OMX_FALSE;
+  if(bReady) {
+    pSem->semval--;
+  }
+  pthread_mutex_unlock(&pSem->mutex);
+
+  if(!bReady && nNow >= nEnd) {
+    DEBUG(DEB_LEV_ERR, "In %s no answer from the clock after %d ms\n", __func__, (int)nTimeout);
+  }
+  return bReady;
+}
+
+/** Waits until the presentation time of the input buffer, as told by the clock component.
+  * At a scale other than 1 (fast forward, rewind) frames are still shown: the clock fulfills the
+  * requests against its scaled media time
+  * @return OMX_FALSE if the frame must be dropped: the clock is not running, or the frame is
+  * later than the late threshold by the time it could be shown
+  */
+OMX_BOOL omx_xvideo_sink_component_ClockPortHandleFunction(omx_xvideo_sink_component_PrivateType* omx_xvideo_sink_component_Private, OMX_BUFFERHEADERTYPE* inputbuffer){
+  omx_base_clock_PortType*            pClockPort;
+  OMX_BUFFERHEADERTYPE*               clockBuffer;
+  OMX_TIME_MEDIATIMETYPE*             pMediaTime;
+  OMX_HANDLETYPE                      hclkComponent;
+  OMX_TIME_CONFIG_TIMESTAMPTYPE       sClientTimeStamp;
+  OMX_ERRORTYPE                       err;
+  OMX_BOOL                            SendFrame=OMX_TRUE;
+  OMX_BOOL                            bFulfilled=OMX_FALSE;
+  omx_xvideo_sink_component_PortType   *pPort;
+
+  pClockPort    = (omx_base_clock_PortType*)omx_xvideo_sink_component_Private->ports[OMX_BASE_SINK_CLOCKPORT_INDEX];
+  pPort         = (omx_xvideo_sink_component_PortType *) omx_xvideo_sink_component_Private->ports[OMX_BASE_SINK_INPUTPORT_INDEX];
+  hclkComponent = pClockPort->hTunneledComponent;
+  setHeader(&pClockPort->sMediaTimeRequest, sizeof(OMX_TIME_CONFIG_MEDIATIMEREQUESTTYPE));
+
+  /* if  first time stamp is received then notify the clock component */
+  if((inputbuffer->nFlags & OMX_BUFFERFLAG_STARTTIME) == OMX_BUFFERFLAG_STARTTIME) {
+    DEBUG(DEB_LEV_FULL_SEQ,"In %s  first time stamp = %llx \n", __func__,(long long)inputbuffer->nTimeStamp);
+    inputbuffer->nFlags = 0;
+    setHeader(&sClientTimeStamp, sizeof(OMX_TIME_CONFIG_TIMESTAMPTYPE));
+    sClientTimeStamp.nPortIndex = pClockPort->nTunneledPort;
+    sClientTimeStamp.nTimestamp = inputbuffer->nTimeStamp;
+    err = OMX_SetConfig(hclkComponent, OMX_IndexConfigTimeClientStartTime, &sClientTimeStamp);
+    if(err!=OMX_ErrorNone) {
+      DEBUG(DEB_LEV_ERR,"Error %08x In OMX_SetConfig in func=%s \n",err,__func__);
+    }
+
+    /* wait for state change notification from clock src; if it comes later it is handled below */
+    if(omx_xvideo_sink_component_ClockWait(omx_xvideo_sink_component_Private, XVIDEO_SINK_CLOCK_START_TIMEOUT)) {
+      /* update the clock state and clock scale info into the xvideo sink private data */
+      if(pClockPort->pBufferQueue->nelem > 0) {
+        clockBuffer = dequeue(pClockPort->pBufferQueue);
+        pMediaTime  = (OMX_TIME_MEDIATIMETYPE*)clockBuffer->pBuffer;
+        omx_xvideo_sink_component_Private->eState = pMediaTime->eState;
+        omx_xvideo_sink_component_Private->xScale = pMediaTime->xScale;
+        pClockPort->ReturnBufferFunction((omx_base_PortType*)pClockPort,clockBuffer);
+      }
+    }
+  }
+
+  /* take the state or scale changes the clock component sent meanwhile, and any late fulfillment */
+  while(pClockPort->pBufferSem->semval > 0) {
+    tsem_down(pClockPort->pBufferSem);
+    if(pClockPort->pBufferQueue->nelem == 0) {
+      break;
+    }
+    clockBuffer = dequeue(pClockPort->pBufferQueue);
+    pMediaTime  = (OMX_TIME_MEDIATIMETYPE*)clockBuffer->pBuffer;
+    if(pMediaTime->eUpdateType==OMX_TIME_UpdateScaleChanged) {
+      omx_xvideo_sink_component_Private->xScale = pMediaTime->xScale;
+    } else if(pMediaTime->eUpdateType==OMX_TIME_UpdateClockStateChanged) {
+      omx_xvideo_sink_component_Private->eState = pMediaTime->eState;
+    }
+    pClockPort->ReturnBufferFunction((omx_base_PortType*)pClockPort,clockBuffer);
+  }
+
+  /* do not show the frame, if the clock is not running */
+  if(omx_xvideo_sink_component_Private->eState != OMX_TIME_ClockStateRunning){
+    omx_xvideo_sink_component_Private->dropFrameCount++;
+    return OMX_FALSE;
+  }
+
+  /* request the presentation time of the frame; the clock fulfills it once media time gets there,
+   * or at once with a negative offset if that time has already passed */
+  if(!PORT_IS_BEING_FLUSHED(pPort) && !PORT_IS_BEING_FLUSHED(pClockPort) &&
+      omx_xvideo_sink_component_Private->transientState != OMX_TransStateExecutingToIdle) {
+    pClockPort->sMediaTimeRequest.nOffset         = 0;
+    pClockPort->sMediaTimeRequest.nPortIndex      = pClockPort->nTunneledPort;
+    pClockPort->sMediaTimeRequest.pClientPrivate  = NULL;
+    pClockPort->sMediaTimeRequest.nMediaTimestamp = inputbuffer->nTimeStamp;
+    err = OMX_SetConfig(hclkComponent, OMX_IndexConfigTimeMediaTimeRequest, &pClockPort->sMediaTimeRequest);
+    if(err!=OMX_ErrorNone) {
+      DEBUG(DEB_LEV_ERR,"Error %08x In OMX_SetConfig in func=%s \n",err,__func__);
+      return SendFrame;
+    }
+
+    /* scale and state changes may come before the fulfillment */
+    while(!bFulfilled && !PORT_IS_BEING_FLUSHED(pPort) && !PORT_IS_BEING_FLUSHED(pClockPort) &&
+          omx_xvideo_sink_component_Private->transientState != OMX_TransStateExecutingToIdle) {
+      /* wait for the request fullfillment; one that comes later is returned with the notifications above.
+       * At a scale of 0 the media time stands still, the frame waits until the clock moves again */
+      if(!omx_xvideo_sink_component_ClockWait(omx_xvideo_sink_component_Private, XVIDEO_SINK_CLOCK_REQUEST_TIMEOUT)) {
+        if(omx_xvideo_sink_component_Private->xScale == 0) {
+          continue;
+        }
+        break;
+      }
+      if(pClockPort->pBufferQueue->nelem == 0) {
+        break;
+      }
+      clockBuffer = dequeue(pClockPort->pBufferQueue);
+      pMediaTime  = (OMX_TIME_MEDIATIMETYPE*)clockBuffer->pBuffer;
+      if(pMediaTime->eUpdateType==OMX_TIME_UpdateScaleChanged) {
+        /* the request stands, the clock fulfills it at the new pace */
+        omx_xvideo_sink_component_Private->xScale = pMediaTime->xScale;
+      } else if(pMediaTime->eUpdateType==OMX_TIME_UpdateClockStateChanged) {
+        omx_xvideo_sink_component_Private->eState = pMediaTime->eState;
+        if(pMediaTime->eState != OMX_TIME_ClockStateRunning) {
+          SendFrame = OMX_FALSE;
+          bFulfilled = OMX_TRUE;
+        }
+      } else if(pMediaTime->eUpdateType==OMX_TIME_UpdateRequestFulfillment) {
+        bFulfilled = OMX_TRUE;
+        if(pMediaTime->nOffset < -((OMX_TICKS) omx_xvideo_sink_component_Private->sLateThreshold.nLateThreshold)) {
+          DEBUG(DEB_LEV_SIMPLE_SEQ,"In %s dropping frame %lld late by %lld us\n", __func__,
+                (long long)inputbuffer->nTimeStamp, (long long)-pMediaTime->nOffset);
+          SendFrame = OMX_FALSE;
+        } else if(pMediaTime->nOffset < 0) {
+          omx_xvideo_sink_component_Private->lateFrameCount++;
+        }
+      }
+      pClockPort->ReturnBufferFunction((omx_base_PortType*)pClockPort,clockBuffer);
+    }
+  }
+
+  if(!SendFrame) {
+    omx_xvideo_sink_component_Private->dropFrameCount++;
+  }
+  return(SendFrame);
+}
+
+/** Takes the next event from the X server and handles it, the display is locked by the caller.
+  * ShmCompletion frees the image it reports, ConfigureNotify updates the window size
+  * frames are scaled to, so that no round trip to the server is needed per frame.
+  */
+static void omx_xvideo_sink_component_HandleEvent(omx_xvideo_sink_component_PrivateType* omx_xvideo_sink_component_Private) {
+  XShmCompletionEvent* pCompletion;
+  OMX_U32 i;
+
+  XNextEvent(omx_xvideo_sink_component_Private->dpy, &omx_xvideo_sink_component_Private->event);
+  if (omx_xvideo_sink_component_Private->event.type == omx_xvideo_sink_component_Private->CompletionType) {
+    pCompletion = (XShmCompletionEvent*) &omx_xvideo_sink_component_Private->event;
+    for (i = 0; i < XVIDEO_SINK_IMAGES; i++) {
+      if (omx_xvideo_sink_component_Private->yuv_shminfo[i].shmseg == pCompletion->shmseg) {
+        omx_xvideo_sink_component_Private->bImageBusy[i] = OMX_FALSE;
+      }
+    }
+    for (i = 0; i < XVIDEO_SINK_MAX_BUFFERS; i++) {
+      if (omx_xvideo_sink_component_Private->buffer_image[i] != NULL &&
+          omx_xvideo_sink_component_Private->buffer_shminfo[i].shmseg == pCompletion->shmseg) {
+        omx_xvideo_sink_component_Private->bBufferImageBusy[i] = OMX_FALSE;
+      }
+    }
+  } else if (omx_xvideo_sink_component_Private->event.type == ConfigureNotify) {
+    omx_xvideo_sink_component_Private->window_width = omx_xvideo_sink_component_Private->event.xconfigure.width;
+    omx_xvideo_sink_component_Private->window_height = omx_xvideo_sink_component_Private->event.xconfigure.height;
+  }
+}
+
+/** Handles the events the X server has queued, without waiting for any
+  */
+static void omx_xvideo_sink_component_HandleEvents(omx_xvideo_sink_component_PrivateType* omx_xvideo_sink_component_Private) {
+  XLockDisplay(omx_xvideo_sink_component_Private->dpy);
+  while (XPending(omx_xvideo_sink_component_Private->dpy) > 0) {
+    omx_xvideo_sink_component_HandleEvent(omx_xvideo_sink_component_Private);
+  }
+  XUnlockDisplay(omx_xvideo_sink_component_Private->dpy);
+}
+
+/** Handles the events of the X server until the image flag pBusy is cleared,
+  * for XVIDEO_SINK_COMPLETION_TIMEOUT milliseconds at most.
+  * The display is not locked while waiting, the other threads go on using it.
+  * @return OMX_FALSE if the server did not finish reading the image in time
+  */
+static OMX_BOOL omx_xvideo_sink_component_WaitImage(omx_xvideo_sink_component_PrivateType* omx_xvideo_sink_component_Private, OMX_BOOL* pBusy) {
+  struct pollfd pfd;
+  long deadline = GetTime() + XVIDEO_SINK_COMPLETION_TIMEOUT;
+  long remaining;
+
+  pfd.fd = ConnectionNumber(omx_xvideo_sink_component_Private->dpy);
+  pfd.events = POLLIN;
+  omx_xvideo_sink_component_HandleEvents(omx_xvideo_sink_component_Private);
+  while (omx_xvideo_sink_component_Private->bIsXVideoInit && *pBusy) {
+    remaining = deadline - GetTime();
+    if (remaining <= 0) {
+      DEBUG(DEB_LEV_ERR, "In %s no ShmCompletion from the X server after %d ms\n", __func__, XVIDEO_SINK_COMPLETION_TIMEOUT);
+      return OMX_FALSE;
+    }
+    pfd.revents = 0;
+    if (poll(&pfd, 1, (int) remaining) > 0) {
+      omx_xvideo_sink_component_HandleEvents(omx_xvideo_sink_component_Private);
+    }
+  }
+  return OMX_TRUE;
+}
 
+/** Returns the input buffer slot whose XvShm image data is pBuffer, or -1 for a plain buffer
+  */
+static OMX_S32 omx_xvideo_sink_component_BufferImage(omx_xvideo_sink_component_PrivateType* omx_xvideo_sink_component_Private, OMX_U8* pBuffer) {
+  OMX_S32 i;
+
+  if (pBuffer == NULL) {
+    return -1;
+  }
+  for (i = 0; i < XVIDEO_SINK_MAX_BUFFERS; i++) {
+    if (omx_xvideo_sink_component_Private->buffer_image[i] != NULL &&
+        (OMX_U8*) omx_xvideo_sink_component_Private->buffer_image[i]->data == pBuffer) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/** Returns the held input buffers the X server has finished reading, oldest first.
+  * Buffers are held while their image is read, but no more than nKeep of them,
+  * waiting for the server to finish the oldest ones beyond that.
+  */
+static void omx_xvideo_sink_component_ReturnHeldBuffers(omx_xvideo_sink_component_PrivateType* omx_xvideo_sink_component_Private,
+                                                        omx_base_PortType *openmaxStandPort,
+                                                        OMX_U32 nKeep) {
+  OMX_BUFFERHEADERTYPE* pBuffer;
+  OMX_S32 nImage;
+  OMX_U32 i;
+
+  if (omx_xvideo_sink_component_Private->bIsXVideoInit) {
+    omx_xvideo_sink_component_HandleEvents(omx_xvideo_sink_component_Private);
+  }
+  while (omx_xvideo_sink_component_Private->nHeldBuffers > 0) {
+    pBuffer = omx_xvideo_sink_component_Private->pHeldBuffer[0];
+    nImage = omx_xvideo_sink_component_BufferImage(omx_xvideo_sink_component_Private, pBuffer->pBuffer);
+    if (nImage >= 0 && omx_xvideo_sink_component_Private->bBufferImageBusy[nImage]) {
+      if (omx_xvideo_sink_component_Private->nHeldBuffers <= nKeep) {
+        break;
+      }
+      if (omx_xvideo_sink_component_Private->bIsXVideoInit) {
+        omx_xvideo_sink_component_WaitImage(omx_xvideo_sink_component_Private, &omx_xvideo_sink_component_Private->bBufferImageBusy[nImage]);
+      }
+      omx_xvideo_sink_component_Private->bBufferImageBusy[nImage] = OMX_FALSE;
+    }
+    omx_xvideo_sink_component_Private->nHeldBuffers--;
+    for (i = 0; i < omx_xvideo_sink_component_Private->nHeldBuffers; i++) {
+      omx_xvideo_sink_component_Private->pHeldBuffer[i] = omx_xvideo_sink_component_Private->pHeldBuffer[i + 1];
+    }
+    base_port_ReturnBufferFunction(openmaxStandPort, pBuffer);
+  }
+}
+
+/** Returns the bytes of a tightly packed I420 picture of width x height */
+static OMX_U32 omx_xvideo_sink_component_FrameSize(OMX_U32 width, OMX_U32 height) {
+  return width * height + 2 * (width / 2) * (height / 2);
+}
+
+/** Copies a tightly packed I420 frame into an XvShm image of the ring, plane by plane at the
+  * pitches and offsets of the image, which the X server may pad.
+  * @param nFilledLen the bytes of the frame, a shorter frame is not copied
+  * @return OMX_FALSE if the frame holds less than a picture of width x height
+  */
+static OMX_BOOL omx_xvideo_sink_component_CopyFrame(XvImage* pImage, OMX_U8* pFrame, OMX_U32 nFilledLen, OMX_U32 width, OMX_U32 height) {
+  OMX_U32 plane_width, plane_height, image_height, row_bytes, p, y;
+  OMX_U8* src = pFrame;
+
+  if (nFilledLen < omx_xvideo_sink_component_FrameSize(width, height) || pImage->num_planes < 3) {
+    return OMX_FALSE;
+  }
+  for (p = 0; p < 3; p++) {
+    plane_width = (p == 0) ? width : width / 2;
+    plane_height = (p == 0) ? height : height / 2;
+    image_height = (p == 0) ? (OMX_U32) pImage->height : (OMX_U32) pImage->height / 2;
+    row_bytes = plane_width < (OMX_U32) pImage->pitches[p] ? plane_width : (OMX_U32) pImage->pitches[p];
+    for (y = 0; y < plane_height && y < image_height; y++) {
+      memcpy(pImage->data + pImage->offsets[p] + y * pImage->pitches[p], src + y * plane_width, row_bytes);
+    }
+    src += plane_width * plane_height;
+  }
+  return OMX_TRUE;
+}
+
+/** Input buffers are the data areas of XvShm images, so that the producer writes straight into
+  * memory shared with the X server and the frame is put without a copy.
+  * Only tightly packed I420 images can stand in for a buffer; otherwise, or when the display is not
+  * open, buffers are allocated by the base port as usual.
+  */
+OMX_ERRORTYPE omx_xvideo_sink_component_port_AllocateBuffer(
+  omx_base_PortType *openmaxStandPort,
+  OMX_BUFFERHEADERTYPE** pBuffer,
+  OMX_U32 nPortIndex,
+  OMX_PTR pAppPrivate,
+  OMX_U32 nSizeBytes) {
+
+  omx_xvideo_sink_component_PrivateType* omx_xvideo_sink_component_Private = openmaxStandPort->standCompContainer->pComponentPrivate;
+  int width = openmaxStandPort->sPortParam.format.video.nFrameWidth;
+  int height = openmaxStandPort->sPortParam.format.video.nFrameHeight;
+  XShmSegmentInfo* pShminfo;
+  XvImage* pImage;
+  OMX_ERRORTYPE err;
+  OMX_U32 i;
+
+  if (omx_xvideo_sink_component_Private->transientState == OMX_TransStateLoadedToIdle || openmaxStandPort->bIsTransientToEnabled) {
+    /** the display is opened on the way to idle or when the port is enabled, wait until it is */
+    tsem_down(omx_xvideo_sink_component_Private->xvideoSyncSem);
+    tsem_up(omx_xvideo_sink_component_Private->xvideoSyncSem);
+  }
+
+  err = base_port_AllocateBuffer(openmaxStandPort, pBuffer, nPortIndex, pAppPrivate, nSizeBytes);
+  if (err != OMX_ErrorNone || !omx_xvideo_sink_component_Private->bIsXVideoInit) {
+    return err;
+  }
+  for (i = 0; i < openmaxStandPort->sPortParam.nBufferCountActual; i++) {
+    if (openmaxStandPort->pInternalBufferStorage[i] == *pBuffer) {
+      break;
+    }
+  }
+  if (i >= XVIDEO_SINK_MAX_BUFFERS || (width & 1) || (height & 1)) {
+    return OMX_ErrorNone;
+  }
+
+  pShminfo = &omx_xvideo_sink_component_Private->buffer_shminfo[i];
+  XLockDisplay(omx_xvideo_sink_component_Private->dpy);
+  pImage = XvShmCreateImage(omx_xvideo_sink_component_Private->dpy,
+                            omx_xvideo_sink_component_Private->xv_port,
+                            GUID_I420_PLANAR, 0, width, height, pShminfo);
+  if (pImage == NULL) {
+    XUnlockDisplay(omx_xvideo_sink_component_Private->dpy);
+    return OMX_ErrorNone;
+  }
+  if (pImage->num_planes != 3 || pImage->pitches[0] != width || pImage->pitches[1] != width / 2 || pImage->pitches[2] != width / 2 ||
+      pImage->offsets[1] != width * height || pImage->offsets[2] != width * height + (width / 2) * (height / 2)) {
+    /** the server pads the planes, the frames do not fit the image as they are laid out */
+    DEBUG(DEB_LEV_SIMPLE_SEQ, "In %s XvShm image layout differs from the frames, buffer %p is plain memory\n", __func__, *pBuffer);
+    XFree(pImage);
+    XUnlockDisplay(omx_xvideo_sink_component_Private->dpy);
+    return OMX_ErrorNone;
+  }
+
+  pShminfo->shmid = shmget(IPC_PRIVATE, pImage->data_size > (int) nSizeBytes ? pImage->data_size : (int) nSizeBytes, IPC_CREAT | 0777);
+  if (pShminfo->shmid < 0) {
+    XFree(pImage);
+    XUnlockDisplay(omx_xvideo_sink_component_Private->dpy);
+    return OMX_ErrorNone;
+  }
+  pShminfo->shmaddr = (char *) shmat(pShminfo->shmid, 0, 0);
+  pShminfo->readOnly = False;
+  if (pShminfo->shmaddr == (char *) -1 || !XShmAttach(omx_xvideo_sink_component_Private->dpy, pShminfo)) {
+    if (pShminfo->shmaddr != (char *) -1) {
+      shmdt(pShminfo->shmaddr);
+    }
+    shmctl(pShminfo->shmid, IPC_RMID, 0);
+    XFree(pImage);
+    XUnlockDisplay(omx_xvideo_sink_component_Private->dpy);
+    return OMX_ErrorNone;
+  }
+  XSync(omx_xvideo_sink_component_Private->dpy, False);
+  shmctl(pShminfo->shmid, IPC_RMID, 0);
+
+  pImage->data = pShminfo->shmaddr;
+  omx_xvideo_sink_component_Private->buffer_image[i] = pImage;
+  omx_xvideo_sink_component_Private->bBufferImageBusy[i] = OMX_FALSE;
+  XUnlockDisplay(omx_xvideo_sink_component_Private->dpy);
+  DEBUG(DEB_LEV_SIMPLE_SEQ, "In %s input buffer %p is XvShm image %d\n", __func__, *pBuffer, (int)i);
+  free((*pBuffer)->pBuffer);
+  (*pBuffer)->pBuffer = (OMX_U8*) pImage->data;
+  return OMX_ErrorNone;
+}
+
+/** XvShm images of input buffers are detached and freed here, the base port frees the rest
+  */
+OMX_ERRORTYPE omx_xvideo_sink_component_port_FreeBuffer(
+  omx_base_PortType *openmaxStandPort,
+  OMX_U32 nPortIndex,
+  OMX_BUFFERHEADERTYPE* pBuffer) {
+
+  omx_xvideo_sink_component_PrivateType* omx_xvideo_sink_component_Private = openmaxStandPort->standCompContainer->pComponentPrivate;
+  OMX_S32 nImage;
+
+  nImage = omx_xvideo_sink_component_BufferImage(omx_xvideo_sink_component_Private, pBuffer != NULL ? pBuffer->pBuffer : NULL);
+  if (nImage >= 0) {
+    XLockDisplay(omx_xvideo_sink_component_Private->dpy);
+    XShmDetach(omx_xvideo_sink_component_Private->dpy, &omx_xvideo_sink_component_Private->buffer_shminfo[nImage]);
+    shmdt(omx_xvideo_sink_component_Private->buffer_shminfo[nImage].shmaddr);
+    XFree(omx_xvideo_sink_component_Private->buffer_image[nImage]);
+    omx_xvideo_sink_component_Private->buffer_image[nImage] = NULL;
+    omx_xvideo_sink_component_Private->bBufferImageBusy[nImage] = OMX_FALSE;
+    XUnlockDisplay(omx_xvideo_sink_component_Private->dpy);
+    pBuffer->pBuffer = NULL;
+  }
+  return base_port_FreeBuffer(openmaxStandPort, nPortIndex, pBuffer);
+}
+
+/** The X server reads the image of the buffer just put after the put returns, so the buffer is held
+  * until its ShmCompletion arrives. One buffer at least is left to the producer.
+  */
+OMX_ERRORTYPE omx_xvideo_sink_component_port_ReturnBufferFunction(omx_base_PortType *openmaxStandPort, OMX_BUFFERHEADERTYPE* pBuffer) {
+  omx_xvideo_sink_component_PrivateType* omx_xvideo_sink_component_Private = openmaxStandPort->standCompContainer->pComponentPrivate;
+  OMX_U32 nKeep;
+
+  if (pBuffer == NULL || pBuffer != omx_xvideo_sink_component_Private->pShownBuffer) {
+    return base_port_ReturnBufferFunction(openmaxStandPort, pBuffer);
+  }
+  omx_xvideo_sink_component_Private->pShownBuffer = NULL;
+  omx_xvideo_sink_component_Private->pHeldBuffer[omx_xvideo_sink_component_Private->nHeldBuffers++] = pBuffer;
+  nKeep = openmaxStandPort->sPortParam.nBufferCountActual > 1 ? openmaxStandPort->sPortParam.nBufferCountActual - 1 : 0;
+  omx_xvideo_sink_component_ReturnHeldBuffers(omx_xvideo_sink_component_Private, openmaxStandPort, nKeep);
   return OMX_ErrorNone;
 }
 
+/** @brief Releases buffers under processing.
+ * This function must be implemented in the derived classes, for the
+ * specific processing
+ */
+OMX_ERRORTYPE omx_xvideo_sink_component_port_FlushProcessingBuffers(omx_base_PortType *openmaxStandPort) {
+  omx_base_component_PrivateType* omx_base_component_Private;
+  omx_xvideo_sink_component_PrivateType* omx_xvideo_sink_component_Private;
+  OMX_BUFFERHEADERTYPE* pBuffer;
+  omx_base_clock_PortType               *pClockPort;
+  int errQue;
+
+  DEBUG(DEB_LEV_FUNCTION_NAME, "In %s\n", __func__);
+  omx_base_component_Private        = (omx_base_component_PrivateType*)openmaxStandPort->standCompContainer->pComponentPrivate;
+  omx_xvideo_sink_component_Private = (omx_xvideo_sink_component_PrivateType*) omx_base_component_Private;
+
+  pClockPort    = (omx_base_clock_PortType*) omx_xvideo_sink_component_Private->ports[OMX_BASE_SINK_CLOCKPORT_INDEX];
+
+  if(openmaxStandPort->sPortParam.eDomain!=OMX_PortDomainOther) { /* clock buffers not used in the clients buffer managment function */
+    pthread_mutex_lock(&omx_base_component_Private->flush_mutex);
+    openmaxStandPort->bIsPortFlushed=OMX_TRUE;
+    /*Signal the buffer management thread of port flush,if it is waiting for buffers*/
+    if(omx_base_component_Private->bMgmtSem->semval==0) {
+      tsem_up(omx_base_component_Private->bMgmtSem);
+    }
+
+    if(omx_base_component_Private->state==OMX_StatePause ) {
+      /*Waiting at paused state*/
+      tsem_signal(omx_base_component_Private->bStateSem);
+    }
+    DEBUG(DEB_LEV_FULL_SEQ, "In %s waiting for flush all condition port index =%d\n", __func__,(int)openmaxStandPort->sPortParam.nPortIndex);
+    /* Wait until flush is completed */
+    pthread_mutex_unlock(&omx_base_component_Private->flush_mutex);
+
+    /*Dummy signal to clock port, in case a frame is waiting for its presentation time*/
+    if(pClockPort->pBufferSem->semval == 0) {
+      tsem_up(pClockPort->pBufferSem);
+      tsem_reset(pClockPort->pBufferSem);
+    }
+    tsem_down(omx_base_component_Private->flush_all_condition);
+
+    /** the buffers still read by the X server go back with the others, once it is done with them */
+    omx_xvideo_sink_component_ReturnHeldBuffers(omx_xvideo_sink_component_Private, openmaxStandPort, 0);
+    omx_xvideo_sink_component_Private->pShownBuffer = NULL;
+  }
+
+  tsem_reset(omx_base_component_Private->bMgmtSem);
+
+  /* Flush all the buffers not under processing */
+  while (openmaxStandPort->pBufferSem->semval > 0) {
+    DEBUG(DEB_LEV_FULL_SEQ, "In %s TFlag=%x Flusing Port=%d,Semval=%d Qelem=%d\n",
+    __func__,(int)openmaxStandPort->nTunnelFlags,(int)openmaxStandPort->sPortParam.nPortIndex,
+    (int)openmaxStandPort->pBufferSem->semval,(int)openmaxStandPort->pBufferQueue->nelem);
+
+    tsem_down(openmaxStandPort->pBufferSem);
+    pBuffer = dequeue(openmaxStandPort->pBufferQueue);
+    if (PORT_IS_TUNNELED(openmaxStandPort) && !PORT_IS_BUFFER_SUPPLIER(openmaxStandPort)) {
+      DEBUG(DEB_LEV_FULL_SEQ, "In %s: Comp %s is returning io:%d buffer\n",
+        __func__,omx_base_component_Private->name,(int)openmaxStandPort->sPortParam.nPortIndex);
+      if (openmaxStandPort->sPortParam.eDir == OMX_DirInput) {
+        ((OMX_COMPONENTTYPE*)(openmaxStandPort->hTunneledComponent))->FillThisBuffer(openmaxStandPort->hTunneledComponent, pBuffer);
+      } else {
+        ((OMX_COMPONENTTYPE*)(openmaxStandPort->hTunneledComponent))->EmptyThisBuffer(openmaxStandPort->hTunneledComponent, pBuffer);
+      }
+    } else if (PORT_IS_TUNNELED_N_BUFFER_SUPPLIER(openmaxStandPort)) {
+      errQue = queue(openmaxStandPort->pBufferQueue,pBuffer);
+      if (errQue) {
+        return OMX_ErrorInsufficientResources;
+      }
+    } else {
+      (*(openmaxStandPort->BufferProcessedCallback))(
+        openmaxStandPort->standCompContainer,
+        omx_base_component_Private->callbackData,
+        pBuffer);
+    }
+  }
+  /*Port is tunneled and supplier and didn't received all it's buffer then wait for the buffers*/
+  if (PORT_IS_TUNNELED_N_BUFFER_SUPPLIER(openmaxStandPort)) {
+    while(openmaxStandPort->pBufferQueue->nelem!= openmaxStandPort->nNumAssignedBuffers){
+      tsem_down(openmaxStandPort->pBufferSem);
+      DEBUG(DEB_LEV_PARAMS, "In %s Got a buffer qelem=%d\n",__func__,openmaxStandPort->pBufferQueue->nelem);
+    }
+    tsem_reset(openmaxStandPort->pBufferSem);
+  }
+
+  pthread_mutex_lock(&omx_base_component_Private->flush_mutex);
+  openmaxStandPort->bIsPortFlushed=OMX_FALSE;
+  pthread_mutex_unlock(&omx_base_component_Private->flush_mutex);
+
+  tsem_up(omx_base_component_Private->flush_condition);
+
+  DEBUG(DEB_LEV_FUNCTION_NAME, "Out %s Port Index=%d\n", __func__,(int)openmaxStandPort->sPortParam.nPortIndex);
+  return OMX_ErrorNone;
+}
 
 /** buffer management callback function
   * takes one input buffer and displays its contents
   */
 void omx_xvideo_sink_component_BufferMgmtCallback(OMX_COMPONENTTYPE *openmaxStandComp, OMX_BUFFERHEADERTYPE* pInputBuffer) {
   omx_xvideo_sink_component_PrivateType* omx_xvideo_sink_component_Private = openmaxStandComp->pComponentPrivate;
+  omx_base_PortType*                    pPort = omx_xvideo_sink_component_Private->ports[OMX_BASE_SINK_INPUTPORT_INDEX];
+  omx_base_clock_PortType*              pClockPort = (omx_base_clock_PortType *) omx_xvideo_sink_component_Private->ports[OMX_BASE_SINK_CLOCKPORT_INDEX];
   long                                  timediff=0;
-  int d;
-  unsigned int ud, width, height;
-  Window _dw;
+  XvImage*                              pImage;
+  OMX_S32                               nImage;
 
   if (omx_xvideo_sink_component_Private->bIsXVideoInit == OMX_FALSE) {
-    DEBUG(DEB_LEV_FULL_SEQ, "In %s waiting for Xvideo Init\n",__func__);
-    //tsem_down(omx_xvideo_sink_component_Private->xvideoSyncSem);
-    //omx_xvideo_sink_component_Private->bIsXVideoInit = OMX_TRUE;
+    /** the display could not be opened, the frame is dropped */
+    DEBUG(DEB_LEV_FULL_SEQ, "In %s no display, dropping the frame\n",__func__);
+    pInputBuffer->nFilledLen = 0;
     return;
   }
 
-  /** getting current time */
-  omx_xvideo_sink_component_Private->new_time = GetTime();
-  if(omx_xvideo_sink_component_Private->old_time == 0) {
-    omx_xvideo_sink_component_Private->old_time = omx_xvideo_sink_component_Private->new_time;
+  omx_xvideo_sink_component_ReturnHeldBuffers(omx_xvideo_sink_component_Private, pPort,
+                                              pPort->sPortParam.nBufferCountActual > 1 ? pPort->sPortParam.nBufferCountActual - 1 : 0);
+
+  /** frames dropped by the clock port handling are not put */
+  if (pInputBuffer->nFilledLen == 0) {
+    return;
+  }
+
+  if (PORT_IS_TUNNELED(pClockPort)) {
+    /** the frame was held until its presentation time by the clock port handling */
   } else {
-    timediff = nFrameProcessTime - ((omx_xvideo_sink_component_Private->new_time - omx_xvideo_sink_component_Private->old_time) * 1000);
-    if(timediff>0) {
-      usleep(timediff);
+    /** getting current time */
+    omx_xvideo_sink_component_Private->new_time = GetTime();
+    if(omx_xvideo_sink_component_Private->old_time == 0) {
+      omx_xvideo_sink_component_Private->old_time = omx_xvideo_sink_component_Private->new_time;
+    } else {
+      timediff = omx_xvideo_sink_component_Private->nFrameProcessTime - ((omx_xvideo_sink_component_Private->new_time - omx_xvideo_sink_component_Private->old_time) * 1000);
+      if(timediff>0) {
+        usleep(timediff);
+      }
+      omx_xvideo_sink_component_Private->old_time = GetTime();
+    }
+  }
+
+  nImage = omx_xvideo_sink_component_BufferImage(omx_xvideo_sink_component_Private, pInputBuffer->pBuffer);
+  if (nImage >= 0 &&
+      (pInputBuffer->nOffset != 0 ||
+       pInputBuffer->nFilledLen < omx_xvideo_sink_component_FrameSize(pPort->sPortParam.format.video.nFrameWidth,
+                                                                       pPort->sPortParam.format.video.nFrameHeight))) {
+    /** the frame does not start the image or does not fill it, it goes through the copy below */
+    DEBUG(DEB_LEV_FULL_SEQ, "In %s frame at offset %d of %d bytes is not the whole image, copying it\n", __func__,
+          (int)pInputBuffer->nOffset, (int)pInputBuffer->nFilledLen);
+    nImage = -1;
+  }
+  if (nImage >= 0) {
+    /** the producer wrote the frame into the image, it is put as it is and held until the server has read it */
+    pImage = omx_xvideo_sink_component_Private->buffer_image[nImage];
+    XLockDisplay(omx_xvideo_sink_component_Private->dpy);
+    XvShmPutImage(omx_xvideo_sink_component_Private->dpy,
+                  omx_xvideo_sink_component_Private->xv_port,
+                  omx_xvideo_sink_component_Private->window,
+                  omx_xvideo_sink_component_Private->gc,
+                  pImage, 0, 0,
+                  pImage->width,
+                  pImage->height, 0, 0,
+                  omx_xvideo_sink_component_Private->window_width,
+                  omx_xvideo_sink_component_Private->window_height,
+                  True);
+    XFlush(omx_xvideo_sink_component_Private->dpy);
+    omx_xvideo_sink_component_Private->bBufferImageBusy[nImage] = OMX_TRUE;
+    XUnlockDisplay(omx_xvideo_sink_component_Private->dpy);
+    if (pInputBuffer->nFlags & OMX_BUFFERFLAG_EOS) {
+      /** nothing follows the last frame to return it later */
+      omx_xvideo_sink_component_WaitImage(omx_xvideo_sink_component_Private, &omx_xvideo_sink_component_Private->bBufferImageBusy[nImage]);
+      omx_xvideo_sink_component_Private->bBufferImageBusy[nImage] = OMX_FALSE;
+    } else {
+      omx_xvideo_sink_component_Private->pShownBuffer = pInputBuffer;
     }
-    omx_xvideo_sink_component_Private->old_time = GetTime();
+    pInputBuffer->nFilledLen = 0;
+    return;
+  }
+
+  /** images complete in the order they were put, so the next one is the first to be free */
+  if (omx_xvideo_sink_component_Private->bImageBusy[omx_xvideo_sink_component_Private->nNextImage]) {
+    /** the X server still reads every image of the ring, drop the frame rather than wait for it */
+    omx_xvideo_sink_component_Private->dropFrameCount++;
+    DEBUG(DEB_LEV_FULL_SEQ, "In %s no free image, dropping frame %d\n", __func__, (int)omx_xvideo_sink_component_Private->dropFrameCount);
+    pInputBuffer->nFilledLen = 0;
+    return;
   }
+  pImage = omx_xvideo_sink_component_Private->yuv_image[omx_xvideo_sink_component_Private->nNextImage];
 
   /**  Copy image data into in_buffer */
 
   DEBUG(DEB_LEV_FULL_SEQ, "Copying data size=%d buffer size=%d\n",
-    (int)omx_xvideo_sink_component_Private->yuv_image->data_size,
+    (int)pImage->data_size,
     (int)pInputBuffer->nFilledLen);
-  memcpy(omx_xvideo_sink_component_Private->yuv_image->data, pInputBuffer->pBuffer, omx_xvideo_sink_component_Private->yuv_image->data_size);
+  if (!omx_xvideo_sink_component_CopyFrame(pImage, pInputBuffer->pBuffer + pInputBuffer->nOffset, pInputBuffer->nFilledLen,
+                                           pPort->sPortParam.format.video.nFrameWidth, pPort->sPortParam.format.video.nFrameHeight)) {
+    omx_xvideo_sink_component_Private->dropFrameCount++;
+    DEBUG(DEB_LEV_ERR, "In %s frame of %d bytes is short of a picture, dropping it\n", __func__, (int)pInputBuffer->nFilledLen);
+    pInputBuffer->nFilledLen = 0;
+    return;
+  }
 
-  XGetGeometry(omx_xvideo_sink_component_Private->dpy, omx_xvideo_sink_component_Private->window, &_dw, &d, &d, &width, &height, &ud, &ud);
+  XLockDisplay(omx_xvideo_sink_component_Private->dpy);
   XvShmPutImage(omx_xvideo_sink_component_Private->dpy,
                 omx_xvideo_sink_component_Private->xv_port,
                 omx_xvideo_sink_component_Private->window,
                 omx_xvideo_sink_component_Private->gc,
-                omx_xvideo_sink_component_Private->yuv_image, 0, 0,
-                omx_xvideo_sink_component_Private->yuv_image->width,
-                omx_xvideo_sink_component_Private->yuv_image->height, 0, 0, width, height,
+                pImage, 0, 0,
+                pImage->width,
+                pImage->height, 0, 0,
+                omx_xvideo_sink_component_Private->window_width,
+                omx_xvideo_sink_component_Private->window_height,
                 True);
+  XFlush(omx_xvideo_sink_component_Private->dpy);
+  omx_xvideo_sink_component_Private->bImageBusy[omx_xvideo_sink_component_Private->nNextImage] = OMX_TRUE;
+  XUnlockDisplay(omx_xvideo_sink_component_Private->dpy);
+  omx_xvideo_sink_component_Private->nNextImage = (omx_xvideo_sink_component_Private->nNextImage + 1) % XVIDEO_SINK_IMAGES;
 
   pInputBuffer->nFilledLen = 0;
 }
@@ -470,6 +1328,21 @@ OMX_ERRORTYPE omx_xvideo_sink_component_SetConfig(
         return OMX_ErrorBadPortIndex;
       }
       break;
+    case OMX_IndexVendorXvideoSinkLateThreshold:
+      {
+        OMX_XVIDEO_SINK_CONFIG_LATETHRESHOLDTYPE *pLateThreshold = pComponentConfigStructure;
+        if ((err = checkHeader(pComponentConfigStructure, sizeof(OMX_XVIDEO_SINK_CONFIG_LATETHRESHOLDTYPE))) != OMX_ErrorNone) {
+          break;
+        }
+        if (pLateThreshold->nPortIndex != OMX_BASE_SINK_INPUTPORT_INDEX) {
+          return OMX_ErrorBadPortIndex;
+        }
+        omx_xvideo_sink_component_Private->sLateThreshold.nLateThreshold = pLateThreshold->nLateThreshold;
+        break;
+      }
+    case OMX_IndexVendorXvideoSinkStats:
+      /** the statistics are read only */
+      return OMX_ErrorUnsupportedIndex;
     case OMX_IndexConfigCommonOutputPosition:
       omxConfigOutputPosition = (OMX_CONFIG_POINTTYPE*)pComponentConfigStructure;
       portIndex = omxConfigOutputPosition->nPortIndex;
@@ -552,6 +1425,27 @@ OMX_ERRORTYPE omx_xvideo_sink_component_GetConfig(
         return OMX_ErrorBadPortIndex;
       }
       break;
+    case OMX_IndexVendorXvideoSinkLateThreshold:
+      {
+        OMX_XVIDEO_SINK_CONFIG_LATETHRESHOLDTYPE *pLateThreshold = pComponentConfigStructure;
+        setHeader(pLateThreshold, sizeof(OMX_XVIDEO_SINK_CONFIG_LATETHRESHOLDTYPE));
+        if (pLateThreshold->nPortIndex != OMX_BASE_SINK_INPUTPORT_INDEX) {
+          return OMX_ErrorBadPortIndex;
+        }
+        memcpy(pLateThreshold, &omx_xvideo_sink_component_Private->sLateThreshold, sizeof(OMX_XVIDEO_SINK_CONFIG_LATETHRESHOLDTYPE));
+        break;
+      }
+    case OMX_IndexVendorXvideoSinkStats:
+      {
+        OMX_XVIDEO_SINK_CONFIG_STATSTYPE *pStats = pComponentConfigStructure;
+        setHeader(pStats, sizeof(OMX_XVIDEO_SINK_CONFIG_STATSTYPE));
+        if (pStats->nPortIndex != OMX_BASE_SINK_INPUTPORT_INDEX) {
+          return OMX_ErrorBadPortIndex;
+        }
+        pStats->nDroppedFrames = (OMX_U32) omx_xvideo_sink_component_Private->dropFrameCount;
+        pStats->nLateFrames = (OMX_U32) omx_xvideo_sink_component_Private->lateFrameCount;
+        break;
+      }
     case OMX_IndexConfigCommonOutputPosition:
       omxConfigOutputPosition = (OMX_CONFIG_POINTTYPE*)pComponentConfigStructure;
       setHeader(omxConfigOutputPosition, sizeof(OMX_CONFIG_POINTTYPE));
@@ -578,6 +1472,8 @@ OMX_ERRORTYPE omx_xvideo_sink_component_SetParameter(
   OMX_ERRORTYPE err = OMX_ErrorNone;
   OMX_PARAM_PORTDEFINITIONTYPE *pPortDef;
   OMX_VIDEO_PARAM_PORTFORMATTYPE *pVideoPortFormat;
+  OMX_OTHER_PARAM_PORTFORMATTYPE *pOtherPortFormat;
+  omx_base_clock_PortType *pClockPort;
   OMX_U32 portIndex;
 
   /* Check which structure we are being fed and make control its header */
@@ -651,7 +1547,7 @@ OMX_ERRORTYPE omx_xvideo_sink_component_SetParameter(
       }
 
       if(pVideoPortFormat->xFramerate > 0) {
-        nFrameProcessTime = 1000000 / pVideoPortFormat->xFramerate;
+        omx_xvideo_sink_component_Private->nFrameProcessTime = 1000000 / pVideoPortFormat->xFramerate;
       }
       pPort->sVideoParam.xFramerate         = pVideoPortFormat->xFramerate;
       pPort->sVideoParam.eCompressionFormat = pVideoPortFormat->eCompressionFormat;
@@ -662,6 +1558,20 @@ OMX_ERRORTYPE omx_xvideo_sink_component_SetParameter(
       pPort->sPortParam.format.video.nSliceHeight = pPort->sPortParam.format.video.nFrameHeight;  //  No support for slices yet
       pPort->sPortParam.nBufferSize               = (OMX_U32) abs(pPort->sPortParam.format.video.nStride) * pPort->sPortParam.format.video.nSliceHeight;
       break;
+    case OMX_IndexParamOtherPortFormat:
+      pOtherPortFormat = (OMX_OTHER_PARAM_PORTFORMATTYPE*)ComponentParameterStructure;
+      portIndex = pOtherPortFormat->nPortIndex;
+      err = omx_base_component_ParameterSanityCheck(hComponent, portIndex, pOtherPortFormat, sizeof(OMX_OTHER_PARAM_PORTFORMATTYPE));
+      if(err!=OMX_ErrorNone) {
+        DEBUG(DEB_LEV_ERR, "In %s Parameter Check Error=%x\n",__func__,err);
+        break;
+      }
+      if(portIndex != OMX_BASE_SINK_CLOCKPORT_INDEX) {
+        return OMX_ErrorBadPortIndex;
+      }
+      pClockPort = (omx_base_clock_PortType *) omx_xvideo_sink_component_Private->ports[portIndex];
+      pClockPort->sOtherParam.eFormat = pOtherPortFormat->eFormat;
+      break;
 
     default: /*Call the base component function*/
       return omx_base_component_SetParameter(hComponent, nParamIndex, ComponentParameterStructure);
@@ -693,6 +1603,12 @@ OMX_ERRORTYPE omx_xvideo_sink_component_GetParameter(
       }
       memcpy(ComponentParameterStructure, &omx_xvideo_sink_component_Private->sPortTypesParam[OMX_PortDomainVideo], sizeof(OMX_PORT_PARAM_TYPE));
       break;
+    case OMX_IndexParamOtherInit:
+      if ((err = checkHeader(ComponentParameterStructure, sizeof(OMX_PORT_PARAM_TYPE))) != OMX_ErrorNone) {
+        break;
+      }
+      memcpy(ComponentParameterStructure, &omx_xvideo_sink_component_Private->sPortTypesParam[OMX_PortDomainOther], sizeof(OMX_PORT_PARAM_TYPE));
+      break;
 
     case OMX_IndexParamVideoPortFormat:
       pVideoPortFormat = (OMX_VIDEO_PARAM_PORTFORMATTYPE*)ComponentParameterStructure;
@@ -713,36 +1629,87 @@ OMX_ERRORTYPE omx_xvideo_sink_component_GetParameter(
 }
 
 
+OMX_ERRORTYPE omx_xvideo_sink_component_GetExtensionIndex(
+  OMX_HANDLETYPE hComponent,
+  OMX_STRING cParameterName,
+  OMX_INDEXTYPE* pIndexType) {
+
+  DEBUG(DEB_LEV_FUNCTION_NAME,"In  %s \n",__func__);
+
+  if(strcmp(cParameterName,XVIDEO_SINK_LATE_THRESHOLD_EXTENSION) == 0) {
+    *pIndexType = OMX_IndexVendorXvideoSinkLateThreshold;
+  } else if(strcmp(cParameterName,XVIDEO_SINK_STATS_EXTENSION) == 0) {
+    *pIndexType = OMX_IndexVendorXvideoSinkStats;
+  } else {
+    return omx_base_component_GetExtensionIndex(hComponent, cParameterName, pIndexType);
+  }
+  return OMX_ErrorNone;
+}
+
 OMX_ERRORTYPE omx_xvideo_sink_component_MessageHandler(OMX_COMPONENTTYPE* openmaxStandComp,internalRequestMessageType *message) {
 
   omx_xvideo_sink_component_PrivateType* omx_xvideo_sink_component_Private = (omx_xvideo_sink_component_PrivateType*)openmaxStandComp->pComponentPrivate;
+  omx_xvideo_sink_component_PortType* pPort = (omx_xvideo_sink_component_PortType *) omx_xvideo_sink_component_Private->ports[OMX_BASE_SINK_INPUTPORT_INDEX];
   OMX_ERRORTYPE err;
+  OMX_ERRORTYPE initErr = OMX_ErrorNone;
   OMX_STATETYPE eState;
 
   DEBUG(DEB_LEV_FUNCTION_NAME, "In %s\n", __func__);
   eState = omx_xvideo_sink_component_Private->state; //storing current state
 
   if (message->messageType == OMX_CommandStateSet){
-    if ((message->messageParam == OMX_StateExecuting ) && (omx_xvideo_sink_component_Private->state == OMX_StateIdle)) {
+    if ((message->messageParam == OMX_StateIdle ) && (omx_xvideo_sink_component_Private->state == OMX_StateLoaded)) {
+      /** the display is opened before the input buffers are allocated, they may be XvShm images */
       DEBUG(DEB_LEV_SIMPLE_SEQ, "In %s sink component from loaded to idle \n", __func__);
       err = omx_xvideo_sink_component_Init(openmaxStandComp);
+      /*Signal XVideo Initialized, or given up on*/
+      tsem_up(omx_xvideo_sink_component_Private->xvideoSyncSem);
       if(err!=OMX_ErrorNone) {
         DEBUG(DEB_LEV_ERR, "In %s Video Sink Init Failed Error=%x\n",__func__,err);
         return err;
       }
     }
+  } else if (message->messageType == OMX_CommandPortEnable &&
+             (message->messageParam == OMX_BASE_SINK_INPUTPORT_INDEX || message->messageParam == OMX_ALL) &&
+             !PORT_IS_ENABLED(pPort) &&
+             eState != OMX_StateLoaded && eState != OMX_StateWaitForResources) {
+    /** the port definition may have changed while the port was disabled: the window and
+      * the image ring are made again at the frame size before its buffers are allocated
+      */
+    DEBUG(DEB_LEV_SIMPLE_SEQ, "In %s input port enabled, opening the display again\n", __func__);
+    if (omx_xvideo_sink_component_Private->bIsXVideoInit) {
+      omx_xvideo_sink_component_Deinit(openmaxStandComp);
+    }
+    initErr = omx_xvideo_sink_component_Init(openmaxStandComp);
+    tsem_up(omx_xvideo_sink_component_Private->xvideoSyncSem);
   }
   // Execute the base message handling
   err = omx_base_component_MessageHandler(openmaxStandComp,message);
 
+  if (initErr != OMX_ErrorNone) {
+    /** the port is enabled all the same, so that the command completes; its frames are dropped */
+    DEBUG(DEB_LEV_ERR, "In %s Video Sink Init Failed Error=%x\n",__func__,initErr);
+    (*(omx_xvideo_sink_component_Private->callbacks->EventHandler))
+      (openmaxStandComp,
+      omx_xvideo_sink_component_Private->callbackData,
+      OMX_EventError,
+      initErr,
+      OMX_BASE_SINK_INPUTPORT_INDEX,
+      NULL);
+  }
+
   if (message->messageType == OMX_CommandStateSet) {
-    if ((message->messageParam == OMX_StateIdle ) && (omx_xvideo_sink_component_Private->state == OMX_StateIdle) && eState == OMX_StateExecuting) {
+    if ((message->messageParam == OMX_StateLoaded ) && (omx_xvideo_sink_component_Private->state == OMX_StateLoaded) && eState == OMX_StateIdle) {
       err = omx_xvideo_sink_component_Deinit(openmaxStandComp);
       if(err!=OMX_ErrorNone) {
         DEBUG(DEB_LEV_ERR, "In %s Video Sink Deinit Failed Error=%x\n",__func__,err);
         return err;
       }
     }
+  } else if (message->messageType == OMX_CommandPortDisable &&
+             (message->messageParam == OMX_BASE_SINK_INPUTPORT_INDEX || message->messageParam == OMX_ALL)) {
+    /** buffers allocated when the port is enabled again wait for the display to be opened for it */
+    tsem_reset(omx_xvideo_sink_component_Private->xvideoSyncSem);
   }
   return err;
 }
@@ -42,6 +42,7 @@
 #include <sys/ipc.h>
 #include <sys/shm.h>
 #include <sys/resource.h>
+#include <poll.h>
 
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
@@ -51,6 +52,7 @@
 #include <X11/extensions/XShm.h>
 
 #include <bellagio/omx_base_video_port.h>
+#include <bellagio/omx_base_clock_port.h>
 #include <bellagio/omx_base_sink.h>
 #include <bellagio/omx_comp_debug_levels.h>
 
@@ -59,6 +61,63 @@
   */
 #define FBDEV_FILENAME  "/dev/fb0"
 
+/** Number of XvShm images frames are put from; a new frame goes into an image
+  * the X server has finished reading, which it reports with a ShmCompletion event
+  */
+#define XVIDEO_SINK_IMAGES 3
+
+/** Longest time in milliseconds the sink waits for the X server to finish reading an image;
+  * past it the image is taken back anyway, so that a stalled server does not stall a flush
+  */
+#define XVIDEO_SINK_COMPLETION_TIMEOUT 500
+
+/** Maximum number of input buffers that are handed out as XvShm images, the others are plain memory */
+#define XVIDEO_SINK_MAX_BUFFERS 16
+
+/**  Extension names of the late frame threshold and of the frame statistics configs */
+#define XVIDEO_SINK_LATE_THRESHOLD_EXTENSION "OMX.ST.index.config.xvideosink.latethreshold"
+#define XVIDEO_SINK_STATS_EXTENSION "OMX.ST.index.config.xvideosink.stats"
+
+/** Longest waits in milliseconds for the clock component: for the clock to start after the start time
+  * is set, and for a media time request to be fulfilled, which takes as long as the frame is early.
+  * The waits check for flushes every XVIDEO_SINK_CLOCK_WAIT_SLICE
+  */
+#define XVIDEO_SINK_CLOCK_START_TIMEOUT 2000
+#define XVIDEO_SINK_CLOCK_REQUEST_TIMEOUT 2000
+#define XVIDEO_SINK_CLOCK_WAIT_SLICE 20
+
+/**  Default lateness in microseconds beyond which a frame is dropped instead of shown */
+#define XVIDEO_SINK_DEFAULT_LATE_THRESHOLD 20000
+
+/** Vendor specific indexes of the xvideo sink */
+typedef enum OMX_XVIDEO_SINK_INDEXVENDORTYPE {
+  OMX_IndexVendorXvideoSinkLateThreshold = OMX_IndexVendorStartUnused + 0x00d00300, /**< reference: OMX_XVIDEO_SINK_CONFIG_LATETHRESHOLDTYPE */
+  OMX_IndexVendorXvideoSinkStats                                                    /**< reference: OMX_XVIDEO_SINK_CONFIG_STATSTYPE */
+} OMX_XVIDEO_SINK_INDEXVENDORTYPE;
+
+/** Late frame threshold, used when the clock port is tunneled.
+  * A frame whose presentation time has passed by more than nLateThreshold is dropped without being put.
+  * @param nLateThreshold lateness in microseconds of media time
+  */
+typedef struct OMX_XVIDEO_SINK_CONFIG_LATETHRESHOLDTYPE {
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U32 nPortIndex;
+  OMX_U32 nLateThreshold;
+} OMX_XVIDEO_SINK_CONFIG_LATETHRESHOLDTYPE;
+
+/** Frame statistics since the sink went to idle, read only.
+  * @param nDroppedFrames frames not shown: too late for the clock, or no free XvShm image to put them from
+  * @param nLateFrames frames shown after their presentation time, but within the late threshold
+  */
+typedef struct OMX_XVIDEO_SINK_CONFIG_STATSTYPE {
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U32 nPortIndex;
+  OMX_U32 nDroppedFrames;
+  OMX_U32 nLateFrames;
+} OMX_XVIDEO_SINK_CONFIG_STATSTYPE;
+
 /** FBDEV sink port component port structure.
   */
 DERIVEDCLASS(omx_xvideo_sink_component_PortType, omx_base_video_PortType)
@@ -91,12 +150,32 @@ ENDCLASS(omx_xvideo_sink_component_PortType)
   * @param product frame buffer memory area
   * @param frameDropFlag the flag active on scale change indicates that frames are to be dropped
   * @param dropFrameCount counts the number of frames dropped
+  * @param yuv_image the ring of XvShm images frames are put from
+  * @param yuv_shminfo the shared memory segment of each image of the ring
+  * @param bImageBusy set for an image the X server has not finished reading
+  * @param nNextImage the image of the ring the next frame goes into
+  * @param window_width the window width, as last reported by ConfigureNotify
+  * @param window_height the window height, as last reported by ConfigureNotify
+  * @param buffer_image the XvShm image each input buffer slot is the data area of, if any
+  * @param buffer_shminfo the shared memory segment of each input buffer image
+  * @param bBufferImageBusy set for an input buffer image the X server has not finished reading
+  * @param pShownBuffer the input buffer whose image was just put, it is held when it is returned
+  * @param pHeldBuffer the input buffers held until the X server has read them, in the order they were put
+  * @param nHeldBuffers the number of held input buffers
+  * @param lateFrameCount counts the frames shown after their presentation time
+  * @param sLateThreshold lateness beyond which frames are dropped when the clock port is tunneled
+  * @param nFrameProcessTime time in microseconds between frames, for pacing without clock
   */
 DERIVEDCLASS(omx_xvideo_sink_component_PrivateType, omx_base_sink_PrivateType)
 #define omx_xvideo_sink_component_PrivateType_FIELDS omx_base_sink_PrivateType_FIELDS \
   OMX_BOOL                    bIsXVideoInit;\
   tsem_t*                     xvideoSyncSem; \
   OMX_S32                     dropFrameCount; \
+  OMX_S32                     lateFrameCount; \
+  OMX_S32                     xScale; \
+  OMX_TIME_CLOCKSTATE         eState; \
+  OMX_XVIDEO_SINK_CONFIG_LATETHRESHOLDTYPE sLateThreshold; \
+  OMX_U32                     nFrameProcessTime; \
   OMX_S32                     xv_port; \
   OMX_S32                     screen; \
   OMX_S32                     CompletionType; \
@@ -115,8 +194,18 @@ DERIVEDCLASS(omx_xvideo_sink_component_PrivateType, omx_base_sink_PrivateType)
   XEvent                      event; \
   GC                          gc; \
   XvAdaptorInfo               *ai; \
-  XvImage                     *yuv_image; \
-  XShmSegmentInfo             yuv_shminfo; \
+  XvImage                     *yuv_image[XVIDEO_SINK_IMAGES]; \
+  XShmSegmentInfo             yuv_shminfo[XVIDEO_SINK_IMAGES]; \
+  OMX_BOOL                    bImageBusy[XVIDEO_SINK_IMAGES]; \
+  OMX_U32                     nNextImage; \
+  unsigned int                window_width; \
+  unsigned int                window_height; \
+  XvImage                     *buffer_image[XVIDEO_SINK_MAX_BUFFERS]; \
+  XShmSegmentInfo             buffer_shminfo[XVIDEO_SINK_MAX_BUFFERS]; \
+  OMX_BOOL                    bBufferImageBusy[XVIDEO_SINK_MAX_BUFFERS]; \
+  OMX_BUFFERHEADERTYPE        *pShownBuffer; \
+  OMX_BUFFERHEADERTYPE        *pHeldBuffer[XVIDEO_SINK_MAX_BUFFERS]; \
+  OMX_U32                     nHeldBuffers; \
   Atom                        wmDeleteWindow; \
   long                        old_time; \
   long                        new_time;
@@ -137,6 +226,25 @@ OMX_ERRORTYPE omx_xvideo_sink_component_port_SendBufferFunction(
   omx_base_PortType *openmaxStandPort,
   OMX_BUFFERHEADERTYPE* pBuffer);
 
+OMX_ERRORTYPE omx_xvideo_sink_component_port_AllocateBuffer(
+  omx_base_PortType *openmaxStandPort,
+  OMX_BUFFERHEADERTYPE** pBuffer,
+  OMX_U32 nPortIndex,
+  OMX_PTR pAppPrivate,
+  OMX_U32 nSizeBytes);
+
+OMX_ERRORTYPE omx_xvideo_sink_component_port_FreeBuffer(
+  omx_base_PortType *openmaxStandPort,
+  OMX_U32 nPortIndex,
+  OMX_BUFFERHEADERTYPE* pBuffer);
+
+OMX_ERRORTYPE omx_xvideo_sink_component_port_ReturnBufferFunction(
+  omx_base_PortType *openmaxStandPort,
+  OMX_BUFFERHEADERTYPE* pBuffer);
+
+OMX_ERRORTYPE omx_xvideo_sink_component_port_FlushProcessingBuffers(
+  omx_base_PortType *openmaxStandPort);
+
 /* to handle the communication at the clock port */
 OMX_BOOL omx_xvideo_sink_component_ClockPortHandleFunction(
   omx_xvideo_sink_component_PrivateType* omx_xvideo_sink_component_Private,
@@ -162,6 +270,11 @@ OMX_ERRORTYPE omx_xvideo_sink_component_GetConfig(
   OMX_INDEXTYPE nIndex,
   OMX_PTR pComponentConfigStructure);
 
+OMX_ERRORTYPE omx_xvideo_sink_component_GetExtensionIndex(
+  OMX_HANDLETYPE hComponent,
+  OMX_STRING cParameterName,
+  OMX_INDEXTYPE* pIndexType);
+
 /** function prototypes of some internal functions */
 
 OMX_S32 calcStride(OMX_U32 width, OMX_COLOR_FORMATTYPE omx_pxlfmt);